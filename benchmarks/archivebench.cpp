@@ -0,0 +1,183 @@
+#include "assetarchive.h"
+#include "benchmark.h"
+#include "jobsystem.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace {
+const char* DataDirectory = "archive_bench";
+const size_t AssetCount = 2000;
+const size_t MinAssetSize = 4 * 1024;
+const size_t MaxAssetSize = 256 * 1024;
+const int LookupRounds = 100;
+const int Iterations = 5;
+
+// Half of the assets look like text or mesh data and compress well, the
+// other half are noise like already compressed textures.
+std::vector<char> makeAsset(size_t index, std::mt19937& random)
+{
+    std::uniform_int_distribution<size_t> sizes(MinAssetSize, MaxAssetSize);
+    std::vector<char> data(sizes(random));
+    if (index % 2 == 0) {
+        static const char* const words[] = { "vertex ", "index ", "normal ", "float ", "layout ", "uniform ", "0.5, ", "1.0, ", "\n" };
+        size_t position = 0;
+        while (position < data.size()) {
+            const char* word = words[random() % (sizeof(words) / sizeof(words[0]))];
+            for (; *word && position < data.size(); word++) {
+                data[position++] = *word;
+            }
+        }
+    } else {
+        for (char& byte : data) {
+            byte = static_cast<char>(random());
+        }
+    }
+    return data;
+}
+
+std::string assetName(size_t index)
+{
+    return "assets/asset" + std::to_string(index) + ".bin";
+}
+
+std::string loosePath(size_t index)
+{
+    return std::string(DataDirectory) + "/asset" + std::to_string(index) + ".bin";
+}
+
+// The loose file path the engine used so far: open, seek to the end for the
+// size, then read into a fresh vector.
+bool readLoose(const std::string& path, std::vector<char>& data)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+
+uint64_t checksum(const char* data, size_t size)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i += 64) {
+        sum += static_cast<unsigned char>(data[i]);
+    }
+    return sum;
+}
+
+void report(const char* mode, double seconds, uint64_t bytes)
+{
+    std::printf("%-28s %10.2f %12.1f\n", mode, seconds * 1000.0, static_cast<double>(bytes) / seconds / (1024.0 * 1024.0));
+}
+}
+
+int main()
+{
+    std::mt19937 random(1234);
+    mkdir(DataDirectory, 0755);
+    AssetArchiveWriter compressed;
+    AssetArchiveWriter stored;
+    uint64_t totalBytes = 0;
+    for (size_t i = 0; i < AssetCount; i++) {
+        std::vector<char> data = makeAsset(i, random);
+        std::ofstream(loosePath(i), std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+        compressed.add(assetName(i), data.data(), data.size(), true);
+        stored.add(assetName(i), data.data(), data.size(), false);
+        totalBytes += data.size();
+    }
+    std::string compressedPath = std::string(DataDirectory) + "/compressed.pak";
+    std::string storedPath = std::string(DataDirectory) + "/stored.pak";
+    if (!compressed.write(compressedPath) || !stored.write(storedPath)) {
+        return EXIT_FAILURE;
+    }
+    std::printf("%zu assets, %.1f MiB, %.1f MiB compressed\n\n", AssetCount, totalBytes / (1024.0 * 1024.0), compressed.storedSize() / (1024.0 * 1024.0));
+
+    // Lookups and open are measured on the compressed archive; they only
+    // touch the table of contents.
+    AssetArchive archive;
+    double openSeconds = 0.0;
+    for (int i = 0; i < Iterations; i++) {
+        BenchmarkTimer timer;
+        archive.open(compressedPath);
+        openSeconds += timer.elapsedSeconds();
+    }
+    std::vector<std::string> names;
+    for (size_t i = 0; i < AssetCount; i++) {
+        names.push_back(assetName(i));
+    }
+    std::shuffle(names.begin(), names.end(), random);
+    size_t found = 0;
+    BenchmarkTimer lookupTimer;
+    for (int round = 0; round < LookupRounds; round++) {
+        for (const std::string& name : names) {
+            found += archive.find(name) != nullptr;
+        }
+    }
+    double lookupSeconds = lookupTimer.elapsedSeconds();
+    doNotOptimize(found);
+    std::printf("open %.1f us, lookup %.1f ns\n\n", openSeconds * 1e6 / Iterations, lookupSeconds * 1e9 / (LookupRounds * names.size()));
+
+    std::printf("%-28s %10s %12s\n", "read", "ms", "MiB/s");
+    uint64_t sum = 0;
+    std::vector<char> data;
+    BenchmarkTimer looseTimer;
+    for (size_t i = 0; i < AssetCount; i++) {
+        readLoose(loosePath(i), data);
+        sum += checksum(data.data(), data.size());
+    }
+    report("loose files", looseTimer.elapsedSeconds(), totalBytes);
+
+    std::vector<const ArchiveEntry*> entries;
+    for (size_t i = 0; i < AssetCount; i++) {
+        entries.push_back(archive.find(assetName(i)));
+    }
+    // Both decompress into a fresh buffer per entry, as a loader would.
+    std::vector<std::vector<char>> outputs(entries.size());
+    BenchmarkTimer serialTimer;
+    for (size_t i = 0; i < entries.size(); i++) {
+        archive.read(*entries[i], outputs[i]);
+        sum += checksum(outputs[i].data(), outputs[i].size());
+    }
+    report("compressed, one thread", serialTimer.elapsedSeconds(), totalBytes);
+
+    JobSystem jobs;
+    outputs.clear();
+    outputs.shrink_to_fit();
+    BenchmarkTimer parallelTimer;
+    archive.readAll(jobs, entries, outputs);
+    for (const std::vector<char>& output : outputs) {
+        sum += checksum(output.data(), output.size());
+    }
+    char label[64];
+    std::snprintf(label, sizeof(label), "compressed, %u threads", jobs.workerCount());
+    report(label, parallelTimer.elapsedSeconds(), totalBytes);
+
+    AssetArchive storedArchive;
+    storedArchive.open(storedPath);
+    BenchmarkTimer copyTimer;
+    for (size_t i = 0; i < AssetCount; i++) {
+        storedArchive.read(*storedArchive.find(assetName(i)), data);
+        sum += checksum(data.data(), data.size());
+    }
+    report("stored, copied", copyTimer.elapsedSeconds(), totalBytes);
+
+    BenchmarkTimer viewTimer;
+    for (size_t i = 0; i < AssetCount; i++) {
+        const char* view;
+        size_t size;
+        storedArchive.view(*storedArchive.find(assetName(i)), view, size);
+        sum += checksum(view, size);
+    }
+    report("stored, in place", viewTimer.elapsedSeconds(), totalBytes);
+    doNotOptimize(sum);
+    return EXIT_SUCCESS;
+}
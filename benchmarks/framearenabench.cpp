@@ -0,0 +1,65 @@
+#include "allocationcounter.h"
+#include "benchmark.h"
+#include "framearena.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace {
+const size_t VectorCounts[] = { 8, 64, 512 };
+const size_t ElementCount = 32;
+const int Frames = 2000;
+
+// One frame of short-lived vectors, as a frame builds submit infos, barrier
+// batches and culling outputs.
+template <typename MakeVector>
+uint64_t frame(size_t vectorCount, MakeVector makeVector)
+{
+    uint64_t sum = 0;
+    for (size_t v = 0; v < vectorCount; v++) {
+        auto values = makeVector();
+        for (size_t i = 0; i < ElementCount; i++) {
+            values.push_back(static_cast<uint32_t>(i + v));
+        }
+        sum += values[ElementCount / 2];
+    }
+    return sum;
+}
+}
+
+int main()
+{
+    std::printf("frame arena: short-lived vectors of %zu elements per frame, %d frames\n", ElementCount, Frames);
+    std::printf("%9s %14s %14s %16s %16s\n", "vectors", "heap us/frame", "arena us/frame", "heap allocs", "arena allocs");
+    for (size_t vectorCount : VectorCounts) {
+        uint64_t sum = 0;
+        AllocationScope heapAllocations;
+        BenchmarkTimer heapTimer;
+        for (int f = 0; f < Frames; f++) {
+            sum += frame(vectorCount, []() { return std::vector<uint32_t>(); });
+        }
+        double heap = heapTimer.elapsedSeconds();
+        uint64_t heapCount = heapAllocations.count();
+
+        FrameArena arena;
+        // Let the arena reach its peak size before measuring.
+        frame(vectorCount, [&arena]() { return FrameVector<uint32_t>(ArenaAllocator<uint32_t>(arena)); });
+        arena.reset();
+        AllocationScope arenaAllocations;
+        BenchmarkTimer arenaTimer;
+        for (int f = 0; f < Frames; f++) {
+            arena.reset();
+            sum += frame(vectorCount, [&arena]() { return FrameVector<uint32_t>(ArenaAllocator<uint32_t>(arena)); });
+        }
+        double arenaSeconds = arenaTimer.elapsedSeconds();
+        uint64_t arenaCount = arenaAllocations.count();
+        doNotOptimize(sum);
+
+        std::printf("%9zu %14.2f %14.2f %16llu %16llu\n", vectorCount, heap * 1e6 / Frames, arenaSeconds * 1e6 / Frames, static_cast<unsigned long long>(heapCount),
+            static_cast<unsigned long long>(arenaCount));
+    }
+    if (!allocationCountingEnabled()) {
+        std::printf("allocation counts need -DENGINE_ALLOCATION_CHECK=ON\n");
+    }
+    return EXIT_SUCCESS;
+}
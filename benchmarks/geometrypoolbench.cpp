@@ -0,0 +1,82 @@
+#include "benchmark.h"
+#include "rangeallocator.h"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+const uint32_t Capacity = 1024 * 1024;
+const uint32_t MeshCounts[] = { 256, 4096, 16384 };
+const int Rounds = 200;
+
+struct Allocation {
+    uint32_t offset;
+    uint32_t count;
+};
+
+// Fills the allocator, then repeatedly frees a random quarter of the meshes
+// and adds new ones of random size, as streaming geometry in and out would.
+double churn(RangeAllocator& allocator, std::vector<Allocation>& live, uint32_t meshCount, std::mt19937& random)
+{
+    uint32_t averageSize = Capacity / meshCount / 2;
+    std::uniform_int_distribution<uint32_t> size(averageSize / 2, averageSize * 3 / 2);
+    allocator.reset(Capacity);
+    live.clear();
+    for (uint32_t i = 0; i < meshCount; i++) {
+        uint32_t count = size(random);
+        live.push_back({ allocator.allocate(count), count });
+    }
+
+    BenchmarkTimer timer;
+    uint64_t operations = 0;
+    for (int round = 0; round < Rounds; round++) {
+        for (uint32_t i = 0; i < meshCount / 4; i++) {
+            size_t victim = random() % live.size();
+            allocator.free(live[victim].offset, live[victim].count);
+            live[victim] = live.back();
+            live.pop_back();
+            operations++;
+        }
+        while (live.size() < meshCount) {
+            uint32_t count = size(random);
+            uint32_t offset = allocator.allocate(count);
+            operations++;
+            if (offset == RangeAllocator::InvalidOffset) {
+                break;
+            }
+            live.push_back({ offset, count });
+        }
+    }
+    return timer.elapsedSeconds() * 1e9 / static_cast<double>(operations);
+}
+
+// What GeometryPool::compact() does to the ranges: allocate every live mesh
+// again into an empty allocator.
+void repack(RangeAllocator& allocator, std::vector<Allocation>& live)
+{
+    allocator.reset(allocator.capacity());
+    for (Allocation& allocation : live) {
+        allocation.offset = allocator.allocate(allocation.count);
+    }
+}
+}
+
+int main()
+{
+    std::mt19937 random(1234);
+    std::vector<Allocation> live;
+
+    std::printf("%9s %14s %12s %16s %12s %16s %12s\n", "meshes", "ns/operation", "used", "fragmented", "largest", "after compact", "largest");
+    for (uint32_t meshCount : MeshCounts) {
+        RangeAllocator allocator;
+        double nanoseconds = churn(allocator, live, meshCount, random);
+        double fragmented = allocator.fragmentation();
+        uint32_t largest = allocator.largestFree();
+        repack(allocator, live);
+        doNotOptimize(live.front());
+
+        std::printf("%9u %14.1f %12u %15.1f%% %12u %15.1f%% %12u\n", meshCount, nanoseconds, allocator.used(), fragmented * 100.0, largest, allocator.fragmentation() * 100.0, allocator.largestFree());
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include "benchmark.h"
+#include "jobsystem.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+const unsigned ThreadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+const size_t SpawnJobs = 1 << 20;
+const size_t SpawnBatch = 2048;
+const size_t WorkItems = 1 << 22;
+const size_t WorkGrain = 1024;
+
+double spawnOverhead(JobSystem& jobs)
+{
+    BenchmarkTimer timer;
+    for (size_t spawned = 0; spawned < SpawnJobs; spawned += SpawnBatch) {
+        JobCounter counter;
+        for (size_t i = 0; i < SpawnBatch; i++) {
+            jobs.run([]() {}, &counter);
+        }
+        jobs.wait(counter);
+    }
+    return timer.elapsedSeconds() * 1e9 / SpawnJobs;
+}
+
+double dependencyChain(JobSystem& jobs, size_t length)
+{
+    BenchmarkTimer timer;
+    std::vector<std::unique_ptr<JobCounter>> counters;
+    counters.emplace_back(new JobCounter());
+    jobs.run([]() {}, counters.back().get());
+    for (size_t i = 1; i < length; i++) {
+        JobCounter& dependency = *counters.back();
+        counters.emplace_back(new JobCounter());
+        jobs.runAfter(dependency, []() {}, counters.back().get());
+    }
+    jobs.wait(*counters.back());
+    return timer.elapsedSeconds() * 1e9 / length;
+}
+
+double parallelWork(JobSystem& jobs, std::vector<float>& data)
+{
+    BenchmarkTimer timer;
+    jobs.parallelFor(data.size(), WorkGrain, [&data](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            float x = data[i];
+            for (int k = 0; k < 16; k++) {
+                x = std::sqrt(x * x + 1.0f) * 0.5f;
+            }
+            data[i] = x;
+        }
+    });
+    doNotOptimize(data.front());
+    return timer.elapsedSeconds();
+}
+}
+
+int main(int argc, char** argv)
+{
+    unsigned maxThreads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 64;
+    std::vector<float> data(WorkItems, 1.0f);
+    double baseline = 0.0;
+
+    std::printf("%8s %14s %14s %12s %9s\n", "threads", "spawn ns/job", "chain ns/job", "work ms", "speedup");
+    for (unsigned threads : ThreadCounts) {
+        if (threads > maxThreads) {
+            break;
+        }
+        JobSystem jobs(threads);
+        parallelWork(jobs, data);
+
+        double spawn = spawnOverhead(jobs);
+        double chain = dependencyChain(jobs, 4096);
+        double work = parallelWork(jobs, data);
+        if (threads == 1) {
+            baseline = work;
+        }
+        std::printf("%8u %14.1f %14.1f %12.2f %9.2f\n", threads, spawn, chain, work * 1000.0, baseline / work);
+    }
+    return EXIT_SUCCESS;
+}
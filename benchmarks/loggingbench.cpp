@@ -0,0 +1,141 @@
+#include "benchmark.h"
+#include "logger.h"
+
+#include <atomic>
+#include <fstream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace {
+const int Calls = 1 << 20;
+const unsigned ProducerCounts[] = { 1, 2, 4, 8 };
+
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override
+    {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+double disabledCall()
+{
+    Logger::instance().setLevel(LogLevel::Info);
+    BenchmarkTimer timer;
+    for (int i = 0; i < Calls; i++) {
+        LOG_DEBUG(LogCategory::Render, "frame %d image %u", i, 2u);
+    }
+    return timer.elapsedSeconds() * 1e9 / Calls;
+}
+
+// Producers log bursts that fit the queue; draining happens between bursts
+// and is not timed. Reported as wall time per record across all producers.
+double enabledCall(unsigned producers)
+{
+    Logger& logger = Logger::instance();
+    logger.setLevel(LogLevel::Debug);
+    int burst = static_cast<int>(LogQueueSize / 2 / producers);
+    double seconds = 0.0;
+    int calls = 0;
+
+    std::vector<std::thread> threads;
+    std::atomic<int> round(0);
+    std::atomic<unsigned> finished(0);
+    for (unsigned t = 1; t < producers; t++) {
+        threads.emplace_back([&round, &finished, burst]() {
+            for (int seen = 0;; seen++) {
+                int next;
+                while ((next = round.load(std::memory_order_acquire)) == seen) {
+                    std::this_thread::yield();
+                }
+                if (next < 0) {
+                    return;
+                }
+                for (int i = 0; i < burst; i++) {
+                    LOG_DEBUG(LogCategory::Render, "frame %d image %u", i, 2u);
+                }
+                finished.fetch_add(1, std::memory_order_release);
+            }
+        });
+    }
+
+    while (calls < Calls) {
+        finished.store(0, std::memory_order_relaxed);
+        BenchmarkTimer timer;
+        round.fetch_add(1, std::memory_order_release);
+        for (int i = 0; i < burst; i++) {
+            LOG_DEBUG(LogCategory::Render, "frame %d image %u", i, 2u);
+        }
+        while (finished.load(std::memory_order_acquire) != producers - 1) {
+            std::this_thread::yield();
+        }
+        seconds += timer.elapsedSeconds();
+        calls += burst * static_cast<int>(producers);
+        logger.flush();
+    }
+    round.store(-1, std::memory_order_release);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return seconds * 1e9 / calls;
+}
+
+// Logs far faster than the sink drains, so most records are dropped.
+uint64_t flood(unsigned producers)
+{
+    Logger& logger = Logger::instance();
+    logger.setLevel(LogLevel::Debug);
+    uint64_t droppedBefore = logger.dropped();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < producers; t++) {
+        threads.emplace_back([producers]() {
+            for (int i = 0; i < Calls / static_cast<int>(producers); i++) {
+                LOG_DEBUG(LogCategory::Validation, "message %d", i);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    logger.flush();
+    return logger.dropped() - droppedBefore;
+}
+
+double synchronousCall(std::ostream& stream)
+{
+    BenchmarkTimer timer;
+    for (int i = 0; i < Calls; i++) {
+        stream << "frame " << i << " image " << 2u << std::endl;
+    }
+    return timer.elapsedSeconds() * 1e9 / Calls;
+}
+}
+
+int main()
+{
+    NullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+    Logger::instance().start(nullStream);
+
+    std::printf("%d calls per run\n", Calls);
+    std::printf("%-24s %8.1f ns/call\n", "disabled", disabledCall());
+    for (unsigned producers : ProducerCounts) {
+        char label[32];
+        std::snprintf(label, sizeof(label), "enabled, %u producers", producers);
+        std::printf("%-24s %8.1f ns/call\n", label, enabledCall(producers));
+    }
+    uint64_t dropped = flood(4);
+    std::printf("%-24s %llu of %d records dropped\n", "flood, 4 producers", static_cast<unsigned long long>(dropped), Calls);
+
+    std::ofstream devNull("/dev/null");
+    std::printf("%-24s %8.1f ns/call\n", "ofstream + endl", synchronousCall(devNull));
+
+    Logger::instance().stop();
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "benchmark.h"
+#include "resolutionscaler.h"
+
+#include <cmath>
+#include <random>
+
+// Drives the resolution controller with a synthetic GPU: cost proportional to
+// pixel count plus a fixed part, measured with the latency of frames in flight.
+namespace {
+const double BudgetMilliseconds = 16.0;
+const int FramesInFlight = 3;
+const int Frames = 6000;
+
+struct Phase {
+    int frames;
+    double fullResolutionCost;
+};
+
+const Phase Phases[] = { { 1000, 12.0 }, { 1000, 24.0 }, { 500, 40.0 }, { 1500, 18.0 }, { 2000, 30.0 } };
+
+double fullResolutionCost(int frame)
+{
+    int start = 0;
+    for (const Phase& phase : Phases) {
+        if (frame < start + phase.frames) {
+            return phase.fullResolutionCost;
+        }
+        start += phase.frames;
+    }
+    return Phases[0].fullResolutionCost;
+}
+
+void simulate(const char* name, double budget, const ResolutionScalerTuning& tuning)
+{
+    ResolutionScaler scaler;
+    scaler.configure(budget, 0.5, 1.0, tuning);
+
+    std::mt19937 random(42);
+    std::normal_distribution<double> noise(1.0, 0.05);
+    double inFlight[FramesInFlight] = {};
+    RunningStatistics cost;
+    int overBudget = 0;
+
+    BenchmarkTimer timer;
+    for (int frame = 0; frame < Frames; frame++) {
+        double scale = scaler.scale();
+        double gpu = (2.0 + fullResolutionCost(frame) * scale * scale) * noise(random);
+        cost.add(gpu);
+        overBudget += gpu > BudgetMilliseconds ? 1 : 0;
+        int slot = frame % FramesInFlight;
+        if (frame >= FramesInFlight) {
+            scaler.update(inFlight[slot]);
+        }
+        inFlight[slot] = gpu;
+    }
+    double elapsed = timer.elapsedSeconds();
+
+    std::printf("%-10s scale mean %.3f min %.3f | gpu ms mean %.2f max %.2f | over budget %5.2f%% | %4llu changes | %.1f ns/update\n", name, scaler.scales().mean(), scaler.scales().min(),
+        cost.mean(), cost.max(), 100.0 * overBudget / Frames, static_cast<unsigned long long>(scaler.changes()),
+        elapsed * 1e9 / Frames);
+}
+}
+
+int main()
+{
+    std::printf("budget %.1f ms, %d frames, %d frames in flight\n", BudgetMilliseconds, Frames, FramesInFlight);
+
+    simulate("fixed", 0.0, ResolutionScalerTuning());
+    simulate("damped", BudgetMilliseconds, ResolutionScalerTuning());
+
+    ResolutionScalerTuning undamped;
+    undamped.smoothing = 1.0;
+    undamped.lowWatermark = 0.95;
+    undamped.highWatermark = 0.95;
+    undamped.maxStep = 1.0;
+    undamped.quantum = 0.0;
+    undamped.settleFrames = 0;
+    simulate("undamped", BudgetMilliseconds, undamped);
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "benchmark.h"
+#include "tracer.h"
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+// Stays below TraceBufferSize so no span of a capture is dropped.
+const size_t SpansPerCapture = 60000;
+const int Captures = 50;
+
+uint64_t work(uint64_t value)
+{
+    return value * 6364136223846793005ull + 1442695040888963407ull;
+}
+
+// TraceScope is used directly so the benchmark measures the spans whether or
+// not the engine was built with ENGINE_TRACING; the empty loop stands for
+// spans compiled out.
+double measure(bool trace, bool capture)
+{
+    Tracer& tracer = Tracer::instance();
+    uint64_t value = 1;
+    double seconds = 0.0;
+    for (int i = 0; i < Captures; i++) {
+        if (capture) {
+            tracer.start();
+        }
+        BenchmarkTimer timer;
+        for (size_t span = 0; span < SpansPerCapture; span++) {
+            if (trace) {
+                TraceScope scope("span");
+                value = work(value);
+            } else {
+                value = work(value);
+            }
+            doNotOptimize(value);
+        }
+        seconds += timer.elapsedSeconds();
+        if (capture) {
+            tracer.stop();
+        }
+    }
+    return seconds * 1e9 / static_cast<double>(SpansPerCapture * Captures);
+}
+
+// Spans from several threads at once; every thread has its own buffer, so
+// they should cost the same as on one thread.
+double measureThreads(unsigned threadCount)
+{
+    Tracer& tracer = Tracer::instance();
+    tracer.start();
+    BenchmarkTimer timer;
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; t++) {
+        threads.emplace_back([] {
+            uint64_t value = 1;
+            for (size_t span = 0; span < SpansPerCapture; span++) {
+                TraceScope scope("span");
+                value = work(value);
+                doNotOptimize(value);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = timer.elapsedSeconds();
+    tracer.stop();
+    return seconds * 1e9 / static_cast<double>(SpansPerCapture);
+}
+}
+
+int main()
+{
+    Tracer::instance().setThreadName("main");
+    measure(true, true);
+
+    std::printf("%-28s %10s\n", "mode", "ns/span");
+    double empty = measure(false, false);
+    double idle = measure(true, false);
+    double capturing = measure(true, true);
+    std::printf("%-28s %10.2f\n", "no span", empty);
+    std::printf("%-28s %10.2f\n", "span, not capturing", idle - empty);
+    std::printf("%-28s %10.2f\n", "span, capturing", capturing - empty);
+
+    unsigned threadCount = std::max(2u, std::thread::hardware_concurrency());
+    double threaded = measureThreads(threadCount);
+    char label[64];
+    std::snprintf(label, sizeof(label), "capturing, %u threads", threadCount);
+    std::printf("%-28s %10.2f\n", label, threaded / threadCount - empty);
+    std::printf("\n%zu spans, %llu dropped in the last capture\n", Tracer::instance().eventCount(), static_cast<unsigned long long>(Tracer::instance().droppedCount()));
+    return EXIT_SUCCESS;
+}
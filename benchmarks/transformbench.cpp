@@ -0,0 +1,107 @@
+#include "benchmark.h"
+#include "jobsystem.h"
+#include "transformhierarchy.h"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+const size_t NodeCounts[] = { 10000, 100000, 1000000 };
+const uint32_t MaxDepth = 8;
+const int Iterations = 10;
+
+struct Scene {
+    TransformHierarchy hierarchy;
+    std::vector<TransformHandle> handles;
+    std::vector<TransformHandle> roots;
+};
+
+void buildScene(Scene& scene, size_t count, std::mt19937& random)
+{
+    std::vector<uint32_t> depths;
+    scene.hierarchy.reserve(count);
+    scene.handles.reserve(count);
+    depths.reserve(count);
+
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    for (size_t i = 0; i < count; i++) {
+        TransformHandle parent = InvalidTransform;
+        uint32_t depth = 0;
+        if (i % 1000 != 0) {
+            size_t candidate = random() % i;
+            if (depths[candidate] < MaxDepth) {
+                parent = scene.handles[candidate];
+                depth = depths[candidate] + 1;
+            }
+        }
+        TransformHandle handle = scene.hierarchy.create(parent);
+        scene.hierarchy.setLocal(handle, glm::vec3(offset(random), offset(random), offset(random)), glm::angleAxis(offset(random), glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(1.0f));
+        scene.handles.push_back(handle);
+        depths.push_back(depth);
+        if (parent == InvalidTransform) {
+            scene.roots.push_back(handle);
+        }
+    }
+}
+
+void touchRoots(Scene& scene)
+{
+    for (TransformHandle root : scene.roots) {
+        scene.hierarchy.setScale(root, glm::vec3(1.0f));
+    }
+}
+
+void touchRandom(Scene& scene, size_t count, std::mt19937& random)
+{
+    for (size_t i = 0; i < count; i++) {
+        TransformHandle handle = scene.handles[random() % scene.handles.size()];
+        scene.hierarchy.setPosition(handle, glm::vec3(0.5f));
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 0;
+    JobSystem jobs(threads);
+    std::mt19937 random(1234);
+
+    std::printf("%9s %14s %14s %14s %12s\n", "nodes", "full ns/node", "1% dirty ms", "parallel ms", "updated");
+    for (size_t count : NodeCounts) {
+        Scene scene;
+        buildScene(scene, count, random);
+        scene.hierarchy.update();
+
+        BenchmarkTimer fullTimer;
+        for (int i = 0; i < Iterations; i++) {
+            touchRoots(scene);
+            scene.hierarchy.update();
+        }
+        double full = fullTimer.elapsedSeconds() / Iterations;
+
+        double partial = 0.0;
+        size_t updated = 0;
+        for (int i = 0; i < Iterations; i++) {
+            touchRandom(scene, count / 100, random);
+            BenchmarkTimer timer;
+            scene.hierarchy.update();
+            partial += timer.elapsedSeconds();
+            updated += scene.hierarchy.lastUpdatedCount();
+        }
+        partial /= Iterations;
+
+        scene.hierarchy.update(jobs);
+        BenchmarkTimer parallelTimer;
+        for (int i = 0; i < Iterations; i++) {
+            touchRoots(scene);
+            scene.hierarchy.update(jobs);
+        }
+        double parallel = parallelTimer.elapsedSeconds() / Iterations;
+        doNotOptimize(scene.hierarchy.world(scene.handles.back()));
+
+        std::printf("%9zu %14.2f %14.3f %14.3f %12zu\n", count, full * 1e9 / count, partial * 1000.0, parallel * 1000.0, updated / Iterations);
+    }
+    std::printf("workers: %u\n", jobs.workerCount());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,24 @@
+# Converts a SPIR-V binary into a header with a constexpr uint32_t array.
+# Usage: cmake -DINPUT=<file.spv> -DOUTPUT=<file.h> -DNAME=<symbol> -P EmbedSpirv.cmake
+# Without INPUT an empty placeholder is written, for optional shaders.
+
+if(NOT INPUT)
+    file(WRITE "${OUTPUT}" "// Placeholder, no SPIR-V was available at build time.\n#pragma once\n\n#include <cstddef>\n#include <cstdint>\n\nstatic constexpr const uint32_t* ${NAME} = nullptr;\nstatic constexpr size_t ${NAME}_size = 0;\n")
+    return()
+endif()
+
+file(READ "${INPUT}" hex HEX)
+string(LENGTH "${hex}" length)
+math(EXPR remainder "${length} % 8")
+if(length EQUAL 0 OR NOT remainder EQUAL 0)
+    message(FATAL_ERROR "${INPUT} is not a valid SPIR-V binary")
+endif()
+
+# SPIR-V words are little-endian; reorder each group of four bytes.
+string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1, " words "${hex}")
+set(word "0x[0-9a-f]+, ")
+string(REGEX REPLACE "(${word}${word}${word}${word}${word}${word}${word}${word})" "\\1\n    " words "${words}")
+string(REPLACE ", \n" ",\n" words "${words}")
+string(REGEX REPLACE ", $" "," words "${words}")
+
+file(WRITE "${OUTPUT}" "// Generated from ${INPUT}, do not edit.\n#pragma once\n\n#include <cstddef>\n#include <cstdint>\n\nstatic constexpr uint32_t ${NAME}[] = {\n    ${words}\n};\nstatic constexpr size_t ${NAME}_size = sizeof(${NAME});\n")
@@ -0,0 +1,46 @@
+# Runs the engine headless with --perf-check against a baseline for CTest.
+# Usage: cmake -DENGINE=<engine> -DBASELINE=<file>|-DRECORD=<file> -DFRAMES=<n> [-DOPTIONS="<engine options>"] -P PerfCheck.cmake
+# With RECORD a first run writes the baseline to that file with
+# --perf-record and a second run is checked against it, so timings and frame
+# hashes are compared on the same machine and driver.
+# Prints "Skipped:" and succeeds when there is no Vulkan driver or display to
+# run on; the test's SKIP_REGULAR_EXPRESSION turns that into a skipped test.
+
+set(icds)
+if(DEFINED ENV{VK_DRIVER_FILES} OR DEFINED ENV{VK_ICD_FILENAMES})
+    string(REPLACE ":" ";" listed "$ENV{VK_DRIVER_FILES}:$ENV{VK_ICD_FILENAMES}")
+    foreach(icd ${listed})
+        if(EXISTS "${icd}")
+            list(APPEND icds "${icd}")
+        endif()
+    endforeach()
+else()
+    file(GLOB icds "/etc/vulkan/icd.d/*.json" "/usr/local/share/vulkan/icd.d/*.json" "/usr/share/vulkan/icd.d/*.json")
+endif()
+if(NOT icds)
+    message("Skipped: no Vulkan ICD found")
+    return()
+endif()
+
+set(launcher)
+if("$ENV{DISPLAY}" STREQUAL "" AND "$ENV{WAYLAND_DISPLAY}" STREQUAL "")
+    find_program(XVFB_RUN xvfb-run)
+    if(NOT XVFB_RUN)
+        message("Skipped: no display and no xvfb-run")
+        return()
+    endif()
+    set(launcher "${XVFB_RUN}" -a)
+endif()
+
+separate_arguments(options UNIX_COMMAND "${OPTIONS}")
+if(NOT BASELINE)
+    set(BASELINE "${RECORD}")
+    execute_process(COMMAND ${launcher} "${ENGINE}" --frames=${FRAMES} --perf-record=${BASELINE} ${options} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Recording the perf baseline ${BASELINE} failed: ${result}")
+    endif()
+endif()
+execute_process(COMMAND ${launcher} "${ENGINE}" --frames=${FRAMES} --perf-check=${BASELINE} ${options} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Perf check against ${BASELINE} failed: ${result}")
+endif()
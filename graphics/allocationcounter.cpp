@@ -0,0 +1,100 @@
+#include "allocationcounter.h"
+
+#ifdef ENGINE_ALLOCATION_CHECK
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local uint64_t threadAllocations = 0;
+
+void* countedAllocate(size_t size)
+{
+    threadAllocations++;
+    return std::malloc(size ? size : 1);
+}
+}
+
+void* operator new(size_t size)
+{
+    void* memory = countedAllocate(size);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+bool allocationCountingEnabled()
+{
+    return true;
+}
+
+uint64_t threadAllocationCount()
+{
+    return threadAllocations;
+}
+#else
+bool allocationCountingEnabled()
+{
+    return false;
+}
+
+uint64_t threadAllocationCount()
+{
+    return 0;
+}
+#endif
+
+AllocationScope::AllocationScope()
+    : _start(threadAllocationCount())
+{
+}
+
+uint64_t AllocationScope::count() const
+{
+    return threadAllocationCount() - _start;
+}
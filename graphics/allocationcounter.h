@@ -0,0 +1,24 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// Heap allocations made through the global operator new on the calling
+// thread. Counting needs the ENGINE_ALLOCATION_CHECK build option, which
+// replaces the global operator new; otherwise the count stays at zero.
+// malloc from C code is not seen, but a driver written in C++ that calls
+// operator new from within a Vulkan call is counted like engine code.
+bool allocationCountingEnabled();
+uint64_t threadAllocationCount();
+
+// Allocations on the calling thread since construction.
+class AllocationScope {
+public:
+    AllocationScope();
+    uint64_t count() const;
+
+private:
+    uint64_t _start;
+};
+
+#endif // ALLOCATIONCOUNTER_H
@@ -2,119 +2,450 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstring>
 #include <fstream>
 #include <functional>
+#include <iomanip>
 #include <iostream>
+#include <random>
 #include <set>
-
-Application::Application()
+#include <sstream>
+
+Application::Application(const ApplicationSettings& settings)
+    : _settings(settings)
+    , _modelTransform(_transforms.create())
+    , _framePacer(settings.frameRateLimit)
+    , _redraw(settings.onDemandRedraw)
+    , _dynamicResolution(false)
+    , _blitFilter(vk::Filter::eLinear)
+    , _frameCapture(_jobSystem)
+    , _captureConsumer([this](const CapturedFrame& frame) { _frameCapture.consume(frame); })
+    , _frameIndex(0)
+    , _timeToFirstFrame(0.0)
+    , _uploadThroughput(0.0)
+    , _traceEndFrame(0)
+    , _tracesWritten(0)
+    , _sceneMaterial(0)
+    , _drawSortSeconds(0.0)
+    , _drawListsRecorded(0)
+    , _occlusionCulling(false)
+    , _pipelineFormat(vk::Format::eUndefined)
+    , _sceneMesh(InvalidMesh)
+    , _meshChurns(0)
+    , _multiDrawIndirect(false)
+    , _pipelineStatisticsQuery(false)
+    , _commandBuffersRecorded(0)
+    , _descriptorPoolSets(0)
+    , _offscreenAttachment(0)
 {
+    _resolutionScaler.configure(settings.gpuBudget, settings.minResolutionScale);
+    if (perfCheckEnabled()) {
+        // Hashes of a still scene are comparable between runs; reading back
+        // every frame would skew the frame times.
+        _settings.capture.keepHashes = true;
+        if (_settings.capture.directory.empty() && _settings.capture.stream.empty()) {
+            _settings.capture.interval = std::max(_settings.capture.interval, PerfCheckHashInterval);
+        }
+    }
+    _memoryTracker.setBudgetCallback(settings.memoryBudgetThreshold, [](const MemoryHeapStatus& heap) {
+        LOG_WARNING(LogCategory::Memory, "Memory heap %u is over budget: %llu of %llu bytes in use", heap.heap, static_cast<unsigned long long>(heap.usage), static_cast<unsigned long long>(heap.budget));
+    });
 }
 
 Application::~Application() {}
 
-void Application::run()
+bool Application::run()
 {
-    _window.init();
+    _runStart = std::chrono::steady_clock::now();
+    Tracer::instance().setThreadName("main");
+    if (_settings.traceStartup) {
+        startTrace();
+    }
+    if (!_frameCapture.open(_settings.capture)) {
+        std::abort();
+    }
+    if (!_settings.drawStreamPath.empty() && !_drawStream.open(_settings.drawStreamPath, sizeof(UniformBufferObject))) {
+        std::abort();
+    }
+    createViews();
     initVulkan();
     mainLoop();
     destroyVulkan();
-    _window.destroy();
+    for (const std::unique_ptr<View>& view : _views) {
+        view->window.destroy();
+    }
+    bool streamWritten = true;
+    if (_drawStream.isOpen()) {
+        streamWritten = _drawStream.close();
+        if (streamWritten) {
+            LOG_INFO(LogCategory::Capture, "Recorded %llu frames, %llu bytes to %s", static_cast<unsigned long long>(_drawStream.frameCount()), static_cast<unsigned long long>(_drawStream.bytesWritten()), _settings.drawStreamPath.c_str());
+        }
+    }
+    if (Tracer::instance().isCapturing()) {
+        finishTrace();
+    }
+    bool passed = finishPerfCheck();
+    return passed && streamWritten;
+}
+
+View& Application::primaryView()
+{
+    return *_views.front();
+}
+
+const View& Application::primaryView() const
+{
+    return *_views.front();
+}
+
+bool Application::isPrimaryView(const View& view) const
+{
+    return &view == _views.front().get();
+}
+
+uint32_t Application::viewIndex(const View& view) const
+{
+    uint32_t index = 0;
+    while (_views[index].get() != &view) {
+        index++;
+    }
+    return index;
+}
+
+// Compute passes are recorded into the primary view's command buffers only,
+// so their per-frame data has one slot per image of its swap chain.
+uint32_t Application::frameSlotCount() const
+{
+    return static_cast<uint32_t>(primaryView().images.size());
+}
+
+bool Application::anyWindowClosed()
+{
+    for (const std::unique_ptr<View>& view : _views) {
+        if (view->window.shouldBeClosed()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Application::createViews()
+{
+    uint32_t count = std::max(_settings.viewCount, 1u);
+    for (uint32_t i = 0; i < count; i++) {
+        std::unique_ptr<View> view(new View());
+        view->camera = orbitCamera(i, count);
+        view->window.init();
+        _views.push_back(std::move(view));
+    }
 }
 
 void Application::initVulkan()
 {
-    createInstance();
-    setupDebugCallback();
-    createSurface();
-    pickPhysicalDevice();
-    createLogicalDevice();
-    createSwapChain();
-    createImageViews();
-    createRenderPass();
-    createDescriptorSetLayout();
-    createGraphicsPipeline();
-    createCommandPool();
-    createDepthResources();
-    createFramebuffers();
-    createVertexBuffer();
-    createIndexBuffer();
-    createUniformBuffer();
-    createDescriptorPool();
-    createDescriptorSet();
-    createCommandBuffers();
-    createSemaphores();
-    updateUniformBuffer();
+    TRACE_SCOPE("initVulkan");
+    StartupGraph startup;
+    StartupStep instance = startup.addStep("createInstance", {}, [this]() { createInstance(); });
+    StartupStep debugCallback = startup.addStep("setupDebugCallback", { instance }, [this]() { setupDebugCallback(); });
+    StartupStep surface = startup.addStep("createSurface", { instance }, [this]() { createSurface(); });
+    StartupStep physicalDevice = startup.addStep("pickPhysicalDevice", { surface }, [this]() { pickPhysicalDevice(); });
+    StartupStep logicalDevice = startup.addStep("createLogicalDevice", { physicalDevice, debugCallback }, [this]() { createLogicalDevice(); });
+    StartupStep shaders = startup.addStep("loadShaders", {}, [this]() { loadShaders(); });
+
+    StartupStep swapChain = startup.addStep("createSwapChain", { logicalDevice }, [this]() { createSwapChain(); });
+    StartupStep imageViews = startup.addStep("createImageViews", { swapChain }, [this]() { createImageViews(); });
+    StartupStep gpuTimer = startup.addStep("createGpuTimer", { swapChain }, [this]() { createGpuTimer(); });
+    startup.addStep("createPipelineStatistics", { swapChain }, [this]() { createPipelineStatistics(); });
+    StartupStep culling = startup.addStep("configureOcclusionCulling", { gpuTimer, shaders }, [this]() { configureOcclusionCulling(); });
+    StartupStep renderPass = startup.addStep("createRenderPass", { culling }, [this]() { createRenderPass(); });
+    StartupStep descriptorSetLayout = startup.addStep("createDescriptorSetLayout", { logicalDevice }, [this]() { createDescriptorSetLayout(); });
+    StartupStep materials = startup.addStep("createMaterials", { logicalDevice, shaders, descriptorSetLayout }, [this]() { createMaterials(); });
+    StartupStep pipeline = startup.addStep("createGraphicsPipeline", { renderPass, materials }, [this]() { createGraphicsPipeline(); });
+    StartupStep commandPool = startup.addStep("createCommandPool", { logicalDevice }, [this]() { createCommandPool(); });
+    StartupStep attachments = startup.addStep("createAttachments", { culling }, [this]() { createAttachments(); });
+    StartupStep geometry = startup.addStep("createGeometry", { logicalDevice }, [this]() { createGeometry(); });
+    StartupStep particles = startup.addStep("createParticles", { logicalDevice, shaders, swapChain }, [this]() { createParticles(); });
+    StartupStep particlePipeline = startup.addStep("createParticlePipeline", { renderPass, descriptorSetLayout, particles }, [this]() {
+        if (_particles.isInitialized()) {
+            _particles.createRenderPipeline(_renderPass, _descriptorSetLayout);
+        }
+    });
+    StartupStep objects = startup.addStep("createObjects", { logicalDevice, shaders, geometry, swapChain }, [this]() { createObjects(); });
+    StartupStep objectPipeline = startup.addStep("createObjectPipeline", { renderPass, descriptorSetLayout, objects }, [this]() { createObjectPipeline(); });
+    StartupStep depthPyramid = startup.addStep("createDepthPyramid", { attachments, objects }, [this]() { createDepthPyramid(); });
+    StartupStep lights = startup.addStep("createLights", { logicalDevice, shaders, swapChain }, [this]() { createLights(); });
+    StartupStep lightPipeline = startup.addStep("createLightPipeline", { renderPass, descriptorSetLayout, lights }, [this]() { createLightPipeline(); });
+    StartupStep uploads = startup.addStep("submitUploads", { commandPool, geometry, particles, objects, materials }, [this]() { submitUploads(); });
+    StartupStep framebuffers = startup.addStep("createFramebuffers", { imageViews, renderPass, attachments }, [this]() { createFramebuffers(); });
+    StartupStep uniformBuffers = startup.addStep("createUniformBuffers", { swapChain }, [this]() { createUniformBuffers(); });
+    StartupStep descriptorPool = startup.addStep("createDescriptorPool", { logicalDevice, swapChain }, [this]() { createDescriptorPool(); });
+    StartupStep descriptorSets = startup.addStep("createDescriptorSets", { descriptorPool, descriptorSetLayout, uniformBuffers }, [this]() { createDescriptorSets(); });
+    StartupStep commandBuffers = startup.addStep("createCommandBuffers", { framebuffers, pipeline, particlePipeline, objectPipeline, depthPyramid, lightPipeline, descriptorSets, uploads }, [this]() { createCommandBuffers(); });
+    StartupStep semaphores = startup.addStep("createSemaphores", { commandBuffers }, [this]() { createSemaphores(); });
+    StartupStep readback = startup.addStep("createFrameReadback", { swapChain }, [this]() { createFrameReadback(); });
+    startup.addStep("updateScene", { semaphores, readback }, [this]() { updateScene(); });
+
+    startup.run(_jobSystem);
+    startup.report(std::cerr);
 }
 
 void Application::mainLoop()
 {
-    while (!_window.shouldBeClosed()) {
-        _window.pollEvents();
-        updateUniformBuffer();
+    // On demand the scene starts still; space toggles the animation. A perf
+    // check keeps it still so frame hashes are reproducible. Pausing before
+    // the thread starts keeps it from running a first tick.
+    _simulation.setPaused(_redraw.isOnDemand() || perfCheckEnabled());
+    _simulation.start();
+    std::chrono::steady_clock::time_point loopStart = std::chrono::steady_clock::now();
+    while (!anyWindowClosed() && (_settings.frameCount == 0 || _frameIndex < _settings.frameCount)) {
+        handleWindowEvents();
+        if (!_redraw.shouldDraw()) {
+            TRACE_SCOPE("idle");
+            _redraw.beginIdle();
+            primaryView().window.waitEvents(_redraw.idleTimeout());
+            _redraw.endIdle();
+            _frameStats.markIdle();
+            continue;
+        }
+        {
+            TRACE_SCOPE("frame pacing");
+            _framePacer.wait();
+        }
+        _frameStats.beginFrame();
+        for (const std::unique_ptr<View>& view : _views) {
+            view->window.pollEvents();
+        }
+        handleWindowEvents();
+        _redraw.frameStarted();
+        updateScene();
         drawFrame();
+        _frameStats.endFrame();
+        if (_settings.meshChurnInterval != 0 && !_staticMeshes.empty() && _frameIndex / _settings.meshChurnInterval > _meshChurns) {
+            churnMeshes();
+        }
+        if (Tracer::instance().isCapturing() && _frameIndex >= _traceEndFrame) {
+            finishTrace();
+        }
+        if (_frameIndex % MemoryBudgetCheckInterval == 0) {
+            _memoryTracker.checkBudget();
+        }
+        if (_settings.memoryReportInterval != 0 && _frameIndex % _settings.memoryReportInterval == 0) {
+            _memoryTracker.dump(std::cerr);
+        }
+    }
+    _simulation.stop();
+    double loopSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loopStart).count();
+    if (perfCheckEnabled()) {
+        // The frames are done with the queue the uploads go through.
+        _device.waitIdle();
+        measureUploadThroughput();
+    }
+
+    std::ostringstream label;
+    label << vk::to_string(primaryView().presentMode) << ", " << primaryView().images.size() << " images, limit " << _settings.frameRateLimit << " fps";
+    if (_views.size() > 1) {
+        label << ", " << _views.size() << " views";
+    }
+    if (_lighting.isInitialized()) {
+        label << ", " << _lighting.lightCount() << " lights";
+    }
+    _frameStats.report(std::cerr, label.str());
+    _pipelineStatistics.report(std::cerr);
+    _resolutionScaler.report(std::cerr);
+    _particles.report(std::cerr, loopSeconds);
+    _culler.report(std::cerr);
+    _lighting.report(std::cerr);
+    _materials.report(std::cerr);
+    _redraw.report(std::cerr, loopSeconds);
+    _geometry.report(std::cerr, _commandBuffersRecorded);
+    if (_resizeTimes.count() > 0) {
+        std::cerr << std::fixed << std::setprecision(3);
+        std::cerr << "  swap chain recreated " << _resizeTimes.count() << " times, ms: mean " << _resizeTimes.mean() << " max " << _resizeTimes.max() << std::endl;
+        std::cerr.unsetf(std::ios::floatfield);
+    }
+    reportFrameArenas(std::cerr, _frameArenas);
+    if (_drawListsRecorded > 0) {
+        double lists = static_cast<double>(_drawListsRecorded);
+        std::cerr << std::fixed << std::setprecision(1);
+        std::cerr << "  draw lists: " << _drawListsRecorded << " recorded, per list " << _drawStats.draws / lists << " draws, " << _drawStats.binds() / lists << " binds ("
+                  << _drawStats.pipelineBinds / lists << " pipeline, " << _drawStats.descriptorSetBinds / lists << " descriptor set, " << (_drawStats.vertexBufferBinds + _drawStats.indexBufferBinds) / lists
+                  << " buffer), sort " << std::setprecision(3) << _drawSortSeconds * 1e6 / lists << " us" << std::endl;
+        std::cerr.unsetf(std::ios::floatfield);
     }
 }
 
-void Application::destroyVulkan()
+bool Application::perfCheckEnabled() const
 {
-    _graphicsQueue.waitIdle();
-    _presentQueue.waitIdle();
-    for (const vk::Fence& fence : _waitFences) {
-        _device.destroyFence(fence);
+    return !_settings.perfBaseline.empty() || !_settings.perfRecord.empty();
+}
+
+// The startup uploads are too small and too few to say much about
+// throughput, so a perf check stages a known amount into a scratch buffer.
+void Application::measureUploadThroughput()
+{
+    TRACE_SCOPE("measureUploadThroughput");
+    vk::Buffer buffer;
+    vk::DeviceMemory memory;
+    createBuffer(_device, _physicalDevice, _memoryTracker, MemoryCategory::Storage, PerfCheckUploadBytes, vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, buffer, memory);
+    std::vector<uint8_t> data(PerfCheckUploadChunk);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 31);
+    }
+
+    uint64_t bytes = _uploads.uploadedBytes();
+    double seconds = _uploads.uploadSeconds();
+    for (vk::DeviceSize offset = 0; offset < PerfCheckUploadBytes; offset += PerfCheckUploadChunk) {
+        _uploads.uploadBuffer(data.data(), PerfCheckUploadChunk, buffer, offset);
+    }
+    _uploads.submit(_commandPool, _graphicsQueue);
+    bytes = _uploads.uploadedBytes() - bytes;
+    seconds = _uploads.uploadSeconds() - seconds;
+    if (seconds > 0.0) {
+        _uploadThroughput = static_cast<double>(bytes) / seconds / (1024.0 * 1024.0);
     }
 
-    for (const vk::Framebuffer& framebuffer : _swapChainFramebuffers) {
-        _device.destroyFramebuffer(framebuffer);
+    _device.destroyBuffer(buffer);
+    _memoryTracker.free(memory);
+}
+
+bool Application::finishPerfCheck()
+{
+    if (!perfCheckEnabled()) {
+        return true;
+    }
+    PerfCheck check;
+    check.record("init_ms", _timeToFirstFrame, false);
+    check.record("frame_p50_ms", _frameStats.percentileFrameTime(50.0), false);
+    check.record("frame_p99_ms", _frameStats.percentileFrameTime(99.0), false);
+    if (_uploadThroughput > 0.0) {
+        check.record("upload_mib_s", _uploadThroughput, true);
+    }
+    if (_resizeTimes.count() > 0) {
+        check.record("resize_ms", _resizeTimes.mean(), false);
     }
+    for (const std::pair<uint64_t, uint64_t>& hash : _frameCapture.hashes()) {
+        check.recordHash(hash.first, hash.second);
+    }
+
+    if (!_settings.perfRecord.empty() && !check.writeBaseline(_settings.perfRecord, PerfBaselineTolerance)) {
+        return false;
+    }
+    if (_settings.perfBaseline.empty()) {
+        return true;
+    }
+    return check.loadBaseline(_settings.perfBaseline) && check.compare(std::cerr);
+}
+
+void Application::startTrace()
+{
+#ifdef ENGINE_TRACING
+    Tracer::instance().start();
+    _traceEndFrame = _frameIndex + _settings.traceFrames;
+#else
+    LOG_WARNING(LogCategory::General, "Tracing is compiled out, configure with -DENGINE_TRACING=ON");
+#endif
+}
 
-    for (const vk::ImageView& imageview : _swapChainImageViews) {
-        _device.destroyImageView(imageview);
+void Application::finishTrace()
+{
+    Tracer& tracer = Tracer::instance();
+    tracer.stop();
+    // Later captures go next to the first one: trace.json, trace-1.json, ...
+    std::string path = _settings.tracePath;
+    if (_tracesWritten > 0) {
+        size_t extension = path.find_last_of('.');
+        size_t directory = path.find_last_of('/');
+        if (extension == std::string::npos || (directory != std::string::npos && extension < directory)) {
+            extension = path.size();
+        }
+        path.insert(extension, "-" + std::to_string(_tracesWritten));
     }
+    if (tracer.write(path)) {
+        LOG_INFO(LogCategory::General, "Wrote %zu trace events to %s, %llu dropped", tracer.eventCount(), path.c_str(), static_cast<unsigned long long>(tracer.droppedCount()));
+    }
+    _tracesWritten++;
+}
 
-    if (_commandBuffers.size() > 0) {
-        _device.freeCommandBuffers(_commandPool, static_cast<uint32_t>(_commandBuffers.size()), _commandBuffers.data());
+void Application::handleWindowEvents()
+{
+    for (const std::unique_ptr<View>& view : _views) {
+        if (view->window.takePauseRequest()) {
+            _simulation.setPaused(!_simulation.isPaused());
+        }
+        if (view->window.takeTraceRequest() && !Tracer::instance().isCapturing()) {
+            startTrace();
+        }
+        if (view->window.takeDamage()) {
+            _redraw.invalidate();
+        }
     }
+    _redraw.setAnimating(!_simulation.isPaused());
+}
 
-    _device.destroySemaphore(_imageAvailableSemaphore);
-    _device.destroySemaphore(_renderFinishedSemaphore);
+void Application::destroyVulkan()
+{
+    _graphicsQueue.waitIdle();
+    _presentQueue.waitIdle();
+    if (_frameReadback.isInitialized()) {
+        _frameReadback.collect(true, _captureConsumer);
+        _frameReadback.destroy();
+    }
+    _frameCapture.close();
+    _frameCapture.report(std::cerr, _frameReadback);
 
-    _device.destroyBuffer(_vertexBuffer);
-    _device.destroyBuffer(_indexBuffer);
-    _device.destroyBuffer(_uniformStagingBuffer);
-    _device.destroyBuffer(_uniformBuffer);
-    _device.destroyImage(_depthImage);
+    destroyFrameFences();
 
-    _device.freeMemory(_vertexBufferMemory);
-    _device.freeMemory(_indexBufferMemory);
-    _device.freeMemory(_uniformStagingBufferMemory);
-    _device.freeMemory(_uniformBufferMemory);
-    _device.freeMemory(_depthImageMemory);
-    _device.destroyImageView(_depthImageView);
+    for (const std::unique_ptr<View>& view : _views) {
+        for (const vk::Framebuffer& framebuffer : view->framebuffers) {
+            _device.destroyFramebuffer(framebuffer);
+        }
+        for (const vk::ImageView& imageview : view->imageViews) {
+            _device.destroyImageView(imageview);
+        }
+        if (view->commandBuffers.size() > 0) {
+            _device.freeCommandBuffers(_commandPool, static_cast<uint32_t>(view->commandBuffers.size()), view->commandBuffers.data());
+        }
+        _device.destroySemaphore(view->imageAvailableSemaphore);
+        _device.destroySemaphore(view->renderFinishedSemaphore);
+        destroyUniformBuffer(*view);
+        _device.destroySwapchainKHR(view->swapChain);
+    }
+    _device.destroyFramebuffer(_offscreenFramebuffer);
+    _gpuTimer.destroy();
+    _pipelineStatistics.destroy();
+    _attachments.report(std::cerr);
+    _memoryTracker.dump(std::cerr);
+    _attachments.destroy();
+    _particles.destroy();
+    _culler.destroy();
+    _lighting.destroy();
+
+    _geometry.destroy();
+    if (_staticDrawBuffer) {
+        _device.destroyBuffer(_staticDrawBuffer);
+        _memoryTracker.free(_staticDrawMemory);
+    }
 
     _device.destroyDescriptorSetLayout(_descriptorSetLayout);
     _device.destroyDescriptorPool(_descriptorPool);
 
     _device.destroyCommandPool(_commandPool);
 
-    _device.destroyShaderModule(_vertShaderModule);
-    _device.destroyShaderModule(_fragShaderModule);
+    _materials.destroy();
     _device.destroyPipelineCache(_cache);
-    _device.destroyPipelineLayout(_pipelineLayout);
-    _device.destroyPipeline(_graphicsPipeline);
 
-    _device.destroyRenderPass(_renderPass);
-    _device.destroySwapchainKHR(_swapChain);
+    destroyRenderPasses();
     _device.destroy();
     DestroyDebugReportCallbackEXT(_instance, _callback, nullptr);
-    _instance.destroySurfaceKHR(_surface);
+    for (const std::unique_ptr<View>& view : _views) {
+        _instance.destroySurfaceKHR(view->surface);
+    }
     _instance.destroy();
 }
 
 void Application::createInstance()
 {
-    std::cerr << "Creating instance..." << std::endl;
+    LOG_INFO(LogCategory::Startup, "Creating instance...");
     if (enableValidationLayers && !checkValidationLayerSupport()) {
         std::cerr << "validation layers requested, but not available!" << std::endl;
         std::abort();
@@ -130,7 +461,9 @@ void Application::createInstance()
     vk::InstanceCreateInfo createInfo;
     createInfo.pApplicationInfo = &appInfo;
 
-    const std::vector<const char*>& extensions = _window.getRequiredExtensions(enableValidationLayers);
+    std::vector<const char*> extensions = primaryView().window.getRequiredExtensions(enableValidationLayers);
+    std::vector<const char*> trackerExtensions = _memoryTracker.requestInstanceExtensions();
+    extensions.insert(extensions.end(), trackerExtensions.begin(), trackerExtensions.end());
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -152,7 +485,7 @@ void Application::createInstance()
 void Application::setupDebugCallback()
 {
     if (enableValidationLayers) {
-        std::cerr << "Setting up callbacks..." << std::endl;
+        LOG_INFO(LogCategory::Startup, "Setting up callbacks...");
         vk::DebugReportCallbackCreateInfoEXT createInfo;
         createInfo.flags = vk::DebugReportFlagBitsEXT::eError | vk::DebugReportFlagBitsEXT::eWarning;
         createInfo.pfnCallback = debugCallback;
@@ -163,23 +496,25 @@ void Application::setupDebugCallback()
             std::abort();
         }
     } else {
-        std::cerr << "No callbacks..." << std::endl;
+        LOG_INFO(LogCategory::Startup, "No callbacks...");
     }
 }
 
 void Application::createSurface()
 {
-    std::cerr << "Creating surface..." << std::endl;
-    vk::Result res = _window.createSurface(_instance, _surface);
-    if (res != vk::Result::eSuccess) {
-        std::cerr << "Failed to create surface! error:" << res << std::endl;
-        std::abort();
+    LOG_INFO(LogCategory::Startup, "Creating surface...");
+    for (const std::unique_ptr<View>& view : _views) {
+        vk::Result res = view->window.createSurface(_instance, view->surface);
+        if (res != vk::Result::eSuccess) {
+            std::cerr << "Failed to create surface! error:" << res << std::endl;
+            std::abort();
+        }
     }
 }
 
 void Application::pickPhysicalDevice()
 {
-    std::cerr << "Picking physical device..." << std::endl;
+    LOG_INFO(LogCategory::Startup, "Picking physical device...");
     uint32_t deviceCount = 0;
     _instance.enumeratePhysicalDevices(&deviceCount, nullptr);
 
@@ -193,7 +528,7 @@ void Application::pickPhysicalDevice()
 
     for (const auto& device : devices) {
         _physicalDevice = device;
-        _queueFamilyIndices = findQueueFamilies(_physicalDevice, _surface);
+        _queueFamilyIndices = findQueueFamilies(_physicalDevice, primaryView().surface);
     }
 
     if (_physicalDevice.operator VkPhysicalDevice_T*() == VK_NULL_HANDLE) {
@@ -204,7 +539,7 @@ void Application::pickPhysicalDevice()
 
 void Application::createLogicalDevice()
 {
-    std::cerr << "Creating logical device..." << std::endl;
+    LOG_INFO(LogCategory::Startup, "Creating logical device...");
 
     std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
     std::set<int> uniqueQueueFamilies = { _queueFamilyIndices.graphicsFamily, _queueFamilyIndices.presentFamily };
@@ -218,14 +553,29 @@ void Application::createLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    vk::PhysicalDeviceFeatures supportedFeatures;
+    _physicalDevice.getFeatures(&supportedFeatures);
     vk::PhysicalDeviceFeatures deviceFeatures;
+    // Lets the geometry pool draw all static meshes with one indirect call.
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    _multiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+    if (_settings.pipelineStatistics) {
+        deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+        _pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+        if (!_pipelineStatisticsQuery) {
+            LOG_WARNING(LogCategory::Startup, "Pipeline statistics queries are not supported, --pipeline-stats disabled");
+        }
+    }
     vk::DeviceCreateInfo createInfo = {};
 
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    std::vector<const char*> extensions = deviceExtensions;
+    std::vector<const char*> trackerExtensions = _memoryTracker.requestDeviceExtensions(_physicalDevice);
+    extensions.insert(extensions.end(), trackerExtensions.begin(), trackerExtensions.end());
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     if (enableValidationLayers) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -240,30 +590,73 @@ void Application::createLogicalDevice()
     }
     _device.getQueue(static_cast<uint32_t>(_queueFamilyIndices.graphicsFamily), 0, &_graphicsQueue);
     _device.getQueue(static_cast<uint32_t>(_queueFamilyIndices.presentFamily), 0, &_presentQueue);
+    _memoryTracker.init(_instance, _physicalDevice, _device);
+    _uploads.init(_device, _physicalDevice, _memoryTracker);
+    _attachments.init(_device, _physicalDevice, _memoryTracker);
 }
 
 void Application::createSwapChain()
 {
-    std::cerr << "Creating swap chain..." << std::endl;
-    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(_physicalDevice, _surface);
+    for (const std::unique_ptr<View>& view : _views) {
+        createSwapChain(*view);
+    }
+}
+
+void Application::createSwapChain(View& view)
+{
+    LOG_INFO(LogCategory::Startup, "Creating swap chain...");
+    vk::Bool32 presentSupport = VK_FALSE;
+    _physicalDevice.getSurfaceSupportKHR(static_cast<uint32_t>(_queueFamilyIndices.presentFamily), view.surface, &presentSupport);
+    if (!presentSupport) {
+        std::cerr << "Present queue cannot present to every view!" << std::endl;
+        std::abort();
+    }
+    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(_physicalDevice, view.surface);
 
     vk::SurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-    vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
-    vk::Extent2D extent = chooseSwapExtent(swapChainSupport.capabilities, _window.width(), _window.height());
+    vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes, _settings.presentMode);
+    vk::Extent2D extent = chooseSwapExtent(swapChainSupport.capabilities, view.window.width(), view.window.height());
+    uint32_t imageCount = chooseSwapImageCount(swapChainSupport.capabilities, _settings.swapchainImages);
 
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-    if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
-        imageCount = swapChainSupport.capabilities.maxImageCount;
+    // All views share the render pass and pipelines, so they need one color format.
+    if (!isPrimaryView(view) && surfaceFormat.format != primaryView().format) {
+        std::cerr << "Views must share a surface format, got " << vk::to_string(surfaceFormat.format) << " and " << vk::to_string(primaryView().format) << std::endl;
+        std::abort();
     }
 
     vk::SwapchainCreateInfoKHR createInfo = {};
-    createInfo.surface = _surface;
+    createInfo.surface = view.surface;
     createInfo.minImageCount = imageCount;
     createInfo.imageFormat = surfaceFormat.format;
     createInfo.imageColorSpace = surfaceFormat.colorSpace;
     createInfo.imageExtent = extent;
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = vk::ImageUsageFlagBits::eColorAttachment;
+    if (isPrimaryView(view) && _frameCapture.isEnabled()) {
+        if (swapChainSupport.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferSrc) {
+            createInfo.imageUsage |= vk::ImageUsageFlagBits::eTransferSrc;
+        } else {
+            LOG_WARNING(LogCategory::Capture, "Swap chain images cannot be copied, frame capture disabled");
+            _frameCapture.disable();
+        }
+    }
+
+    if (isPrimaryView(view)) {
+        _dynamicResolution = false;
+    }
+    if (isPrimaryView(view) && _resolutionScaler.isEnabled()) {
+        vk::FormatProperties formatProperties;
+        _physicalDevice.getFormatProperties(surfaceFormat.format, &formatProperties);
+        vk::FormatFeatureFlags blitFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst;
+        if ((formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures && (swapChainSupport.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferDst)) {
+            createInfo.imageUsage |= vk::ImageUsageFlagBits::eTransferDst;
+            _blitFilter = (formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear) ? vk::Filter::eLinear : vk::Filter::eNearest;
+            _dynamicResolution = true;
+        } else {
+            LOG_WARNING(LogCategory::Render, "Swap chain images cannot be blitted to, dynamic resolution disabled");
+            _resolutionScaler.configure(0.0, 1.0);
+        }
+    }
 
     uint32_t queueFamilyIndices[] = { static_cast<uint32_t>(_queueFamilyIndices.graphicsFamily), static_cast<uint32_t>(_queueFamilyIndices.presentFamily) };
 
@@ -289,49 +682,110 @@ void Application::createSwapChain()
         std::abort();
     }
     _device.waitIdle();
-    _swapChain = newSwapChain;
-    _device.getSwapchainImagesKHR(_swapChain, &imageCount, nullptr);
-    _swapChainImages.clear();
-    _swapChainImages.resize(imageCount);
-    _device.getSwapchainImagesKHR(_swapChain, &imageCount, _swapChainImages.data());
-    _swapChainImageFormat = surfaceFormat.format;
-    _swapChainExtent = extent;
-    assert(_swapChainExtent.height != 0);
+    view.swapChain = newSwapChain;
+    _device.getSwapchainImagesKHR(view.swapChain, &imageCount, nullptr);
+    view.images.clear();
+    view.images.resize(imageCount);
+    _device.getSwapchainImagesKHR(view.swapChain, &imageCount, view.images.data());
+    view.imageFences.assign(imageCount, vk::Fence());
+    view.format = surfaceFormat.format;
+    view.extent = extent;
+    view.presentMode = presentMode;
+    assert(view.extent.height != 0);
+    _drawStream.view(viewIndex(view), imageCount, extent.width, extent.height);
 }
 
 void Application::createImageViews()
 {
-    std::cerr << "Creating image views..." << std::endl;
-    _swapChainImageViews.resize(_swapChainImages.size());
+    LOG_INFO(LogCategory::Startup, "Creating image views...");
+    for (const std::unique_ptr<View>& view : _views) {
+        view->imageViews.resize(view->images.size());
 
-    size_t size = _swapChainImages.size();
-    for (size_t i = 0; i < size; i++) {
-        createImageView(_swapChainImages[i], _swapChainImageFormat, vk::ImageAspectFlagBits::eColor, _swapChainImageViews[i]);
+        size_t size = view->images.size();
+        for (size_t i = 0; i < size; i++) {
+            createImageView(view->images[i], view->format, vk::ImageAspectFlagBits::eColor, view->imageViews[i]);
+        }
     }
 }
 
 void Application::createRenderPass()
 {
-    std::cerr << "Creating render pass..." << std::endl;
+    LOG_INFO(LogCategory::Startup, "Creating render pass...");
+    RenderPassSetup present;
+    _lateRenderPass = vk::RenderPass();
+    if (_occlusionCulling) {
+        // The primary view draws last frame's visible objects, builds the depth
+        // pyramid from the stored depth and draws the rest in a second pass.
+        // The depth attachment is shared between frames, so the early pass
+        // also waits for the previous pyramid build and late pass.
+        RenderPassSetup early;
+        early.colorFinalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+        early.depthFinalLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+        early.depthStoreOp = vk::AttachmentStoreOp::eStore;
+        early.srcStages = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eComputeShader;
+        early.srcAccess = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+        early.dstStages = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eColorAttachmentOutput;
+        createRenderPass(early, _renderPass);
+
+        RenderPassSetup late;
+        late.loadOp = vk::AttachmentLoadOp::eLoad;
+        late.colorInitialLayout = vk::ImageLayout::eColorAttachmentOptimal;
+        late.depthInitialLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+        late.srcStages = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eComputeShader;
+        createRenderPass(late, _lateRenderPass);
+        createRenderPass(present, _presentRenderPass);
+        return;
+    }
+    if (!_dynamicResolution) {
+        createRenderPass(present, _renderPass);
+        _presentRenderPass = _renderPass;
+        return;
+    }
+    // The offscreen target is shared between frames; wait for the previous upscale to read it.
+    RenderPassSetup offscreen;
+    offscreen.colorFinalLayout = vk::ImageLayout::eTransferSrcOptimal;
+    offscreen.srcStages = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eTransfer;
+    createRenderPass(offscreen, _renderPass);
+    _presentRenderPass = _renderPass;
+    if (_views.size() > 1) {
+        // Only the primary view is upscaled, the others render straight into their swap chains.
+        // Both passes are compatible, so the pipelines work with either.
+        createRenderPass(present, _presentRenderPass);
+    }
+}
+
+void Application::destroyRenderPasses()
+{
+    if (_lateRenderPass) {
+        _device.destroyRenderPass(_lateRenderPass);
+    }
+    if (_presentRenderPass != _renderPass) {
+        _device.destroyRenderPass(_presentRenderPass);
+    }
+    _device.destroyRenderPass(_renderPass);
+}
+
+void Application::createRenderPass(const RenderPassSetup& setup, vk::RenderPass& renderPass)
+{
     vk::AttachmentDescription colorAttachment;
-    colorAttachment.format = _swapChainImageFormat;
+    colorAttachment.format = primaryView().format;
     colorAttachment.samples = vk::SampleCountFlagBits::e1;
-    colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    colorAttachment.loadOp = setup.loadOp;
     colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
     colorAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
     colorAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-    colorAttachment.initialLayout = vk::ImageLayout::eUndefined;
-    colorAttachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+    colorAttachment.initialLayout = setup.colorInitialLayout;
+    colorAttachment.finalLayout = setup.colorFinalLayout;
 
     vk::AttachmentDescription depthAttachment;
     depthAttachment.format = findDepthFormat(_physicalDevice);
     depthAttachment.samples = vk::SampleCountFlagBits::e1;
-    depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
-    depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+    depthAttachment.loadOp = setup.loadOp;
+    depthAttachment.storeOp = setup.depthStoreOp;
     depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
     depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-    depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
-    depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+    depthAttachment.initialLayout = setup.depthInitialLayout;
+    depthAttachment.finalLayout = setup.depthFinalLayout;
 
     vk::AttachmentReference colorAttachmentRef(0, vk::ImageLayout::eColorAttachmentOptimal);
     vk::AttachmentReference depthAttachmentRef(1, vk::ImageLayout::eDepthStencilAttachmentOptimal);
@@ -342,12 +796,23 @@ void Application::createRenderPass()
     subpass.pColorAttachments = &colorAttachmentRef;
     subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-    vk::SubpassDependency dependency;
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+    std::vector<vk::SubpassDependency> dependencies(1);
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = setup.srcStages;
+    dependencies[0].srcAccessMask = setup.srcAccess;
+    dependencies[0].dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+    dependencies[0].dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+    if (setup.dstStages) {
+        vk::SubpassDependency outgoing;
+        outgoing.srcSubpass = 0;
+        outgoing.dstSubpass = VK_SUBPASS_EXTERNAL;
+        outgoing.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests;
+        outgoing.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+        outgoing.dstStageMask = setup.dstStages;
+        outgoing.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+        dependencies.push_back(outgoing);
+    }
     std::array<vk::AttachmentDescription, 2> attachments = { { colorAttachment, depthAttachment } };
 
     vk::RenderPassCreateInfo renderPassInfo;
@@ -355,146 +820,158 @@ void Application::createRenderPass()
     renderPassInfo.pAttachments = attachments.data();
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
 
-    vk::Result res = _device.createRenderPass(&renderPassInfo, nullptr, &_renderPass);
+    vk::Result res = _device.createRenderPass(&renderPassInfo, nullptr, &renderPass);
     if (res != vk::Result::eSuccess) {
         std::cerr << "Failed to create render pass! error:" << res << std::endl;
         std::abort();
     }
 }
 
-void Application::createGraphicsPipeline()
+void Application::loadShaders()
 {
-    std::cerr << "Creating graphics pipeline..." << std::endl;
-
-    // Copy shaders directory from repo or change working directory
-    const auto vertShaderCode = readFile("shaders/vert.spv");
-    const auto fragShaderCode = readFile("shaders/frag.spv");
-
-    std::cerr << "Creating vertex shader..." << std::endl;
-    createShaderModule(_device, vertShaderCode, _vertShaderModule);
-    std::cerr << "Creating fragment shader..." << std::endl;
-    createShaderModule(_device, fragShaderCode, _fragShaderModule);
-    std::cerr << "Shaders created!" << std::endl;
-
-    vk::PipelineShaderStageCreateInfo vertShaderStageInfo;
-    vertShaderStageInfo.stage = vk::ShaderStageFlagBits::eVertex;
-    vertShaderStageInfo.module = _vertShaderModule;
-    vertShaderStageInfo.pName = "main";
-
-    vk::PipelineShaderStageCreateInfo fragShaderStageInfo;
-    fragShaderStageInfo.stage = vk::ShaderStageFlagBits::eFragment;
-    fragShaderStageInfo.module = _fragShaderModule;
-    fragShaderStageInfo.pName = "main";
-
-    vk::PipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-    vk::PipelineInputAssemblyStateCreateInfo inputAssembly(vk::PipelineInputAssemblyStateCreateFlags(), vk::PrimitiveTopology::eTriangleList, VK_FALSE);
-
-    vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(_swapChainExtent.width), static_cast<float>(_swapChainExtent.height), 0.0f, 1.0f);
-
-    vk::Rect2D scissor(vk::Offset2D(0, 0), _swapChainExtent);
-
-    vk::PipelineViewportStateCreateInfo viewportState;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    vk::PipelineTessellationStateCreateInfo tesselationState;
-
-    vk::PipelineRasterizationStateCreateInfo rasterizer;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = vk::PolygonMode::eFill;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = vk::CullModeFlagBits::eBack;
-    rasterizer.frontFace = vk::FrontFace::eCounterClockwise;
-    rasterizer.depthBiasEnable = VK_FALSE;
-
-    vk::PipelineMultisampleStateCreateInfo multisampling;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-    vk::PipelineDepthStencilStateCreateInfo depthStencil(vk::PipelineDepthStencilStateCreateFlags(), VK_TRUE, VK_TRUE, vk::CompareOp::eLess, VK_FALSE, VK_FALSE);
-
-    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
-    colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-    colorBlendAttachment.blendEnable = VK_FALSE;
-
-    vk::PipelineColorBlendStateCreateInfo colorBlending(vk::PipelineColorBlendStateCreateFlags(), VK_FALSE, vk::LogicOp::eCopy, 1, &colorBlendAttachment, { { 0.0f, 0.0f, 0.0f, 0.0f } });
-
-    vk::DescriptorSetLayout setLayouts[] = { _descriptorSetLayout };
-    vk::PipelineLayoutCreateInfo pipelineLayoutInfo = {};
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    if (_settings.shaderDirectory.empty()) {
+        LOG_INFO(LogCategory::Startup, "Using embedded shaders");
+    } else {
+        LOG_INFO(LogCategory::Startup, "Loading shaders from %s...", _settings.shaderDirectory.c_str());
+    }
+    _vertShaderCode = loadShader(_settings.shaderDirectory, "vert", _vertShaderStorage);
+    _fragShaderCode = loadShader(_settings.shaderDirectory, "frag", _fragShaderStorage);
+    if (_settings.particleCount > 0 && !_particles.loadShaders(_settings.shaderDirectory)) {
+        LOG_WARNING(LogCategory::Startup, "Particle shaders are not available, build with glslangValidator or pass --shader-dir; particles disabled");
+        _settings.particleCount = 0;
+    }
+    if (_settings.objectCount > 0 && !_culler.loadShaders(_settings.shaderDirectory)) {
+        LOG_WARNING(LogCategory::Startup, "Object shaders are not available, build with glslangValidator or pass --shader-dir; objects disabled");
+        _settings.objectCount = 0;
+    }
+    if (_settings.lightCount > 0 && !_lighting.loadShaders(_settings.shaderDirectory)) {
+        LOG_WARNING(LogCategory::Startup, "Clustered lighting shaders are not available, build with glslangValidator or pass --shader-dir; lighting disabled");
+        _settings.lightCount = 0;
+    }
+    if (_settings.materialCount > 0 && !findShader(_settings.shaderDirectory, "material_frag", _materialShaderStorage, _materialShaderCode)) {
+        LOG_WARNING(LogCategory::Startup, "Material shader is not available, build with glslangValidator or pass --shader-dir; extra materials use the scene shader");
+    }
+}
 
-    vk::Result pipelineResult = _device.createPipelineLayout(&pipelineLayoutInfo, nullptr, &_pipelineLayout);
-    if (pipelineResult != vk::Result::eSuccess) {
-        std::cerr << "Failed to create pipeline layout! error:" << pipelineResult << std::endl;
-        std::abort();
+void Application::createMaterials()
+{
+    _materials.init(_device, _physicalDevice, _memoryTracker, _descriptorSetLayout);
+    _materials.addShader("vert", _vertShaderCode);
+    _materials.addShader("frag", _fragShaderCode);
+    if (_materialShaderCode.words) {
+        _materials.addShader("material_frag", _materialShaderCode);
     }
-    std::cerr << "Pipeline layout created!" << std::endl;
 
-    vk::GraphicsPipelineCreateInfo pipelineInfo(vk::PipelineCreateFlags(), 2, shaderStages, &vertexInputInfo, &inputAssembly, &tesselationState, &viewportState, &rasterizer, &multisampling, &depthStencil, &colorBlending, nullptr, _pipelineLayout, _renderPass, 0, vk::Pipeline(), 0);
+    MaterialDesc scene;
+    scene.name = "scene";
+    _sceneMaterial = _materials.create(scene);
+    _drawStream.material(_sceneMaterial, scene);
 
-    std::cerr << "Creating pipeline cache..." << std::endl;
-    vk::PipelineCacheCreateInfo cacheCreateInfo;
-    vk::Result cacheResult = _device.createPipelineCache(&cacheCreateInfo, nullptr, &_cache);
-    if (cacheResult != vk::Result::eSuccess) {
-        std::cerr << "Failed to create pipeline cache! error:" << cacheResult << std::endl;
-        std::abort();
+    // Synthetic materials only exercise registration and state deduplication;
+    // the scene is still drawn with its own material.
+    if (_settings.materialCount > 0) {
+        LOG_INFO(LogCategory::Startup, "Creating %u materials...", _settings.materialCount);
     }
-
-    vk::Result graphicsResult = _device.createGraphicsPipelines(_cache, 1, &pipelineInfo, nullptr, &_graphicsPipeline);
-    if (graphicsResult != vk::Result::eSuccess) {
-        std::cerr << "Failed to create graphics pipeline! error:" << graphicsResult << std::endl;
-        std::abort();
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (uint32_t i = 0; i < _settings.materialCount; i++) {
+        MaterialDesc desc;
+        desc.name = "material" + std::to_string(i);
+        if (_materials.hasShader("material_frag")) {
+            desc.state.fragmentShader = "material_frag";
+        }
+        uint32_t variant = random();
+        desc.state.cullMode = (variant & 1) ? vk::CullModeFlagBits::eNone : vk::CullModeFlagBits::eBack;
+        desc.state.blend = (variant & 2) != 0;
+        desc.state.depthWrite = !desc.state.blend;
+        desc.state.depthCompare = (variant & 4) ? vk::CompareOp::eLessOrEqual : vk::CompareOp::eLess;
+        for (int c = 0; c < 3; c++) {
+            desc.parameters.baseColor[c] = unit(random);
+            desc.parameters.emissive[c] = 0.1f * unit(random);
+        }
+        desc.parameters.baseColor[3] = desc.state.blend ? 0.5f : 1.0f;
+        _drawStream.material(_materials.create(desc), desc);
     }
-    std::cerr << "Graphics pipeline created!" << std::endl;
+    _materials.uploadParameters(_uploads);
+    _pipelineLayout = _materials.pipelineLayout();
 }
 
-void Application::createFramebuffers()
+void Application::createGraphicsPipeline()
 {
-    std::cerr << "Creating framebuffers..." << std::endl;
-    _swapChainFramebuffers.resize(_swapChainImageViews.size());
+    if (!_cache) {
+        LOG_INFO(LogCategory::Startup, "Creating pipeline cache...");
+        vk::PipelineCacheCreateInfo cacheCreateInfo;
+        vk::Result cacheResult = _device.createPipelineCache(&cacheCreateInfo, nullptr, &_cache);
+        if (cacheResult != vk::Result::eSuccess) {
+            std::cerr << "Failed to create pipeline cache! error:" << cacheResult << std::endl;
+            std::abort();
+        }
+    }
 
-    size_t size = _swapChainImageViews.size();
-    for (size_t i = 0; i < size; i++) {
-        std::array<vk::ImageView, 2> attachments = { { _swapChainImageViews[i], _depthImageView } };
+    LOG_INFO(LogCategory::Startup, "Creating %zu graphics pipelines for %zu materials...", _materials.pipelineCount(), _materials.materialCount());
+    _materials.createPipelines(_renderPass, _cache);
+    _graphicsPipeline = _materials.pipeline(_sceneMaterial);
+    _pipelineFormat = primaryView().format;
+    LOG_INFO(LogCategory::Startup, "Graphics pipelines created!");
+}
 
-        vk::FramebufferCreateInfo framebufferInfo;
-        framebufferInfo.renderPass = _renderPass;
-        framebufferInfo.attachmentCount = attachments.size();
-        framebufferInfo.pAttachments = attachments.data();
-        framebufferInfo.width = _swapChainExtent.width;
-        framebufferInfo.height = _swapChainExtent.height;
-        framebufferInfo.layers = 1;
+void Application::createFramebuffers()
+{
+    LOG_INFO(LogCategory::Startup, "Creating framebuffers...");
+    for (const std::unique_ptr<View>& view : _views) {
+        view->framebuffers.clear();
+        if (isPrimaryView(*view) && _dynamicResolution) {
+            std::array<vk::ImageView, 2> attachments = { { _attachments.view(_offscreenAttachment), _attachments.view(view->depthAttachment) } };
+
+            vk::FramebufferCreateInfo framebufferInfo;
+            framebufferInfo.renderPass = _renderPass;
+            framebufferInfo.attachmentCount = attachments.size();
+            framebufferInfo.pAttachments = attachments.data();
+            framebufferInfo.width = view->extent.width;
+            framebufferInfo.height = view->extent.height;
+            framebufferInfo.layers = 1;
+
+            vk::Result res = _device.createFramebuffer(&framebufferInfo, nullptr, &_offscreenFramebuffer);
+            if (res != vk::Result::eSuccess) {
+                std::cerr << "Failed to create offscreen framebuffer! error:" << res << std::endl;
+                std::abort();
+            }
+            continue;
+        }
 
-        vk::Result res = _device.createFramebuffer(&framebufferInfo, nullptr, &_swapChainFramebuffers[i]);
-        if (res != vk::Result::eSuccess) {
-            std::cerr << "Failed to create framebuffer! error:" << res << std::endl;
-            std::abort();
+        view->framebuffers.resize(view->imageViews.size());
+
+        size_t size = view->imageViews.size();
+        for (size_t i = 0; i < size; i++) {
+            std::array<vk::ImageView, 2> attachments = { { view->imageViews[i], _attachments.view(view->depthAttachment) } };
+
+            vk::FramebufferCreateInfo framebufferInfo;
+            framebufferInfo.renderPass = _presentRenderPass;
+            framebufferInfo.attachmentCount = attachments.size();
+            framebufferInfo.pAttachments = attachments.data();
+            framebufferInfo.width = view->extent.width;
+            framebufferInfo.height = view->extent.height;
+            framebufferInfo.layers = 1;
+
+            vk::Result res = _device.createFramebuffer(&framebufferInfo, nullptr, &view->framebuffers[i]);
+            if (res != vk::Result::eSuccess) {
+                std::cerr << "Failed to create framebuffer! error:" << res << std::endl;
+                std::abort();
+            }
         }
     }
 }
 
 void Application::createCommandPool()
 {
-    std::cerr << "Creating command pools..." << std::endl;
+    LOG_INFO(LogCategory::Startup, "Creating command pools...");
     vk::CommandPoolCreateInfo poolInfo;
     poolInfo.queueFamilyIndex = static_cast<uint32_t>(_queueFamilyIndices.graphicsFamily);
+    // Command buffers are re-recorded in place when the render resolution changes.
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
     vk::Result res = _device.createCommandPool(&poolInfo, nullptr, &_commandPool);
     if (res != vk::Result::eSuccess) {
         std::cerr << "Failed to create command pool! error:" << res << std::endl;
@@ -504,226 +981,810 @@ void Application::createCommandPool()
 
 void Application::createCommandBuffers()
 {
-    std::cerr << "Creating command buffers..." << std::endl;
-    if (_commandBuffers.size() > 0) {
-        _device.freeCommandBuffers(_commandPool, static_cast<uint32_t>(_commandBuffers.size()), _commandBuffers.data());
-    }
-    _commandBuffers.resize(_swapChainFramebuffers.size());
-
-    vk::CommandBufferAllocateInfo allocInfo;
-    allocInfo.commandPool = _commandPool;
-    allocInfo.level = vk::CommandBufferLevel::ePrimary;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(_commandBuffers.size());
-
-    if (_device.allocateCommandBuffers(&allocInfo, _commandBuffers.data()) != vk::Result::eSuccess) {
-        std::cerr << "Failed to allocate command buffers!" << std::endl;
-        std::abort();
-    }
+    LOG_INFO(LogCategory::Startup, "Creating command buffers...");
+    for (const std::unique_ptr<View>& view : _views) {
+        if (view->commandBuffers.size() > 0) {
+            _device.freeCommandBuffers(_commandPool, static_cast<uint32_t>(view->commandBuffers.size()), view->commandBuffers.data());
+        }
+        view->commandBuffers.resize(view->images.size());
+        view->commandBufferVersions.resize(view->commandBuffers.size());
 
-    size_t size = _commandBuffers.size();
-    for (size_t i = 0; i < size; i++) {
-        vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
+        vk::CommandBufferAllocateInfo allocInfo;
+        allocInfo.commandPool = _commandPool;
+        allocInfo.level = vk::CommandBufferLevel::ePrimary;
+        allocInfo.commandBufferCount = static_cast<uint32_t>(view->commandBuffers.size());
 
-        vk::RenderPassBeginInfo renderPassInfo;
-        renderPassInfo.renderPass = _renderPass;
-        renderPassInfo.framebuffer = _swapChainFramebuffers[i];
-        renderPassInfo.renderArea.offset = vk::Offset2D(0, 0);
-        renderPassInfo.renderArea.extent = _swapChainExtent;
+        if (_device.allocateCommandBuffers(&allocInfo, view->commandBuffers.data()) != vk::Result::eSuccess) {
+            std::cerr << "Failed to allocate command buffers!" << std::endl;
+            std::abort();
+        }
 
-        std::array<vk::ClearValue, 2> clearValues = {};
-        clearValues[0].color = vk::ClearColorValue(std::array<float, 4>{ { 0.1f, 0.2f, 0.1f, 1.0f } });
-        clearValues[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+        size_t size = view->commandBuffers.size();
+        for (size_t i = 0; i < size; i++) {
+            recordCommandBuffer(*view, i);
+        }
+    }
+}
 
-        renderPassInfo.clearValueCount = clearValues.size();
-        renderPassInfo.pClearValues = clearValues.data();
+void Application::recordCommandBuffer(View& view, size_t index)
+{
+    TRACE_SCOPE("recordCommandBuffer");
+    // GPU timing and statistics, the particle simulation, occlusion culling
+    // and the upscale belong to the primary view; the other views only draw
+    // the shared scene with their own camera.
+    bool primary = isPrimaryView(view);
+    bool upscale = primary && _dynamicResolution;
+    bool cull = primary && _occlusionCulling;
+    bool statistics = primary && _pipelineStatistics.isInitialized();
+    uint32_t slot = static_cast<uint32_t>(index);
+    vk::CommandBuffer commandBuffer = view.commandBuffers[index];
+    vk::Extent2D extent = renderExtent(view);
+    vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
+
+    vk::RenderPassBeginInfo renderPassInfo;
+    renderPassInfo.renderPass = upscale || cull ? _renderPass : _presentRenderPass;
+    renderPassInfo.framebuffer = upscale ? _offscreenFramebuffer : view.framebuffers[index];
+    renderPassInfo.renderArea.offset = vk::Offset2D(0, 0);
+    renderPassInfo.renderArea.extent = extent;
+
+    std::array<vk::ClearValue, 2> clearValues = {};
+    clearValues[0].color = vk::ClearColorValue(std::array<float, 4>{ { 0.1f, 0.2f, 0.1f, 1.0f } });
+    clearValues[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+
+    renderPassInfo.clearValueCount = clearValues.size();
+    renderPassInfo.pClearValues = clearValues.data();
+
+    vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f);
+    vk::Rect2D scissor(vk::Offset2D(0, 0), extent);
+
+    vk::DescriptorSet descriptorSet = view.descriptorSets[index];
+
+    if (commandBuffer.begin(&beginInfo) == vk::Result::eSuccess) {
+        if (primary && _gpuTimer.isInitialized()) {
+            _gpuTimer.writeBegin(commandBuffer, static_cast<uint32_t>(index));
+        }
+        if (statistics) {
+            _pipelineStatistics.reset(commandBuffer, slot);
+            _pipelineStatistics.begin(commandBuffer, slot, StatisticsPassCompute);
+        }
+        if (primary && _particles.isInitialized()) {
+            _particles.recordSimulation(commandBuffer, static_cast<uint32_t>(index));
+        }
+        if (cull) {
+            _culler.recordEarlyCull(commandBuffer, static_cast<uint32_t>(index));
+        }
+        if (primary && _lighting.isInitialized()) {
+            _lighting.recordAssignment(commandBuffer, static_cast<uint32_t>(index));
+        }
+        if (statistics) {
+            _pipelineStatistics.end(commandBuffer, slot, StatisticsPassCompute);
+            _pipelineStatistics.begin(commandBuffer, slot, StatisticsPassScene);
+        }
+        commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+
+        commandBuffer.setViewport(0, 1, &viewport);
+        commandBuffer.setScissor(0, 1, &scissor);
+        // All meshes live in the pool, so its buffers stay bound for every
+        // draw of the frame, including the late pass.
+        _geometry.bind(commandBuffer);
+        if (primary && _lighting.isInitialized()) {
+            _lighting.recordDraw(commandBuffer, descriptorSet, static_cast<uint32_t>(index), _geometry.mesh(_sceneMesh));
+        } else {
+            recordSceneDraws(commandBuffer, descriptorSet);
+        }
+        // Static meshes reuse whichever scene pipeline was just bound.
+        _geometry.drawIndirect(commandBuffer, _staticDrawBuffer, static_cast<uint32_t>(_staticMeshes.size()), _multiDrawIndirect);
+        if (cull) {
+            _culler.recordDraw(commandBuffer, descriptorSet, 0);
+            commandBuffer.endRenderPass();
+            if (statistics) {
+                _pipelineStatistics.end(commandBuffer, slot, StatisticsPassScene);
+                _pipelineStatistics.begin(commandBuffer, slot, StatisticsPassLate);
+            }
+            _culler.recordPyramid(commandBuffer, static_cast<uint32_t>(index), _attachments.image(view.depthAttachment));
+            _culler.recordLateCull(commandBuffer, static_cast<uint32_t>(index));
+
+            renderPassInfo.renderPass = _lateRenderPass;
+            commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+            commandBuffer.setViewport(0, 1, &viewport);
+            commandBuffer.setScissor(0, 1, &scissor);
+            _culler.recordDraw(commandBuffer, descriptorSet, 1);
+        } else if (_culler.isInitialized()) {
+            _culler.recordDrawAll(commandBuffer, descriptorSet);
+        }
+        if (_particles.isInitialized()) {
+            _particles.recordDraw(commandBuffer, descriptorSet);
+        }
 
-        vk::Buffer vertexBuffers[] = { _vertexBuffer };
-        vk::DeviceSize offsets[] = { 0 };
+        commandBuffer.endRenderPass();
+        if (statistics) {
+            _pipelineStatistics.end(commandBuffer, slot, cull ? StatisticsPassLate : StatisticsPassScene);
+        }
+        if (upscale) {
+            recordUpscale(commandBuffer, view.images[index]);
+        }
+        if (primary && _gpuTimer.isInitialized()) {
+            _gpuTimer.writeEnd(commandBuffer, static_cast<uint32_t>(index));
+        }
+        commandBuffer.end();
+    } else {
+        std::cerr << "Command buffers bind fail!" << std::endl;
+        std::abort();
+    }
+    view.commandBufferVersions[index] = commandBufferVersion();
+    _commandBuffersRecorded++;
+
+    // The stream keeps the draws of the shared scene; compute passes, culled
+    // objects and particles are generated on the GPU and not replayed.
+    if (_drawStream.isOpen()) {
+        std::vector<DrawStreamDraw> draws;
+        draws.push_back({ _sceneMaterial, _sceneMesh, 1, 0 });
+        for (MeshHandle mesh : _staticMeshes) {
+            draws.push_back({ _sceneMaterial, mesh, 1, 0 });
+        }
+        _drawStream.commands(viewIndex(view), slot, extent.width, extent.height, draws);
+    }
+}
 
-        if (_commandBuffers[i].begin(&beginInfo) == vk::Result::eSuccess) {
-            _commandBuffers[i].beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+void Application::recordSceneDraws(vk::CommandBuffer commandBuffer, vk::DescriptorSet descriptorSet)
+{
+    // Each command buffer records a single view and pass, so only the state
+    // fields of the key vary.
+    DrawItem item;
+    item.pipeline = _graphicsPipeline;
+    item.pipelineLayout = _pipelineLayout;
+    item.descriptorSet = descriptorSet;
+    item.materialSet = _materials.descriptorSet();
+    item.materialIndex = _sceneMaterial;
+    const MeshRange& mesh = _geometry.mesh(_sceneMesh);
+    item.indexCount = mesh.indexCount;
+    item.firstIndex = mesh.firstIndex;
+    item.vertexOffset = mesh.vertexOffset;
+
+    _drawList.clear();
+    _drawList.add(makeSortKey(0, 0, _materials.pipelineIndex(_sceneMaterial), _sceneMaterial, _sceneMesh, 0.0f), item);
+    std::chrono::steady_clock::time_point sortStart = std::chrono::steady_clock::now();
+    _drawList.sort();
+    _drawSortSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - sortStart).count();
+    _drawStats += _drawList.record(commandBuffer);
+    _drawListsRecorded++;
+}
 
-            _commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, _graphicsPipeline);
-            _commandBuffers[i].bindVertexBuffers(0, 1, vertexBuffers, offsets);
-            _commandBuffers[i].bindIndexBuffer(_indexBuffer, 0, vk::IndexType::eUint16);
-            _commandBuffers[i].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _pipelineLayout, 0, 1, &_descriptorSet, 0, nullptr);
-            _commandBuffers[i].drawIndexed(static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+void Application::recordUpscale(vk::CommandBuffer commandBuffer, vk::Image target)
+{
+    vk::Extent2D extent = renderExtent(primaryView());
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+    // Source stage is the transfer stage the image-available semaphore waits on.
+    vk::ImageMemoryBarrier toTransfer;
+    toTransfer.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    toTransfer.oldLayout = vk::ImageLayout::eUndefined;
+    toTransfer.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = target;
+    toTransfer.subresourceRange = range;
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    vk::ImageBlit blit;
+    blit.srcSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+    blit.srcOffsets[1] = vk::Offset3D(static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1);
+    blit.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+    blit.dstOffsets[1] = vk::Offset3D(static_cast<int32_t>(primaryView().extent.width), static_cast<int32_t>(primaryView().extent.height), 1);
+    commandBuffer.blitImage(_attachments.image(_offscreenAttachment), vk::ImageLayout::eTransferSrcOptimal, target, vk::ImageLayout::eTransferDstOptimal, 1, &blit, _blitFilter);
+
+    vk::ImageMemoryBarrier toPresent = toTransfer;
+    toPresent.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    toPresent.dstAccessMask = vk::AccessFlags();
+    toPresent.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    toPresent.newLayout = vk::ImageLayout::ePresentSrcKHR;
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &toPresent);
+}
 
-            _commandBuffers[i].endRenderPass();
-            _commandBuffers[i].end();
-        } else {
-            std::cerr << "Command buffers bind fail!" << std::endl;
-            std::abort();
-        }
+vk::Extent2D Application::renderExtent(const View& view) const
+{
+    if (!isPrimaryView(view) || !_dynamicResolution) {
+        return view.extent;
     }
+    vk::Extent2D extent;
+    _resolutionScaler.scaledExtent(view.extent.width, view.extent.height, extent.width, extent.height);
+    return extent;
 }
 
 void Application::createSemaphores()
 {
-    std::cerr << "Creating semaphores..." << std::endl;
-    vk::SemaphoreCreateInfo semaphoreInfo;
-
-    if (_device.createSemaphore(&semaphoreInfo, nullptr, &_imageAvailableSemaphore) != vk::Result::eSuccess || _device.createSemaphore(&semaphoreInfo, nullptr, &_renderFinishedSemaphore) != vk::Result::eSuccess) {
-        std::cerr << "Failed to create semaphores!" << std::endl;
-        std::abort();
+    LOG_INFO(LogCategory::Startup, "Creating semaphores...");
+    for (const std::unique_ptr<View>& view : _views) {
+        createSemaphores(*view);
     }
+    createFrameFences();
+}
+
+void Application::createFrameFences()
+{
     vk::FenceCreateInfo fenceCreateInfo = {};
     fenceCreateInfo.flags = vk::FenceCreateFlagBits::eSignaled;
-    _waitFences.resize(_commandBuffers.size());
+    _waitFences.resize(frameSlotCount());
     for (auto& fence : _waitFences) {
         if (_device.createFence(&fenceCreateInfo, nullptr, &fence) != vk::Result::eSuccess) {
             std::cerr << "Failed to create fence!" << std::endl;
             std::abort();
         }
     }
+    while (_frameArenas.size() < _waitFences.size()) {
+        _frameArenas.emplace_back(new FrameArena());
+    }
 }
 
-void Application::updateUniformBuffer()
+void Application::destroyFrameFences()
 {
-    static auto startTime = std::chrono::high_resolution_clock::now();
+    for (const vk::Fence& fence : _waitFences) {
+        _device.destroyFence(fence);
+    }
+    _waitFences.clear();
+}
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count() / 1000.0f;
-    float ratio = static_cast<float>(_swapChainExtent.width) / static_cast<float>(_swapChainExtent.height);
-    UniformBufferObject ubo;
-    ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.view = glm::lookAt(glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.proj = glm::perspective(glm::radians(46.0f), ratio, 0.1f, 100.0f);
-    ubo.proj[1][1] *= -1.0f;
-    void* dataPtr = nullptr;
+void Application::createSemaphores(View& view)
+{
+    vk::SemaphoreCreateInfo semaphoreInfo;
 
-    vk::Result res = _device.mapMemory(_uniformStagingBufferMemory, vk::DeviceSize(0), sizeof(UniformBufferObject), vk::MemoryMapFlags(), &dataPtr);
-    if (res != vk::Result::eSuccess) {
-        std::cerr << "Failed to map memory for uniform buffer! error:" << res << std::endl;
+    if (_device.createSemaphore(&semaphoreInfo, nullptr, &view.imageAvailableSemaphore) != vk::Result::eSuccess || _device.createSemaphore(&semaphoreInfo, nullptr, &view.renderFinishedSemaphore) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create semaphores!" << std::endl;
         std::abort();
     }
-    memcpy(dataPtr, &ubo, sizeof(UniformBufferObject));
-    _device.unmapMemory(_uniformStagingBufferMemory);
-    copyBuffer(_device, _commandPool, _graphicsQueue, _uniformStagingBuffer, _uniformBuffer, sizeof(UniformBufferObject));
 }
 
-void Application::drawFrame()
+void Application::updateScene()
 {
-    uint32_t imageIndex;
-    vk::Result result = _device.acquireNextImageKHR(_swapChain, std::numeric_limits<uint64_t>::max(), _imageAvailableSemaphore, nullptr, &imageIndex);
+    TRACE_SCOPE("updateScene");
+    SimulationState state = _simulation.interpolatedState();
+    _transforms.setRotation(_modelTransform, glm::angleAxis(static_cast<float>(std::fmod(state.rotation, 2.0 * glm::pi<double>())), glm::vec3(0.0f, 0.0f, 1.0f)));
+    _transforms.update();
+}
 
-    if (result == vk::Result::eErrorOutOfDateKHR) {
-        recreateSwapChain();
-        return;
-    } else if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
-        std::cerr << "Failed to acquire swap chain image! error:" << result << std::endl;
-        std::abort();
+void Application::updateUniformBuffer(View& view)
+{
+    TRACE_SCOPE("updateUniformBuffer");
+    UniformBufferObject ubo;
+    ubo.model = _transforms.world(_modelTransform);
+    ubo.view = view.camera.viewMatrix();
+    ubo.proj = view.camera.projectionMatrix(view.extent);
+    memcpy(view.uniformData + view.uniformStride * view.imageIndex, &ubo, sizeof(UniformBufferObject));
+    _drawStream.uniforms(viewIndex(view), view.imageIndex, &ubo);
+}
+
+// Command buffers are recorded again when the render resolution changes or
+// the geometry pool moves meshes; both versions only ever grow.
+uint32_t Application::commandBufferVersion() const
+{
+    return _resolutionScaler.version() + _geometry.version();
+}
+
+void Application::drawFrame()
+{
+    TRACE_SCOPE("drawFrame");
+    // Steady state is a frame that neither records command buffers, rebuilds
+    // the swap chain, captures nor traces; it must not touch the heap.
+    AllocationScope allocations;
+    bool steadyState = _frameIndex >= AllocationWarmupFrames && !_frameCapture.isEnabled() && !Tracer::instance().isCapturing();
+    for (size_t i = 0; i < _views.size(); i++) {
+        TRACE_SCOPE("acquire");
+        View& view = *_views[i];
+        vk::Result result = _device.acquireNextImageKHR(view.swapChain, std::numeric_limits<uint64_t>::max(), view.imageAvailableSemaphore, nullptr, &view.imageIndex);
+
+        if (result == vk::Result::eErrorOutOfDateKHR) {
+            consumeAcquireSignals(i);
+            recreateSwapChain();
+            return;
+        } else if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
+            std::cerr << "Failed to acquire swap chain image! error:" << result << std::endl;
+            std::abort();
+        }
     }
 
-    _device.waitForFences(1, &_waitFences[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
-    _device.resetFences(1, &_waitFences[imageIndex]);
+    // The fence of the primary image guards the whole frame. The other views
+    // acquire independently, so also wait for whichever frame last drew into
+    // their image before reusing its command buffer and uniform slot.
+    uint32_t imageIndex = primaryView().imageIndex;
+    vk::Fence frameFence = _waitFences[imageIndex];
+    {
+        TRACE_SCOPE("wait for frame");
+        _device.waitForFences(1, &frameFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        _device.resetFences(1, &frameFence);
+        for (const std::unique_ptr<View>& view : _views) {
+            vk::Fence& imageFence = view->imageFences[view->imageIndex];
+            if (imageFence && imageFence != frameFence) {
+                _device.waitForFences(1, &imageFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            }
+            imageFence = frameFence;
+        }
+    }
+    FrameArena& arena = *_frameArenas[imageIndex];
+    arena.reset();
+
+    double gpuMilliseconds = 0.0;
+    if (_gpuTimer.isInitialized() && _gpuTimer.collect(imageIndex, gpuMilliseconds)) {
+        _resolutionScaler.update(gpuMilliseconds);
+        _redraw.addGpuTime(gpuMilliseconds);
+        if (_gpuSubmitTimestamps[imageIndex] != 0 && Tracer::instance().isCapturing()) {
+            uint64_t gpuBegin;
+            uint64_t gpuEnd;
+            _gpuTimer.lastSpan(gpuBegin, gpuEnd);
+            Tracer::instance().recordGpu("gpu frame", gpuBegin, gpuEnd, _gpuSubmitTimestamps[imageIndex]);
+        }
+    }
+    if (_pipelineStatistics.isInitialized()) {
+        _pipelineStatistics.collect(imageIndex);
+    }
+    for (const std::unique_ptr<View>& view : _views) {
+        if (view->commandBufferVersions[view->imageIndex] != commandBufferVersion()) {
+            recordCommandBuffer(*view, view->imageIndex);
+            steadyState = false;
+        }
+        updateUniformBuffer(*view);
+    }
+    if (_particles.isInitialized()) {
+        _particles.update(imageIndex, _simulation.interpolatedState().time);
+    }
+    if (_occlusionCulling) {
+        _culler.collect(imageIndex);
+        _culler.update(imageIndex, primaryView().camera.viewMatrix(), primaryView().camera.projectionMatrix(primaryView().extent));
+    }
+    if (_lighting.isInitialized()) {
+        const Camera& camera = primaryView().camera;
+        _lighting.collect(imageIndex);
+        _lighting.update(imageIndex, _simulation.interpolatedState().time, camera.viewMatrix(), camera.projectionMatrix(primaryView().extent), renderExtent(primaryView()), camera.nearPlane, camera.farPlane);
+    }
 
-    vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
+    bool capture = _frameReadback.isInitialized() && _frameCapture.shouldCapture(_frameIndex);
+    if (_frameReadback.isInitialized()) {
+        _frameReadback.collect(false, _captureConsumer);
+    }
 
-    vk::SubmitInfo submitInfo;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &_imageAvailableSemaphore;
-    submitInfo.pWaitDstStageMask = waitStages;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &_commandBuffers[imageIndex];
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &_renderFinishedSemaphore;
+    // One submit for all views. With dynamic resolution the primary swap chain
+    // image is first touched by the upscale blit.
+    size_t viewCount = _views.size();
+    FrameVector<vk::PipelineStageFlags> waitStages(viewCount, vk::PipelineStageFlagBits::eColorAttachmentOutput, ArenaAllocator<vk::PipelineStageFlags>(arena));
+    FrameVector<vk::SubmitInfo> submitInfos(viewCount, vk::SubmitInfo(), ArenaAllocator<vk::SubmitInfo>(arena));
+    FrameVector<vk::Semaphore> renderFinishedSemaphores(viewCount, vk::Semaphore(), ArenaAllocator<vk::Semaphore>(arena));
+    FrameVector<vk::SwapchainKHR> swapChains(viewCount, vk::SwapchainKHR(), ArenaAllocator<vk::SwapchainKHR>(arena));
+    FrameVector<uint32_t> imageIndices(viewCount, 0, ArenaAllocator<uint32_t>(arena));
+    if (_dynamicResolution) {
+        waitStages[0] = vk::PipelineStageFlagBits::eTransfer;
+    }
+    for (size_t i = 0; i < viewCount; i++) {
+        View& view = *_views[i];
+        bool readback = capture && i == 0;
+        submitInfos[i].waitSemaphoreCount = 1;
+        submitInfos[i].pWaitSemaphores = &view.imageAvailableSemaphore;
+        submitInfos[i].pWaitDstStageMask = &waitStages[i];
+        submitInfos[i].commandBufferCount = 1;
+        submitInfos[i].pCommandBuffers = &view.commandBuffers[view.imageIndex];
+        submitInfos[i].signalSemaphoreCount = readback ? 0 : 1;
+        submitInfos[i].pSignalSemaphores = readback ? nullptr : &view.renderFinishedSemaphore;
+        renderFinishedSemaphores[i] = view.renderFinishedSemaphore;
+        swapChains[i] = view.swapChain;
+        imageIndices[i] = view.imageIndex;
+    }
 
-    vk::Result submitResult = _graphicsQueue.submit(1, &submitInfo, _waitFences[imageIndex]);
+    vk::Result submitResult;
+    {
+        TRACE_SCOPE("submit");
+        submitResult = _graphicsQueue.submit(static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), frameFence);
+    }
     if (submitResult != vk::Result::eSuccess) {
         std::cerr << "failed to submit draw command buffer! error:" << submitResult << std::endl;
         std::abort();
     }
+    _drawStream.frame();
+    if (_gpuTimer.isInitialized()) {
+        _gpuTimer.markSubmitted(imageIndex);
+        _gpuSubmitTimestamps[imageIndex] = Tracer::instance().isCapturing() ? traceTimestamp() : 0;
+    }
+    if (_pipelineStatistics.isInitialized()) {
+        _pipelineStatistics.markSubmitted(imageIndex);
+    }
+    if (_occlusionCulling) {
+        _culler.markSubmitted(imageIndex);
+    }
+    if (_lighting.isInitialized()) {
+        _lighting.markSubmitted(imageIndex);
+    }
 
+    if (capture) {
+        vk::CommandBuffer readbackCommands = _frameReadback.record(primaryView().images[imageIndex], _frameIndex, _captureConsumer);
+        vk::SubmitInfo readbackSubmitInfo;
+        readbackSubmitInfo.commandBufferCount = 1;
+        readbackSubmitInfo.pCommandBuffers = &readbackCommands;
+        readbackSubmitInfo.signalSemaphoreCount = 1;
+        readbackSubmitInfo.pSignalSemaphores = &primaryView().renderFinishedSemaphore;
+
+        vk::Result readbackResult = _graphicsQueue.submit(1, &readbackSubmitInfo, _frameReadback.fence());
+        if (readbackResult != vk::Result::eSuccess) {
+            std::cerr << "failed to submit readback command buffer! error:" << readbackResult << std::endl;
+            std::abort();
+        }
+        _frameReadback.markSubmitted();
+    }
+
+    FrameVector<vk::Result> presentResults(viewCount, vk::Result::eSuccess, ArenaAllocator<vk::Result>(arena));
     vk::PresentInfoKHR presentInfo;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = &_renderFinishedSemaphore;
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = &_swapChain;
-    presentInfo.pImageIndices = &imageIndex;
-
-    vk::Result presentResult = _presentQueue.presentKHR(&presentInfo);
-    if (presentResult == vk::Result::eErrorOutOfDateKHR || presentResult == vk::Result::eSuboptimalKHR) {
+    presentInfo.waitSemaphoreCount = static_cast<uint32_t>(renderFinishedSemaphores.size());
+    presentInfo.pWaitSemaphores = renderFinishedSemaphores.data();
+    presentInfo.swapchainCount = static_cast<uint32_t>(swapChains.size());
+    presentInfo.pSwapchains = swapChains.data();
+    presentInfo.pImageIndices = imageIndices.data();
+    presentInfo.pResults = presentResults.data();
+
+    vk::Result presentResult;
+    {
+        TRACE_SCOPE("present");
+        presentResult = _presentQueue.presentKHR(&presentInfo);
+    }
+    if (_frameIndex++ == 0) {
+        _timeToFirstFrame = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _runStart).count();
+        LOG_INFO(LogCategory::Render, "Time to first frame: %.2f ms", _timeToFirstFrame);
+    }
+    bool outOfDate = presentResult == vk::Result::eErrorOutOfDateKHR || presentResult == vk::Result::eSuboptimalKHR;
+    for (vk::Result result : presentResults) {
+        outOfDate = outOfDate || result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR;
+    }
+    bool resizeCheck = perfCheckEnabled() && _frameIndex % PerfCheckResizeInterval == 0;
+    if (outOfDate || resizeCheck) {
         recreateSwapChain();
+        return;
     } else if (presentResult != vk::Result::eSuccess) {
         std::cerr << "failed to present swap chain image! error:" << presentResult << std::endl;
         std::abort();
     }
+    if (steadyState && allocations.count() != 0) {
+        std::cerr << "drawFrame() made " << allocations.count() << " heap allocations in steady-state frame " << _frameIndex << "!" << std::endl;
+        std::abort();
+    }
+}
+
+// The views before the one that went out of date already acquired an image
+// and their semaphores have a pending signal. Nothing will wait on them this
+// frame, so a wait-only submission consumes the signals; the queue is idle
+// before recreateSwapChain() destroys the semaphores.
+void Application::consumeAcquireSignals(size_t viewCount)
+{
+    if (viewCount == 0) {
+        return;
+    }
+    std::vector<vk::Semaphore> semaphores;
+    std::vector<vk::PipelineStageFlags> stages(viewCount, vk::PipelineStageFlagBits::eAllCommands);
+    for (size_t i = 0; i < viewCount; i++) {
+        semaphores.push_back(_views[i]->imageAvailableSemaphore);
+    }
+    vk::SubmitInfo submitInfo = {};
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(semaphores.size());
+    submitInfo.pWaitSemaphores = semaphores.data();
+    submitInfo.pWaitDstStageMask = stages.data();
+    vk::Result res = _graphicsQueue.submit(1, &submitInfo, vk::Fence());
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to submit acquire semaphore wait! error:" << res << std::endl;
+        std::abort();
+    }
 }
 
 void Application::recreateSwapChain()
 {
-    std::cerr << "Recreating swap chain..." << std::endl;
+    TRACE_SCOPE("recreateSwapChain");
+    LOG_INFO(LogCategory::Render, "Recreating swap chain...");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    _redraw.invalidate();
     _graphicsQueue.waitIdle();
     _presentQueue.waitIdle();
     _device.waitIdle();
-    for (const vk::ImageView& imageview : _swapChainImageViews) {
-        _device.destroyImageView(imageview);
+    if (_frameReadback.isInitialized()) {
+        _frameReadback.collect(true, _captureConsumer);
+        _frameReadback.destroy();
     }
-    for (const vk::Framebuffer& framebuffer : _swapChainFramebuffers) {
-        _device.destroyFramebuffer(framebuffer);
+    for (const std::unique_ptr<View>& view : _views) {
+        for (const vk::ImageView& imageview : view->imageViews) {
+            _device.destroyImageView(imageview);
+        }
+        for (const vk::Framebuffer& framebuffer : view->framebuffers) {
+            _device.destroyFramebuffer(framebuffer);
+        }
+        // Pending acquire signals were consumed by consumeAcquireSignals() and
+        // the queues are idle, so no semaphore is in use any more.
+        _device.destroySemaphore(view->imageAvailableSemaphore);
+        _device.destroySemaphore(view->renderFinishedSemaphore);
+        destroyUniformBuffer(*view);
+        _device.destroySwapchainKHR(view->swapChain);
     }
+    _device.destroyFramebuffer(_offscreenFramebuffer);
+    _offscreenFramebuffer = vk::Framebuffer();
+    _gpuTimer.destroy();
+    _pipelineStatistics.destroy();
 
-    _device.destroyImage(_depthImage);
-    _device.freeMemory(_depthImageMemory);
-    _device.destroyImageView(_depthImageView);
-    _device.destroyShaderModule(_vertShaderModule);
-    _device.destroyShaderModule(_fragShaderModule);
-    _device.destroyPipelineCache(_cache);
-    _device.destroyPipelineLayout(_pipelineLayout);
-    _device.destroyPipeline(_graphicsPipeline);
-    _device.destroyRenderPass(_renderPass);
-    _device.destroySwapchainKHR(_swapChain);
+    _particles.destroyRenderPipeline();
+    _culler.destroyRenderPipeline();
+    _culler.destroyPyramid();
+    _lighting.destroyRenderPipeline();
+    destroyRenderPasses();
 
     createSwapChain();
+    resizeFrameSlots();
+    createGpuTimer();
+    createPipelineStatistics();
+    configureOcclusionCulling();
     createImageViews();
     createRenderPass();
-    createGraphicsPipeline();
-    createDepthResources();
+    // Viewport and scissor are dynamic and render passes with the same
+    // formats are compatible, so the material pipelines only have to be
+    // rebuilt when the swap chain format changed.
+    if (primaryView().format != _pipelineFormat) {
+        _materials.destroyPipelines();
+        createGraphicsPipeline();
+    }
+    if (_particles.isInitialized()) {
+        _particles.createRenderPipeline(_renderPass, _descriptorSetLayout);
+    }
+    createObjectPipeline();
+    createLightPipeline();
+    createAttachments();
+    createDepthPyramid();
+    submitUploads();
     createFramebuffers();
+    createUniformBuffers();
+    createDescriptorPool();
+    createDescriptorSets();
     createCommandBuffers();
+    for (const std::unique_ptr<View>& view : _views) {
+        createSemaphores(*view);
+    }
+    createFrameReadback();
+    _resizeTimes.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
 }
 
-void Application::createVertexBuffer()
+void Application::createFrameReadback()
 {
-    vk::DeviceSize bufferSize = sizeof(Vertex) * vertices.size();
-    vk::Buffer stagingBuffer;
-    vk::DeviceMemory stagingBufferMemory;
-    createBuffer(_device, _physicalDevice, bufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
-    void* dataPtr = nullptr;
-    vk::Result res = _device.mapMemory(stagingBufferMemory, vk::DeviceSize(0), bufferSize, vk::MemoryMapFlags(), &dataPtr);
-    if (res != vk::Result::eSuccess) {
-        std::cerr << "Failed to map memory for vertex buffer! error:" << res << std::endl;
-        std::abort();
+    if (_frameCapture.isEnabled()) {
+        _frameReadback.init(_device, _physicalDevice, _memoryTracker, static_cast<uint32_t>(_queueFamilyIndices.graphicsFamily), primaryView().extent, primaryView().format, ReadbackRingSize);
     }
-    memcpy(dataPtr, vertices.data(), static_cast<size_t>(bufferSize));
-    _device.unmapMemory(stagingBufferMemory);
+}
 
-    createBuffer(_device, _physicalDevice, bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, _vertexBuffer, _vertexBufferMemory);
-    copyBuffer(_device, _commandPool, _graphicsQueue, stagingBuffer, _vertexBuffer, bufferSize);
-    _device.destroyBuffer(stagingBuffer);
-    _device.freeMemory(stagingBufferMemory);
+void Application::createParticles()
+{
+    if (_settings.particleCount > 0) {
+        LOG_INFO(LogCategory::Startup, "Creating %u particles...", _settings.particleCount);
+        _particles.init(_device, _physicalDevice, _memoryTracker, _uploads, _settings.particleCount, frameSlotCount());
+    }
 }
 
-void Application::createIndexBuffer()
+// The driver may return a different number of images for the new swap chain;
+// the frame fences and systems with per-frame slots are rebuilt for it.
+void Application::resizeFrameSlots()
 {
-    vk::DeviceSize bufferSize = sizeof(uint16_t) * indices.size();
-    vk::Buffer stagingBuffer;
-    vk::DeviceMemory stagingBufferMemory;
-    createBuffer(_device, _physicalDevice, bufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
-    void* dataPtr = nullptr;
-    vk::Result res = _device.mapMemory(stagingBufferMemory, vk::DeviceSize(0), bufferSize, vk::MemoryMapFlags(), &dataPtr);
-    if (res != vk::Result::eSuccess) {
-        std::cerr << "Failed to map memory for index buffer! error:" << res << std::endl;
-        std::abort();
+    uint32_t slotCount = frameSlotCount();
+    if (_waitFences.size() != slotCount) {
+        destroyFrameFences();
+        createFrameFences();
+    }
+    if (_particles.isInitialized() && _particles.slotCount() != slotCount) {
+        _particles.destroy();
+        createParticles();
     }
-    memcpy(dataPtr, indices.data(), static_cast<size_t>(bufferSize));
-    _device.unmapMemory(stagingBufferMemory);
+    if (_culler.isInitialized() && _culler.slotCount() != slotCount) {
+        _culler.destroy();
+        createObjects();
+    }
+    if (_lighting.isInitialized() && _lighting.slotCount() != slotCount) {
+        _lighting.destroy();
+        createLights();
+    }
+}
 
-    createBuffer(_device, _physicalDevice, bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, _indexBuffer, _indexBufferMemory);
-    copyBuffer(_device, _commandPool, _graphicsQueue, stagingBuffer, _indexBuffer, bufferSize);
-    _device.destroyBuffer(stagingBuffer);
-    _device.freeMemory(stagingBufferMemory);
+void Application::configureOcclusionCulling()
+{
+    _occlusionCulling = false;
+    if (!_settings.occlusionCulling || _settings.objectCount == 0) {
+        return;
+    }
+    if (_dynamicResolution) {
+        LOG_WARNING(LogCategory::Render, "Occlusion culling does not support dynamic resolution, disabled");
+        _settings.occlusionCulling = false;
+        return;
+    }
+    if (!OcclusionCuller::supportsDepthFormat(_physicalDevice, findDepthFormat(_physicalDevice))) {
+        LOG_WARNING(LogCategory::Render, "Depth cannot be sampled for the depth pyramid, occlusion culling disabled");
+        _settings.occlusionCulling = false;
+        return;
+    }
+    _occlusionCulling = true;
+}
+
+void Application::createObjects()
+{
+    if (_settings.objectCount > 0) {
+        LOG_INFO(LogCategory::Startup, "Creating %u objects...", _settings.objectCount);
+        _culler.init(_device, _physicalDevice, _memoryTracker, _uploads, static_cast<uint32_t>(_queueFamilyIndices.graphicsFamily), _settings.objectCount, _geometry.mesh(_sceneMesh), frameSlotCount());
+    }
+}
+
+void Application::createObjectPipeline()
+{
+    if (_culler.isInitialized()) {
+        _culler.createRenderPipeline(_renderPass, _descriptorSetLayout, _fragShaderCode);
+    }
+}
+
+void Application::createDepthPyramid()
+{
+    _culler.destroyPyramid();
+    if (_occlusionCulling) {
+        _culler.createPyramid(_attachments.view(primaryView().depthAttachment), primaryView().extent, frameSlotCount());
+    }
+}
+
+void Application::createLights()
+{
+    if (_settings.lightCount > 0) {
+        LOG_INFO(LogCategory::Startup, "Creating %u lights...", _settings.lightCount);
+        _lighting.init(_device, _physicalDevice, _memoryTracker, static_cast<uint32_t>(_queueFamilyIndices.graphicsFamily), _settings.lightCount, frameSlotCount());
+    }
+}
+
+void Application::createLightPipeline()
+{
+    if (_lighting.isInitialized()) {
+        _lighting.createRenderPipeline(_renderPass, _descriptorSetLayout);
+    }
+}
+
+namespace {
+// Axis aligned box with four vertices per face so each face has its own
+// texture coordinates. Faces wind counter-clockwise seen from outside.
+void makeBox(const glm::vec3& center, float halfSize, const glm::vec3& color, std::vector<Vertex>& boxVertices, std::vector<uint16_t>& boxIndices)
+{
+    static const glm::vec3 axes[] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+    // Normal and the two tangents of each face, chosen so u x v = normal.
+    static const int faces[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 2, 0 }, { 1, 0, 2 }, { 2, 0, 1 }, { 2, 1, 0 } };
+    static const float corners[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+    boxVertices.clear();
+    boxIndices.clear();
+    for (int face = 0; face < 6; face++) {
+        float sign = (face % 2 == 0) ? 1.0f : -1.0f;
+        glm::vec3 normal = axes[faces[face][0]] * sign;
+        glm::vec3 u = axes[faces[face][1]];
+        glm::vec3 v = axes[faces[face][2]];
+        uint16_t base = static_cast<uint16_t>(boxVertices.size());
+        for (const float* corner : corners) {
+            Vertex vertex;
+            vertex.pos = center + halfSize * (normal + corner[0] * u + corner[1] * v);
+            vertex.color = color;
+            vertex.texCoord = glm::vec2(0.5f + 0.5f * corner[0], 0.5f + 0.5f * corner[1]);
+            boxVertices.push_back(vertex);
+        }
+        const uint16_t quad[] = { 0, 1, 2, 2, 3, 0 };
+        for (uint16_t index : quad) {
+            boxIndices.push_back(static_cast<uint16_t>(base + index));
+        }
+    }
+}
+
+// One to three boxes stacked at ring position slot of slotCount around the
+// model, baked in model space into a single mesh.
+void makeStaticMesh(uint32_t slot, uint32_t slotCount, uint32_t boxCount, std::vector<Vertex>& meshVertices, std::vector<uint16_t>& meshIndices)
+{
+    meshVertices.clear();
+    meshIndices.clear();
+    std::vector<Vertex> boxVertices;
+    std::vector<uint16_t> boxIndices;
+    float angle = 2.0f * glm::pi<float>() * static_cast<float>(slot) / static_cast<float>(slotCount);
+    glm::vec3 color(0.5f + 0.5f * std::cos(angle), 0.5f + 0.5f * std::sin(angle), 0.6f);
+    float height = 0.0f;
+    for (uint32_t box = 0; box < boxCount; box++) {
+        float size = 0.04f + 0.03f * static_cast<float>((slot + box) % 3);
+        glm::vec3 center(1.2f * std::cos(angle), 1.2f * std::sin(angle), height + size);
+        height += 2.0f * size;
+        makeBox(center, size, color, boxVertices, boxIndices);
+        uint16_t base = static_cast<uint16_t>(meshVertices.size());
+        meshVertices.insert(meshVertices.end(), boxVertices.begin(), boxVertices.end());
+        for (uint16_t index : boxIndices) {
+            meshIndices.push_back(static_cast<uint16_t>(base + index));
+        }
+    }
+}
+}
+
+void Application::createGeometry()
+{
+    _geometry.init(_device, _physicalDevice, _memoryTracker, GeometryPoolVertices, GeometryPoolIndices);
+    _sceneMesh = _geometry.add(_uploads, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()));
+    _drawStream.mesh(_sceneMesh, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()));
+
+    if (_settings.staticMeshCount == 0) {
+        return;
+    }
+    LOG_INFO(LogCategory::Startup, "Creating %u static meshes...", _settings.staticMeshCount);
+    std::vector<Vertex> meshVertices;
+    std::vector<uint16_t> meshIndices;
+    for (uint32_t i = 0; i < _settings.staticMeshCount; i++) {
+        makeStaticMesh(i, _settings.staticMeshCount, 1, meshVertices, meshIndices);
+        MeshHandle mesh = _geometry.add(_uploads, meshVertices.data(), static_cast<uint32_t>(meshVertices.size()), meshIndices.data(), static_cast<uint32_t>(meshIndices.size()));
+        if (mesh == InvalidMesh) {
+            LOG_WARNING(LogCategory::Startup, "Geometry pool is full after %u static meshes", i);
+            break;
+        }
+        _drawStream.mesh(mesh, meshVertices.data(), static_cast<uint32_t>(meshVertices.size()), meshIndices.data(), static_cast<uint32_t>(meshIndices.size()));
+        _staticMeshes.push_back(mesh);
+    }
+    uploadStaticDraws();
+}
+
+void Application::uploadStaticDraws()
+{
+    if (_staticMeshes.empty()) {
+        return;
+    }
+    std::vector<vk::DrawIndexedIndirectCommand> commands;
+    commands.reserve(_staticMeshes.size());
+    for (MeshHandle mesh : _staticMeshes) {
+        commands.push_back(_geometry.drawCommand(mesh));
+    }
+    vk::DeviceSize commandBytes = sizeof(vk::DrawIndexedIndirectCommand) * commands.size();
+    if (!_staticDrawBuffer) {
+        createBuffer(_device, _physicalDevice, _memoryTracker, MemoryCategory::Storage, commandBytes, vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal,
+            _staticDrawBuffer, _staticDrawMemory);
+    }
+    _uploads.uploadBuffer(commands.data(), commandBytes, _staticDrawBuffer);
+}
+
+// Replaces one static mesh by a cluster of another size, so ranges of
+// different sizes come and go as they would while streaming geometry.
+void Application::churnMeshes()
+{
+    TRACE_SCOPE("churnMeshes");
+    // Frames in flight may still draw the replaced mesh, read the indirect
+    // commands or, after a compaction, the retired buffers.
+    _device.waitForFences(static_cast<uint32_t>(_waitFences.size()), _waitFences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+    size_t slot = _meshChurns % _staticMeshes.size();
+    uint32_t boxCount = 1 + static_cast<uint32_t>((_meshChurns + 1) % 3);
+    std::vector<Vertex> meshVertices;
+    std::vector<uint16_t> meshIndices;
+    makeStaticMesh(static_cast<uint32_t>(slot), static_cast<uint32_t>(_staticMeshes.size()), boxCount, meshVertices, meshIndices);
+    uint32_t vertexCount = static_cast<uint32_t>(meshVertices.size());
+    uint32_t indexCount = static_cast<uint32_t>(meshIndices.size());
+
+    // The batch runs its copies before its uploads, so compaction has to come
+    // before the new mesh is added or the mesh would not be carried over.
+    uint32_t version = _geometry.version();
+    if (_geometry.slack() > GeometryCompactThreshold) {
+        _geometry.compact(_uploads);
+    }
+    MeshHandle mesh = _geometry.add(_uploads, meshVertices.data(), vertexCount, meshIndices.data(), indexCount);
+    if (mesh == InvalidMesh && _geometry.version() == version) {
+        _geometry.compact(_uploads);
+        mesh = _geometry.add(_uploads, meshVertices.data(), vertexCount, meshIndices.data(), indexCount);
+    }
+    if (mesh == InvalidMesh) {
+        LOG_WARNING(LogCategory::Render, "Geometry pool has no room for a mesh of %u vertices, keeping the old one", vertexCount);
+    } else {
+        _geometry.remove(_staticMeshes[slot]);
+        _staticMeshes[slot] = mesh;
+        _drawStream.mesh(mesh, meshVertices.data(), vertexCount, meshIndices.data(), indexCount);
+    }
+
+    uploadStaticDraws();
+    if (_geometry.version() != version && _culler.isInitialized()) {
+        _culler.setMesh(_uploads, _geometry.mesh(_sceneMesh));
+    }
+    _uploads.submit(_commandPool, _graphicsQueue);
+    // The submit waited for the copies out of the retired buffers, and no
+    // frame in flight uses them.
+    _geometry.releaseRetired();
+    _meshChurns++;
+}
+
+void Application::submitUploads()
+{
+    LOG_INFO(LogCategory::Startup, "Submitting %zu uploads...", _uploads.pendingCount());
+    _uploads.submit(_commandPool, _graphicsQueue);
 }
 
 void Application::createDescriptorSetLayout()
@@ -747,12 +1808,43 @@ void Application::createDescriptorSetLayout()
     }
 }
 
-void Application::createDepthResources()
+void Application::createAttachments()
 {
-    vk::Format depthFormat = findDepthFormat(_physicalDevice);
-    createImage(_swapChainExtent.width, _swapChainExtent.height, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, _depthImage, _depthImageMemory);
-    createImageView(_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth, _depthImageView);
-    transitionImageLayout(_depthImage, depthFormat, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
+    // Every attachment is used by its view's scene pass. Depth is never
+    // stored, so the pool backs it with transient memory, except where the
+    // depth pyramid samples it. The views' passes are all in flight together,
+    // so they share one pass index and never alias.
+    _attachments.reset();
+    for (const std::unique_ptr<View>& view : _views) {
+        vk::ImageUsageFlags depthUsage = vk::ImageUsageFlagBits::eDepthStencilAttachment;
+        if (isPrimaryView(*view) && _occlusionCulling) {
+            depthUsage |= vk::ImageUsageFlagBits::eSampled;
+        }
+        view->depthAttachment = _attachments.request(AttachmentKey(findDepthFormat(_physicalDevice), view->extent, depthUsage), 0, 0);
+    }
+    if (_dynamicResolution) {
+        // Allocated at full size; lower scales render into the top-left corner,
+        // so scale changes only re-record command buffers.
+        _offscreenAttachment = _attachments.request(AttachmentKey(primaryView().format, primaryView().extent, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc), 0, 0);
+    }
+    _attachments.build();
+}
+
+void Application::createPipelineStatistics()
+{
+    if (_pipelineStatisticsQuery) {
+        _pipelineStatistics.init(_device, frameSlotCount(), { "compute", "scene", "late" });
+    }
+}
+
+void Application::createGpuTimer()
+{
+    _gpuSubmitTimestamps.assign(frameSlotCount(), 0);
+    if (!_gpuTimer.init(_device, _physicalDevice, static_cast<uint32_t>(_queueFamilyIndices.graphicsFamily), frameSlotCount()) && _dynamicResolution) {
+        LOG_WARNING(LogCategory::Render, "Dynamic resolution needs GPU timestamps, disabled");
+        _dynamicResolution = false;
+        _resolutionScaler.configure(0.0, 1.0);
+    }
 }
 
 void Application::createImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspectFlags, vk::ImageView& imageView)
@@ -773,7 +1865,7 @@ void Application::createImageView(vk::Image image, vk::Format format, vk::ImageA
     }
 }
 
-void Application::createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, vk::DeviceMemory& imageMemory)
+void Application::createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, MemoryCategory category, vk::Image& image, vk::DeviceMemory& imageMemory)
 {
     vk::ImageCreateInfo imageInfo = {};
     imageInfo.imageType = vk::ImageType::e2D;
@@ -801,7 +1893,7 @@ void Application::createImage(uint32_t width, uint32_t height, vk::Format format
     allocInfo.allocationSize = memRequirements.size;
     allocInfo.memoryTypeIndex = findMemoryType(_physicalDevice, memRequirements.memoryTypeBits, properties);
 
-    if (_device.allocateMemory(&allocInfo, nullptr, &imageMemory) != vk::Result::eSuccess) {
+    if (_memoryTracker.allocate(allocInfo, category, imageMemory) != vk::Result::eSuccess) {
         std::cerr << "Failed to allocate image memory!" << std::endl;
         std::abort();
     }
@@ -811,95 +1903,102 @@ void Application::createImage(uint32_t width, uint32_t height, vk::Format format
 void Application::transitionImageLayout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
 {
     vk::CommandBuffer commandBuffer = beginSingleTimeCommands(_device, _commandPool);
+    recordImageLayoutTransition(commandBuffer, image, format, oldLayout, newLayout);
+    endSingleTimeCommands(_device, _graphicsQueue, _commandPool, commandBuffer);
+}
 
-    vk::ImageMemoryBarrier barrier;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-
-    if (newLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal) {
-        barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eDepth;
-
-        if (hasStencilComponent(format)) {
-            barrier.subresourceRange.aspectMask |= vk::ImageAspectFlagBits::eStencil;
+void Application::createUniformBuffers()
+{
+    vk::PhysicalDeviceProperties properties;
+    _physicalDevice.getProperties(&properties);
+    vk::DeviceSize alignment = std::max<vk::DeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+    vk::DeviceSize stride = (sizeof(UniformBufferObject) + alignment - 1) / alignment * alignment;
+
+    // Written straight from the CPU every frame, one slot per swap chain image,
+    // instead of a staging copy that would need its own submit.
+    for (const std::unique_ptr<View>& view : _views) {
+        vk::DeviceSize bufferSize = stride * view->images.size();
+        createBuffer(_device, _physicalDevice, _memoryTracker, MemoryCategory::Uniform, bufferSize, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, view->uniformBuffer, view->uniformBufferMemory);
+
+        void* dataPtr = nullptr;
+        vk::Result res = _device.mapMemory(view->uniformBufferMemory, vk::DeviceSize(0), bufferSize, vk::MemoryMapFlags(), &dataPtr);
+        if (res != vk::Result::eSuccess) {
+            std::cerr << "Failed to map memory for uniform buffer! error:" << res << std::endl;
+            std::abort();
         }
-    } else {
-        barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    }
-
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    vk::PipelineStageFlags sourceStage;
-    vk::PipelineStageFlags destinationStage;
-
-    if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eTransferDstOptimal) {
-        barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-        sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
-        destinationStage = vk::PipelineStageFlagBits::eTransfer;
-    } else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal) {
-        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-        sourceStage = vk::PipelineStageFlagBits::eTransfer;
-        destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
-    } else if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal) {
-        barrier.dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-        sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
-        destinationStage = vk::PipelineStageFlagBits::eEarlyFragmentTests;
-    } else {
-        std::cout << "Failed to transition layout!" << std::endl;
-        std::abort();
+        view->uniformData = static_cast<uint8_t*>(dataPtr);
+        view->uniformStride = stride;
     }
-
-    commandBuffer.pipelineBarrier(sourceStage, destinationStage, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &barrier);
-    endSingleTimeCommands(_device, _graphicsQueue, _commandPool, commandBuffer);
 }
 
-void Application::createUniformBuffer()
+void Application::destroyUniformBuffer(View& view)
 {
-    vk::DeviceSize bufferSize = sizeof(UniformBufferObject);
-
-    createBuffer(_device, _physicalDevice, bufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, _uniformStagingBuffer, _uniformStagingBufferMemory);
-    createBuffer(_device, _physicalDevice, bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, _uniformBuffer, _uniformBufferMemory);
+    if (!view.descriptorSets.empty()) {
+        _device.freeDescriptorSets(_descriptorPool, static_cast<uint32_t>(view.descriptorSets.size()), view.descriptorSets.data());
+        view.descriptorSets.clear();
+    }
+    if (view.uniformData != nullptr) {
+        _device.unmapMemory(view.uniformBufferMemory);
+        view.uniformData = nullptr;
+    }
+    _device.destroyBuffer(view.uniformBuffer);
+    _memoryTracker.free(view.uniformBufferMemory);
+    view.uniformBuffer = vk::Buffer();
+    view.uniformBufferMemory = vk::DeviceMemory();
 }
 
+// One scene set per swap chain image of every view. Sets are freed and
+// reallocated with the swap chains, so the pool only has to be replaced when
+// a new swap chain has more images than it was sized for.
 void Application::createDescriptorPool()
 {
+    uint32_t setCount = 0;
+    for (const std::unique_ptr<View>& view : _views) {
+        setCount += static_cast<uint32_t>(view->images.size());
+    }
+    if (_descriptorPool && setCount <= _descriptorPoolSets) {
+        return;
+    }
+    _device.destroyDescriptorPool(_descriptorPool);
+
     std::array<vk::DescriptorPoolSize, 1> poolSizes;
     poolSizes[0].type = vk::DescriptorType::eUniformBuffer;
-    poolSizes[0].descriptorCount = 1;
+    poolSizes[0].descriptorCount = setCount;
 
-    vk::DescriptorPoolCreateInfo poolInfo(vk::DescriptorPoolCreateFlags(), 1, poolSizes.size(), poolSizes.data());
+    vk::DescriptorPoolCreateInfo poolInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, setCount, poolSizes.size(), poolSizes.data());
 
     if (_device.createDescriptorPool(&poolInfo, nullptr, &_descriptorPool) != vk::Result::eSuccess) {
         std::cerr << "Failed to create descriptor pool!" << std::endl;
         std::abort();
     }
+    _descriptorPoolSets = setCount;
 }
 
-void Application::createDescriptorSet()
+void Application::createDescriptorSets()
 {
-    vk::DescriptorSetAllocateInfo allocInfo(_descriptorPool, 1, &_descriptorSetLayout);
+    for (const std::unique_ptr<View>& view : _views) {
+        view->descriptorSets.resize(view->images.size());
+        std::vector<vk::DescriptorSetLayout> layouts(view->descriptorSets.size(), _descriptorSetLayout);
+        vk::DescriptorSetAllocateInfo allocInfo(_descriptorPool, static_cast<uint32_t>(layouts.size()), layouts.data());
 
-    if (_device.allocateDescriptorSets(&allocInfo, &_descriptorSet) != vk::Result::eSuccess) {
-        std::cerr << "Failed to allocate descriptor set!" << std::endl;
-        std::abort();
-    }
-
-    vk::DescriptorBufferInfo bufferInfo(_uniformBuffer, 0, sizeof(UniformBufferObject));
+        if (_device.allocateDescriptorSets(&allocInfo, view->descriptorSets.data()) != vk::Result::eSuccess) {
+            std::cerr << "Failed to allocate descriptor sets!" << std::endl;
+            std::abort();
+        }
 
-    std::array<vk::WriteDescriptorSet, 1> descriptorWrites = {};
+        size_t size = view->descriptorSets.size();
+        for (size_t i = 0; i < size; i++) {
+            vk::DescriptorBufferInfo bufferInfo(view->uniformBuffer, view->uniformStride * i, sizeof(UniformBufferObject));
 
-    descriptorWrites[0].dstSet = _descriptorSet;
-    descriptorWrites[0].dstBinding = 0;
-    descriptorWrites[0].dstArrayElement = 0;
-    descriptorWrites[0].descriptorType = vk::DescriptorType::eUniformBuffer;
-    descriptorWrites[0].descriptorCount = 1;
-    descriptorWrites[0].pBufferInfo = &bufferInfo;
+            std::array<vk::WriteDescriptorSet, 1> descriptorWrites = {};
+            descriptorWrites[0].dstSet = view->descriptorSets[i];
+            descriptorWrites[0].dstBinding = 0;
+            descriptorWrites[0].dstArrayElement = 0;
+            descriptorWrites[0].descriptorType = vk::DescriptorType::eUniformBuffer;
+            descriptorWrites[0].descriptorCount = 1;
+            descriptorWrites[0].pBufferInfo = &bufferInfo;
 
-    _device.updateDescriptorSets(descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+            _device.updateDescriptorSets(descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+        }
+    }
 }
@@ -1,12 +1,42 @@
 #ifndef APPLICATION_INCONCE_H
 #define APPLICATION_INCONCE_H
 
+#include <chrono>
+#include <memory>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
+#include "allocationcounter.h"
+#include "attachmentpool.h"
+#include "clusteredlighting.h"
 #include "debugcallbacks.h"
+#include "drawlist.h"
+#include "drawstream.h"
+#include "framearena.h"
+#include "framecapture.h"
+#include "framepacer.h"
+#include "framestats.h"
+#include "geometrypool.h"
+#include "gputimer.h"
 #include "helperfunctions.h"
-#include "window/window.h"
+#include "jobsystem.h"
+#include "logger.h"
+#include "materialsystem.h"
+#include "memorytracker.h"
+#include "occlusionculler.h"
+#include "particlesystem.h"
+#include "perfcheck.h"
+#include "pipelinestatistics.h"
+#include "redrawscheduler.h"
+#include "resolutionscaler.h"
+#include "settings.h"
+#include "shadercode.h"
+#include "simulation.h"
+#include "startupgraph.h"
+#include "tracer.h"
+#include "transformhierarchy.h"
+#include "uploadbatch.h"
+#include "view.h"
 
 #include "vertex.h"
 
@@ -28,16 +58,94 @@ const std::vector<Vertex> vertices = { { { -0.5f, -0.5f, 0.0f }, { 1.0f, 0.0f, 0
 
 const std::vector<uint16_t> indices = { 0, 1, 2, 2, 3, 0, 4, 5, 6, 6, 7, 4 };
 
+// Load and store behaviour of the scene pass. The defaults describe a single
+// pass rendering a whole frame; occlusion culling splits it in two.
+struct RenderPassSetup {
+    vk::AttachmentLoadOp loadOp = vk::AttachmentLoadOp::eClear;
+    vk::ImageLayout colorInitialLayout = vk::ImageLayout::eUndefined;
+    vk::ImageLayout colorFinalLayout = vk::ImageLayout::ePresentSrcKHR;
+    vk::ImageLayout depthInitialLayout = vk::ImageLayout::eUndefined;
+    vk::ImageLayout depthFinalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+    vk::AttachmentStoreOp depthStoreOp = vk::AttachmentStoreOp::eDontCare;
+    vk::PipelineStageFlags srcStages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+    vk::AccessFlags srcAccess;
+    // Stages after the pass that use its attachments; none when empty.
+    vk::PipelineStageFlags dstStages;
+};
+
+const uint32_t ReadbackRingSize = 3;
+const uint64_t MemoryBudgetCheckInterval = 60;
+const uint32_t GeometryPoolVertices = 256 * 1024;
+const uint32_t GeometryPoolIndices = 1024 * 1024;
+// --mesh-churn compacts the geometry pool once this share of the space below
+// its last mesh is free.
+const double GeometryCompactThreshold = 0.25;
+// Frames before drawFrame() has to stop allocating: every frame arena has to
+// grow to its peak once and be folded into a single block on reset.
+const uint64_t AllocationWarmupFrames = 16;
+// A perf check rebuilds the swap chain this often to measure resize latency
+// and keeps the hash of every PerfCheckHashInterval-th frame.
+const uint64_t PerfCheckResizeInterval = 120;
+const uint32_t PerfCheckHashInterval = 60;
+// After the last frame a perf check times PerfCheckUploadBytes through the
+// upload batch in uploads of PerfCheckUploadChunk bytes.
+const vk::DeviceSize PerfCheckUploadBytes = 16 * 1024 * 1024;
+const vk::DeviceSize PerfCheckUploadChunk = 1024 * 1024;
+const double PerfBaselineTolerance = 0.25;
+// Passes counted by --pipeline-stats: the compute work before the scene, the
+// scene pass and, with occlusion culling, the late cull and draw.
+const uint32_t StatisticsPassCompute = 0;
+const uint32_t StatisticsPassScene = 1;
+const uint32_t StatisticsPassLate = 2;
+
 class Application {
 public:
-    Application();
+    explicit Application(const ApplicationSettings& settings = ApplicationSettings());
     ~Application();
-    void run();
+    // False when --perf-check found a regression.
+    bool run();
 
 private:
-    Window _window;
+    ApplicationSettings _settings;
+    std::vector<std::unique_ptr<View>> _views;
+    JobSystem _jobSystem;
+    Simulation _simulation;
+    TransformHierarchy _transforms;
+    TransformHandle _modelTransform;
+    FramePacer _framePacer;
+    RedrawScheduler _redraw;
+    FrameStats _frameStats;
+    GpuTimer _gpuTimer;
+    // Per slot, when its command buffer was submitted during a trace capture.
+    std::vector<uint64_t> _gpuSubmitTimestamps;
+    PipelineStatistics _pipelineStatistics;
+    ResolutionScaler _resolutionScaler;
+    bool _dynamicResolution;
+    vk::Filter _blitFilter;
+    FrameReadback _frameReadback;
+    FrameCapture _frameCapture;
+    DrawStreamWriter _drawStream;
+    std::function<void(const CapturedFrame&)> _captureConsumer;
+    uint64_t _frameIndex;
+    std::chrono::steady_clock::time_point _runStart;
+    double _timeToFirstFrame;
+    RunningStatistics _resizeTimes;
+    double _uploadThroughput;
+    uint64_t _traceEndFrame;
+    uint32_t _tracesWritten;
+    MemoryTracker _memoryTracker;
+    UploadBatch _uploads;
+    ParticleSystem _particles;
+    OcclusionCuller _culler;
+    ClusteredLighting _lighting;
+    MaterialSystem _materials;
+    MaterialHandle _sceneMaterial;
+    DrawList _drawList;
+    DrawListStats _drawStats;
+    double _drawSortSeconds;
+    uint64_t _drawListsRecorded;
+    bool _occlusionCulling;
     vk::Instance _instance;
-    vk::SurfaceKHR _surface;
     VkDebugReportCallbackEXT _callback;
     vk::PhysicalDevice _physicalDevice;
     vk::Device _device;
@@ -47,47 +155,60 @@ private:
 
     QueueFamilyIndices _queueFamilyIndices;
 
-    vk::SwapchainKHR _swapChain;
-    std::vector<vk::Image> _swapChainImages;
-    vk::Format _swapChainImageFormat;
-    vk::Extent2D _swapChainExtent;
-    std::vector<vk::ImageView> _swapChainImageViews;
-    std::vector<vk::Framebuffer> _swapChainFramebuffers;
-
     vk::RenderPass _renderPass;
+    vk::RenderPass _presentRenderPass;
+    vk::RenderPass _lateRenderPass;
     vk::DescriptorSetLayout _descriptorSetLayout;
     vk::PipelineLayout _pipelineLayout;
     vk::Pipeline _graphicsPipeline;
+    // Color format of the render pass the material pipelines were created for.
+    vk::Format _pipelineFormat;
 
     vk::CommandPool _commandPool;
-    std::vector<vk::CommandBuffer> _commandBuffers;
 
-    vk::Buffer _vertexBuffer;
-    vk::DeviceMemory _vertexBufferMemory;
-    vk::Buffer _indexBuffer;
-    vk::DeviceMemory _indexBufferMemory;
+    GeometryPool _geometry;
+    MeshHandle _sceneMesh;
+    std::vector<MeshHandle> _staticMeshes;
+    vk::Buffer _staticDrawBuffer;
+    vk::DeviceMemory _staticDrawMemory;
+    uint64_t _meshChurns;
+    bool _multiDrawIndirect;
+    bool _pipelineStatisticsQuery;
+    uint64_t _commandBuffersRecorded;
 
-    vk::Buffer _uniformStagingBuffer;
-    vk::DeviceMemory _uniformStagingBufferMemory;
-    vk::Buffer _uniformBuffer;
-    vk::DeviceMemory _uniformBufferMemory;
     vk::DescriptorPool _descriptorPool;
-    vk::DescriptorSet _descriptorSet;
+    uint32_t _descriptorPoolSets;
 
-    vk::Image _depthImage;
-    vk::DeviceMemory _depthImageMemory;
-    vk::ImageView _depthImageView;
+    AttachmentPool _attachments;
+    AttachmentHandle _offscreenAttachment;
+    vk::Framebuffer _offscreenFramebuffer;
 
-    vk::Semaphore _imageAvailableSemaphore;
-    vk::Semaphore _renderFinishedSemaphore;
     std::vector<vk::Fence> _waitFences;
+    std::vector<std::unique_ptr<FrameArena>> _frameArenas;
 
-    vk::ShaderModule _vertShaderModule;
-    vk::ShaderModule _fragShaderModule;
+    std::vector<uint32_t> _vertShaderStorage;
+    std::vector<uint32_t> _fragShaderStorage;
+    ShaderCode _vertShaderCode;
+    ShaderCode _fragShaderCode;
+    std::vector<uint32_t> _materialShaderStorage;
+    ShaderCode _materialShaderCode;
 
 private:
+    View& primaryView();
+    const View& primaryView() const;
+    bool isPrimaryView(const View& view) const;
+    uint32_t viewIndex(const View& view) const;
+    uint32_t frameSlotCount() const;
+    bool anyWindowClosed();
+    void createViews();
     void initVulkan();
     void mainLoop();
+    void handleWindowEvents();
+    bool perfCheckEnabled() const;
+    void measureUploadThroughput();
+    bool finishPerfCheck();
+    void startTrace();
+    void finishTrace();
     void destroyVulkan();
     void createInstance();
     void setupDebugCallback();
@@ -95,26 +216,55 @@ private:
     void pickPhysicalDevice();
     void createLogicalDevice();
     void createSwapChain();
+    void createSwapChain(View& view);
     void createImageViews();
     void createRenderPass();
+    void createRenderPass(const RenderPassSetup& setup, vk::RenderPass& renderPass);
+    void destroyRenderPasses();
+    void loadShaders();
+    void createMaterials();
     void createGraphicsPipeline();
     void createFramebuffers();
     void createCommandPool();
     void createCommandBuffers();
+    void recordCommandBuffer(View& view, size_t index);
+    void recordSceneDraws(vk::CommandBuffer commandBuffer, vk::DescriptorSet descriptorSet);
+    void recordUpscale(vk::CommandBuffer commandBuffer, vk::Image target);
+    vk::Extent2D renderExtent(const View& view) const;
     void createSemaphores();
+    void createSemaphores(View& view);
+    void createFrameFences();
+    void destroyFrameFences();
     void drawFrame();
+    uint32_t commandBufferVersion() const;
     void recreateSwapChain();
-    void createVertexBuffer();
-    void createIndexBuffer();
-    void createUniformBuffer();
+    void consumeAcquireSignals(size_t viewCount);
+    void createGeometry();
+    void uploadStaticDraws();
+    void churnMeshes();
+    void submitUploads();
+    void createUniformBuffers();
+    void destroyUniformBuffer(View& view);
     void createDescriptorPool();
-    void createDescriptorSet();
-    void updateUniformBuffer();
+    void createDescriptorSets();
+    void updateScene();
+    void updateUniformBuffer(View& view);
     void createDescriptorSetLayout();
-    void createDepthResources();
+    void createAttachments();
+    void createGpuTimer();
+    void createPipelineStatistics();
+    void createFrameReadback();
+    void createParticles();
+    void resizeFrameSlots();
+    void configureOcclusionCulling();
+    void createObjects();
+    void createObjectPipeline();
+    void createDepthPyramid();
+    void createLights();
+    void createLightPipeline();
 
     void createImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspectFlags, vk::ImageView& imageView);
-    void createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, vk::DeviceMemory& imageMemory);
+    void createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, MemoryCategory category, vk::Image& image, vk::DeviceMemory& imageMemory);
     void transitionImageLayout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
 };
 
@@ -0,0 +1,293 @@
+#include "assetarchive.h"
+#include "jobsystem.h"
+#include "lz4block.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const uint64_t EntryAlignment = 16;
+// An LZ4 block expands at most about 255 times, one length byte per 255
+// bytes of a match.
+const uint64_t MaxExpansion = 255;
+// Entries differ in size, so each worker gets several batches to balance.
+const size_t BatchesPerWorker = 4;
+
+uint64_t align(uint64_t value)
+{
+    return (value + EntryAlignment - 1) & ~(EntryAlignment - 1);
+}
+
+bool entryLess(const ArchiveEntry& entry, uint64_t hash)
+{
+    return entry.nameHash < hash;
+}
+}
+
+uint64_t hashAssetName(const char* name, size_t length)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ static_cast<unsigned char>(name[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+AssetArchive::AssetArchive()
+    : _data(nullptr)
+    , _size(0)
+    , _entries(nullptr)
+    , _entryCount(0)
+    , _names(nullptr)
+{
+}
+
+AssetArchive::~AssetArchive()
+{
+    close();
+}
+
+bool AssetArchive::open(const std::string& path)
+{
+    close();
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        std::cerr << "Failed to open archive: [" << path << "]" << std::endl;
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(ArchiveHeader))) {
+        std::cerr << "Archive is too small: [" << path << "]" << std::endl;
+        ::close(file);
+        return false;
+    }
+    _size = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(file);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map archive: [" << path << "]" << std::endl;
+        _size = 0;
+        return false;
+    }
+    _data = static_cast<const char*>(mapping);
+    if (!validate(path)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool AssetArchive::validate(const std::string& path)
+{
+    const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(_data);
+    if (std::memcmp(header->magic, ArchiveMagic, sizeof(ArchiveMagic)) != 0 || header->version != ArchiveVersion) {
+        std::cerr << "Not a version " << ArchiveVersion << " archive: [" << path << "]" << std::endl;
+        return false;
+    }
+    uint64_t tocSize = static_cast<uint64_t>(header->entryCount) * sizeof(ArchiveEntry);
+    if (header->tocOffset % alignof(ArchiveEntry) != 0 || header->tocOffset > _size || tocSize > _size - header->tocOffset || header->namesOffset > _size) {
+        std::cerr << "Corrupt table of contents in archive: [" << path << "]" << std::endl;
+        return false;
+    }
+    _entries = reinterpret_cast<const ArchiveEntry*>(_data + header->tocOffset);
+    _entryCount = header->entryCount;
+    _names = _data + header->namesOffset;
+
+    // Checked once here so lookups and reads can trust the table.
+    uint64_t namesSize = _size - header->namesOffset;
+    for (uint32_t i = 0; i < _entryCount; i++) {
+        const ArchiveEntry& entry = _entries[i];
+        bool sorted = i == 0 || _entries[i - 1].nameHash <= entry.nameHash;
+        bool dataInside = entry.offset <= _size && entry.storedSize <= _size - entry.offset;
+        bool nameInside = entry.nameOffset <= namesSize && entry.nameLength <= namesSize - entry.nameOffset;
+        bool sizeValid = (entry.flags & ArchiveEntryCompressed) != 0 ? entry.size <= entry.storedSize * MaxExpansion : entry.storedSize == entry.size;
+        if (!sorted || !dataInside || !nameInside || !sizeValid || hashAssetName(_names + entry.nameOffset, entry.nameLength) != entry.nameHash) {
+            std::cerr << "Corrupt entry " << i << " in archive: [" << path << "]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetArchive::close()
+{
+    if (_data) {
+        munmap(const_cast<char*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+    _entries = nullptr;
+    _entryCount = 0;
+    _names = nullptr;
+}
+
+bool AssetArchive::isOpen() const
+{
+    return _data != nullptr;
+}
+
+size_t AssetArchive::entryCount() const
+{
+    return _entryCount;
+}
+
+const ArchiveEntry& AssetArchive::entry(size_t index) const
+{
+    return _entries[index];
+}
+
+std::string AssetArchive::name(const ArchiveEntry& entry) const
+{
+    return std::string(_names + entry.nameOffset, entry.nameLength);
+}
+
+const ArchiveEntry* AssetArchive::find(const std::string& name) const
+{
+    uint64_t hash = hashAssetName(name.data(), name.size());
+    const ArchiveEntry* end = _entries + _entryCount;
+    for (const ArchiveEntry* entry = std::lower_bound(_entries, end, hash, entryLess); entry != end && entry->nameHash == hash; entry++) {
+        if (entry->nameLength == name.size() && std::memcmp(_names + entry->nameOffset, name.data(), name.size()) == 0) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetArchive::view(const ArchiveEntry& entry, const char*& data, size_t& size) const
+{
+    if (entry.flags & ArchiveEntryCompressed) {
+        return false;
+    }
+    data = _data + entry.offset;
+    size = static_cast<size_t>(entry.size);
+    return true;
+}
+
+bool AssetArchive::read(const ArchiveEntry& entry, std::vector<char>& data) const
+{
+    const char* stored = _data + entry.offset;
+    data.resize(static_cast<size_t>(entry.size));
+    if (entry.flags & ArchiveEntryCompressed) {
+        return lz4Decompress(stored, static_cast<size_t>(entry.storedSize), data.data(), data.size());
+    }
+    std::memcpy(data.data(), stored, data.size());
+    return true;
+}
+
+bool AssetArchive::readAll(JobSystem& jobs, const std::vector<const ArchiveEntry*>& entries, std::vector<std::vector<char>>& data) const
+{
+    data.resize(entries.size());
+    std::atomic<bool> succeeded(true);
+    size_t grain = std::max<size_t>(entries.size() / (jobs.workerCount() * BatchesPerWorker), 1);
+    jobs.parallelFor(entries.size(), grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (!read(*entries[i], data[i])) {
+                succeeded.store(false, std::memory_order_relaxed);
+            }
+        }
+    });
+    return succeeded.load();
+}
+
+void AssetArchiveWriter::add(const std::string& name, const char* data, size_t size, bool compress)
+{
+    PendingEntry entry;
+    entry.name = name;
+    entry.size = size;
+    entry.compressed = false;
+    if (compress && size > 0) {
+        entry.stored.resize(lz4CompressBound(size));
+        size_t compressedSize = lz4Compress(data, size, entry.stored.data(), size - 1);
+        if (compressedSize != 0) {
+            entry.stored.resize(compressedSize);
+            entry.compressed = true;
+        }
+    }
+    if (!entry.compressed) {
+        entry.stored.assign(data, data + size);
+    }
+    _entries.push_back(std::move(entry));
+}
+
+bool AssetArchiveWriter::write(const std::string& path) const
+{
+    std::vector<ArchiveEntry> toc(_entries.size());
+    std::string names;
+    uint64_t offset = align(sizeof(ArchiveHeader));
+    for (size_t i = 0; i < _entries.size(); i++) {
+        const PendingEntry& pending = _entries[i];
+        ArchiveEntry& entry = toc[i];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.nameHash = hashAssetName(pending.name.data(), pending.name.size());
+        entry.offset = offset;
+        entry.storedSize = pending.stored.size();
+        entry.size = pending.size;
+        entry.nameOffset = static_cast<uint32_t>(names.size());
+        entry.nameLength = static_cast<uint32_t>(pending.name.size());
+        entry.flags = pending.compressed ? ArchiveEntryCompressed : 0;
+        names += pending.name;
+        offset = align(offset + entry.storedSize);
+    }
+
+    ArchiveHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, ArchiveMagic, sizeof(ArchiveMagic));
+    header.version = ArchiveVersion;
+    header.entryCount = static_cast<uint32_t>(toc.size());
+    header.tocOffset = offset;
+    header.namesOffset = offset + toc.size() * sizeof(ArchiveEntry);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to create archive: [" << path << "]" << std::endl;
+        return false;
+    }
+    const char padding[EntryAlignment] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, static_cast<std::streamsize>(align(sizeof(header)) - sizeof(header)));
+    for (size_t i = 0; i < _entries.size(); i++) {
+        const std::vector<char>& stored = _entries[i].stored;
+        file.write(stored.data(), static_cast<std::streamsize>(stored.size()));
+        file.write(padding, static_cast<std::streamsize>(align(stored.size()) - stored.size()));
+    }
+    // Data is written in insertion order; only the table is sorted.
+    std::stable_sort(toc.begin(), toc.end(), [](const ArchiveEntry& a, const ArchiveEntry& b) { return a.nameHash < b.nameHash; });
+    file.write(reinterpret_cast<const char*>(toc.data()), static_cast<std::streamsize>(toc.size() * sizeof(ArchiveEntry)));
+    file.write(names.data(), static_cast<std::streamsize>(names.size()));
+    if (!file) {
+        std::cerr << "Failed to write archive: [" << path << "]" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+size_t AssetArchiveWriter::entryCount() const
+{
+    return _entries.size();
+}
+
+uint64_t AssetArchiveWriter::size() const
+{
+    uint64_t total = 0;
+    for (const PendingEntry& entry : _entries) {
+        total += entry.size;
+    }
+    return total;
+}
+
+uint64_t AssetArchiveWriter::storedSize() const
+{
+    uint64_t total = 0;
+    for (const PendingEntry& entry : _entries) {
+        total += entry.stored.size();
+    }
+    return total;
+}
@@ -0,0 +1,100 @@
+#ifndef ASSETARCHIVE_H
+#define ASSETARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Archive layout, all little endian: header, entry data (each entry 16 byte
+// aligned), table of contents sorted by name hash, then the entry names.
+const char ArchiveMagic[4] = { 'E', 'P', 'A', 'K' };
+const uint32_t ArchiveVersion = 1;
+const uint32_t ArchiveEntryCompressed = 1;
+
+struct ArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t tocOffset;
+    uint64_t namesOffset;
+};
+
+struct ArchiveEntry {
+    uint64_t nameHash;
+    uint64_t offset;
+    // Bytes in the archive; equal to size unless the entry is compressed.
+    uint64_t storedSize;
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+uint64_t hashAssetName(const char* name, size_t length);
+
+// Read-only view of a packed archive. The file is memory mapped, lookups are
+// a binary search over the hashed table of contents, and uncompressed entries
+// can be used in place without a copy.
+class AssetArchive {
+public:
+    AssetArchive();
+    ~AssetArchive();
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    size_t entryCount() const;
+    const ArchiveEntry& entry(size_t index) const;
+    std::string name(const ArchiveEntry& entry) const;
+    // nullptr when there is no entry with that name.
+    const ArchiveEntry* find(const std::string& name) const;
+
+    // Points into the mapping and stays valid until close(). Fails for
+    // compressed entries.
+    bool view(const ArchiveEntry& entry, const char*& data, size_t& size) const;
+    bool read(const ArchiveEntry& entry, std::vector<char>& data) const;
+    // Reads entries on the job system's workers in a few batches per worker.
+    // Returns false if any entry could not be read.
+    bool readAll(JobSystem& jobs, const std::vector<const ArchiveEntry*>& entries, std::vector<std::vector<char>>& data) const;
+
+private:
+    bool validate(const std::string& path);
+
+    const char* _data;
+    size_t _size;
+    const ArchiveEntry* _entries;
+    uint32_t _entryCount;
+    const char* _names;
+};
+
+// Collects entries in memory and writes them as an archive.
+class AssetArchiveWriter {
+public:
+    // Compressed entries are stored uncompressed when that is smaller.
+    void add(const std::string& name, const char* data, size_t size, bool compress);
+    bool write(const std::string& path) const;
+
+    size_t entryCount() const;
+    uint64_t size() const;
+    uint64_t storedSize() const;
+
+private:
+    struct PendingEntry {
+        std::string name;
+        std::vector<char> stored;
+        uint64_t size;
+        bool compressed;
+    };
+
+    std::vector<PendingEntry> _entries;
+};
+
+#endif // ASSETARCHIVE_H
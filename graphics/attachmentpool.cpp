@@ -0,0 +1,289 @@
+#include "attachmentpool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+const vk::ImageUsageFlags AttachmentUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment;
+
+bool overlaps(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB)
+{
+    return firstA <= lastB && firstB <= lastA;
+}
+}
+
+AttachmentKey::AttachmentKey(vk::Format format, vk::Extent2D extent, vk::ImageUsageFlags usage, vk::SampleCountFlagBits samples)
+    : format(format)
+    , extent(extent)
+    , usage(usage)
+    , samples(samples)
+{
+}
+
+bool AttachmentKey::operator==(const AttachmentKey& other) const
+{
+    return format == other.format && extent.width == other.extent.width && extent.height == other.extent.height && usage == other.usage && samples == other.samples;
+}
+
+bool AttachmentKey::isTransient() const
+{
+    return (usage & ~AttachmentUsage) == vk::ImageUsageFlags();
+}
+
+AttachmentPool::AttachmentPool()
+    : _memoryTracker(nullptr)
+    , _allocatedBytes(0)
+    , _peakBytes(0)
+    , _builds(0)
+    , _reusedBlocks(0)
+{
+}
+
+void AttachmentPool::init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker)
+{
+    _device = device;
+    _memoryTracker = &tracker;
+    physicalDevice.getMemoryProperties(&_memoryProperties);
+}
+
+void AttachmentPool::destroy()
+{
+    destroyImages(_built);
+    _built.clear();
+    _requests.clear();
+    for (const Block& block : _blocks) {
+        _memoryTracker->free(block.memory);
+    }
+    _blocks.clear();
+    _allocatedBytes = 0;
+}
+
+void AttachmentPool::reset()
+{
+    _requests.clear();
+}
+
+AttachmentHandle AttachmentPool::request(const AttachmentKey& key, uint32_t firstPass, uint32_t lastPass)
+{
+    Request request = { key, firstPass, std::max(firstPass, lastPass), vk::Image(), vk::ImageView(), vk::MemoryRequirements(), 0 };
+    _requests.push_back(request);
+    return static_cast<AttachmentHandle>(_requests.size() - 1);
+}
+
+bool AttachmentPool::sameRequests() const
+{
+    if (_requests.size() != _built.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < _requests.size(); i++) {
+        if (!(_requests[i].key == _built[i].key) || _requests[i].firstPass != _built[i].firstPass || _requests[i].lastPass != _built[i].lastPass) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AttachmentPool::build()
+{
+    if (sameRequests()) {
+        _requests = _built;
+        return;
+    }
+    _builds++;
+    destroyImages(_built);
+    for (Request& request : _requests) {
+        createImage(request);
+    }
+
+    // Largest first, each into the first slot of matching memory type whose
+    // users are all outside its pass range.
+    std::vector<size_t> order(_requests.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return _requests[a].requirements.size > _requests[b].requirements.size; });
+
+    std::vector<Block> slots;
+    for (size_t index : order) {
+        Request& request = _requests[index];
+        bool lazy = request.key.isTransient();
+        size_t chosen = slots.size();
+        for (size_t s = 0; s < slots.size() && chosen == slots.size(); s++) {
+            Block& slot = slots[s];
+            if (slot.lazy != lazy || !(request.requirements.memoryTypeBits & (1u << slot.memoryType))) {
+                continue;
+            }
+            bool free = true;
+            for (size_t user : slot.users) {
+                free = free && !overlaps(request.firstPass, request.lastPass, _requests[user].firstPass, _requests[user].lastPass);
+            }
+            if (free) {
+                chosen = s;
+            }
+        }
+        if (chosen == slots.size()) {
+            Block slot = { vk::DeviceMemory(), 0, 0, lazy, std::vector<size_t>() };
+            bool found = lazy && findMemoryType(request.requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated, slot.memoryType);
+            if (!found && !findMemoryType(request.requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal, slot.memoryType)) {
+                std::cerr << "Failed to find memory type for attachment!" << std::endl;
+                std::abort();
+            }
+            slots.push_back(slot);
+        }
+        Block& slot = slots[chosen];
+        slot.size = std::max(slot.size, request.requirements.size);
+        slot.users.push_back(index);
+        request.block = chosen;
+    }
+
+    // Keep the smallest old block that still fits each slot, free the rest
+    // before allocating so a resize does not hold both sets at once.
+    std::vector<bool> kept(_blocks.size(), false);
+    for (Block& slot : slots) {
+        size_t best = _blocks.size();
+        for (size_t b = 0; b < _blocks.size(); b++) {
+            if (!kept[b] && _blocks[b].memoryType == slot.memoryType && _blocks[b].size >= slot.size && (best == _blocks.size() || _blocks[b].size < _blocks[best].size)) {
+                best = b;
+            }
+        }
+        if (best != _blocks.size()) {
+            kept[best] = true;
+            slot.memory = _blocks[best].memory;
+            slot.size = _blocks[best].size;
+            _reusedBlocks++;
+        }
+    }
+    for (size_t b = 0; b < _blocks.size(); b++) {
+        if (!kept[b]) {
+            _memoryTracker->free(_blocks[b].memory);
+        }
+    }
+
+    _allocatedBytes = 0;
+    for (Block& slot : slots) {
+        if (!slot.memory) {
+            vk::MemoryAllocateInfo allocInfo(slot.size, slot.memoryType);
+            if (_memoryTracker->allocate(allocInfo, MemoryCategory::Attachment, slot.memory) != vk::Result::eSuccess) {
+                std::cerr << "Failed to allocate attachment memory!" << std::endl;
+                std::abort();
+            }
+        }
+        _allocatedBytes += slot.size;
+    }
+    _peakBytes = std::max(_peakBytes, _allocatedBytes);
+    _blocks = slots;
+
+    for (Request& request : _requests) {
+        _device.bindImageMemory(request.image, _blocks[request.block].memory, 0);
+
+        vk::ImageViewCreateInfo viewInfo;
+        viewInfo.image = request.image;
+        viewInfo.viewType = vk::ImageViewType::e2D;
+        viewInfo.format = request.key.format;
+        viewInfo.subresourceRange.aspectMask = (request.key.usage & vk::ImageUsageFlagBits::eDepthStencilAttachment) ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+        if (_device.createImageView(&viewInfo, nullptr, &request.view) != vk::Result::eSuccess) {
+            std::cerr << "Failed to create attachment image view!" << std::endl;
+            std::abort();
+        }
+    }
+    _built = _requests;
+}
+
+void AttachmentPool::createImage(Request& request)
+{
+    vk::ImageCreateInfo imageInfo;
+    imageInfo.imageType = vk::ImageType::e2D;
+    imageInfo.extent = vk::Extent3D(request.key.extent.width, request.key.extent.height, 1);
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = request.key.format;
+    imageInfo.tiling = vk::ImageTiling::eOptimal;
+    imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+    imageInfo.usage = request.key.usage;
+    if (request.key.isTransient()) {
+        imageInfo.usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+    }
+    imageInfo.samples = request.key.samples;
+    imageInfo.sharingMode = vk::SharingMode::eExclusive;
+
+    if (_device.createImage(&imageInfo, nullptr, &request.image) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create attachment image!" << std::endl;
+        std::abort();
+    }
+    _device.getImageMemoryRequirements(request.image, &request.requirements);
+}
+
+void AttachmentPool::destroyImages(std::vector<Request>& requests)
+{
+    for (Request& request : requests) {
+        _device.destroyImageView(request.view);
+        _device.destroyImage(request.image);
+        request.view = vk::ImageView();
+        request.image = vk::Image();
+    }
+}
+
+bool AttachmentPool::findMemoryType(uint32_t typeBits, vk::MemoryPropertyFlags properties, uint32_t& memoryType) const
+{
+    for (uint32_t i = 0; i < _memoryProperties.memoryTypeCount; i++) {
+        if ((typeBits & (1u << i)) && (_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            memoryType = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+vk::Image AttachmentPool::image(AttachmentHandle handle) const
+{
+    return _built[handle].image;
+}
+
+vk::ImageView AttachmentPool::view(AttachmentHandle handle) const
+{
+    return _built[handle].view;
+}
+
+vk::DeviceSize AttachmentPool::allocatedBytes() const
+{
+    return _allocatedBytes;
+}
+
+vk::DeviceSize AttachmentPool::peakBytes() const
+{
+    return _peakBytes;
+}
+
+vk::DeviceSize AttachmentPool::requestedBytes() const
+{
+    vk::DeviceSize bytes = 0;
+    for (const Request& request : _built) {
+        bytes += request.requirements.size;
+    }
+    return bytes;
+}
+
+vk::DeviceSize AttachmentPool::committedBytes() const
+{
+    vk::DeviceSize bytes = 0;
+    for (const Block& block : _blocks) {
+        if (block.lazy && (_memoryProperties.memoryTypes[block.memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated)) {
+            vk::DeviceSize committed = 0;
+            _device.getMemoryCommitment(block.memory, &committed);
+            bytes += committed;
+        } else {
+            bytes += block.size;
+        }
+    }
+    return bytes;
+}
+
+void AttachmentPool::report(std::ostream& stream) const
+{
+    const double MiB = 1024.0 * 1024.0;
+    stream << "Attachments: " << _built.size() << " images in " << _blocks.size() << " blocks, " << _allocatedBytes / MiB << " MiB allocated (" << requestedBytes() / MiB << " MiB without aliasing, "
+           << committedBytes() / MiB << " MiB committed), peak " << _peakBytes / MiB << " MiB, " << _builds << " builds, " << _reusedBlocks << " blocks reused" << std::endl;
+}
@@ -0,0 +1,87 @@
+#ifndef ATTACHMENTPOOL_H
+#define ATTACHMENTPOOL_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "memorytracker.h"
+
+struct AttachmentKey {
+    vk::Format format;
+    vk::Extent2D extent;
+    vk::ImageUsageFlags usage;
+    vk::SampleCountFlagBits samples;
+
+    AttachmentKey(vk::Format format, vk::Extent2D extent, vk::ImageUsageFlags usage, vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1);
+    bool operator==(const AttachmentKey& other) const;
+    // Attachments that are never sampled or copied only live inside a render
+    // pass and can use transient, lazily allocated memory.
+    bool isTransient() const;
+};
+
+typedef uint32_t AttachmentHandle;
+
+// Render targets requested by key together with the range of passes that use
+// them. Attachments whose pass ranges do not overlap share memory. Images are
+// kept while the requests stay the same and memory blocks are kept across
+// rebuilds (resizes) as long as they are large enough.
+class AttachmentPool {
+public:
+    AttachmentPool();
+
+    void init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker);
+    void destroy();
+
+    // Starts a new set of requests; images and memory stay alive until build().
+    void reset();
+    AttachmentHandle request(const AttachmentKey& key, uint32_t firstPass, uint32_t lastPass);
+    void build();
+
+    vk::Image image(AttachmentHandle handle) const;
+    vk::ImageView view(AttachmentHandle handle) const;
+
+    vk::DeviceSize allocatedBytes() const;
+    vk::DeviceSize peakBytes() const;
+    vk::DeviceSize requestedBytes() const;
+    vk::DeviceSize committedBytes() const;
+    void report(std::ostream& stream) const;
+
+private:
+    struct Request {
+        AttachmentKey key;
+        uint32_t firstPass;
+        uint32_t lastPass;
+        vk::Image image;
+        vk::ImageView view;
+        vk::MemoryRequirements requirements;
+        size_t block;
+    };
+
+    struct Block {
+        vk::DeviceMemory memory;
+        vk::DeviceSize size;
+        uint32_t memoryType;
+        bool lazy;
+        std::vector<size_t> users;
+    };
+
+    bool sameRequests() const;
+    void destroyImages(std::vector<Request>& requests);
+    void createImage(Request& request);
+    bool findMemoryType(uint32_t typeBits, vk::MemoryPropertyFlags properties, uint32_t& memoryType) const;
+
+    vk::Device _device;
+    MemoryTracker* _memoryTracker;
+    vk::PhysicalDeviceMemoryProperties _memoryProperties;
+    std::vector<Request> _requests;
+    std::vector<Request> _built;
+    std::vector<Block> _blocks;
+    vk::DeviceSize _allocatedBytes;
+    vk::DeviceSize _peakBytes;
+    uint64_t _builds;
+    uint64_t _reusedBlocks;
+};
+
+#endif // ATTACHMENTPOOL_H
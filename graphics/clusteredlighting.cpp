@@ -0,0 +1,339 @@
+#include "clusteredlighting.h"
+#include "helperfunctions.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+const float LightRadius = 0.35f;
+const float LightIntensity = 1.5f;
+
+float unitRandom(uint32_t& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / 16777216.0f;
+}
+}
+
+ClusteredLighting::ClusteredLighting()
+    : _memoryTracker(nullptr)
+    , _lightCount(0)
+    , _slotCount(0)
+    , _lightData(nullptr)
+    , _lightStride(0)
+    , _parameters(nullptr)
+    , _parameterStride(0)
+{
+}
+
+bool ClusteredLighting::loadShaders(const std::string& shaderDirectory)
+{
+    return findShader(shaderDirectory, "light_cluster_comp", _compStorage, _compCode) && findShader(shaderDirectory, "clustered_vert", _vertStorage, _vertCode)
+        && findShader(shaderDirectory, "clustered_frag", _fragStorage, _fragCode);
+}
+
+void ClusteredLighting::init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, uint32_t queueFamily, uint32_t lightCount, uint32_t slotCount)
+{
+    _device = device;
+    _memoryTracker = &tracker;
+    _lightCount = lightCount;
+    _slotCount = slotCount;
+
+    // Lights circle the scene at different heights and speeds.
+    _orbits.resize(lightCount);
+    _lights.resize(lightCount);
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < lightCount; i++) {
+        _orbits[i].radius = 0.2f + 1.8f * unitRandom(state);
+        _orbits[i].angle = 6.2831853f * unitRandom(state);
+        _orbits[i].speed = (unitRandom(state) - 0.5f) * 2.0f;
+        _orbits[i].height = -0.6f + 0.9f * unitRandom(state);
+        _lights[i].positionRadius[3] = LightRadius;
+        _lights[i].color[0] = 0.2f + 0.8f * unitRandom(state);
+        _lights[i].color[1] = 0.2f + 0.8f * unitRandom(state);
+        _lights[i].color[2] = 0.2f + 0.8f * unitRandom(state);
+        _lights[i].color[3] = LightIntensity;
+    }
+
+    vk::PhysicalDeviceProperties properties;
+    physicalDevice.getProperties(&properties);
+    vk::DeviceSize storageAlignment = std::max<vk::DeviceSize>(properties.limits.minStorageBufferOffsetAlignment, 1);
+    _lightStride = (sizeof(PointLight) * lightCount + storageAlignment - 1) / storageAlignment * storageAlignment;
+    createBuffer(_device, physicalDevice, tracker, MemoryCategory::Storage, _lightStride * _slotCount, vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, _lightBuffer, _lightMemory);
+    void* mapped = nullptr;
+    vk::Result res = _device.mapMemory(_lightMemory, 0, _lightStride * _slotCount, vk::MemoryMapFlags(), &mapped);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to map lights! error:" << res << std::endl;
+        std::abort();
+    }
+    _lightData = static_cast<uint8_t*>(mapped);
+
+    createBuffer(_device, physicalDevice, tracker, MemoryCategory::Storage, sizeof(uint32_t) * ClusterCount, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal,
+        _clusterCountBuffer, _clusterCountMemory);
+    createBuffer(_device, physicalDevice, tracker, MemoryCategory::Storage, sizeof(uint32_t) * ClusterCount * MaxLightsPerCluster, vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, _clusterLightBuffer, _clusterLightMemory);
+
+    vk::DeviceSize uniformAlignment = std::max<vk::DeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+    _parameterStride = (sizeof(Parameters) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+    createBuffer(_device, physicalDevice, tracker, MemoryCategory::Uniform, _parameterStride * _slotCount, vk::BufferUsageFlagBits::eUniformBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, _parameterBuffer, _parameterMemory);
+    res = _device.mapMemory(_parameterMemory, 0, _parameterStride * _slotCount, vk::MemoryMapFlags(), &mapped);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to map lighting parameters! error:" << res << std::endl;
+        std::abort();
+    }
+    _parameters = static_cast<uint8_t*>(mapped);
+    std::memset(_parameters, 0, static_cast<size_t>(_parameterStride * _slotCount));
+
+    std::vector<vk::DescriptorType> bindings = { vk::DescriptorType::eStorageBufferDynamic, vk::DescriptorType::eStorageBuffer, vk::DescriptorType::eStorageBuffer, vk::DescriptorType::eUniformBufferDynamic };
+    _assignment.init(_device, vk::PipelineCache(), _compCode, bindings);
+    _assignmentSet = _assignment.allocateDescriptorSet();
+    _assignment.bindBuffer(_assignmentSet, 0, _lightBuffer, 0, sizeof(PointLight) * lightCount);
+    _assignment.bindBuffer(_assignmentSet, 1, _clusterCountBuffer);
+    _assignment.bindBuffer(_assignmentSet, 2, _clusterLightBuffer);
+    _assignment.bindBuffer(_assignmentSet, 3, _parameterBuffer, 0, sizeof(Parameters));
+    if (!_assignmentTimer.init(_device, physicalDevice, queueFamily, _slotCount)) {
+        std::cerr << "Light assignment time will not be measured" << std::endl;
+    }
+
+    // The lit fragment shader reads the same buffers through its own set.
+    std::vector<vk::DescriptorSetLayoutBinding> layoutBindings(bindings.size());
+    std::vector<vk::DescriptorPoolSize> poolSizes(bindings.size());
+    for (size_t i = 0; i < bindings.size(); i++) {
+        layoutBindings[i] = vk::DescriptorSetLayoutBinding(static_cast<uint32_t>(i), bindings[i], 1, vk::ShaderStageFlagBits::eFragment, nullptr);
+        poolSizes[i] = vk::DescriptorPoolSize(bindings[i], 1);
+    }
+    vk::DescriptorSetLayoutCreateInfo layoutInfo;
+    layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+    layoutInfo.pBindings = layoutBindings.data();
+    if (_device.createDescriptorSetLayout(&layoutInfo, nullptr, &_lightSetLayout) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create light descriptor set layout!" << std::endl;
+        std::abort();
+    }
+    vk::DescriptorPoolCreateInfo poolInfo(vk::DescriptorPoolCreateFlags(), 1, static_cast<uint32_t>(poolSizes.size()), poolSizes.data());
+    if (_device.createDescriptorPool(&poolInfo, nullptr, &_lightPool) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create light descriptor pool!" << std::endl;
+        std::abort();
+    }
+    vk::DescriptorSetAllocateInfo allocInfo(_lightPool, 1, &_lightSetLayout);
+    if (_device.allocateDescriptorSets(&allocInfo, &_lightSet) != vk::Result::eSuccess) {
+        std::cerr << "Failed to allocate light descriptor set!" << std::endl;
+        std::abort();
+    }
+    std::array<vk::DescriptorBufferInfo, 4> bufferInfos = { { vk::DescriptorBufferInfo(_lightBuffer, 0, sizeof(PointLight) * lightCount), vk::DescriptorBufferInfo(_clusterCountBuffer, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(_clusterLightBuffer, 0, VK_WHOLE_SIZE), vk::DescriptorBufferInfo(_parameterBuffer, 0, sizeof(Parameters)) } };
+    std::array<vk::WriteDescriptorSet, 4> writes;
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i].dstSet = _lightSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = bindings[i];
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    _device.updateDescriptorSets(writes.size(), writes.data(), 0, nullptr);
+}
+
+void ClusteredLighting::destroy()
+{
+    if (!isInitialized()) {
+        return;
+    }
+    destroyRenderPipeline();
+    _assignmentTimer.destroy();
+    _assignment.destroy();
+    _device.destroyDescriptorPool(_lightPool);
+    _device.destroyDescriptorSetLayout(_lightSetLayout);
+    _device.unmapMemory(_lightMemory);
+    _device.unmapMemory(_parameterMemory);
+    vk::Buffer buffers[] = { _lightBuffer, _clusterCountBuffer, _clusterLightBuffer, _parameterBuffer };
+    vk::DeviceMemory memories[] = { _lightMemory, _clusterCountMemory, _clusterLightMemory, _parameterMemory };
+    for (size_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); i++) {
+        _device.destroyBuffer(buffers[i]);
+        _memoryTracker->free(memories[i]);
+    }
+    _lightCount = 0;
+}
+
+bool ClusteredLighting::isInitialized() const
+{
+    return _lightCount != 0;
+}
+
+uint32_t ClusteredLighting::lightCount() const
+{
+    return _lightCount;
+}
+
+uint32_t ClusteredLighting::slotCount() const
+{
+    return _slotCount;
+}
+
+void ClusteredLighting::createRenderPipeline(vk::RenderPass renderPass, vk::DescriptorSetLayout sceneLayout)
+{
+    createShaderModule(_device, _vertCode, _vertModule);
+    createShaderModule(_device, _fragCode, _fragModule);
+
+    vk::PipelineShaderStageCreateInfo shaderStages[2];
+    shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
+    shaderStages[0].module = _vertModule;
+    shaderStages[0].pName = "main";
+    shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
+    shaderStages[1].module = _fragModule;
+    shaderStages[1].pName = "main";
+
+    auto bindingDescription = Vertex::getBindingDescription();
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly(vk::PipelineInputAssemblyStateCreateFlags(), vk::PrimitiveTopology::eTriangleList, VK_FALSE);
+
+    vk::PipelineViewportStateCreateInfo viewportState;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    vk::PipelineRasterizationStateCreateInfo rasterizer;
+    rasterizer.polygonMode = vk::PolygonMode::eFill;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = vk::CullModeFlagBits::eBack;
+    rasterizer.frontFace = vk::FrontFace::eCounterClockwise;
+
+    vk::PipelineMultisampleStateCreateInfo multisampling;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+    vk::PipelineDepthStencilStateCreateInfo depthStencil(vk::PipelineDepthStencilStateCreateFlags(), VK_TRUE, VK_TRUE, vk::CompareOp::eLess, VK_FALSE, VK_FALSE);
+
+    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
+    colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+    vk::PipelineColorBlendStateCreateInfo colorBlending(vk::PipelineColorBlendStateCreateFlags(), VK_FALSE, vk::LogicOp::eCopy, 1, &colorBlendAttachment, { { 0.0f, 0.0f, 0.0f, 0.0f } });
+
+    vk::DynamicState dynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+    vk::PipelineDynamicStateCreateInfo dynamicState(vk::PipelineDynamicStateCreateFlags(), 2, dynamicStates);
+
+    vk::DescriptorSetLayout setLayouts[] = { sceneLayout, _lightSetLayout };
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+    pipelineLayoutInfo.setLayoutCount = 2;
+    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    vk::Result res = _device.createPipelineLayout(&pipelineLayoutInfo, nullptr, &_pipelineLayout);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create lit pipeline layout! error:" << res << std::endl;
+        std::abort();
+    }
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo(vk::PipelineCreateFlags(), 2, shaderStages, &vertexInputInfo, &inputAssembly, nullptr, &viewportState, &rasterizer, &multisampling, &depthStencil, &colorBlending, &dynamicState, _pipelineLayout, renderPass, 0, vk::Pipeline(), 0);
+    res = _device.createGraphicsPipelines(vk::PipelineCache(), 1, &pipelineInfo, nullptr, &_pipeline);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create lit pipeline! error:" << res << std::endl;
+        std::abort();
+    }
+}
+
+void ClusteredLighting::destroyRenderPipeline()
+{
+    if (!_pipeline) {
+        return;
+    }
+    _device.destroyPipeline(_pipeline);
+    _device.destroyPipelineLayout(_pipelineLayout);
+    _device.destroyShaderModule(_vertModule);
+    _device.destroyShaderModule(_fragModule);
+    _pipeline = vk::Pipeline();
+    _pipelineLayout = vk::PipelineLayout();
+    _vertModule = vk::ShaderModule();
+    _fragModule = vk::ShaderModule();
+}
+
+void ClusteredLighting::update(uint32_t slot, double time, const glm::mat4& view, const glm::mat4& projection, vk::Extent2D extent, float nearPlane, float farPlane)
+{
+    float seconds = static_cast<float>(time);
+    for (uint32_t i = 0; i < _lightCount; i++) {
+        const LightOrbit& orbit = _orbits[i];
+        float angle = orbit.angle + orbit.speed * seconds;
+        _lights[i].positionRadius[0] = orbit.radius * std::cos(angle);
+        _lights[i].positionRadius[1] = orbit.radius * std::sin(angle);
+        _lights[i].positionRadius[2] = orbit.height;
+    }
+    std::memcpy(_lightData + slot * _lightStride, _lights.data(), sizeof(PointLight) * _lightCount);
+
+    Parameters parameters;
+    parameters.view = view;
+    parameters.inverseProjection = glm::inverse(projection);
+    parameters.screenSize = glm::vec2(static_cast<float>(extent.width), static_cast<float>(extent.height));
+    parameters.nearPlane = nearPlane;
+    parameters.farPlane = farPlane;
+    parameters.lightCount = _lightCount;
+    std::memcpy(_parameters + slot * _parameterStride, &parameters, sizeof(Parameters));
+}
+
+void ClusteredLighting::recordAssignment(vk::CommandBuffer commandBuffer, uint32_t slot) const
+{
+    if (_assignmentTimer.isInitialized()) {
+        _assignmentTimer.writeBegin(commandBuffer, slot);
+    }
+
+    // The grid is shared between frames; the previous frame's fragments may still read it.
+    vk::MemoryBarrier toCompute(vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eShaderWrite);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), 1, &toCompute, 0, nullptr, 0, nullptr);
+    _assignment.dispatch(commandBuffer, _assignmentSet, ComputePipeline::groupCount(ClusterCount, LocalSize), 1, 1, dynamicOffsets(slot));
+    vk::MemoryBarrier toFragment(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlags(), 1, &toFragment, 0, nullptr, 0, nullptr);
+
+    if (_assignmentTimer.isInitialized()) {
+        _assignmentTimer.writeEnd(commandBuffer, slot);
+    }
+}
+
+void ClusteredLighting::recordDraw(vk::CommandBuffer commandBuffer, vk::DescriptorSet sceneSet, uint32_t slot, const MeshRange& mesh) const
+{
+    std::vector<uint32_t> offsets = dynamicOffsets(slot);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, _pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _pipelineLayout, 0, 1, &sceneSet, 0, nullptr);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _pipelineLayout, 1, 1, &_lightSet, static_cast<uint32_t>(offsets.size()), offsets.data());
+    commandBuffer.drawIndexed(mesh.indexCount, 1, mesh.firstIndex, mesh.vertexOffset, 0);
+}
+
+void ClusteredLighting::markSubmitted(uint32_t slot)
+{
+    if (_assignmentTimer.isInitialized()) {
+        _assignmentTimer.markSubmittedslot;
+    }
+}
+
+void ClusteredLighting::collect(uint32_t slot)
+{
+    double milliseconds = 0.0;
+    if (_assignmentTimer.isInitialized() && _assignmentTimer.collect(slot, milliseconds)) {
+        _assignmentTimes.add(milliseconds);
+    }
+}
+
+void ClusteredLighting::report(std::ostream& stream) const
+{
+    if (!isInitialized()) {
+        return;
+    }
+    stream << "  clustered lighting: " << _lightCount << " lights, " << ClusterCountX << "x" << ClusterCountY << "x" << ClusterCountZ << " clusters, up to " << MaxLightsPerCluster << " lights each";
+    if (_assignmentTimes.count() > 0) {
+        stream << std::fixed << std::setprecision(3);
+        stream << " | assignment mean " << _assignmentTimes.mean() << " ms, max " << _assignmentTimes.max() << " ms";
+        stream.unsetf(std::ios::floatfield);
+    }
+    stream << std::endl;
+}
+
+std::vector<uint32_t> ClusteredLighting::dynamicOffsets(uint32_t slot) const
+{
+    return { static_cast<uint32_t>(slot * _lightStride), static_cast<uint32_t>(slot * _parameterStride) };
+}
@@ -0,0 +1,118 @@
+#ifndef CLUSTEREDLIGHTING_H
+#define CLUSTEREDLIGHTING_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "computepipeline.h"
+#include "framestats.h"
+#include "geometrypool.h"
+#include "gputimer.h"
+#include "memorytracker.h"
+#include "shadercode.h"
+#include "vertex.h"
+
+struct PointLight {
+    float positionRadius[4];
+    float color[4];
+};
+
+// Clustered forward shading. A compute pass bins the point lights into a grid
+// of view-space froxels, tiles on screen and exponential slices in depth, and
+// the lit fragment shader only loops over the lights of its own cluster. The
+// cluster grid is built for the camera of the view it is recorded for.
+class ClusteredLighting {
+public:
+    static const uint32_t LocalSize = 64;
+    static const uint32_t ClusterCountX = 16;
+    static const uint32_t ClusterCountY = 9;
+    static const uint32_t ClusterCountZ = 24;
+    static const uint32_t ClusterCount = ClusterCountX * ClusterCountY * ClusterCountZ;
+    static const uint32_t MaxLightsPerCluster = 128;
+
+    ClusteredLighting();
+
+    bool loadShaders(const std::string& shaderDirectory);
+    void init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, uint32_t queueFamily, uint32_t lightCount, uint32_t slotCount);
+    void destroy();
+    bool isInitialized() const;
+    uint32_t lightCount() const;
+    uint32_t slotCount() const;
+
+    void createRenderPipeline(vk::RenderPass renderPass, vk::DescriptorSetLayout sceneLayout);
+    void destroyRenderPipeline();
+
+    // Slots pair with pre-recorded command buffers, as for ParticleSystem.
+    void update(uint32_t slot, double time, const glm::mat4& view, const glm::mat4& projection, vk::Extent2D extent, float nearPlane, float farPlane);
+    void recordAssignment(vk::CommandBuffer commandBuffer, uint32_t slot) const;
+    // Draws with the scene's vertex and index buffers, which must be bound.
+    void recordDraw(vk::CommandBuffer commandBuffer, vk::DescriptorSet sceneSet, uint32_t slot, const MeshRange& mesh) const;
+    void markSubmitted(uint32_t slot);
+    void collect(uint32_t slot);
+
+    void report(std::ostream& stream) const;
+
+private:
+    struct Parameters {
+        glm::mat4 view;
+        glm::mat4 inverseProjection;
+        glm::vec2 screenSize;
+        float nearPlane;
+        float farPlane;
+        uint32_t lightCount;
+    };
+
+    struct LightOrbit {
+        float radius;
+        float angle;
+        float speed;
+        float height;
+    };
+
+    std::vector<uint32_t> dynamicOffsets(uint32_t slot) const;
+
+    vk::Device _device;
+    MemoryTracker* _memoryTracker;
+    uint32_t _lightCount;
+    uint32_t _slotCount;
+    std::vector<LightOrbit> _orbits;
+    std::vector<PointLight> _lights;
+
+    std::vector<uint32_t> _compStorage;
+    std::vector<uint32_t> _vertStorage;
+    std::vector<uint32_t> _fragStorage;
+    ShaderCode _compCode;
+    ShaderCode _vertCode;
+    ShaderCode _fragCode;
+
+    vk::Buffer _lightBuffer;
+    vk::DeviceMemory _lightMemory;
+    uint8_t* _lightData;
+    vk::DeviceSize _lightStride;
+    vk::Buffer _clusterCountBuffer;
+    vk::DeviceMemory _clusterCountMemory;
+    vk::Buffer _clusterLightBuffer;
+    vk::DeviceMemory _clusterLightMemory;
+    vk::Buffer _parameterBuffer;
+    vk::DeviceMemory _parameterMemory;
+    uint8_t* _parameters;
+    vk::DeviceSize _parameterStride;
+
+    ComputePipeline _assignment;
+    vk::DescriptorSet _assignmentSet;
+    GpuTimer _assignmentTimer;
+    RunningStatistics _assignmentTimes;
+
+    vk::DescriptorSetLayout _lightSetLayout;
+    vk::DescriptorPool _lightPool;
+    vk::DescriptorSet _lightSet;
+    vk::ShaderModule _vertModule;
+    vk::ShaderModule _fragModule;
+    vk::PipelineLayout _pipelineLayout;
+    vk::Pipeline _pipeline;
+};
+
+#endif // CLUSTEREDLIGHTING_H
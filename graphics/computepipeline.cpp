@@ -0,0 +1,142 @@
+#include "computepipeline.h"
+#include "helperfunctions.h"
+
+#include <cstdlib>
+#include <iostream>
+
+ComputePipeline::ComputePipeline()
+{
+}
+
+void ComputePipeline::init(vk::Device device, vk::PipelineCache cache, const ShaderCode& code, const std::vector<vk::DescriptorType>& bindings, uint32_t maxSets)
+{
+    _device = device;
+    _bindings = bindings;
+    createShaderModule(_device, code, _shaderModule);
+
+    std::vector<vk::DescriptorSetLayoutBinding> layoutBindings(bindings.size());
+    std::vector<vk::DescriptorPoolSize> poolSizes(bindings.size());
+    for (size_t i = 0; i < bindings.size(); i++) {
+        layoutBindings[i].binding = static_cast<uint32_t>(i);
+        layoutBindings[i].descriptorType = bindings[i];
+        layoutBindings[i].descriptorCount = 1;
+        layoutBindings[i].stageFlags = vk::ShaderStageFlagBits::eCompute;
+        poolSizes[i].type = bindings[i];
+        poolSizes[i].descriptorCount = maxSets;
+    }
+
+    vk::DescriptorSetLayoutCreateInfo layoutInfo;
+    layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+    layoutInfo.pBindings = layoutBindings.data();
+    if (_device.createDescriptorSetLayout(&layoutInfo, nullptr, &_setLayout) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create compute descriptor set layout!" << std::endl;
+        std::abort();
+    }
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &_setLayout;
+    vk::Result res = _device.createPipelineLayout(&pipelineLayoutInfo, nullptr, &_pipelineLayout);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create compute pipeline layout! error:" << res << std::endl;
+        std::abort();
+    }
+
+    vk::ComputePipelineCreateInfo pipelineInfo;
+    pipelineInfo.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipelineInfo.stage.module = _shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = _pipelineLayout;
+    res = _device.createComputePipelines(cache, 1, &pipelineInfo, nullptr, &_pipeline);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create compute pipeline! error:" << res << std::endl;
+        std::abort();
+    }
+
+    vk::DescriptorPoolCreateInfo poolInfo(vk::DescriptorPoolCreateFlags(), maxSets, static_cast<uint32_t>(poolSizes.size()), poolSizes.data());
+    if (_device.createDescriptorPool(&poolInfo, nullptr, &_descriptorPool) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create compute descriptor pool!" << std::endl;
+        std::abort();
+    }
+}
+
+void ComputePipeline::destroy()
+{
+    if (!isInitialized()) {
+        return;
+    }
+    _device.destroyDescriptorPool(_descriptorPool);
+    _device.destroyPipeline(_pipeline);
+    _device.destroyPipelineLayout(_pipelineLayout);
+    _device.destroyDescriptorSetLayout(_setLayout);
+    _device.destroyShaderModule(_shaderModule);
+    _pipeline = vk::Pipeline();
+}
+
+bool ComputePipeline::isInitialized() const
+{
+    return static_cast<bool>(_pipeline);
+}
+
+vk::DescriptorSet ComputePipeline::allocateDescriptorSet()
+{
+    vk::DescriptorSet set;
+    vk::DescriptorSetAllocateInfo allocInfo(_descriptorPool, 1, &_setLayout);
+    if (_device.allocateDescriptorSets(&allocInfo, &set) != vk::Result::eSuccess) {
+        std::cerr << "Failed to allocate compute descriptor set!" << std::endl;
+        std::abort();
+    }
+    return set;
+}
+
+void ComputePipeline::bindBuffer(vk::DescriptorSet set, uint32_t binding, vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range) const
+{
+    vk::DescriptorBufferInfo bufferInfo(buffer, offset, range);
+
+    vk::WriteDescriptorSet write;
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.dstArrayElement = 0;
+    write.descriptorType = _bindings[binding];
+    write.descriptorCount = 1;
+    write.pBufferInfo = &bufferInfo;
+    _device.updateDescriptorSets(1, &write, 0, nullptr);
+}
+
+void ComputePipeline::bindImage(vk::DescriptorSet set, uint32_t binding, vk::ImageView view, vk::ImageLayout layout, vk::Sampler sampler) const
+{
+    vk::DescriptorImageInfo imageInfo(sampler, view, layout);
+
+    vk::WriteDescriptorSet write;
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.dstArrayElement = 0;
+    write.descriptorType = _bindings[binding];
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+    _device.updateDescriptorSets(1, &write, 0, nullptr);
+}
+
+void ComputePipeline::dispatch(vk::CommandBuffer commandBuffer, vk::DescriptorSet set, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ, const std::vector<uint32_t>& dynamicOffsets) const
+{
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, _pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _pipelineLayout, 0, 1, &set, static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+    commandBuffer.dispatch(groupCountX, groupCountY, groupCountZ);
+}
+
+uint32_t ComputePipeline::groupCount(uint32_t items, uint32_t localSize)
+{
+    return (items + localSize - 1) / localSize;
+}
+
+void recordComputeToVertexBarrier(vk::CommandBuffer commandBuffer, vk::Buffer buffer)
+{
+    vk::BufferMemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eVertexAttributeRead, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, buffer, 0, VK_WHOLE_SIZE);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eVertexInput, vk::DependencyFlags(), 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void recordVertexToComputeBarrier(vk::CommandBuffer commandBuffer, vk::Buffer buffer)
+{
+    vk::BufferMemoryBarrier barrier(vk::AccessFlagBits::eVertexAttributeRead, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, buffer, 0, VK_WHOLE_SIZE);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eVertexInput, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), 0, nullptr, 1, &barrier, 0, nullptr);
+}
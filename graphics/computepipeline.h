@@ -0,0 +1,42 @@
+#ifndef COMPUTEPIPELINE_H
+#define COMPUTEPIPELINE_H
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "shadercode.h"
+
+// A compute shader with its descriptor set layout, pipeline layout and a pool
+// for descriptor sets. Bindings are numbered in the order of their types.
+class ComputePipeline {
+public:
+    ComputePipeline();
+
+    void init(vk::Device device, vk::PipelineCache cache, const ShaderCode& code, const std::vector<vk::DescriptorType>& bindings, uint32_t maxSets = 1);
+    void destroy();
+    bool isInitialized() const;
+
+    vk::DescriptorSet allocateDescriptorSet();
+    void bindBuffer(vk::DescriptorSet set, uint32_t binding, vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE) const;
+    void bindImage(vk::DescriptorSet set, uint32_t binding, vk::ImageView view, vk::ImageLayout layout, vk::Sampler sampler = vk::Sampler()) const;
+
+    void dispatch(vk::CommandBuffer commandBuffer, vk::DescriptorSet set, uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1, const std::vector<uint32_t>& dynamicOffsets = std::vector<uint32_t>()) const;
+    static uint32_t groupCount(uint32_t items, uint32_t localSize);
+
+private:
+    vk::Device _device;
+    vk::ShaderModule _shaderModule;
+    vk::DescriptorSetLayout _setLayout;
+    vk::PipelineLayout _pipelineLayout;
+    vk::Pipeline _pipeline;
+    vk::DescriptorPool _descriptorPool;
+    std::vector<vk::DescriptorType> _bindings;
+};
+
+// Storage buffer written by a compute dispatch and read as vertex input, and
+// the reverse for the next dispatch overwriting data a draw may still read.
+void recordComputeToVertexBarrier(vk::CommandBuffer commandBuffer, vk::Buffer buffer);
+void recordVertexToComputeBarrier(vk::CommandBuffer commandBuffer, vk::Buffer buffer);
+
+#endif // COMPUTEPIPELINE_H
@@ -8,6 +8,8 @@
 #include <vulkan/vulkan.hpp>
 #include <iostream>
 
+#include "logger.h"
+
 
 const std::vector<const char*> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
@@ -39,7 +41,9 @@ static void DestroyDebugReportCallbackEXT(VkInstance instance, VkDebugReportCall
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objType, uint64_t obj, size_t location, int32_t code, const char* layerPrefix, const char* msg, void* userData)
 {
-    std::cerr << "validation layer: " << msg << std::endl;
+    // Called on driver threads and can fire for every draw, so never block here.
+    LogLevel level = (flags & VK_DEBUG_REPORT_ERROR_BIT_EXT) ? LogLevel::Error : (flags & (VK_DEBUG_REPORT_WARNING_BIT_EXT | VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT)) ? LogLevel::Warning : LogLevel::Info;
+    LOG_AT(LogCategory::Validation, level, "%s: %s", layerPrefix, msg);
 
     return VK_FALSE;
 }
@@ -0,0 +1,203 @@
+#include "drawlist.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+const uint32_t RadixBits = 8;
+const uint32_t RadixBuckets = 1u << RadixBits;
+const uint32_t RadixPasses = 64 / RadixBits;
+
+uint64_t field(uint32_t value, uint32_t bits)
+{
+    return static_cast<uint64_t>(std::min<uint32_t>(value, (1u << bits) - 1));
+}
+}
+
+uint64_t makeSortKey(uint32_t view, uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+    uint32_t depthMax = (1u << SortKeyDepthBits) - 1;
+    uint32_t quantizedDepth = static_cast<uint32_t>(std::min(std::max(depth, 0.0f), 1.0f) * static_cast<float>(depthMax));
+    uint64_t key = field(view, SortKeyViewBits);
+    key = (key << SortKeyPassBits) | field(pass, SortKeyPassBits);
+    key = (key << SortKeyPipelineBits) | field(pipeline, SortKeyPipelineBits);
+    key = (key << SortKeyMaterialBits) | field(material, SortKeyMaterialBits);
+    key = (key << SortKeyMeshBits) | field(mesh, SortKeyMeshBits);
+    key = (key << SortKeyDepthBits) | field(quantizedDepth, SortKeyDepthBits);
+    return key;
+}
+
+uint64_t DrawListStats::binds() const
+{
+    return pipelineBinds + descriptorSetBinds + vertexBufferBinds + indexBufferBinds;
+}
+
+DrawListStats& DrawListStats::operator+=(const DrawListStats& other)
+{
+    draws += other.draws;
+    pipelineBinds += other.pipelineBinds;
+    descriptorSetBinds += other.descriptorSetBinds;
+    vertexBufferBinds += other.vertexBufferBinds;
+    indexBufferBinds += other.indexBufferBinds;
+    pushConstants += other.pushConstants;
+    return *this;
+}
+
+DrawList::DrawList()
+    : _sorted(true)
+{
+}
+
+void DrawList::clear()
+{
+    _items.clear();
+    _entries.clear();
+    _sorted = true;
+}
+
+void DrawList::reserve(size_t count)
+{
+    _items.reserve(count);
+    _entries.reserve(count);
+    _scratch.reserve(count);
+}
+
+void DrawList::add(uint64_t key, const DrawItem& item)
+{
+    Entry entry;
+    entry.key = key;
+    entry.index = static_cast<uint32_t>(_items.size());
+    _sorted = _sorted && (_entries.empty() || _entries.back().key <= key);
+    _items.push_back(item);
+    _entries.push_back(entry);
+}
+
+size_t DrawList::size() const
+{
+    return _items.size();
+}
+
+void DrawList::sort()
+{
+    if (_sorted) {
+        return;
+    }
+    // LSD radix sort, stable, one byte per pass. All histograms come from a
+    // single read of the keys, and passes over bytes that are equal in every
+    // key are skipped, so unused key fields cost nothing.
+    size_t count = _entries.size();
+    std::array<std::array<uint32_t, RadixBuckets>, RadixPasses> histograms;
+    for (std::array<uint32_t, RadixBuckets>& histogram : histograms) {
+        histogram.fill(0);
+    }
+    for (const Entry& entry : _entries) {
+        for (uint32_t pass = 0; pass < RadixPasses; pass++) {
+            histograms[pass][(entry.key >> (pass * RadixBits)) & (RadixBuckets - 1)]++;
+        }
+    }
+
+    _scratch.resize(count);
+    for (uint32_t pass = 0; pass < RadixPasses; pass++) {
+        std::array<uint32_t, RadixBuckets>& histogram = histograms[pass];
+        uint32_t shift = pass * RadixBits;
+        if (histogram[(_entries[0].key >> shift) & (RadixBuckets - 1)] == count) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram) {
+            uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+        for (const Entry& entry : _entries) {
+            _scratch[histogram[(entry.key >> shift) & (RadixBuckets - 1)]++] = entry;
+        }
+        _entries.swap(_scratch);
+    }
+    _sorted = true;
+}
+
+const DrawItem& DrawList::sorted(size_t index) const
+{
+    return _items[_entries[index].index];
+}
+
+DrawListStats DrawList::record(vk::CommandBuffer commandBuffer) const
+{
+    return walk(&commandBuffer);
+}
+
+DrawListStats DrawList::countBinds() const
+{
+    return walk(nullptr);
+}
+
+DrawListStats DrawList::walk(vk::CommandBuffer* commandBuffer) const
+{
+    DrawListStats stats;
+    vk::Pipeline pipeline;
+    vk::PipelineLayout pipelineLayout;
+    vk::DescriptorSet descriptorSet;
+    vk::DescriptorSet materialSet;
+    uint32_t materialIndex = 0;
+    vk::Buffer vertexBuffer;
+    vk::Buffer indexBuffer;
+    vk::IndexType indexType = vk::IndexType::eUint16;
+    vk::DeviceSize vertexOffset = 0;
+
+    for (const Entry& entry : _entries) {
+        const DrawItem& item = _items[entry.index];
+        if (item.pipeline != pipeline) {
+            if (commandBuffer) {
+                commandBuffer->bindPipeline(vk::PipelineBindPoint::eGraphics, item.pipeline);
+            }
+            pipeline = item.pipeline;
+            stats.pipelineBinds++;
+        }
+        // A different layout may disturb the bound sets and push constants,
+        // so they are set again.
+        bool layoutChanged = item.pipelineLayout != pipelineLayout;
+        if (item.descriptorSet != descriptorSet || layoutChanged) {
+            if (commandBuffer) {
+                commandBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, item.pipelineLayout, 0, 1, &item.descriptorSet, 0, nullptr);
+            }
+            descriptorSet = item.descriptorSet;
+            stats.descriptorSetBinds++;
+        }
+        if (item.materialSet && (item.materialSet != materialSet || layoutChanged)) {
+            if (commandBuffer) {
+                commandBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, item.pipelineLayout, 1, 1, &item.materialSet, 0, nullptr);
+            }
+            materialSet = item.materialSet;
+            stats.descriptorSetBinds++;
+        }
+        if (item.materialSet && (item.materialIndex != materialIndex || layoutChanged)) {
+            if (commandBuffer) {
+                commandBuffer->pushConstants(item.pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(uint32_t), &item.materialIndex);
+            }
+            materialIndex = item.materialIndex;
+            stats.pushConstants++;
+        }
+        pipelineLayout = item.pipelineLayout;
+        if (item.vertexBuffer && item.vertexBuffer != vertexBuffer) {
+            if (commandBuffer) {
+                commandBuffer->bindVertexBuffers(0, 1, &item.vertexBuffer, &vertexOffset);
+            }
+            vertexBuffer = item.vertexBuffer;
+            stats.vertexBufferBinds++;
+        }
+        if (item.indexBuffer && (item.indexBuffer != indexBuffer || item.indexType != indexType)) {
+            if (commandBuffer) {
+                commandBuffer->bindIndexBuffer(item.indexBuffer, 0, item.indexType);
+            }
+            indexBuffer = item.indexBuffer;
+            indexType = item.indexType;
+            stats.indexBufferBinds++;
+        }
+        if (commandBuffer) {
+            commandBuffer->drawIndexed(item.indexCount, item.instanceCount, item.firstIndex, item.vertexOffset, item.firstInstance);
+        }
+        stats.draws++;
+    }
+    return stats;
+}
@@ -0,0 +1,87 @@
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// Sort key layout, most significant first: view, pass, pipeline, material,
+// mesh and quantized depth. Sorting by key groups draws by the state that is
+// most expensive to change. Depth is in [0, 1]; pass 1 - depth for passes
+// that draw back to front.
+const uint32_t SortKeyViewBits = 4;
+const uint32_t SortKeyPassBits = 4;
+const uint32_t SortKeyPipelineBits = 12;
+const uint32_t SortKeyMaterialBits = 16;
+const uint32_t SortKeyMeshBits = 12;
+const uint32_t SortKeyDepthBits = 16;
+
+uint64_t makeSortKey(uint32_t view, uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+struct DrawItem {
+    vk::Pipeline pipeline;
+    vk::PipelineLayout pipelineLayout;
+    vk::DescriptorSet descriptorSet;
+    // Bound at set 1 when set; the material index is then pushed as a vertex
+    // and fragment push constant at offset 0.
+    vk::DescriptorSet materialSet;
+    uint32_t materialIndex = 0;
+    // Null buffers keep whatever is bound, e.g. the shared geometry pool.
+    vk::Buffer vertexBuffer;
+    vk::Buffer indexBuffer;
+    vk::IndexType indexType = vk::IndexType::eUint16;
+    uint32_t indexCount = 0;
+    uint32_t instanceCount = 1;
+    uint32_t firstIndex = 0;
+    int32_t vertexOffset = 0;
+    uint32_t firstInstance = 0;
+};
+
+struct DrawListStats {
+    uint64_t draws = 0;
+    uint64_t pipelineBinds = 0;
+    uint64_t descriptorSetBinds = 0;
+    uint64_t vertexBufferBinds = 0;
+    uint64_t indexBufferBinds = 0;
+    uint64_t pushConstants = 0;
+
+    uint64_t binds() const;
+    DrawListStats& operator+=(const DrawListStats& other);
+};
+
+// Draws are collected with their sort keys, radix sorted and recorded in key
+// order; binds that would not change the bound state are skipped. Storage is
+// kept between frames, so a list that is cleared and refilled every frame
+// stops allocating once it has reached its peak size.
+class DrawList {
+public:
+    DrawList();
+
+    void clear();
+    void reserve(size_t count);
+    void add(uint64_t key, const DrawItem& item);
+    size_t size() const;
+
+    void sort();
+    const DrawItem& sorted(size_t index) const;
+
+    DrawListStats record(vk::CommandBuffer commandBuffer) const;
+    // Bind counts record() would produce, without a command buffer.
+    DrawListStats countBinds() const;
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    DrawListStats walk(vk::CommandBuffer* commandBuffer) const;
+
+    std::vector<DrawItem> _items;
+    std::vector<Entry> _entries;
+    std::vector<Entry> _scratch;
+    bool _sorted;
+};
+
+#endif // DRAWLIST_H
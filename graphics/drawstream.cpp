@@ -0,0 +1,356 @@
+#include "drawstream.h"
+
+#include <fstream>
+#include <iostream>
+
+namespace {
+void copyName(const std::string& name, char* destination)
+{
+    std::strncpy(destination, name.c_str(), DrawStreamShaderNameSize - 1);
+    destination[DrawStreamShaderNameSize - 1] = '\0';
+}
+
+size_t frameViewSize(uint32_t uniformSize)
+{
+    return sizeof(DrawStreamFrameView) + uniformSize;
+}
+}
+
+DrawStreamMaterial makeStreamMaterial(MaterialHandle handle, const MaterialDesc& desc)
+{
+    const PipelineState& state = desc.state;
+    DrawStreamMaterial material = DrawStreamMaterial();
+    material.handle = handle;
+    material.topology = static_cast<uint32_t>(state.topology);
+    material.polygonMode = static_cast<uint32_t>(state.polygonMode);
+    material.cullMode = static_cast<uint32_t>(static_cast<VkCullModeFlags>(state.cullMode));
+    material.frontFace = static_cast<uint32_t>(state.frontFace);
+    material.depthTest = state.depthTest;
+    material.depthWrite = state.depthWrite;
+    material.depthCompare = static_cast<uint32_t>(state.depthCompare);
+    material.blend = state.blend;
+    material.srcColorBlend = static_cast<uint32_t>(state.srcColorBlend);
+    material.dstColorBlend = static_cast<uint32_t>(state.dstColorBlend);
+    material.colorBlendOp = static_cast<uint32_t>(state.colorBlendOp);
+    material.parameters = desc.parameters;
+    copyName(state.vertexShader, material.vertexShader);
+    copyName(state.fragmentShader, material.fragmentShader);
+    return material;
+}
+
+MaterialDesc makeMaterialDesc(const DrawStreamMaterial& material)
+{
+    MaterialDesc desc;
+    desc.name = "material" + std::to_string(material.handle);
+    PipelineState& state = desc.state;
+    state.vertexShader = std::string(material.vertexShader, strnlen(material.vertexShader, DrawStreamShaderNameSize));
+    state.fragmentShader = std::string(material.fragmentShader, strnlen(material.fragmentShader, DrawStreamShaderNameSize));
+    state.topology = static_cast<vk::PrimitiveTopology>(material.topology);
+    state.polygonMode = static_cast<vk::PolygonMode>(material.polygonMode);
+    state.cullMode = vk::CullModeFlags(static_cast<vk::CullModeFlagBits>(material.cullMode));
+    state.frontFace = static_cast<vk::FrontFace>(material.frontFace);
+    state.depthTest = material.depthTest != 0;
+    state.depthWrite = material.depthWrite != 0;
+    state.depthCompare = static_cast<vk::CompareOp>(material.depthCompare);
+    state.blend = material.blend != 0;
+    state.srcColorBlend = static_cast<vk::BlendFactor>(material.srcColorBlend);
+    state.dstColorBlend = static_cast<vk::BlendFactor>(material.dstColorBlend);
+    state.colorBlendOp = static_cast<vk::BlendOp>(material.colorBlendOp);
+    desc.parameters = material.parameters;
+    return desc;
+}
+
+DrawStreamWriter::DrawStreamWriter()
+    : _file(nullptr)
+    , _failed(false)
+    , _uniformSize(0)
+    , _frameViews(0)
+    , _frameCount(0)
+    , _bytesWritten(0)
+{
+}
+
+DrawStreamWriter::~DrawStreamWriter()
+{
+    close();
+}
+
+bool DrawStreamWriter::open(const std::string& path, uint32_t uniformSize)
+{
+    close();
+    _file = std::fopen(path.c_str(), "wb");
+    if (!_file) {
+        std::cerr << "Failed to create draw stream: [" << path << "]" << std::endl;
+        return false;
+    }
+    _path = path;
+    _failed = false;
+    _uniformSize = uniformSize;
+    _frame.assign(sizeof(DrawStreamFrame) + DrawStreamMaxViews * frameViewSize(uniformSize), 0);
+    _frameViews = 0;
+    _frameCount = 0;
+    _start = std::chrono::steady_clock::now();
+
+    DrawStreamHeader header;
+    std::memcpy(header.magic, DrawStreamMagic, sizeof(DrawStreamMagic));
+    header.version = DrawStreamVersion;
+    header.uniformSize = uniformSize;
+    header.vertexSize = sizeof(Vertex);
+    _bytesWritten = std::fwrite(&header, 1, sizeof(header), _file);
+    if (_bytesWritten != sizeof(header)) {
+        _failed = true;
+        return close();
+    }
+    return true;
+}
+
+bool DrawStreamWriter::close()
+{
+    if (!_file) {
+        return true;
+    }
+    bool closed = std::fclose(_file) == 0;
+    _file = nullptr;
+    if (_failed || !closed) {
+        std::cerr << "Failed to write draw stream: [" << _path << "]" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool DrawStreamWriter::isOpen() const
+{
+    return _file != nullptr;
+}
+
+void DrawStreamWriter::write(DrawStreamRecordType type, const void* data, size_t size, const void* extra, size_t extraSize, const void* extra2, size_t extra2Size)
+{
+    DrawStreamRecordHeader header;
+    header.type = type;
+    header.size = static_cast<uint32_t>(size + extraSize + extra2Size);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_failed) {
+        return;
+    }
+    size_t written = std::fwrite(&header, 1, sizeof(header), _file);
+    written += std::fwrite(data, 1, size, _file);
+    if (extraSize != 0) {
+        written += std::fwrite(extra, 1, extraSize, _file);
+    }
+    if (extra2Size != 0) {
+        written += std::fwrite(extra2, 1, extra2Size, _file);
+    }
+    _bytesWritten += written;
+    _failed = written != sizeof(header) + size + extraSize + extra2Size;
+}
+
+void DrawStreamWriter::view(uint32_t view, uint32_t slotCount, uint32_t width, uint32_t height)
+{
+    if (!_file) {
+        return;
+    }
+    DrawStreamView record = { view, slotCount, width, height };
+    write(DrawStreamRecordType::View, &record, sizeof(record));
+}
+
+void DrawStreamWriter::material(MaterialHandle handle, const MaterialDesc& desc)
+{
+    if (!_file) {
+        return;
+    }
+    DrawStreamMaterial record = makeStreamMaterial(handle, desc);
+    write(DrawStreamRecordType::Material, &record, sizeof(record));
+}
+
+void DrawStreamWriter::mesh(MeshHandle handle, const Vertex* vertices, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount)
+{
+    if (!_file) {
+        return;
+    }
+    DrawStreamMesh record = { handle, vertexCount, indexCount };
+    write(DrawStreamRecordType::Mesh, &record, sizeof(record), vertices, vertexCount * sizeof(Vertex), indices, indexCount * sizeof(uint16_t));
+}
+
+void DrawStreamWriter::commands(uint32_t view, uint32_t slot, uint32_t width, uint32_t height, const std::vector<DrawStreamDraw>& draws)
+{
+    if (!_file) {
+        return;
+    }
+    DrawStreamCommands record = { view, slot, width, height, static_cast<uint32_t>(draws.size()) };
+    write(DrawStreamRecordType::Commands, &record, sizeof(record), draws.data(), draws.size() * sizeof(DrawStreamDraw));
+}
+
+void DrawStreamWriter::uniforms(uint32_t view, uint32_t slot, const void* data)
+{
+    if (!_file || _frameViews == DrawStreamMaxViews) {
+        return;
+    }
+    char* destination = _frame.data() + sizeof(DrawStreamFrame) + _frameViews * frameViewSize(_uniformSize);
+    DrawStreamFrameView frameView = { view, slot };
+    std::memcpy(destination, &frameView, sizeof(frameView));
+    std::memcpy(destination + sizeof(frameView), data, _uniformSize);
+    _frameViews++;
+}
+
+void DrawStreamWriter::frame()
+{
+    if (!_file) {
+        return;
+    }
+    DrawStreamFrame record;
+    record.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+    record.viewCount = _frameViews;
+    record.reserved = 0;
+    std::memcpy(_frame.data(), &record, sizeof(record));
+    write(DrawStreamRecordType::Frame, _frame.data(), sizeof(DrawStreamFrame) + _frameViews * frameViewSize(_uniformSize));
+    _frameViews = 0;
+    _frameCount++;
+}
+
+uint64_t DrawStreamWriter::frameCount() const
+{
+    return _frameCount;
+}
+
+uint64_t DrawStreamWriter::bytesWritten() const
+{
+    return _bytesWritten;
+}
+
+DrawStreamReader::DrawStreamReader()
+    : _uniformSize(0)
+    , _recordCount(0)
+    , _frameCount(0)
+    , _position(0)
+{
+}
+
+bool DrawStreamReader::open(const std::string& path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open draw stream: [" << path << "]" << std::endl;
+        return false;
+    }
+    _data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(_data.data(), static_cast<std::streamsize>(_data.size()));
+    if (!file) {
+        std::cerr << "Failed to read draw stream: [" << path << "]" << std::endl;
+        return false;
+    }
+    return validate(path);
+}
+
+bool DrawStreamReader::validate(const std::string& path)
+{
+    DrawStreamHeader header;
+    if (_data.size() < sizeof(header)) {
+        std::cerr << "Not a draw stream: [" << path << "]" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, _data.data(), sizeof(header));
+    if (std::memcmp(header.magic, DrawStreamMagic, sizeof(DrawStreamMagic)) != 0 || header.version != DrawStreamVersion || header.vertexSize != sizeof(Vertex)) {
+        std::cerr << "Not a version " << DrawStreamVersion << " draw stream: [" << path << "]" << std::endl;
+        return false;
+    }
+    _uniformSize = header.uniformSize;
+    _recordCount = 0;
+    _frameCount = 0;
+
+    size_t position = sizeof(header);
+    while (position < _data.size()) {
+        DrawStreamRecordHeader record;
+        bool valid = _data.size() - position >= sizeof(record);
+        if (valid) {
+            std::memcpy(&record, _data.data() + position, sizeof(record));
+            position += sizeof(record);
+            valid = record.size <= _data.size() - position;
+        }
+        if (valid) {
+            const char* payload = _data.data() + position;
+            size_t size = record.size;
+            switch (record.type) {
+            case DrawStreamRecordType::View:
+                valid = size == sizeof(DrawStreamView);
+                break;
+            case DrawStreamRecordType::Material:
+                valid = size == sizeof(DrawStreamMaterial);
+                break;
+            case DrawStreamRecordType::Mesh: {
+                DrawStreamMesh mesh;
+                valid = size >= sizeof(mesh);
+                if (valid) {
+                    std::memcpy(&mesh, payload, sizeof(mesh));
+                    valid = size == sizeof(mesh) + static_cast<uint64_t>(mesh.vertexCount) * sizeof(Vertex) + static_cast<uint64_t>(mesh.indexCount) * sizeof(uint16_t);
+                }
+                break;
+            }
+            case DrawStreamRecordType::Commands: {
+                DrawStreamCommands commands;
+                valid = size >= sizeof(commands);
+                if (valid) {
+                    std::memcpy(&commands, payload, sizeof(commands));
+                    valid = size == sizeof(commands) + static_cast<uint64_t>(commands.drawCount) * sizeof(DrawStreamDraw);
+                }
+                break;
+            }
+            case DrawStreamRecordType::Frame: {
+                DrawStreamFrame frame;
+                valid = size >= sizeof(frame);
+                if (valid) {
+                    std::memcpy(&frame, payload, sizeof(frame));
+                    valid = frame.viewCount <= DrawStreamMaxViews && size == sizeof(frame) + frame.viewCount * frameViewSize(_uniformSize);
+                    _frameCount++;
+                }
+                break;
+            }
+            default:
+                valid = false;
+                break;
+            }
+            position += size;
+        }
+        if (!valid) {
+            std::cerr << "Corrupt record " << _recordCount << " in draw stream: [" << path << "]" << std::endl;
+            return false;
+        }
+        _recordCount++;
+    }
+    rewind();
+    return true;
+}
+
+uint32_t DrawStreamReader::uniformSize() const
+{
+    return _uniformSize;
+}
+
+size_t DrawStreamReader::recordCount() const
+{
+    return _recordCount;
+}
+
+uint64_t DrawStreamReader::frameCount() const
+{
+    return _frameCount;
+}
+
+bool DrawStreamReader::next(DrawStreamRecord& record)
+{
+    if (_position >= _data.size()) {
+        return false;
+    }
+    DrawStreamRecordHeader header;
+    std::memcpy(&header, _data.data() + _position, sizeof(header));
+    record.type = header.type;
+    record.data = _data.data() + _position + sizeof(header);
+    record.size = header.size;
+    _position += sizeof(header) + header.size;
+    return true;
+}
+
+void DrawStreamReader::rewind()
+{
+    _position = sizeof(DrawStreamHeader);
+}
@@ -0,0 +1,192 @@
+#ifndef DRAWSTREAM_H
+#define DRAWSTREAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "geometrypool.h"
+#include "materialsystem.h"
+#include "vertex.h"
+
+// Stream layout, native byte order: header, then records of a
+// DrawStreamRecordHeader followed by its payload. Swap chain, material and
+// mesh records create resources; a commands record replaces what one view's
+// command buffer slot draws; a frame record carries the uniforms of every view
+// drawn in that frame and when it was submitted.
+const char DrawStreamMagic[4] = { 'E', 'D', 'R', 'S' };
+const uint32_t DrawStreamVersion = 1;
+const uint32_t DrawStreamMaxViews = 16;
+const size_t DrawStreamShaderNameSize = 32;
+
+enum class DrawStreamRecordType : uint32_t {
+    View = 1,
+    Material,
+    Mesh,
+    Commands,
+    Frame
+};
+
+struct DrawStreamHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t uniformSize;
+    uint32_t vertexSize;
+};
+
+struct DrawStreamRecordHeader {
+    DrawStreamRecordType type;
+    uint32_t size;
+};
+
+struct DrawStreamView {
+    uint32_t view;
+    uint32_t slotCount;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct DrawStreamMaterial {
+    uint32_t handle;
+    uint32_t topology;
+    uint32_t polygonMode;
+    uint32_t cullMode;
+    uint32_t frontFace;
+    uint32_t depthTest;
+    uint32_t depthWrite;
+    uint32_t depthCompare;
+    uint32_t blend;
+    uint32_t srcColorBlend;
+    uint32_t dstColorBlend;
+    uint32_t colorBlendOp;
+    MaterialParameters parameters;
+    char vertexShader[DrawStreamShaderNameSize];
+    char fragmentShader[DrawStreamShaderNameSize];
+};
+
+// Followed by vertexCount vertices and indexCount 16 bit indices.
+struct DrawStreamMesh {
+    uint32_t handle;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+};
+
+// Followed by drawCount DrawStreamDraws; width and height are the render
+// extent, which is smaller than the view with dynamic resolution.
+struct DrawStreamCommands {
+    uint32_t view;
+    uint32_t slot;
+    uint32_t width;
+    uint32_t height;
+    uint32_t drawCount;
+};
+
+struct DrawStreamDraw {
+    uint32_t material;
+    uint32_t mesh;
+    uint32_t instanceCount;
+    uint32_t firstInstance;
+};
+
+// Followed by viewCount times the view index, its slot and uniformSize bytes.
+struct DrawStreamFrame {
+    uint64_t nanoseconds;
+    uint32_t viewCount;
+    uint32_t reserved;
+};
+
+struct DrawStreamFrameView {
+    uint32_t view;
+    uint32_t slot;
+};
+
+DrawStreamMaterial makeStreamMaterial(MaterialHandle handle, const MaterialDesc& desc);
+MaterialDesc makeMaterialDesc(const DrawStreamMaterial& material);
+
+// Appends the draw stream of a session to a file. Resource records may come
+// from startup steps on any thread; uniforms() and frame() are called by the
+// render loop and neither allocates.
+class DrawStreamWriter {
+public:
+    DrawStreamWriter();
+    ~DrawStreamWriter();
+    DrawStreamWriter(const DrawStreamWriter&) = delete;
+    DrawStreamWriter& operator=(const DrawStreamWriter&) = delete;
+
+    bool open(const std::string& path, uint32_t uniformSize);
+    // False when a write failed; records after the first failure are dropped.
+    bool close();
+    bool isOpen() const;
+
+    void view(uint32_t view, uint32_t slotCount, uint32_t width, uint32_t height);
+    void material(MaterialHandle handle, const MaterialDesc& desc);
+    void mesh(MeshHandle handle, const Vertex* vertices, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount);
+    void commands(uint32_t view, uint32_t slot, uint32_t width, uint32_t height, const std::vector<DrawStreamDraw>& draws);
+    // Collects the uniforms of one view; frame() writes them with the time.
+    void uniforms(uint32_t view, uint32_t slot, const void* data);
+    void frame();
+
+    uint64_t frameCount() const;
+    uint64_t bytesWritten() const;
+
+private:
+    void write(DrawStreamRecordType type, const void* data, size_t size, const void* extra = nullptr, size_t extraSize = 0, const void* extra2 = nullptr, size_t extra2Size = 0);
+
+    std::FILE* _file;
+    std::string _path;
+    bool _failed;
+    std::mutex _mutex;
+    uint32_t _uniformSize;
+    std::vector<char> _frame;
+    uint32_t _frameViews;
+    std::chrono::steady_clock::time_point _start;
+    uint64_t _frameCount;
+    uint64_t _bytesWritten;
+};
+
+struct DrawStreamRecord {
+    DrawStreamRecordType type;
+    const char* data;
+    size_t size;
+};
+
+// Reads a whole stream into memory. Every record is checked once by open(),
+// so the payload sizes can be trusted while iterating.
+class DrawStreamReader {
+public:
+    DrawStreamReader();
+
+    bool open(const std::string& path);
+    uint32_t uniformSize() const;
+    size_t recordCount() const;
+    uint64_t frameCount() const;
+
+    // Records in stream order; false after the last one.
+    bool next(DrawStreamRecord& record);
+    void rewind();
+
+    // Copies the fixed part of a record's payload.
+    template <typename T>
+    static T fixedPart(const DrawStreamRecord& record)
+    {
+        T value;
+        std::memcpy(&value, record.data, sizeof(T));
+        return value;
+    }
+
+private:
+    bool validate(const std::string& path);
+
+    std::vector<char> _data;
+    uint32_t _uniformSize;
+    size_t _recordCount;
+    uint64_t _frameCount;
+    size_t _position;
+};
+
+#endif // DRAWSTREAM_H
@@ -0,0 +1,92 @@
+#include "framearena.h"
+
+#include <algorithm>
+
+FrameArena::FrameArena(size_t blockSize)
+    : _block(0)
+    , _offset(0)
+    , _used(0)
+    , _peak(0)
+    , _overflows(0)
+{
+    addBlock(blockSize);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    for (;;) {
+        Block& block = _blocks[_block];
+        size_t offset = (_offset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= block.size) {
+            _offset = offset + size;
+            _used += size;
+            _peak = std::max(_peak, _used);
+            return block.memory.get() + offset;
+        }
+        if (_block + 1 == _blocks.size()) {
+            addBlock(std::max(size + alignment, block.size * 2));
+            _overflows++;
+        }
+        _block++;
+        _offset = 0;
+    }
+}
+
+void FrameArena::reset()
+{
+    if (_blocks.size() > 1) {
+        addBlock(capacity());
+        _blocks.erase(_blocks.begin(), _blocks.end() - 1);
+    }
+    _block = 0;
+    _offset = 0;
+    _used = 0;
+}
+
+size_t FrameArena::used() const
+{
+    return _used;
+}
+
+size_t FrameArena::capacity() const
+{
+    size_t capacity = 0;
+    for (const Block& block : _blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+size_t FrameArena::peak() const
+{
+    return _peak;
+}
+
+uint64_t FrameArena::overflows() const
+{
+    return _overflows;
+}
+
+void FrameArena::addBlock(size_t minimumSize)
+{
+    Block block;
+    block.memory.reset(new uint8_t[minimumSize]);
+    block.size = minimumSize;
+    _blocks.push_back(std::move(block));
+}
+
+void reportFrameArenas(std::ostream& stream, const std::vector<std::unique_ptr<FrameArena>>& arenas)
+{
+    if (arenas.empty()) {
+        return;
+    }
+    size_t capacity = 0;
+    size_t peak = 0;
+    uint64_t overflows = 0;
+    for (const std::unique_ptr<FrameArena>& arena : arenas) {
+        capacity = std::max(capacity, arena->capacity());
+        peak = std::max(peak, arena->peak());
+        overflows += arena->overflows();
+    }
+    stream << "  frame arenas: " << arenas.size() << " x " << capacity << " bytes, peak " << peak << " bytes per frame, " << overflows << " overflow blocks" << std::endl;
+}
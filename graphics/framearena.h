@@ -0,0 +1,99 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+// Bump allocator for data that lives as long as one frame in flight. Nothing
+// is freed individually; reset() releases everything at once and is called
+// when the fence of the arena's frame has signalled. An allocation that does
+// not fit chains another block, and reset() folds the blocks into one sized
+// for the peak, so an arena stops touching the heap once it has seen its
+// largest frame.
+class FrameArena {
+public:
+    explicit FrameArena(size_t blockSize = 64 * 1024);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+    void reset();
+
+    size_t used() const;
+    size_t capacity() const;
+    size_t peak() const;
+    uint64_t overflows() const;
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> memory;
+        size_t size;
+    };
+
+    void addBlock(size_t minimumSize);
+
+    std::vector<Block> _blocks;
+    size_t _block;
+    size_t _offset;
+    size_t _used;
+    size_t _peak;
+    uint64_t _overflows;
+};
+
+// STL allocator drawing from a FrameArena; deallocation is a no-op.
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(FrameArena& arena)
+        : _arena(&arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+        : _arena(other.arena())
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t)
+    {
+    }
+
+    FrameArena* arena() const
+    {
+        return _arena;
+    }
+
+private:
+    FrameArena* _arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena() != b.arena();
+}
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+void reportFrameArenas(std::ostream& stream, const std::vector<std::unique_ptr<FrameArena>>& arenas);
+
+#endif // FRAMEARENA_H
@@ -0,0 +1,162 @@
+#include "framecapture.h"
+#include "logger.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+bool pixelLayoutForFormat(vk::Format format, PixelLayout& layout)
+{
+    switch (format) {
+    case vk::Format::eB8G8R8A8Unorm:
+    case vk::Format::eB8G8R8A8Srgb:
+        layout = PixelLayout::BGRA8;
+        return true;
+    case vk::Format::eR8G8B8A8Unorm:
+    case vk::Format::eR8G8B8A8Srgb:
+        layout = PixelLayout::RGBA8;
+        return true;
+    default:
+        return false;
+    }
+}
+
+struct PendingImage {
+    std::string path;
+    uint32_t width;
+    uint32_t height;
+    bool png;
+    std::vector<uint8_t> rgb;
+};
+}
+
+FrameCapture::FrameCapture(JobSystem& jobs)
+    : _jobs(jobs)
+    , _enabled(false)
+    , _consumedFrames(0)
+    , _consumedBytes(0)
+{
+}
+
+bool FrameCapture::open(const CaptureSettings& settings)
+{
+    _settings = settings;
+    if (_settings.interval == 0) {
+        _settings.interval = 1;
+    }
+    _enabled = !_settings.directory.empty() || !_settings.hashFile.empty() || !_settings.stream.empty() || _settings.keepHashes;
+    if (!_enabled) {
+        return true;
+    }
+
+    if (!_settings.hashFile.empty()) {
+        _hashFile.open(_settings.hashFile);
+        if (!_hashFile.is_open()) {
+            std::cerr << "Failed to open hash file: [" << _settings.hashFile << "]" << std::endl;
+            return false;
+        }
+    }
+    if (!_settings.stream.empty() && !_stream.open(_settings.stream)) {
+        return false;
+    }
+    return true;
+}
+
+void FrameCapture::close()
+{
+    _jobs.wait(_pendingWrites);
+    _stream.close();
+    _hashFile.close();
+}
+
+void FrameCapture::disable()
+{
+    close();
+    _enabled = false;
+}
+
+bool FrameCapture::isEnabled() const
+{
+    return _enabled;
+}
+
+bool FrameCapture::shouldCapture(uint64_t frameIndex) const
+{
+    return _enabled && frameIndex % _settings.interval == 0;
+}
+
+void FrameCapture::consume(const CapturedFrame& frame)
+{
+    PixelLayout layout;
+    if (!pixelLayoutForFormat(frame.format, layout)) {
+        LOG_WARNING(LogCategory::Capture, "Cannot capture swapchain format %s", vk::to_string(frame.format).c_str());
+        _enabled = false;
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (_consumedFrames == 0) {
+        _firstFrame = now;
+    }
+    _lastFrame = now;
+    _consumedFrames++;
+    _consumedBytes += frame.rowPitch * frame.height;
+
+    convertToRGB(frame.pixels, frame.width, frame.height, frame.rowPitch, layout, _rgb);
+
+    if (_hashFile.is_open() || _settings.keepHashes) {
+        uint64_t hash = hashPixels(_rgb.data(), _rgb.size());
+        if (_hashFile.is_open()) {
+            _hashFile << frame.frameIndex << " " << hashToString(hash) << "\n";
+        }
+        if (_settings.keepHashes) {
+            _hashes.push_back(std::make_pair(frame.frameIndex, hash));
+        }
+    }
+
+    if (_stream.isOpen()) {
+        _stream.write(_rgb);
+    }
+
+    if (!_settings.directory.empty()) {
+        bool png = _settings.format != "ppm";
+        std::ostringstream path;
+        path << _settings.directory << "/frame_" << std::setw(6) << std::setfill('0') << frame.frameIndex << (png ? ".png" : ".ppm");
+
+        PendingImage* image = new PendingImage();
+        image->path = path.str();
+        image->width = frame.width;
+        image->height = frame.height;
+        image->png = png;
+        image->rgb = _rgb;
+        _jobs.run([image]() {
+            if (image->png) {
+                writePNG(image->path, image->width, image->height, image->rgb);
+            } else {
+                writePPM(image->path, image->width, image->height, image->rgb);
+            }
+            delete image;
+        }, &_pendingWrites);
+    }
+}
+
+const std::vector<std::pair<uint64_t, uint64_t>>& FrameCapture::hashes() const
+{
+    return _hashes;
+}
+
+void FrameCapture::report(std::ostream& stream, const FrameReadback& readback) const
+{
+    if (!_enabled && _consumedFrames == 0) {
+        return;
+    }
+    double seconds = std::chrono::duration<double>(_lastFrame - _firstFrame).count();
+    double framesPerSecond = seconds > 0.0 ? static_cast<double>(_consumedFrames - 1) / seconds : 0.0;
+    double megabytesPerSecond = seconds > 0.0 ? static_cast<double>(_consumedBytes) / (1024.0 * 1024.0) / seconds : 0.0;
+    stream << "[capture] frames: " << _consumedFrames << " throughput: " << framesPerSecond << " frames/sec, " << megabytesPerSecond << " MB/s, readback stalls: " << readback.stalls();
+    if (_stream.isOpen() || _stream.bytesWritten() > 0) {
+        stream << ", streamed " << _stream.bytesWritten() / (1024 * 1024) << " MB";
+    }
+    stream << std::endl;
+}
@@ -0,0 +1,48 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "framereadback.h"
+#include "imagewriter.h"
+#include "jobsystem.h"
+#include "settings.h"
+
+// Consumes frames collected by FrameReadback: hashes them, streams raw RGB to
+// a file or pipe, and hands image encoding to the job system.
+class FrameCapture {
+public:
+    explicit FrameCapture(JobSystem& jobs);
+
+    bool open(const CaptureSettings& settings);
+    void close();
+    void disable();
+    bool isEnabled() const;
+    bool shouldCapture(uint64_t frameIndex) const;
+    void consume(const CapturedFrame& frame);
+
+    const std::vector<std::pair<uint64_t, uint64_t>>& hashes() const;
+    void report(std::ostream& stream, const FrameReadback& readback) const;
+
+private:
+    JobSystem& _jobs;
+    JobCounter _pendingWrites;
+    CaptureSettings _settings;
+    bool _enabled;
+    std::ofstream _hashFile;
+    FrameStream _stream;
+    std::vector<uint8_t> _rgb;
+    std::vector<std::pair<uint64_t, uint64_t>> _hashes;
+    std::chrono::steady_clock::time_point _firstFrame;
+    std::chrono::steady_clock::time_point _lastFrame;
+    uint64_t _consumedFrames;
+    uint64_t _consumedBytes;
+};
+
+#endif // FRAMECAPTURE_H
@@ -0,0 +1,49 @@
+#include "framepacer.h"
+
+#include <thread>
+
+namespace {
+const std::chrono::microseconds SpinThreshold(1500);
+}
+
+FramePacer::FramePacer(double frameRate)
+    : _interval(Clock::duration::zero())
+{
+    setFrameRate(frameRate);
+}
+
+void FramePacer::setFrameRate(double frameRate)
+{
+    if (frameRate > 0.0) {
+        _interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameRate));
+    } else {
+        _interval = Clock::duration::zero();
+    }
+    _nextFrame = Clock::now();
+}
+
+bool FramePacer::isEnabled() const
+{
+    return _interval > Clock::duration::zero();
+}
+
+void FramePacer::wait()
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+    if (now > _nextFrame + _interval) {
+        // Missed more than a whole frame; restart the cadence rather than bursting.
+        _nextFrame = now;
+    }
+
+    if (_nextFrame - now > SpinThreshold) {
+        std::this_thread::sleep_until(_nextFrame - SpinThreshold);
+    }
+    while (Clock::now() < _nextFrame) {
+        std::this_thread::yield();
+    }
+    _nextFrame += _interval;
+}
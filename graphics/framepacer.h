@@ -0,0 +1,23 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <chrono>
+
+// Holds frames to a fixed cadence. Sleeps for the bulk of the interval and
+// spins for the remainder, since sleep_until overshoots by up to a scheduler tick.
+class FramePacer {
+public:
+    explicit FramePacer(double frameRate = 0.0);
+
+    void setFrameRate(double frameRate);
+    bool isEnabled() const;
+    void wait();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::duration _interval;
+    Clock::time_point _nextFrame;
+};
+
+#endif // FRAMEPACER_H
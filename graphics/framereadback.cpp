@@ -0,0 +1,202 @@
+#include "framereadback.h"
+#include "helperfunctions.h"
+
+#include <iostream>
+#include <limits>
+
+FrameReadback::FrameReadback()
+    : _memoryTracker(nullptr)
+    , _frameSize(0)
+    , _nextSlot(0)
+    , _oldestSlot(0)
+    , _collectedFrames(0)
+    , _stalls(0)
+{
+}
+
+void FrameReadback::init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, uint32_t queueFamily, vk::Extent2D extent, vk::Format format, uint32_t ringSize)
+{
+    _device = device;
+    _memoryTracker = &tracker;
+    _extent = extent;
+    _format = format;
+    _frameSize = static_cast<vk::DeviceSize>(extent.width) * extent.height * 4;
+    _nextSlot = 0;
+    _oldestSlot = 0;
+
+    vk::CommandPoolCreateInfo poolInfo;
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+    poolInfo.queueFamilyIndex = queueFamily;
+    vk::Result res = _device.createCommandPool(&poolInfo, nullptr, &_commandPool);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create readback command pool! error:" << res << std::endl;
+        std::abort();
+    }
+
+    _slots.resize(ringSize);
+    std::vector<vk::CommandBuffer> commandBuffers(ringSize);
+    vk::CommandBufferAllocateInfo allocInfo(_commandPool, vk::CommandBufferLevel::ePrimary, ringSize);
+    if (_device.allocateCommandBuffers(&allocInfo, commandBuffers.data()) != vk::Result::eSuccess) {
+        std::cerr << "Failed to allocate readback command buffers!" << std::endl;
+        std::abort();
+    }
+
+    for (size_t i = 0; i < _slots.size(); i++) {
+        Slot& slot = _slots[i];
+        slot.commandBuffer = commandBuffers[i];
+        slot.pending = false;
+
+        // Host-cached memory makes the CPU-side reads fast; it is not required.
+        vk::BufferCreateInfo bufferInfo(vk::BufferCreateFlags(), _frameSize, vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive);
+        if (_device.createBuffer(&bufferInfo, nullptr, &slot.buffer) != vk::Result::eSuccess) {
+            std::cerr << "Failed to create readback buffer!" << std::endl;
+            std::abort();
+        }
+        vk::MemoryRequirements memRequirements;
+        _device.getBufferMemoryRequirements(slot.buffer, &memRequirements);
+
+        vk::PhysicalDeviceMemoryProperties memProperties;
+        physicalDevice.getMemoryProperties(&memProperties);
+        vk::MemoryPropertyFlags cached = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostCached;
+        uint32_t memoryType = std::numeric_limits<uint32_t>::max();
+        for (uint32_t type = 0; type < memProperties.memoryTypeCount; type++) {
+            if ((memRequirements.memoryTypeBits & (1u << type)) && (memProperties.memoryTypes[type].propertyFlags & cached) == cached) {
+                memoryType = type;
+                break;
+            }
+        }
+        if (memoryType == std::numeric_limits<uint32_t>::max()) {
+            memoryType = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        }
+
+        vk::MemoryAllocateInfo memoryInfo(memRequirements.size, memoryType);
+        if (_memoryTracker->allocate(memoryInfo, MemoryCategory::Staging, slot.memory) != vk::Result::eSuccess) {
+            std::cerr << "Failed to allocate readback memory!" << std::endl;
+            std::abort();
+        }
+        _device.bindBufferMemory(slot.buffer, slot.memory, 0);
+        if (_device.mapMemory(slot.memory, 0, _frameSize, vk::MemoryMapFlags(), &slot.mapped) != vk::Result::eSuccess) {
+            std::cerr << "Failed to map readback memory!" << std::endl;
+            std::abort();
+        }
+
+        vk::FenceCreateInfo fenceInfo;
+        if (_device.createFence(&fenceInfo, nullptr, &slot.fence) != vk::Result::eSuccess) {
+            std::cerr << "Failed to create readback fence!" << std::endl;
+            std::abort();
+        }
+    }
+}
+
+void FrameReadback::destroy()
+{
+    if (!isInitialized()) {
+        return;
+    }
+    for (Slot& slot : _slots) {
+        if (slot.pending) {
+            _device.waitForFences(1, &slot.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+        _device.unmapMemory(slot.memory);
+        _device.destroyBuffer(slot.buffer);
+        _memoryTracker->free(slot.memory);
+        _device.destroyFence(slot.fence);
+    }
+    _slots.clear();
+    _device.destroyCommandPool(_commandPool);
+    _commandPool = vk::CommandPool();
+}
+
+bool FrameReadback::isInitialized() const
+{
+    return !_slots.empty();
+}
+
+vk::CommandBuffer FrameReadback::record(vk::Image image, uint64_t frameIndex, const std::function<void(const CapturedFrame&)>& consumer)
+{
+    Slot& slot = _slots[_nextSlot];
+    if (slot.pending) {
+        // The ring is full; drain the oldest copy even if it means waiting.
+        _stalls++;
+        collect(true, consumer);
+    }
+
+    _device.resetFences(1, &slot.fence);
+    slot.commandBuffer.reset(vk::CommandBufferResetFlags());
+    slot.frameIndex = frameIndex;
+
+    vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    slot.commandBuffer.begin(&beginInfo);
+
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+    vk::ImageMemoryBarrier toTransfer(vk::AccessFlagBits::eColorAttachmentWrite, vk::AccessFlagBits::eTransferRead, vk::ImageLayout::ePresentSrcKHR, vk::ImageLayout::eTransferSrcOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, range);
+    slot.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    vk::BufferImageCopy region;
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+    region.imageOffset = vk::Offset3D(0, 0, 0);
+    region.imageExtent = vk::Extent3D(_extent.width, _extent.height, 1);
+    slot.commandBuffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, slot.buffer, 1, &region);
+
+    vk::ImageMemoryBarrier toPresent(vk::AccessFlagBits::eTransferRead, vk::AccessFlags(), vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::ePresentSrcKHR, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, range);
+    vk::BufferMemoryBarrier toHost(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, slot.buffer, 0, _frameSize);
+    slot.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe | vk::PipelineStageFlagBits::eHost, vk::DependencyFlags(), 0, nullptr, 1, &toHost, 1, &toPresent);
+
+    slot.commandBuffer.end();
+    return slot.commandBuffer;
+}
+
+vk::Fence FrameReadback::fence() const
+{
+    return _slots[_nextSlot].fence;
+}
+
+void FrameReadback::markSubmitted()
+{
+    _slots[_nextSlot].pending = true;
+    _nextSlot = (_nextSlot + 1) % _slots.size();
+}
+
+void FrameReadback::collect(bool wait, const std::function<void(const CapturedFrame&)>& consumer)
+{
+    // Copies complete in submission order, so only the oldest slot needs checking.
+    while (_slots[_oldestSlot].pending) {
+        Slot& slot = _slots[_oldestSlot];
+        if (wait) {
+            _device.waitForFences(1, &slot.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        } else if (_device.getFenceStatus(slot.fence) != vk::Result::eSuccess) {
+            return;
+        }
+        consume(slot, consumer);
+        _oldestSlot = (_oldestSlot + 1) % _slots.size();
+        wait = false;
+    }
+}
+
+void FrameReadback::consume(Slot& slot, const std::function<void(const CapturedFrame&)>& consumer)
+{
+    slot.pending = false;
+    _collectedFrames++;
+
+    CapturedFrame frame;
+    frame.frameIndex = slot.frameIndex;
+    frame.width = _extent.width;
+    frame.height = _extent.height;
+    frame.format = _format;
+    frame.rowPitch = static_cast<size_t>(_extent.width) * 4;
+    frame.pixels = static_cast<const uint8_t*>(slot.mapped);
+    consumer(frame);
+}
+
+uint64_t FrameReadback::collectedFrames() const
+{
+    return _collectedFrames;
+}
+
+uint64_t FrameReadback::stalls() const
+{
+    return _stalls;
+}
@@ -0,0 +1,68 @@
+#ifndef FRAMEREADBACK_H
+#define FRAMEREADBACK_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "memorytracker.h"
+
+struct CapturedFrame {
+    uint64_t frameIndex;
+    uint32_t width;
+    uint32_t height;
+    vk::Format format;
+    size_t rowPitch;
+    const uint8_t* pixels;
+};
+
+// Copies presented images into a ring of persistently mapped host buffers.
+// A slot is consumed only once its fence has signalled, normally a few frames
+// after the copy was submitted, so the CPU never waits on the GPU.
+class FrameReadback {
+public:
+    FrameReadback();
+
+    void init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, uint32_t queueFamily, vk::Extent2D extent, vk::Format format, uint32_t ringSize);
+    void destroy();
+    bool isInitialized() const;
+
+    // Records a copy of a PresentSrc image into the next free slot. Submit the
+    // returned command buffer after the frame's draw, signalling fence().
+    vk::CommandBuffer record(vk::Image image, uint64_t frameIndex, const std::function<void(const CapturedFrame&)>& consumer);
+    vk::Fence fence() const;
+    void markSubmitted();
+
+    void collect(bool wait, const std::function<void(const CapturedFrame&)>& consumer);
+
+    uint64_t collectedFrames() const;
+    uint64_t stalls() const;
+
+private:
+    struct Slot {
+        vk::Buffer buffer;
+        vk::DeviceMemory memory;
+        void* mapped = nullptr;
+        vk::CommandBuffer commandBuffer;
+        vk::Fence fence;
+        uint64_t frameIndex = 0;
+        bool pending = false;
+    };
+
+    void consume(Slot& slot, const std::function<void(const CapturedFrame&)>& consumer);
+
+    vk::Device _device;
+    MemoryTracker* _memoryTracker;
+    vk::CommandPool _commandPool;
+    vk::Extent2D _extent;
+    vk::Format _format;
+    vk::DeviceSize _frameSize;
+    std::vector<Slot> _slots;
+    size_t _nextSlot;
+    size_t _oldestSlot;
+    uint64_t _collectedFrames;
+    uint64_t _stalls;
+};
+
+#endif // FRAMEREADBACK_H
@@ -0,0 +1,139 @@
+#include "framestats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+namespace {
+const size_t MaxFrameTimeSamples = 1 << 20;
+
+double millisecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+}
+
+RunningStatistics::RunningStatistics()
+{
+    reset();
+}
+
+void RunningStatistics::add(double value)
+{
+    // Welford's online algorithm, stable for long runs.
+    _count++;
+    double delta = value - _mean;
+    _mean += delta / static_cast<double>(_count);
+    _m2 += delta * (value - _mean);
+    _min = std::min(_min, value);
+    _max = std::max(_max, value);
+}
+
+void RunningStatistics::reset()
+{
+    _count = 0;
+    _mean = 0.0;
+    _m2 = 0.0;
+    _min = std::numeric_limits<double>::max();
+    _max = std::numeric_limits<double>::lowest();
+}
+
+uint64_t RunningStatistics::count() const
+{
+    return _count;
+}
+
+double RunningStatistics::mean() const
+{
+    return _mean;
+}
+
+double RunningStatistics::variance() const
+{
+    return _count > 1 ? _m2 / static_cast<double>(_count - 1) : 0.0;
+}
+
+double RunningStatistics::stddev() const
+{
+    return std::sqrt(variance());
+}
+
+double RunningStatistics::min() const
+{
+    return _count > 0 ? _min : 0.0;
+}
+
+double RunningStatistics::max() const
+{
+    return _count > 0 ? _max : 0.0;
+}
+
+FrameStats::FrameStats()
+    : _hasLastFrame(false)
+{
+}
+
+void FrameStats::beginFrame()
+{
+    _inputTime = Clock::now();
+}
+
+void FrameStats::endFrame()
+{
+    Clock::time_point now = Clock::now();
+    _submitLatencies.add(millisecondsBetween(_inputTime, now));
+    if (_hasLastFrame) {
+        double frameTime = millisecondsBetween(_lastFrameEnd, now);
+        _frameTimes.add(frameTime);
+        if (_frameTimeSamples.size() < MaxFrameTimeSamples) {
+            _frameTimeSamples.push_back(static_cast<float>(frameTime));
+        }
+    }
+    _lastFrameEnd = now;
+    _hasLastFrame = true;
+}
+
+void FrameStats::markIdle()
+{
+    _hasLastFrame = false;
+}
+
+void FrameStats::reset()
+{
+    _hasLastFrame = false;
+    _frameTimes.reset();
+    _submitLatencies.reset();
+    _frameTimeSamples.clear();
+}
+
+const RunningStatistics& FrameStats::frameTimes() const
+{
+    return _frameTimes;
+}
+
+const RunningStatistics& FrameStats::submitLatencies() const
+{
+    return _submitLatencies;
+}
+
+double FrameStats::percentileFrameTime(double percentile) const
+{
+    if (_frameTimeSamples.empty()) {
+        return 0.0;
+    }
+    std::vector<float> samples(_frameTimeSamples);
+    size_t index = std::min(samples.size() - 1, static_cast<size_t>(percentile / 100.0 * static_cast<double>(samples.size())));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+    return samples[index];
+}
+
+void FrameStats::report(std::ostream& stream, const std::string& label) const
+{
+    stream << std::fixed << std::setprecision(3);
+    stream << "[" << label << "] frames: " << _frameTimes.count() << std::endl;
+    stream << "  frame time ms: mean " << _frameTimes.mean() << " stddev " << _frameTimes.stddev() << " variance " << _frameTimes.variance()
+           << " min " << _frameTimes.min() << " p50 " << percentileFrameTime(50.0) << " p99 " << percentileFrameTime(99.0) << " max " << _frameTimes.max() << std::endl;
+    stream << "  input-to-submit ms: mean " << _submitLatencies.mean() << " stddev " << _submitLatencies.stddev() << " min " << _submitLatencies.min() << " max " << _submitLatencies.max() << std::endl;
+    stream.unsetf(std::ios::floatfield);
+}
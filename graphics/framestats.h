@@ -0,0 +1,60 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class RunningStatistics {
+public:
+    RunningStatistics();
+
+    void add(double value);
+    void reset();
+    uint64_t count() const;
+    double mean() const;
+    double variance() const;
+    double stddev() const;
+    double min() const;
+    double max() const;
+
+private:
+    uint64_t _count;
+    double _mean;
+    double _m2;
+    double _min;
+    double _max;
+};
+
+class FrameStats {
+public:
+    FrameStats();
+
+    void beginFrame();
+    void endFrame();
+    // The loop waited instead of drawing; the next frame does not count the gap.
+    void markIdle();
+    void reset();
+
+    const RunningStatistics& frameTimes() const;
+    // From beginFrame(), before input is polled, to endFrame(), after the
+    // present call returns: CPU time until the frame is queued for display,
+    // not until it is on screen.
+    const RunningStatistics& submitLatencies() const;
+    double percentileFrameTime(double percentile) const;
+    void report(std::ostream& stream, const std::string& label) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point _inputTime;
+    Clock::time_point _lastFrameEnd;
+    bool _hasLastFrame;
+    RunningStatistics _frameTimes;
+    RunningStatistics _submitLatencies;
+    std::vector<float> _frameTimeSamples;
+};
+
+#endif // FRAMESTATS_H
@@ -0,0 +1,188 @@
+#include "geometrypool.h"
+#include "helperfunctions.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+GeometryPool::GeometryPool()
+    : _memoryTracker(nullptr)
+    , _version(0)
+    , _compactions(0)
+    , _vertexBufferBinds(0)
+    , _indexBufferBinds(0)
+    , _indirectCalls(0)
+    , _indirectDraws(0)
+{
+}
+
+void GeometryPool::init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    _device = device;
+    _physicalDevice = physicalDevice;
+    _memoryTracker = &tracker;
+    _layout.reset(vertexCapacity, indexCapacity);
+    createBuffers(_buffers);
+}
+
+void GeometryPool::destroy()
+{
+    if (!isInitialized()) {
+        return;
+    }
+    releaseRetired();
+    destroyBuffers(_buffers);
+}
+
+bool GeometryPool::isInitialized() const
+{
+    return static_cast<bool>(_buffers.vertexBuffer);
+}
+
+MeshHandle GeometryPool::add(UploadBatch& uploads, const Vertex* vertices, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount)
+{
+    if (vertexCount == 0 || indexCount == 0) {
+        std::cerr << "Mesh with " << vertexCount << " vertices and " << indexCount << " indices is empty!" << std::endl;
+        std::abort();
+    }
+    if (vertexCount > std::numeric_limits<uint16_t>::max() + 1u) {
+        std::cerr << "Mesh with " << vertexCount << " vertices cannot use 16 bit indices!" << std::endl;
+        std::abort();
+    }
+    MeshHandle handle = _layout.add(vertexCount, indexCount);
+    if (handle == InvalidMesh) {
+        return InvalidMesh;
+    }
+    const MeshRange& range = _layout.mesh(handle);
+    uploads.uploadBuffer(vertices, sizeof(Vertex) * vertexCount, _buffers.vertexBuffer, sizeof(Vertex) * static_cast<uint32_t>(range.vertexOffset));
+    uploads.uploadBuffer(indices, sizeof(uint16_t) * indexCount, _buffers.indexBuffer, sizeof(uint16_t) * range.firstIndex);
+    return handle;
+}
+
+void GeometryPool::remove(MeshHandle handle)
+{
+    _layout.remove(handle);
+}
+
+const MeshRange& GeometryPool::mesh(MeshHandle handle) const
+{
+    return _layout.mesh(handle);
+}
+
+size_t GeometryPool::meshCount() const
+{
+    return _layout.meshCount();
+}
+
+vk::DrawIndexedIndirectCommand GeometryPool::drawCommand(MeshHandle handle, uint32_t instanceCount, uint32_t firstInstance) const
+{
+    const MeshRange& range = _layout.mesh(handle);
+    return vk::DrawIndexedIndirectCommand(range.indexCount, instanceCount, range.firstIndex, range.vertexOffset, firstInstance);
+}
+
+double GeometryPool::fragmentation() const
+{
+    return _layout.fragmentation();
+}
+
+double GeometryPool::slack() const
+{
+    return _layout.slack();
+}
+
+void GeometryPool::compact(UploadBatch& uploads)
+{
+    // Copies within one buffer must not overlap, so the meshes move into new
+    // buffers instead of sliding down in place.
+    Buffers packed;
+    createBuffers(packed);
+    for (const MeshMove& move : _layout.compact()) {
+        uploads.copyBuffer(_buffers.vertexBuffer, sizeof(Vertex) * static_cast<uint32_t>(move.from.vertexOffset), packed.vertexBuffer, sizeof(Vertex) * static_cast<uint32_t>(move.to.vertexOffset),
+            sizeof(Vertex) * move.from.vertexCount);
+        uploads.copyBuffer(_buffers.indexBuffer, sizeof(uint16_t) * move.from.firstIndex, packed.indexBuffer, sizeof(uint16_t) * move.to.firstIndex, sizeof(uint16_t) * move.from.indexCount);
+    }
+    _retired.push_back(_buffers);
+    _buffers = packed;
+    _compactions++;
+    _version++;
+}
+
+void GeometryPool::releaseRetired()
+{
+    for (Buffers& buffers : _retired) {
+        destroyBuffers(buffers);
+    }
+    _retired.clear();
+}
+
+uint32_t GeometryPool::version() const
+{
+    return _version;
+}
+
+void GeometryPool::bind(vk::CommandBuffer commandBuffer)
+{
+    vk::DeviceSize offset = 0;
+    commandBuffer.bindVertexBuffers(0, 1, &_buffers.vertexBuffer, &offset);
+    commandBuffer.bindIndexBuffer(_buffers.indexBuffer, 0, vk::IndexType::eUint16);
+    _vertexBufferBinds++;
+    _indexBufferBinds++;
+}
+
+void GeometryPool::drawIndirect(vk::CommandBuffer commandBuffer, vk::Buffer commands, uint32_t count, bool multiDraw)
+{
+    if (count == 0) {
+        return;
+    }
+    uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+    if (multiDraw) {
+        commandBuffer.drawIndexedIndirect(commands, 0, count, stride);
+        _indirectCalls++;
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            commandBuffer.drawIndexedIndirect(commands, i * stride, 1, stride);
+        }
+        _indirectCalls += count;
+    }
+    _indirectDraws += count;
+}
+
+void GeometryPool::report(std::ostream& stream, uint64_t commandBuffers) const
+{
+    if (!isInitialized()) {
+        return;
+    }
+    stream << std::fixed << std::setprecision(1);
+    const RangeAllocator& vertices = _layout.vertices();
+    const RangeAllocator& indices = _layout.indices();
+    stream << "  geometry pool: " << _layout.meshCount() << " meshes, " << vertices.used() << "/" << vertices.capacity() << " vertices, " << indices.used() << "/" << indices.capacity() << " indices, "
+           << 100.0 * fragmentation() << "% fragmented, " << _compactions << " compactions" << std::endl;
+    if (commandBuffers > 0) {
+        double frames = static_cast<double>(commandBuffers);
+        stream << "    per recorded frame: " << (_vertexBufferBinds + _indexBufferBinds) / frames << " buffer binds";
+        if (_indirectDraws > 0) {
+            stream << ", " << _indirectDraws / frames << " indirect draws in " << _indirectCalls / frames << " calls";
+        }
+        stream << std::endl;
+    }
+    stream.unsetf(std::ios::floatfield);
+}
+
+void GeometryPool::createBuffers(Buffers& buffers)
+{
+    vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+    createBuffer(_device, _physicalDevice, *_memoryTracker, MemoryCategory::Vertex, sizeof(Vertex) * _layout.vertices().capacity(), usage | vk::BufferUsageFlagBits::eVertexBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, buffers.vertexBuffer, buffers.vertexMemory);
+    createBuffer(_device, _physicalDevice, *_memoryTracker, MemoryCategory::Index, sizeof(uint16_t) * _layout.indices().capacity(), usage | vk::BufferUsageFlagBits::eIndexBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, buffers.indexBuffer, buffers.indexMemory);
+}
+
+void GeometryPool::destroyBuffers(Buffers& buffers)
+{
+    _device.destroyBuffer(buffers.vertexBuffer);
+    _memoryTracker->free(buffers.vertexMemory);
+    _device.destroyBuffer(buffers.indexBuffer);
+    _memoryTracker->free(buffers.indexMemory);
+    buffers = Buffers();
+}
@@ -0,0 +1,79 @@
+#ifndef GEOMETRYPOOL_H
+#define GEOMETRYPOOL_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "memorytracker.h"
+#include "meshlayout.h"
+#include "uploadbatch.h"
+#include "vertex.h"
+
+// Static geometry sub-allocated from one large vertex buffer and one large
+// index buffer, so it is bound once per pass and many meshes can be drawn by
+// a single multi-draw indirect call.
+class GeometryPool {
+public:
+    GeometryPool();
+
+    void init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, uint32_t vertexCapacity, uint32_t indexCapacity);
+    void destroy();
+    bool isInitialized() const;
+
+    // Returns InvalidMesh when no free range is large enough; compacting may help.
+    // Meshes must have at least one vertex and one index.
+    MeshHandle add(UploadBatch& uploads, const Vertex* vertices, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount);
+    void remove(MeshHandle mesh);
+    const MeshRange& mesh(MeshHandle mesh) const;
+    size_t meshCount() const;
+    vk::DrawIndexedIndirectCommand drawCommand(MeshHandle mesh, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
+
+    double fragmentation() const;
+    double slack() const;
+    // Copies the live meshes into fresh, packed buffers through the upload
+    // batch. Mesh ranges and buffers change, so command buffers have to be
+    // recorded again; the old buffers go once releaseRetired() is called
+    // after the uploads have completed. The batch copies before it uploads,
+    // so meshes added to it before compacting are lost.
+    void compact(UploadBatch& uploads);
+    void releaseRetired();
+    // Changes whenever buffers or mesh ranges move.
+    uint32_t version() const;
+
+    void bind(vk::CommandBuffer commandBuffer);
+    // Draws commands[0, count) with one call when multi-draw indirect is
+    // enabled, otherwise one call per command.
+    void drawIndirect(vk::CommandBuffer commandBuffer, vk::Buffer commands, uint32_t count, bool multiDraw);
+
+    void report(std::ostream& stream, uint64_t commandBuffers) const;
+
+private:
+    struct Buffers {
+        vk::Buffer vertexBuffer;
+        vk::DeviceMemory vertexMemory;
+        vk::Buffer indexBuffer;
+        vk::DeviceMemory indexMemory;
+    };
+
+    void createBuffers(Buffers& buffers);
+    void destroyBuffers(Buffers& buffers);
+
+    vk::Device _device;
+    vk::PhysicalDevice _physicalDevice;
+    MemoryTracker* _memoryTracker;
+
+    Buffers _buffers;
+    std::vector<Buffers> _retired;
+    MeshLayout _layout;
+    uint32_t _version;
+
+    uint64_t _compactions;
+    uint64_t _vertexBufferBinds;
+    uint64_t _indexBufferBinds;
+    uint64_t _indirectCalls;
+    uint64_t _indirectDraws;
+};
+
+#endif // GEOMETRYPOOL_H
@@ -0,0 +1,100 @@
+#include "gputimer.h"
+#include "logger.h"
+
+#include <cstdlib>
+#include <iostream>
+
+GpuTimer::GpuTimer()
+    : _period(0.0)
+    , _validMask(0)
+    , _lastBegin(0)
+    , _lastEnd(0)
+{
+}
+
+bool GpuTimer::init(vk::Device device, vk::PhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t slotCount)
+{
+    uint32_t familyCount = 0;
+    physicalDevice.getQueueFamilyProperties(&familyCount, nullptr);
+    std::vector<vk::QueueFamilyProperties> families(familyCount);
+    physicalDevice.getQueueFamilyProperties(&familyCount, families.data());
+
+    vk::PhysicalDeviceProperties properties;
+    physicalDevice.getProperties(&properties);
+    if (queueFamily >= familyCount || families[queueFamily].timestampValidBits == 0 || properties.limits.timestampPeriod <= 0.0f) {
+        LOG_WARNING(LogCategory::Render, "Timestamp queries are not supported, GPU timing disabled");
+        return false;
+    }
+
+    vk::QueryPoolCreateInfo poolInfo;
+    poolInfo.queryType = vk::QueryType::eTimestamp;
+    poolInfo.queryCount = slotCount * 2;
+    vk::Result res = device.createQueryPool(&poolInfo, nullptr, &_queryPool);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create timestamp query pool! error:" << res << std::endl;
+        std::abort();
+    }
+
+    uint32_t validBits = families[queueFamily].timestampValidBits;
+    _device = device;
+    _period = properties.limits.timestampPeriod;
+    _validMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    _submitted.assign(slotCount, false);
+    return true;
+}
+
+void GpuTimer::destroy()
+{
+    if (!isInitialized()) {
+        return;
+    }
+    _device.destroyQueryPool(_queryPool);
+    _queryPool = vk::QueryPool();
+    _device = vk::Device();
+    _submitted.clear();
+}
+
+bool GpuTimer::isInitialized() const
+{
+    return !_submitted.empty();
+}
+
+void GpuTimer::writeBegin(vk::CommandBuffer commandBuffer, uint32_t slot) const
+{
+    commandBuffer.resetQueryPool(_queryPool, slot * 2, 2);
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, _queryPool, slot * 2);
+}
+
+void GpuTimer::writeEnd(vk::CommandBuffer commandBuffer, uint32_t slot) const
+{
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, _queryPool, slot * 2 + 1);
+}
+
+void GpuTimer::markSubmitted(uint32_t slot)
+{
+    _submitted[slot] = true;
+}
+
+bool GpuTimer::collect(uint32_t slot, double& milliseconds)
+{
+    if (!_submitted[slot]) {
+        return false;
+    }
+    uint64_t timestamps[2] = {};
+    vk::Result res = _device.getQueryPoolResults(_queryPool, slot * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+    if (res != vk::Result::eSuccess) {
+        return false;
+    }
+    _submitted[slot] = false;
+    uint64_t ticks = ((timestamps[1] & _validMask) - (timestamps[0] & _validMask)) & _validMask;
+    milliseconds = static_cast<double>(ticks) * _period * 1e-6;
+    _lastBegin = static_cast<uint64_t>(static_cast<double>(timestamps[0] & _validMask) * _period);
+    _lastEnd = _lastBegin + static_cast<uint64_t>(static_cast<double>(ticks) * _period);
+    return true;
+}
+
+void GpuTimer::lastSpan(uint64_t& begin, uint64_t& end) const
+{
+    begin = _lastBegin;
+    end = _lastEnd;
+}
@@ -0,0 +1,36 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// Measures command buffer execution time with a pair of timestamp queries per
+// slot. Slots match pre-recorded command buffers; a slot is read back after the
+// fence guarding its command buffer has been waited on, so reads never block.
+class GpuTimer {
+public:
+    GpuTimer();
+
+    bool init(vk::Device device, vk::PhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t slotCount);
+    void destroy();
+    bool isInitialized() const;
+
+    void writeBegin(vk::CommandBuffer commandBuffer, uint32_t slot) const;
+    void writeEnd(vk::CommandBuffer commandBuffer, uint32_t slot) const;
+    void markSubmitted(uint32_t slot);
+    bool collect(uint32_t slot, double& milliseconds);
+    // GPU clock nanoseconds of the span last collected, for the tracer.
+    void lastSpan(uint64_t& begin, uint64_t& end) const;
+
+private:
+    vk::Device _device;
+    vk::QueryPool _queryPool;
+    double _period;
+    uint64_t _validMask;
+    uint64_t _lastBegin;
+    uint64_t _lastEnd;
+    std::vector<bool> _submitted;
+};
+
+#endif // GPUTIMER_H
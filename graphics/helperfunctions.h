@@ -1,11 +1,15 @@
 #ifndef HELPERFUNCTIONS_H
 #define HELPERFUNCTIONS_H
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <iostream>
 #include <vulkan/vulkan.hpp>
 
+#include "memorytracker.h"
+#include "shadercode.h"
+
 struct SwapChainSupportDetails {
     vk::SurfaceCapabilitiesKHR capabilities;
     std::vector<vk::SurfaceFormatKHR> formats;
@@ -65,17 +69,33 @@ static vk::SurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<vk::Surfac
     return availableFormats[0];
 }
 
-static vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes)
+static vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes, vk::PresentModeKHR preferredMode)
 {
-    vk::PresentModeKHR bestMode = vk::PresentModeKHR::eFifo;
-    for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == vk::PresentModeKHR::eMailbox) {
-            return availablePresentMode;
-        } else if (availablePresentMode == vk::PresentModeKHR::eImmediate) {
-            bestMode = availablePresentMode;
-        }
+    auto isAvailable = [&availablePresentModes](vk::PresentModeKHR mode) {
+        return std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end();
+    };
+
+    if (isAvailable(preferredMode)) {
+        return preferredMode;
+    }
+    if (preferredMode == vk::PresentModeKHR::eMailbox && isAvailable(vk::PresentModeKHR::eImmediate)) {
+        return vk::PresentModeKHR::eImmediate;
     }
-    return bestMode;
+    if (preferredMode == vk::PresentModeKHR::eImmediate && isAvailable(vk::PresentModeKHR::eMailbox)) {
+        return vk::PresentModeKHR::eMailbox;
+    }
+    std::cerr << "Present mode " << vk::to_string(preferredMode) << " not available, falling back to FIFO" << std::endl;
+    return vk::PresentModeKHR::eFifo;
+}
+
+static uint32_t chooseSwapImageCount(const vk::SurfaceCapabilitiesKHR& capabilities, uint32_t requestedCount)
+{
+    uint32_t imageCount = requestedCount > 0 ? requestedCount : capabilities.minImageCount + 1;
+    imageCount = std::max(imageCount, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) {
+        imageCount = capabilities.maxImageCount;
+    }
+    return imageCount;
 }
 
 static vk::Format findSupportedFormat(vk::PhysicalDevice& physicalDevice, const std::vector<vk::Format>& candidates, vk::ImageTiling tiling, vk::FormatFeatureFlags features)
@@ -198,6 +218,54 @@ static void endSingleTimeCommands(vk::Device& device, vk::Queue& graphicsQueue,
     device.freeCommandBuffers(commandPool, 1, &commandBuffer);
 }
 
+static void recordImageLayoutTransition(vk::CommandBuffer commandBuffer, vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
+{
+    vk::ImageMemoryBarrier barrier;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+
+    if (newLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal) {
+        barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eDepth;
+
+        if (hasStencilComponent(format)) {
+            barrier.subresourceRange.aspectMask |= vk::ImageAspectFlagBits::eStencil;
+        }
+    } else {
+        barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+    }
+
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    vk::PipelineStageFlags sourceStage;
+    vk::PipelineStageFlags destinationStage;
+
+    if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eTransferDstOptimal) {
+        barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+        sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
+        destinationStage = vk::PipelineStageFlagBits::eTransfer;
+    } else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal) {
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        sourceStage = vk::PipelineStageFlagBits::eTransfer;
+        destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
+    } else if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal) {
+        barrier.dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+        sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
+        destinationStage = vk::PipelineStageFlagBits::eEarlyFragmentTests;
+    } else {
+        std::cout << "Failed to transition layout!" << std::endl;
+        std::abort();
+    }
+
+    commandBuffer.pipelineBarrier(sourceStage, destinationStage, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
 static void createShaderModule(vk::Device& device, const std::vector<char>& code, vk::ShaderModule& shaderModule)
 {
     assert(code.size() % 4 == 0);
@@ -210,6 +278,18 @@ static void createShaderModule(vk::Device& device, const std::vector<char>& code
     }
 }
 
+static void createShaderModule(vk::Device& device, const ShaderCode& code, vk::ShaderModule& shaderModule)
+{
+    assert(code.size % 4 == 0);
+    vk::ShaderModuleCreateInfo createInfo(vk::ShaderModuleCreateFlags(), code.size, code.words);
+
+    vk::Result res = device.createShaderModule(&createInfo, nullptr, &shaderModule);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "failed to create shader module! error:" << res << std::endl;
+        std::abort();
+    }
+}
+
 static vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities, uint32_t width, uint32_t height)
 {
     if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
@@ -241,7 +321,7 @@ static SwapChainSupportDetails querySwapChainSupport(vk::PhysicalDevice& device,
     return details;
 }
 
-static void createBuffer(vk::Device& device, vk::PhysicalDevice& physicalDevice, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, vk::DeviceMemory& bufferMemory)
+static void createBuffer(vk::Device& device, vk::PhysicalDevice& physicalDevice, MemoryTracker& tracker, MemoryCategory category, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, vk::DeviceMemory& bufferMemory)
 {
     vk::BufferCreateInfo bufferInfo;
     bufferInfo.size = size;
@@ -260,7 +340,7 @@ static void createBuffer(vk::Device& device, vk::PhysicalDevice& physicalDevice,
     allocInfo.allocationSize = memRequirements.size;
     allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
 
-    if (device.allocateMemory(&allocInfo, nullptr, &bufferMemory) != vk::Result::eSuccess) {
+    if (tracker.allocate(allocInfo, category, bufferMemory) != vk::Result::eSuccess) {
         std::cerr << "Failed to allocate buffer memory!" << std::endl;
         std::abort();
     }
@@ -0,0 +1,223 @@
+#include "imagewriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+const uint32_t MaxStoredBlock = 65535;
+
+std::array<uint32_t, 256> makeCrcTable()
+{
+    std::array<uint32_t, 256> table;
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+    }
+    return table;
+}
+
+uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+    static const std::array<uint32_t, 256> table = makeCrcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void appendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void writeChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> chunk;
+    chunk.reserve(data.size() + 12);
+    appendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    appendBigEndian(chunk, crc32(0, chunk.data() + 4, data.size() + 4));
+    file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+}
+
+void convertToRGB(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, PixelLayout layout, std::vector<uint8_t>& rgb)
+{
+    rgb.resize(static_cast<size_t>(width) * height * 3);
+    const int red = layout == PixelLayout::BGRA8 ? 2 : 0;
+    const int blue = layout == PixelLayout::BGRA8 ? 0 : 2;
+    uint8_t* out = rgb.data();
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t* row = pixels + rowPitch * y;
+        for (uint32_t x = 0; x < width; x++) {
+            const uint8_t* pixel = row + x * 4;
+            *out++ = pixel[red];
+            *out++ = pixel[1];
+            *out++ = pixel[blue];
+        }
+    }
+}
+
+uint64_t hashPixels(const uint8_t* rgb, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= rgb[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string hashToString(uint64_t hash)
+{
+    std::ostringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return stream.str();
+}
+
+bool writePPM(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: [" << path << "]" << std::endl;
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+    return file.good();
+}
+
+bool writePNG(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: [" << path << "]" << std::endl;
+        return false;
+    }
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.push_back(8); // bit depth
+    header.push_back(2); // truecolor
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    writeChunk(file, "IHDR", header);
+
+    // Each scanline is prefixed with filter type 0, then wrapped in uncompressed
+    // deflate blocks: fast to produce and readable by any decoder.
+    size_t stride = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((stride + 1) * height);
+    for (uint32_t y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb.begin() + static_cast<std::ptrdiff_t>(stride * y), rgb.begin() + static_cast<std::ptrdiff_t>(stride * (y + 1)));
+    }
+
+    std::vector<uint8_t> zlib;
+    zlib.reserve(raw.size() + raw.size() / MaxStoredBlock * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+    size_t offset = 0;
+    do {
+        size_t blockSize = std::min<size_t>(MaxStoredBlock, raw.size() - offset);
+        bool last = offset + blockSize == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(blockSize));
+        zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+        zlib.push_back(static_cast<uint8_t>(~blockSize));
+        zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+        for (size_t i = 0; i < blockSize; i++) {
+            uint8_t value = raw[offset + i];
+            zlib.push_back(value);
+            adlerA = (adlerA + value) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+        offset += blockSize;
+    } while (offset < raw.size());
+    appendBigEndian(zlib, (adlerB << 16) | adlerA);
+
+    writeChunk(file, "IDAT", zlib);
+    writeChunk(file, "IEND", std::vector<uint8_t>());
+    return file.good();
+}
+
+FrameStream::FrameStream()
+    : _file(nullptr)
+    , _isPipe(false)
+    , _bytesWritten(0)
+{
+}
+
+FrameStream::~FrameStream()
+{
+    close();
+}
+
+bool FrameStream::open(const std::string& target)
+{
+    close();
+    _isPipe = !target.empty() && target[0] == '|';
+    if (_isPipe) {
+        _file = popen(target.c_str() + 1, "w");
+    } else {
+        _file = std::fopen(target.c_str(), "wb");
+    }
+    if (!_file) {
+        std::cerr << "Failed to open frame stream: [" << target << "]" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void FrameStream::close()
+{
+    if (!_file) {
+        return;
+    }
+    if (_isPipe) {
+        pclose(_file);
+    } else {
+        std::fclose(_file);
+    }
+    _file = nullptr;
+}
+
+bool FrameStream::isOpen() const
+{
+    return _file != nullptr;
+}
+
+bool FrameStream::write(const std::vector<uint8_t>& rgb)
+{
+    if (!_file) {
+        return false;
+    }
+    size_t written = std::fwrite(rgb.data(), 1, rgb.size(), _file);
+    _bytesWritten += written;
+    return written == rgb.size();
+}
+
+uint64_t FrameStream::bytesWritten() const
+{
+    return _bytesWritten;
+}
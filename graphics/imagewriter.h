@@ -0,0 +1,42 @@
+#ifndef IMAGEWRITER_H
+#define IMAGEWRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+enum class PixelLayout {
+    RGBA8,
+    BGRA8
+};
+
+void convertToRGB(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, PixelLayout layout, std::vector<uint8_t>& rgb);
+uint64_t hashPixels(const uint8_t* rgb, size_t size);
+std::string hashToString(uint64_t hash);
+
+bool writePPM(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb);
+bool writePNG(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb);
+
+// Raw frame sink for video encoders. A path starting with '|' is run as a shell
+// command and fed through a pipe, e.g. "|ffmpeg -f rawvideo -pix_fmt rgb24 ...".
+class FrameStream {
+public:
+    FrameStream();
+    ~FrameStream();
+    FrameStream(const FrameStream&) = delete;
+    FrameStream& operator=(const FrameStream&) = delete;
+
+    bool open(const std::string& target);
+    void close();
+    bool isOpen() const;
+    bool write(const std::vector<uint8_t>& rgb);
+    uint64_t bytesWritten() const;
+
+private:
+    FILE* _file;
+    bool _isPipe;
+    uint64_t _bytesWritten;
+};
+
+#endif // IMAGEWRITER_H
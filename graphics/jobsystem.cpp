@@ -0,0 +1,289 @@
+#include "jobsystem.h"
+#include "tracer.h"
+
+#include <algorithm>
+
+namespace {
+thread_local JobSystem* t_jobSystem = nullptr;
+thread_local int t_workerIndex = -1;
+
+const int SpinsBeforeSleep = 64;
+}
+
+JobCounter::JobCounter()
+    : _value(0)
+{
+}
+
+bool JobCounter::isDone() const
+{
+    return _value.load(std::memory_order_acquire) == 0;
+}
+
+int JobCounter::value() const
+{
+    return _value.load(std::memory_order_acquire);
+}
+
+WorkStealingQueue::WorkStealingQueue()
+    : _top(0)
+    , _bottom(0)
+    , _buffer(new std::atomic<Job*>[JobQueueSize])
+{
+    static_assert((JobQueueSize & (JobQueueSize - 1)) == 0, "Queue size must be a power of two");
+}
+
+bool WorkStealingQueue::push(Job* job)
+{
+    int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    int64_t top = _top.load(std::memory_order_acquire);
+    if (bottom - top >= static_cast<int64_t>(JobQueueSize)) {
+        return false;
+    }
+    _buffer[bottom & (JobQueueSize - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+Job* WorkStealingQueue::pop()
+{
+    int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    _bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = _top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = _buffer[bottom & (JobQueueSize - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // Last element: race against thieves for it.
+        if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkStealingQueue::steal()
+{
+    int64_t top = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = _bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom) {
+        return nullptr;
+    }
+    Job* job = _buffer[top & (JobQueueSize - 1)].load(std::memory_order_relaxed);
+    if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::JobSystem(unsigned workerCount)
+    : _running(true)
+    , _queuedJobs(0)
+    , _sleeping(0)
+{
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < workerCount; i++) {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->pool.reset(new Job[JobPoolSize]);
+        worker->random = 0x9e3779b9u * (i + 1);
+        _workers.push_back(std::move(worker));
+    }
+
+    t_jobSystem = this;
+    t_workerIndex = 0;
+    for (unsigned i = 1; i < workerCount; i++) {
+        _threads.emplace_back(&JobSystem::workerMain, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _running = false;
+    }
+    _wakeCondition.notify_all();
+    for (std::thread& thread : _threads) {
+        thread.join();
+    }
+    if (t_jobSystem == this) {
+        t_jobSystem = nullptr;
+        t_workerIndex = -1;
+    }
+}
+
+unsigned JobSystem::workerCount() const
+{
+    return static_cast<unsigned>(_workers.size());
+}
+
+int JobSystem::currentWorker() const
+{
+    return t_jobSystem == this ? t_workerIndex : -1;
+}
+
+Job* JobSystem::allocateJob(bool forceHeap)
+{
+    int index = currentWorker();
+    if (forceHeap || index < 0) {
+        Job* job = new Job();
+        job->heapAllocated = true;
+        return job;
+    }
+    // Only the owner sets busy, so a slot seen free stays free until taken.
+    Worker& worker = *_workers[static_cast<size_t>(index)];
+    for (size_t i = 0; i < JobPoolProbes; i++) {
+        Job* job = &worker.pool[worker.allocated++ & (JobPoolSize - 1)];
+        if (!job->busy.load(std::memory_order_acquire)) {
+            job->busy.store(true, std::memory_order_relaxed);
+            job->heapAllocated = false;
+            return job;
+        }
+    }
+    Job* job = new Job();
+    job->heapAllocated = true;
+    return job;
+}
+
+void JobSystem::schedule(Job* job)
+{
+    int index = currentWorker();
+    if (index >= 0) {
+        if (!_workers[static_cast<size_t>(index)]->queue.push(job)) {
+            // Queue is full; running inline keeps the producer making progress.
+            execute(job);
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(_externalMutex);
+        _externalJobs.push_back(job);
+    }
+
+    _queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+    if (_sleeping.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _wakeCondition.notify_one();
+    }
+}
+
+void JobSystem::execute(Job* job)
+{
+    {
+        TRACE_SCOPE("job");
+        job->function(*job);
+    }
+    JobCounter* counter = job->counter;
+    if (job->heapAllocated) {
+        delete job;
+    } else {
+        job->busy.store(false, std::memory_order_release);
+    }
+    if (counter) {
+        finish(*counter);
+    }
+}
+
+void JobSystem::finish(JobCounter& counter)
+{
+    if (counter._value.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    std::vector<Job*> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter._mutex);
+        continuations.swap(counter._continuations);
+    }
+    for (Job* job : continuations) {
+        schedule(job);
+    }
+}
+
+Job* JobSystem::findJob()
+{
+    int index = currentWorker();
+    Job* job = nullptr;
+
+    if (index >= 0) {
+        Worker& self = *_workers[static_cast<size_t>(index)];
+        job = self.queue.pop();
+
+        size_t count = _workers.size();
+        if (!job && count > 1) {
+            uint32_t& random = self.random;
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            size_t start = random % count;
+            for (size_t i = 0; i < count && !job; i++) {
+                size_t victim = (start + i) % count;
+                if (victim != static_cast<size_t>(index)) {
+                    job = _workers[victim]->queue.steal();
+                }
+            }
+        }
+    }
+
+    if (!job) {
+        std::lock_guard<std::mutex> lock(_externalMutex);
+        if (!_externalJobs.empty()) {
+            job = _externalJobs.front();
+            _externalJobs.pop_front();
+        }
+    }
+
+    if (job) {
+        _queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    while (!counter.isDone()) {
+        Job* job = currentWorker() >= 0 ? findJob() : nullptr;
+        if (job) {
+            execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::workerMain(unsigned index)
+{
+    t_jobSystem = this;
+    t_workerIndex = static_cast<int>(index);
+    Tracer::instance().setThreadName("worker " + std::to_string(index));
+
+    int idleSpins = 0;
+    while (_running.load(std::memory_order_relaxed)) {
+        Job* job = findJob();
+        if (job) {
+            execute(job);
+            idleSpins = 0;
+            continue;
+        }
+        if (++idleSpins < SpinsBeforeSleep) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _sleeping.fetch_add(1, std::memory_order_seq_cst);
+        _wakeCondition.wait(lock, [this]() { return !_running || _queuedJobs.load(std::memory_order_seq_cst) > 0; });
+        _sleeping.fetch_sub(1, std::memory_order_seq_cst);
+        idleSpins = 0;
+    }
+}
@@ -0,0 +1,184 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+const size_t JobPayloadSize = 48;
+// Jobs come from a per-thread pool; a slot is reused only once its job has
+// finished, and jobs beyond that are allocated on the heap.
+const size_t JobPoolSize = 4096;
+// Busy pool slots probed before a job falls back to the heap.
+const size_t JobPoolProbes = 8;
+const size_t JobQueueSize = 4096;
+
+class JobCounter;
+
+struct Job {
+    void (*function)(Job& job);
+    JobCounter* counter;
+    bool heapAllocated;
+    // Set by the owning worker when it hands the slot out, cleared by
+    // whichever thread ran the job.
+    std::atomic<bool> busy { false };
+    alignas(16) unsigned char payload[JobPayloadSize];
+};
+
+// Counts outstanding jobs. Jobs queued with runAfter() are released once the
+// counter they depend on drops to zero.
+class JobCounter {
+public:
+    JobCounter();
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool isDone() const;
+    int value() const;
+
+private:
+    friend class JobSystem;
+    std::atomic<int> _value;
+    std::mutex _mutex;
+    std::vector<Job*> _continuations;
+};
+
+// Chase-Lev deque: the owner pushes and pops at the bottom, thieves steal from the top.
+class WorkStealingQueue {
+public:
+    WorkStealingQueue();
+
+    bool push(Job* job);
+    Job* pop();
+    Job* steal();
+
+private:
+    std::atomic<int64_t> _top;
+    char _padding[64 - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t> _bottom;
+    std::unique_ptr<std::atomic<Job*>[]> _buffer;
+};
+
+class JobSystem {
+public:
+    // workerCount includes the calling thread, which participates in wait().
+    explicit JobSystem(unsigned workerCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    template <typename F>
+    void run(F&& function, JobCounter* counter = nullptr);
+    template <typename F>
+    void runAfter(JobCounter& dependency, F&& function, JobCounter* counter = nullptr);
+    template <typename F>
+    void parallelFor(size_t count, size_t grain, F&& function);
+
+    void wait(JobCounter& counter);
+    unsigned workerCount() const;
+
+private:
+    struct Worker {
+        WorkStealingQueue queue;
+        std::unique_ptr<Job[]> pool;
+        size_t allocated = 0;
+        uint32_t random = 0;
+    };
+
+    template <typename F>
+    static void invoke(Job& job);
+    template <typename F>
+    Job* createJob(F&& function, JobCounter* counter, bool forceHeap);
+
+    Job* allocateJob(bool forceHeap);
+    void schedule(Job* job);
+    void execute(Job* job);
+    void finish(JobCounter& counter);
+    Job* findJob();
+    void workerMain(unsigned index);
+    int currentWorker() const;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<std::thread> _threads;
+    std::atomic<bool> _running;
+    std::atomic<int> _queuedJobs;
+    std::atomic<int> _sleeping;
+    std::mutex _sleepMutex;
+    std::condition_variable _wakeCondition;
+    std::mutex _externalMutex;
+    std::deque<Job*> _externalJobs;
+};
+
+template <typename F>
+void JobSystem::invoke(Job& job)
+{
+    typedef typename std::decay<F>::type Function;
+    Function* function = reinterpret_cast<Function*>(job.payload);
+    (*function)();
+    function->~Function();
+}
+
+template <typename F>
+Job* JobSystem::createJob(F&& function, JobCounter* counter, bool forceHeap)
+{
+    typedef typename std::decay<F>::type Function;
+    static_assert(sizeof(Function) <= JobPayloadSize, "Job capture is too large");
+    static_assert(alignof(Function) <= 16, "Job capture is over-aligned");
+
+    Job* job = allocateJob(forceHeap);
+    job->function = &JobSystem::invoke<F>;
+    job->counter = counter;
+    new (job->payload) Function(std::forward<F>(function));
+    if (counter) {
+        counter->_value.fetch_add(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+template <typename F>
+void JobSystem::run(F&& function, JobCounter* counter)
+{
+    schedule(createJob(std::forward<F>(function), counter, false));
+}
+
+template <typename F>
+void JobSystem::runAfter(JobCounter& dependency, F&& function, JobCounter* counter)
+{
+    // Continuations may wait arbitrarily long, so they never come from the recycled pool.
+    Job* job = createJob(std::forward<F>(function), counter, true);
+    {
+        std::lock_guard<std::mutex> lock(dependency._mutex);
+        if (dependency._value.load(std::memory_order_acquire) > 0) {
+            dependency._continuations.push_back(job);
+            return;
+        }
+    }
+    schedule(job);
+}
+
+template <typename F>
+void JobSystem::parallelFor(size_t count, size_t grain, F&& function)
+{
+    if (grain == 0) {
+        grain = 1;
+    }
+    JobCounter counter;
+    for (size_t begin = 0; begin < count; begin += grain) {
+        size_t end = std::min(begin + grain, count);
+        auto* callable = &function;
+        run([callable, begin, end]() { (*callable)(begin, end); }, &counter);
+    }
+    wait(counter);
+}
+
+#endif // JOBSYSTEM_H
@@ -0,0 +1,283 @@
+#include "logger.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+LogQueue::LogQueue(size_t capacity)
+    : _enqueuePosition(0)
+    , _dequeuePosition(0)
+{
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    _cells.reset(new Cell[size]);
+    _mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+LogRecord* LogQueue::beginPush(size_t& position)
+{
+    position = _enqueuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = _cells[position & _mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0) {
+            if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                return &cell.record;
+            }
+        } else if (difference < 0) {
+            return nullptr;
+        } else {
+            position = _enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void LogQueue::endPush(size_t position)
+{
+    _cells[position & _mask].sequence.store(position + 1, std::memory_order_release);
+}
+
+bool LogQueue::pop(LogRecord& record)
+{
+    Cell& cell = _cells[_dequeuePosition & _mask];
+    if (cell.sequence.load(std::memory_order_acquire) != _dequeuePosition + 1) {
+        return false;
+    }
+    record.time = cell.record.time;
+    record.category = cell.record.category;
+    record.level = cell.record.level;
+    record.length = cell.record.length;
+    memcpy(record.message, cell.record.message, cell.record.length);
+    cell.sequence.store(_dequeuePosition + _mask + 1, std::memory_order_release);
+    _dequeuePosition++;
+    return true;
+}
+
+Logger::Logger(size_t capacity)
+    : _queue(capacity)
+    , _pushed(0)
+    , _written(0)
+    , _dropped(0)
+    , _reportedDrops(0)
+    , _sink(nullptr)
+    , _running(false)
+    , _start(std::chrono::steady_clock::now())
+{
+    setLevel(LogLevel::Info);
+}
+
+Logger::~Logger()
+{
+    stop();
+}
+
+Logger& Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+void Logger::start(std::ostream& sink)
+{
+    stop();
+    _sink = &sink;
+    _running.store(true);
+    _thread = std::thread(&Logger::threadMain, this);
+}
+
+void Logger::stop()
+{
+    if (!_thread.joinable()) {
+        return;
+    }
+    _running.store(false);
+    _thread.join();
+    drain();
+    _sink->flush();
+}
+
+void Logger::flush()
+{
+    while (_thread.joinable() && _written.load(std::memory_order_acquire) < _pushed.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void Logger::setLevel(LogLevel level)
+{
+    for (std::atomic<LogLevel>& categoryLevel : _levels) {
+        categoryLevel.store(level, std::memory_order_relaxed);
+    }
+}
+
+void Logger::setLevel(LogCategory category, LogLevel level)
+{
+    _levels[static_cast<size_t>(category)].store(level, std::memory_order_relaxed);
+}
+
+LogLevel Logger::level(LogCategory category) const
+{
+    return _levels[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+}
+
+static bool parseLevel(const std::string& name, LogLevel& level)
+{
+    for (uint8_t i = 0; i <= static_cast<uint8_t>(LogLevel::Off); i++) {
+        if (name == toString(static_cast<LogLevel>(i))) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseCategory(const std::string& name, LogCategory& category)
+{
+    for (uint8_t i = 0; i < static_cast<uint8_t>(LogCategory::Count); i++) {
+        if (name == toString(static_cast<LogCategory>(i))) {
+            category = static_cast<LogCategory>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Logger::configure(const std::string& spec)
+{
+    // Comma separated "level" or "category:level" entries, applied in order.
+    std::istringstream stream(spec);
+    std::string entry;
+    while (std::getline(stream, entry, ',')) {
+        size_t colon = entry.find(':');
+        LogLevel level;
+        if (colon == std::string::npos) {
+            if (!parseLevel(entry, level)) {
+                return false;
+            }
+            setLevel(level);
+            continue;
+        }
+        LogCategory category;
+        if (!parseCategory(entry.substr(0, colon), category) || !parseLevel(entry.substr(colon + 1), level)) {
+            return false;
+        }
+        setLevel(category, level);
+    }
+    return true;
+}
+
+void Logger::log(LogCategory category, LogLevel level, const char* format, ...)
+{
+    size_t position;
+    LogRecord* record = _queue.beginPush(position);
+    if (record == nullptr) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    record->time = std::chrono::steady_clock::now();
+    record->category = category;
+    record->level = level;
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(record->message, LogMessageSize, format, args);
+    va_end(args);
+    record->length = static_cast<uint16_t>(length < 0 ? 0 : std::min<size_t>(static_cast<size_t>(length), LogMessageSize - 1));
+
+    _pushed.fetch_add(1, std::memory_order_relaxed);
+    _queue.endPush(position);
+}
+
+uint64_t Logger::written() const
+{
+    return _written.load(std::memory_order_relaxed);
+}
+
+uint64_t Logger::dropped() const
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+void Logger::threadMain()
+{
+    while (_running.load(std::memory_order_acquire)) {
+        if (drain() > 0) {
+            _sink->flush();
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+size_t Logger::drain()
+{
+    LogRecord record;
+    size_t count = 0;
+    while (_queue.pop(record)) {
+        write(record);
+        _written.fetch_add(1, std::memory_order_release);
+        count++;
+    }
+    uint64_t dropped = _dropped.load(std::memory_order_relaxed);
+    if (dropped != _reportedDrops) {
+        *_sink << "[logger] " << dropped - _reportedDrops << " messages dropped\n";
+        _reportedDrops = dropped;
+    }
+    return count;
+}
+
+void Logger::write(const LogRecord& record)
+{
+    char prefix[64];
+    double seconds = std::chrono::duration<double>(record.time - _start).count();
+    int length = snprintf(prefix, sizeof(prefix), "[%10.4f] %s %s: ", seconds, toString(record.level), toString(record.category));
+    _sink->write(prefix, length);
+    _sink->write(record.message, record.length);
+    _sink->put('\n');
+}
+
+const char* toString(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::Debug:
+        return "debug";
+    case LogLevel::Info:
+        return "info";
+    case LogLevel::Warning:
+        return "warning";
+    case LogLevel::Error:
+        return "error";
+    case LogLevel::Off:
+        return "off";
+    }
+    return "unknown";
+}
+
+const char* toString(LogCategory category)
+{
+    switch (category) {
+    case LogCategory::General:
+        return "general";
+    case LogCategory::Startup:
+        return "startup";
+    case LogCategory::Render:
+        return "render";
+    case LogCategory::Validation:
+        return "validation";
+    case LogCategory::Memory:
+        return "memory";
+    case LogCategory::Capture:
+        return "capture";
+    case LogCategory::Count:
+        break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,133 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+
+enum class LogLevel : uint8_t {
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+enum class LogCategory : uint8_t {
+    General,
+    Startup,
+    Render,
+    Validation,
+    Memory,
+    Capture,
+    Count
+};
+
+const size_t LogMessageSize = 232;
+const size_t LogQueueSize = 4096;
+
+struct LogRecord {
+    std::chrono::steady_clock::time_point time;
+    LogCategory category;
+    LogLevel level;
+    uint16_t length;
+    char message[LogMessageSize];
+};
+
+// Bounded multi-producer / single-consumer queue of log records. Producers
+// claim a cell with a CAS on the enqueue position and format straight into
+// it; a full queue drops the record instead of blocking the caller.
+class LogQueue {
+public:
+    explicit LogQueue(size_t capacity = LogQueueSize);
+
+    LogRecord* beginPush(size_t& position);
+    void endPush(size_t position);
+    bool pop(LogRecord& record);
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _enqueuePosition;
+    alignas(64) size_t _dequeuePosition;
+};
+
+// Asynchronous logger. log() formats into the queue and returns; a background
+// thread drains records to the sink, so hot paths never wait on the stream.
+// Levels are checked per category before any formatting happens.
+class Logger {
+public:
+    explicit Logger(size_t capacity = LogQueueSize);
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    static Logger& instance();
+
+    void start(std::ostream& sink);
+    void stop();
+    void flush();
+
+    void setLevel(LogLevel level);
+    void setLevel(LogCategory category, LogLevel level);
+    LogLevel level(LogCategory category) const;
+    bool configure(const std::string& spec);
+
+    bool isEnabled(LogCategory category, LogLevel level) const
+    {
+        return level >= _levels[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+    }
+
+    void log(LogCategory category, LogLevel level, const char* format, ...)
+#if defined(__GNUC__)
+        __attribute__((format(printf, 4, 5)))
+#endif
+        ;
+
+    uint64_t written() const;
+    uint64_t dropped() const;
+
+private:
+    void threadMain();
+    size_t drain();
+    void write(const LogRecord& record);
+
+    LogQueue _queue;
+    std::atomic<LogLevel> _levels[static_cast<size_t>(LogCategory::Count)];
+    std::atomic<uint64_t> _pushed;
+    std::atomic<uint64_t> _written;
+    std::atomic<uint64_t> _dropped;
+    uint64_t _reportedDrops;
+    std::ostream* _sink;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::chrono::steady_clock::time_point _start;
+};
+
+const char* toString(LogLevel level);
+const char* toString(LogCategory category);
+
+#define LOG_AT(category, level, ...)                            \
+    do {                                                        \
+        Logger& logger_ = Logger::instance();                   \
+        if (logger_.isEnabled(category, level)) {               \
+            logger_.log(category, level, __VA_ARGS__);          \
+        }                                                       \
+    } while (0)
+
+#define LOG_DEBUG(category, ...) LOG_AT(category, LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(category, ...) LOG_AT(category, LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(category, ...) LOG_AT(category, LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(category, ...) LOG_AT(category, LogLevel::Error, __VA_ARGS__)
+
+#endif // LOGGER_H
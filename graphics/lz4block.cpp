@@ -0,0 +1,194 @@
+#include "lz4block.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+const size_t MinMatch = 4;
+// The format requires the last five bytes to be literals and the last match
+// to start at least twelve bytes before the end of the block.
+const size_t LastLiterals = 5;
+const size_t MatchFindLimit = 12;
+const size_t MaxOffset = 65535;
+const uint32_t HashBits = 16;
+
+uint32_t read32(const char* data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t hashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HashBits);
+}
+
+// Writes the extra length bytes that follow a nibble of 15.
+bool writeLength(size_t length, char*& output, const char* end)
+{
+    while (length >= 255) {
+        if (output == end) {
+            return false;
+        }
+        *output++ = static_cast<char>(255);
+        length -= 255;
+    }
+    if (output == end) {
+        return false;
+    }
+    *output++ = static_cast<char>(length);
+    return true;
+}
+
+bool readLength(const unsigned char*& input, const unsigned char* end, size_t& length)
+{
+    unsigned char byte;
+    do {
+        if (input == end) {
+            return false;
+        }
+        byte = *input++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// One sequence: literals followed by a match, or only literals for the last
+// sequence of the block (matchLength 0).
+bool writeSequence(const char* literals, size_t literalCount, size_t offset, size_t matchLength, char*& output, const char* end)
+{
+    if (output == end) {
+        return false;
+    }
+    char* token = output++;
+    size_t literalNibble = literalCount < 15 ? literalCount : 15;
+    size_t matchNibble = 0;
+    if (literalNibble == 15 && !writeLength(literalCount - 15, output, end)) {
+        return false;
+    }
+    if (static_cast<size_t>(end - output) < literalCount) {
+        return false;
+    }
+    if (literalCount != 0) {
+        std::memcpy(output, literals, literalCount);
+        output += literalCount;
+    }
+    if (matchLength != 0) {
+        if (end - output < 2) {
+            return false;
+        }
+        *output++ = static_cast<char>(offset & 0xff);
+        *output++ = static_cast<char>(offset >> 8);
+        size_t extra = matchLength - MinMatch;
+        matchNibble = extra < 15 ? extra : 15;
+        if (matchNibble == 15 && !writeLength(extra - 15, output, end)) {
+            return false;
+        }
+    }
+    *token = static_cast<char>((literalNibble << 4) | matchNibble);
+    return true;
+}
+}
+
+size_t lz4CompressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t lz4Compress(const char* source, size_t sourceSize, char* destination, size_t capacity)
+{
+    char* output = destination;
+    const char* end = destination + capacity;
+    size_t anchor = 0;
+    if (sourceSize > MatchFindLimit) {
+        // Positions are stored plus one so that zero means empty.
+        std::vector<uint32_t> table(1u << HashBits, 0);
+        size_t matchEnd = sourceSize - LastLiterals;
+        size_t position = 0;
+        while (position + MatchFindLimit <= sourceSize) {
+            uint32_t sequence = read32(source + position);
+            uint32_t& slot = table[hashSequence(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(position + 1);
+            if (candidate == 0 || position + 1 - candidate > MaxOffset || read32(source + candidate - 1) != sequence) {
+                // Step faster through data that does not compress.
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+            size_t reference = candidate - 1;
+            while (position > anchor && reference > 0 && source[position - 1] == source[reference - 1]) {
+                position--;
+                reference--;
+            }
+            size_t length = MinMatch;
+            while (position + length < matchEnd && source[position + length] == source[reference + length]) {
+                length++;
+            }
+            if (!writeSequence(source + anchor, position - anchor, position - reference, length, output, end)) {
+                return 0;
+            }
+            position += length;
+            anchor = position;
+        }
+    }
+    if (!writeSequence(source + anchor, sourceSize - anchor, 0, 0, output, end)) {
+        return 0;
+    }
+    return static_cast<size_t>(output - destination);
+}
+
+bool lz4Decompress(const char* source, size_t sourceSize, char* destination, size_t destinationSize)
+{
+    const unsigned char* input = reinterpret_cast<const unsigned char*>(source);
+    const unsigned char* inputEnd = input + sourceSize;
+    size_t written = 0;
+    while (input != inputEnd) {
+        unsigned char token = *input++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(input, inputEnd, literalCount)) {
+            return false;
+        }
+        if (literalCount > static_cast<size_t>(inputEnd - input) || literalCount > destinationSize - written) {
+            return false;
+        }
+        if (literalCount != 0) {
+            std::memcpy(destination + written, input, literalCount);
+            input += literalCount;
+            written += literalCount;
+        }
+        if (input == inputEnd) {
+            break;
+        }
+
+        if (inputEnd - input < 2) {
+            return false;
+        }
+        size_t offset = input[0] | (static_cast<size_t>(input[1]) << 8);
+        input += 2;
+        if (offset == 0 || offset > written) {
+            return false;
+        }
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(input, inputEnd, matchLength)) {
+            return false;
+        }
+        matchLength += MinMatch;
+        if (matchLength > destinationSize - written) {
+            return false;
+        }
+        char* target = destination + written;
+        const char* match = target - offset;
+        if (offset >= matchLength) {
+            std::memcpy(target, match, matchLength);
+        } else {
+            // Overlapping copies repeat the last offset bytes.
+            for (size_t i = 0; i < matchLength; i++) {
+                target[i] = match[i];
+            }
+        }
+        written += matchLength;
+    }
+    return written == destinationSize;
+}
@@ -0,0 +1,18 @@
+#ifndef LZ4BLOCK_H
+#define LZ4BLOCK_H
+
+#include <cstddef>
+
+// Compressor and decompressor for the LZ4 block format: the raw sequence
+// stream without frame header or checksums, so the size of the decompressed
+// data has to be stored alongside. Output is readable by any LZ4 block
+// decoder and the decoder accepts any valid block.
+size_t lz4CompressBound(size_t size);
+// Greedy single-pass compression. Returns the compressed size, or 0 when the
+// result does not fit into capacity.
+size_t lz4Compress(const char* source, size_t sourceSize, char* destination, size_t capacity);
+// Returns false unless the block is well formed and decodes to exactly
+// destinationSize bytes; never reads or writes out of bounds.
+bool lz4Decompress(const char* source, size_t sourceSize, char* destination, size_t destinationSize);
+
+#endif // LZ4BLOCK_H
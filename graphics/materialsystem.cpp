@@ -0,0 +1,324 @@
+#include "materialsystem.h"
+#include "helperfunctions.h"
+#include "vertex.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+const uint64_t FnvOffset = 14695981039346656037ull;
+const uint64_t FnvPrime = 1099511628211ull;
+
+void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FnvPrime;
+    }
+}
+
+void hashValue(uint64_t& hash, uint32_t value)
+{
+    hashBytes(hash, &value, sizeof(value));
+}
+
+void hashString(uint64_t& hash, const std::string& value)
+{
+    hashBytes(hash, value.data(), value.size());
+    // Keeps ("ab", "c") and ("a", "bc") apart.
+    hashValue(hash, static_cast<uint32_t>(value.size()));
+}
+}
+
+bool PipelineState::operator==(const PipelineState& other) const
+{
+    return vertexShader == other.vertexShader && fragmentShader == other.fragmentShader && topology == other.topology && polygonMode == other.polygonMode && cullMode == other.cullMode
+        && frontFace == other.frontFace && depthTest == other.depthTest && depthWrite == other.depthWrite && depthCompare == other.depthCompare && blend == other.blend
+        && srcColorBlend == other.srcColorBlend && dstColorBlend == other.dstColorBlend && colorBlendOp == other.colorBlendOp;
+}
+
+size_t PipelineState::hash() const
+{
+    uint64_t hash = FnvOffset;
+    hashString(hash, vertexShader);
+    hashString(hash, fragmentShader);
+    hashValue(hash, static_cast<uint32_t>(topology));
+    hashValue(hash, static_cast<uint32_t>(polygonMode));
+    hashValue(hash, static_cast<uint32_t>(static_cast<VkCullModeFlags>(cullMode)));
+    hashValue(hash, static_cast<uint32_t>(frontFace));
+    hashValue(hash, (depthTest ? 1u : 0u) | (depthWrite ? 2u : 0u) | (blend ? 4u : 0u));
+    hashValue(hash, static_cast<uint32_t>(depthCompare));
+    hashValue(hash, static_cast<uint32_t>(srcColorBlend));
+    hashValue(hash, static_cast<uint32_t>(dstColorBlend));
+    hashValue(hash, static_cast<uint32_t>(colorBlendOp));
+    return static_cast<size_t>(hash);
+}
+
+MaterialSystem::MaterialSystem()
+    : _memoryTracker(nullptr)
+    , _lookups(0)
+    , _hits(0)
+    , _pipelineBuilds(0)
+{
+}
+
+void MaterialSystem::init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, vk::DescriptorSetLayout sceneLayout)
+{
+    _device = device;
+    _physicalDevice = physicalDevice;
+    _memoryTracker = &tracker;
+
+    vk::DescriptorSetLayoutBinding parameterBinding(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, nullptr);
+    vk::DescriptorSetLayoutCreateInfo layoutInfo;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &parameterBinding;
+    if (_device.createDescriptorSetLayout(&layoutInfo, nullptr, &_setLayout) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create material descriptor set layout!" << std::endl;
+        std::abort();
+    }
+
+    vk::DescriptorSetLayout setLayouts[] = { sceneLayout, _setLayout };
+    vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(uint32_t));
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+    pipelineLayoutInfo.setLayoutCount = 2;
+    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    vk::Result res = _device.createPipelineLayout(&pipelineLayoutInfo, nullptr, &_pipelineLayout);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create pipeline layout! error:" << res << std::endl;
+        std::abort();
+    }
+}
+
+void MaterialSystem::destroy()
+{
+    if (!_pipelineLayout) {
+        return;
+    }
+    destroyPipelines();
+    for (const auto& module : _shaderModules) {
+        _device.destroyShaderModule(module.second);
+    }
+    _shaderModules.clear();
+    if (_parameterBuffer) {
+        _device.destroyDescriptorPool(_descriptorPool);
+        _device.destroyBuffer(_parameterBuffer);
+        _memoryTracker->free(_parameterMemory);
+    }
+    _device.destroyPipelineLayout(_pipelineLayout);
+    _device.destroyDescriptorSetLayout(_setLayout);
+    _pipelineLayout = vk::PipelineLayout();
+}
+
+void MaterialSystem::addShader(const std::string& name, const ShaderCode& code)
+{
+    _shaderCode[name] = code;
+}
+
+bool MaterialSystem::hasShader(const std::string& name) const
+{
+    return _shaderCode.count(name) != 0;
+}
+
+MaterialHandle MaterialSystem::create(const MaterialDesc& desc)
+{
+    _lookups++;
+    uint32_t pipelineIndex;
+    auto found = _pipelineIndices.find(desc.state);
+    if (found != _pipelineIndices.end()) {
+        pipelineIndex = found->second;
+        _hits++;
+    } else {
+        pipelineIndex = static_cast<uint32_t>(_pipelines.size());
+        PipelineEntry entry;
+        entry.state = desc.state;
+        entry.materialCount = 0;
+        _pipelines.push_back(entry);
+        _pipelineIndices.emplace(desc.state, pipelineIndex);
+    }
+    _pipelines[pipelineIndex].materialCount++;
+
+    MaterialHandle material = static_cast<MaterialHandle>(_materialPipelines.size());
+    _materialPipelines.push_back(pipelineIndex);
+    _parameters.push_back(desc.parameters);
+    _names.push_back(desc.name);
+    return material;
+}
+
+size_t MaterialSystem::materialCount() const
+{
+    return _materialPipelines.size();
+}
+
+size_t MaterialSystem::pipelineCount() const
+{
+    return _pipelines.size();
+}
+
+const std::string& MaterialSystem::name(MaterialHandle material) const
+{
+    return _names[material];
+}
+
+void MaterialSystem::uploadParameters(UploadBatch& uploads)
+{
+    vk::DeviceSize size = sizeof(MaterialParameters) * _parameters.size();
+    createBuffer(_device, _physicalDevice, *_memoryTracker, MemoryCategory::Storage, size, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal,
+        _parameterBuffer, _parameterMemory);
+    uploads.uploadBuffer(_parameters.data(), size, _parameterBuffer);
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, 1);
+    vk::DescriptorPoolCreateInfo poolInfo(vk::DescriptorPoolCreateFlags(), 1, 1, &poolSize);
+    if (_device.createDescriptorPool(&poolInfo, nullptr, &_descriptorPool) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create material descriptor pool!" << std::endl;
+        std::abort();
+    }
+    vk::DescriptorSetAllocateInfo allocInfo(_descriptorPool, 1, &_setLayout);
+    if (_device.allocateDescriptorSets(&allocInfo, &_descriptorSet) != vk::Result::eSuccess) {
+        std::cerr << "Failed to allocate material descriptor set!" << std::endl;
+        std::abort();
+    }
+    vk::DescriptorBufferInfo bufferInfo(_parameterBuffer, 0, VK_WHOLE_SIZE);
+    vk::WriteDescriptorSet write;
+    write.dstSet = _descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorType = vk::DescriptorType::eStorageBuffer;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &bufferInfo;
+    _device.updateDescriptorSets(1, &write, 0, nullptr);
+}
+
+void MaterialSystem::createPipelines(vk::RenderPass renderPass, vk::PipelineCache cache)
+{
+    auto bindingDescription = Vertex::getBindingDescription();
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
+    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    vk::PipelineViewportStateCreateInfo viewportState;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    vk::PipelineMultisampleStateCreateInfo multisampling;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+    vk::DynamicState dynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+    vk::PipelineDynamicStateCreateInfo dynamicState(vk::PipelineDynamicStateCreateFlags(), 2, dynamicStates);
+
+    for (PipelineEntry& entry : _pipelines) {
+        if (entry.pipeline) {
+            continue;
+        }
+        const PipelineState& state = entry.state;
+
+        vk::PipelineShaderStageCreateInfo shaderStages[2];
+        shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
+        shaderStages[0].module = shaderModule(state.vertexShader);
+        shaderStages[0].pName = "main";
+        shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
+        shaderStages[1].module = shaderModule(state.fragmentShader);
+        shaderStages[1].pName = "main";
+
+        vk::PipelineInputAssemblyStateCreateInfo inputAssembly(vk::PipelineInputAssemblyStateCreateFlags(), state.topology, VK_FALSE);
+
+        vk::PipelineRasterizationStateCreateInfo rasterizer;
+        rasterizer.depthClampEnable = VK_FALSE;
+        rasterizer.rasterizerDiscardEnable = VK_FALSE;
+        rasterizer.polygonMode = state.polygonMode;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.cullMode = state.cullMode;
+        rasterizer.frontFace = state.frontFace;
+        rasterizer.depthBiasEnable = VK_FALSE;
+
+        vk::PipelineDepthStencilStateCreateInfo depthStencil(vk::PipelineDepthStencilStateCreateFlags(), state.depthTest, state.depthWrite, state.depthCompare, VK_FALSE, VK_FALSE);
+
+        vk::PipelineColorBlendAttachmentState colorBlendAttachment;
+        colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+        colorBlendAttachment.blendEnable = state.blend;
+        colorBlendAttachment.srcColorBlendFactor = state.srcColorBlend;
+        colorBlendAttachment.dstColorBlendFactor = state.dstColorBlend;
+        colorBlendAttachment.colorBlendOp = state.colorBlendOp;
+        colorBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+        colorBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+        colorBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
+        vk::PipelineColorBlendStateCreateInfo colorBlending(vk::PipelineColorBlendStateCreateFlags(), VK_FALSE, vk::LogicOp::eCopy, 1, &colorBlendAttachment, { { 0.0f, 0.0f, 0.0f, 0.0f } });
+
+        vk::GraphicsPipelineCreateInfo pipelineInfo(vk::PipelineCreateFlags(), 2, shaderStages, &vertexInputInfo, &inputAssembly, nullptr, &viewportState, &rasterizer, &multisampling, &depthStencil, &colorBlending, &dynamicState, _pipelineLayout, renderPass, 0, vk::Pipeline(), 0);
+        vk::Result res = _device.createGraphicsPipelines(cache, 1, &pipelineInfo, nullptr, &entry.pipeline);
+        if (res != vk::Result::eSuccess) {
+            std::cerr << "Failed to create graphics pipeline! error:" << res << std::endl;
+            std::abort();
+        }
+        _pipelineBuilds++;
+    }
+}
+
+void MaterialSystem::destroyPipelines()
+{
+    for (PipelineEntry& entry : _pipelines) {
+        if (entry.pipeline) {
+            _device.destroyPipeline(entry.pipeline);
+            entry.pipeline = vk::Pipeline();
+        }
+    }
+}
+
+vk::Pipeline MaterialSystem::pipeline(MaterialHandle material) const
+{
+    return _pipelines[_materialPipelines[material]].pipeline;
+}
+
+uint32_t MaterialSystem::pipelineIndex(MaterialHandle material) const
+{
+    return _materialPipelines[material];
+}
+
+vk::PipelineLayout MaterialSystem::pipelineLayout() const
+{
+    return _pipelineLayout;
+}
+
+vk::DescriptorSet MaterialSystem::descriptorSet() const
+{
+    return _descriptorSet;
+}
+
+void MaterialSystem::report(std::ostream& stream) const
+{
+    if (_lookups == 0) {
+        return;
+    }
+    uint32_t largest = 0;
+    for (const PipelineEntry& entry : _pipelines) {
+        largest = std::max(largest, entry.materialCount);
+    }
+    stream << std::fixed << std::setprecision(1);
+    stream << "  materials: " << _materialPipelines.size() << " materials on " << _pipelines.size() << " pipelines, state cache hit rate " << 100.0 * _hits / _lookups << "%, up to " << largest
+           << " materials per pipeline, " << _pipelineBuilds << " pipeline builds, " << sizeof(MaterialParameters) * _parameters.size() << " bytes of parameters" << std::endl;
+    stream.unsetf(std::ios::floatfield);
+}
+
+vk::ShaderModule MaterialSystem::shaderModule(const std::string& name)
+{
+    auto found = _shaderModules.find(name);
+    if (found != _shaderModules.end()) {
+        return found->second;
+    }
+    auto code = _shaderCode.find(name);
+    if (code == _shaderCode.end()) {
+        std::cerr << "Material shader [" << name << "] was not added!" << std::endl;
+        std::abort();
+    }
+    vk::ShaderModule module;
+    createShaderModule(_device, code->second, module);
+    _shaderModules[name] = module;
+    return module;
+}
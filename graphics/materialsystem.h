@@ -0,0 +1,124 @@
+#ifndef MATERIALSYSTEM_H
+#define MATERIALSYSTEM_H
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "memorytracker.h"
+#include "shadercode.h"
+#include "uploadbatch.h"
+
+// Everything that goes into a vk::Pipeline besides the render pass and the
+// shared layout. Materials with equal states share one pipeline.
+struct PipelineState {
+    std::string vertexShader = "vert";
+    std::string fragmentShader = "frag";
+    vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+    vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+    vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+    vk::FrontFace frontFace = vk::FrontFace::eCounterClockwise;
+    bool depthTest = true;
+    bool depthWrite = true;
+    vk::CompareOp depthCompare = vk::CompareOp::eLess;
+    bool blend = false;
+    vk::BlendFactor srcColorBlend = vk::BlendFactor::eSrcAlpha;
+    vk::BlendFactor dstColorBlend = vk::BlendFactor::eOneMinusSrcAlpha;
+    vk::BlendOp colorBlendOp = vk::BlendOp::eAdd;
+
+    bool operator==(const PipelineState& other) const;
+    size_t hash() const;
+};
+
+struct PipelineStateHash {
+    size_t operator()(const PipelineState& state) const
+    {
+        return state.hash();
+    }
+};
+
+// One tightly packed entry per material in a storage buffer; shaders index it
+// with the material index push constant.
+struct MaterialParameters {
+    float baseColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    float emissive[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+struct MaterialDesc {
+    std::string name;
+    PipelineState state;
+    MaterialParameters parameters;
+};
+
+typedef uint32_t MaterialHandle;
+
+// Owns the pipelines of all materials. Pipelines are created per unique state,
+// found by hash when a material is added, and share one layout: the scene set,
+// the material parameter set and a push constant holding the material index.
+class MaterialSystem {
+public:
+    MaterialSystem();
+
+    void init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, vk::DescriptorSetLayout sceneLayout);
+    void destroy();
+
+    // Code must outlive the material system.
+    void addShader(const std::string& name, const ShaderCode& code);
+    bool hasShader(const std::string& name) const;
+
+    MaterialHandle create(const MaterialDesc& desc);
+    size_t materialCount() const;
+    size_t pipelineCount() const;
+    const std::string& name(MaterialHandle material) const;
+
+    void uploadParameters(UploadBatch& uploads);
+
+    // Pipelines depend on the render pass and are rebuilt with it.
+    void createPipelines(vk::RenderPass renderPass, vk::PipelineCache cache);
+    void destroyPipelines();
+
+    vk::Pipeline pipeline(MaterialHandle material) const;
+    uint32_t pipelineIndex(MaterialHandle material) const;
+    vk::PipelineLayout pipelineLayout() const;
+    vk::DescriptorSet descriptorSet() const;
+
+    void report(std::ostream& stream) const;
+
+private:
+    struct PipelineEntry {
+        PipelineState state;
+        vk::Pipeline pipeline;
+        uint32_t materialCount;
+    };
+
+    vk::ShaderModule shaderModule(const std::string& name);
+
+    vk::Device _device;
+    vk::PhysicalDevice _physicalDevice;
+    MemoryTracker* _memoryTracker;
+
+    std::map<std::string, ShaderCode> _shaderCode;
+    std::map<std::string, vk::ShaderModule> _shaderModules;
+
+    std::unordered_map<PipelineState, uint32_t, PipelineStateHash> _pipelineIndices;
+    std::vector<PipelineEntry> _pipelines;
+    std::vector<uint32_t> _materialPipelines;
+    std::vector<MaterialParameters> _parameters;
+    std::vector<std::string> _names;
+    uint64_t _lookups;
+    uint64_t _hits;
+    uint64_t _pipelineBuilds;
+
+    vk::DescriptorSetLayout _setLayout;
+    vk::DescriptorPool _descriptorPool;
+    vk::DescriptorSet _descriptorSet;
+    vk::PipelineLayout _pipelineLayout;
+    vk::Buffer _parameterBuffer;
+    vk::DeviceMemory _parameterMemory;
+};
+
+#endif // MATERIALSYSTEM_H
@@ -0,0 +1,214 @@
+#include "memorytracker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+namespace {
+const char* const CategoryNames[] = { "vertex", "index", "uniform", "texture", "attachment", "staging", "storage" };
+
+const double MiB = 1024.0 * 1024.0;
+
+bool hasExtension(const std::vector<vk::ExtensionProperties>& extensions, const char* name)
+{
+    for (const vk::ExtensionProperties& extension : extensions) {
+        if (std::strcmp(extension.extensionName, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+const char* memoryCategoryName(MemoryCategory category)
+{
+    return CategoryNames[static_cast<size_t>(category)];
+}
+
+MemoryTracker::MemoryTracker()
+    : _getMemoryProperties2(nullptr)
+    , _instanceExtension(false)
+    , _budgetExtension(false)
+    , _threshold(1.0)
+{
+}
+
+std::vector<const char*> MemoryTracker::requestInstanceExtensions()
+{
+    std::vector<const char*> extensions;
+#ifdef VK_EXT_memory_budget
+    uint32_t count = 0;
+    vk::enumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+    std::vector<vk::ExtensionProperties> available(count);
+    vk::enumerateInstanceExtensionProperties(nullptr, &count, available.data());
+    _instanceExtension = hasExtension(available, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    if (_instanceExtension) {
+        extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    }
+#endif
+    return extensions;
+}
+
+std::vector<const char*> MemoryTracker::requestDeviceExtensions(vk::PhysicalDevice physicalDevice)
+{
+    std::vector<const char*> extensions;
+#ifdef VK_EXT_memory_budget
+    uint32_t count = 0;
+    physicalDevice.enumerateDeviceExtensionProperties(nullptr, &count, nullptr);
+    std::vector<vk::ExtensionProperties> available(count);
+    physicalDevice.enumerateDeviceExtensionProperties(nullptr, &count, available.data());
+    _budgetExtension = _instanceExtension && hasExtension(available, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (_budgetExtension) {
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+#endif
+    return extensions;
+}
+
+void MemoryTracker::init(vk::Instance instance, vk::PhysicalDevice physicalDevice, vk::Device device)
+{
+    _device = device;
+    _physicalDevice = physicalDevice;
+    physicalDevice.getMemoryProperties(&_memoryProperties);
+    if (_budgetExtension) {
+        _getMemoryProperties2 = instance.getProcAddr("vkGetPhysicalDeviceMemoryProperties2KHR");
+        _budgetExtension = _getMemoryProperties2 != nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _heaps.assign(_memoryProperties.memoryHeapCount, Usage());
+    _overBudget.assign(_memoryProperties.memoryHeapCount, false);
+}
+
+bool MemoryTracker::hasBudgetExtension() const
+{
+    return _budgetExtension;
+}
+
+void MemoryTracker::add(Usage& usage, vk::DeviceSize size)
+{
+    usage.live += size;
+    usage.peak = std::max(usage.peak, usage.live);
+    usage.count++;
+}
+
+vk::Result MemoryTracker::allocate(const vk::MemoryAllocateInfo& allocInfo, MemoryCategory category, vk::DeviceMemory& memory)
+{
+    vk::Result res = _device.allocateMemory(&allocInfo, nullptr, &memory);
+    if (res != vk::Result::eSuccess) {
+        return res;
+    }
+
+    Allocation allocation = { allocInfo.allocationSize, _memoryProperties.memoryTypes[allocInfo.memoryTypeIndex].heapIndex, category };
+    std::lock_guard<std::mutex> lock(_mutex);
+    _allocations[static_cast<VkDeviceMemory>(memory)] = allocation;
+    add(_categories[static_cast<size_t>(category)], allocation.size);
+    add(_heaps[allocation.heap], allocation.size);
+    return res;
+}
+
+void MemoryTracker::free(vk::DeviceMemory memory)
+{
+    if (!memory) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto found = _allocations.find(static_cast<VkDeviceMemory>(memory));
+        if (found != _allocations.end()) {
+            _categories[static_cast<size_t>(found->second.category)].live -= found->second.size;
+            _heaps[found->second.heap].live -= found->second.size;
+            _allocations.erase(found);
+        }
+    }
+    _device.freeMemory(memory);
+}
+
+vk::DeviceSize MemoryTracker::liveBytes(MemoryCategory category) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _categories[static_cast<size_t>(category)].live;
+}
+
+vk::DeviceSize MemoryTracker::peakBytes(MemoryCategory category) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _categories[static_cast<size_t>(category)].peak;
+}
+
+uint64_t MemoryTracker::allocationCount(MemoryCategory category) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _categories[static_cast<size_t>(category)].count;
+}
+
+std::vector<MemoryHeapStatus> MemoryTracker::heapStatus() const
+{
+    std::vector<MemoryHeapStatus> heaps(_memoryProperties.memoryHeapCount);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (uint32_t i = 0; i < _memoryProperties.memoryHeapCount; i++) {
+            MemoryHeapStatus& heap = heaps[i];
+            heap.heap = i;
+            heap.deviceLocal = static_cast<bool>(_memoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+            heap.size = _memoryProperties.memoryHeaps[i].size;
+            heap.budget = heap.size;
+            heap.tracked = _heaps[i].live;
+            heap.usage = heap.tracked;
+            heap.peak = _heaps[i].peak;
+        }
+    }
+
+#ifdef VK_EXT_memory_budget
+    if (_budgetExtension) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+        budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2KHR properties = {};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+        properties.pNext = &budget;
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(_getMemoryProperties2);
+        getMemoryProperties2(static_cast<VkPhysicalDevice>(_physicalDevice), &properties);
+        for (MemoryHeapStatus& heap : heaps) {
+            heap.budget = budget.heapBudget[heap.heap];
+            heap.usage = budget.heapUsage[heap.heap];
+        }
+    }
+#endif
+    return heaps;
+}
+
+void MemoryTracker::setBudgetCallback(double threshold, const BudgetCallback& callback)
+{
+    _threshold = threshold;
+    _callback = callback;
+}
+
+void MemoryTracker::checkBudget()
+{
+    if (!_callback) {
+        return;
+    }
+    for (const MemoryHeapStatus& heap : heapStatus()) {
+        bool over = static_cast<double>(heap.usage) > _threshold * static_cast<double>(heap.budget);
+        if (over && !_overBudget[heap.heap]) {
+            _callback(heap);
+        }
+        _overBudget[heap.heap] = over;
+    }
+}
+
+void MemoryTracker::dump(std::ostream& stream) const
+{
+    stream << std::fixed << std::setprecision(2);
+    stream << "GPU memory" << (_budgetExtension ? " (VK_EXT_memory_budget)" : "") << ":" << std::endl;
+    for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); i++) {
+        MemoryCategory category = static_cast<MemoryCategory>(i);
+        stream << "  " << std::setw(10) << std::left << memoryCategoryName(category) << std::right << " live " << liveBytes(category) / MiB << " MiB, peak " << peakBytes(category) / MiB << " MiB, "
+               << allocationCount(category) << " allocations" << std::endl;
+    }
+    for (const MemoryHeapStatus& heap : heapStatus()) {
+        stream << "  heap " << heap.heap << (heap.deviceLocal ? " (device local)" : "") << ": tracked " << heap.tracked / MiB << " MiB, peak " << heap.peak / MiB << " MiB, usage " << heap.usage / MiB
+               << " MiB of budget " << heap.budget / MiB << " MiB, heap size " << heap.size / MiB << " MiB" << std::endl;
+    }
+    stream.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,97 @@
+#ifndef MEMORYTRACKER_H
+#define MEMORYTRACKER_H
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+enum class MemoryCategory {
+    Vertex,
+    Index,
+    Uniform,
+    Texture,
+    Attachment,
+    Staging,
+    Storage,
+    Count
+};
+
+const char* memoryCategoryName(MemoryCategory category);
+
+struct MemoryHeapStatus {
+    uint32_t heap;
+    bool deviceLocal;
+    vk::DeviceSize size;
+    // Driver-reported budget and process usage with VK_EXT_memory_budget,
+    // otherwise the heap size and the bytes allocated through the tracker.
+    vk::DeviceSize budget;
+    vk::DeviceSize usage;
+    vk::DeviceSize tracked;
+    vk::DeviceSize peak;
+};
+
+// Every device memory allocation goes through the tracker, tagged with a
+// category. Thread-safe, since startup allocates from several jobs at once.
+class MemoryTracker {
+public:
+    typedef std::function<void(const MemoryHeapStatus&)> BudgetCallback;
+
+    MemoryTracker();
+
+    // Extensions to enable for VK_EXT_memory_budget; empty when unsupported.
+    std::vector<const char*> requestInstanceExtensions();
+    std::vector<const char*> requestDeviceExtensions(vk::PhysicalDevice physicalDevice);
+    void init(vk::Instance instance, vk::PhysicalDevice physicalDevice, vk::Device device);
+    bool hasBudgetExtension() const;
+
+    vk::Result allocate(const vk::MemoryAllocateInfo& allocInfo, MemoryCategory category, vk::DeviceMemory& memory);
+    void free(vk::DeviceMemory memory);
+
+    vk::DeviceSize liveBytes(MemoryCategory category) const;
+    vk::DeviceSize peakBytes(MemoryCategory category) const;
+    uint64_t allocationCount(MemoryCategory category) const;
+    std::vector<MemoryHeapStatus> heapStatus() const;
+
+    // Called once when a heap's usage crosses threshold * budget, and again
+    // only after it has dropped back below.
+    void setBudgetCallback(double threshold, const BudgetCallback& callback);
+    void checkBudget();
+    void dump(std::ostream& stream) const;
+
+private:
+    struct Allocation {
+        vk::DeviceSize size;
+        uint32_t heap;
+        MemoryCategory category;
+    };
+
+    struct Usage {
+        vk::DeviceSize live = 0;
+        vk::DeviceSize peak = 0;
+        uint64_t count = 0;
+    };
+
+    static void add(Usage& usage, vk::DeviceSize size);
+
+    vk::Device _device;
+    vk::PhysicalDevice _physicalDevice;
+    vk::PhysicalDeviceMemoryProperties _memoryProperties;
+    PFN_vkVoidFunction _getMemoryProperties2;
+    bool _instanceExtension;
+    bool _budgetExtension;
+
+    mutable std::mutex _mutex;
+    std::unordered_map<VkDeviceMemory, Allocation> _allocations;
+    Usage _categories[static_cast<size_t>(MemoryCategory::Count)];
+    std::vector<Usage> _heaps;
+
+    double _threshold;
+    BudgetCallback _callback;
+    std::vector<bool> _overBudget;
+};
+
+#endif // MEMORYTRACKER_H
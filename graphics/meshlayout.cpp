@@ -0,0 +1,122 @@
+#include "meshlayout.h"
+
+#include <algorithm>
+#include <initializer_list>
+
+MeshLayout::MeshLayout()
+    : _liveMeshes(0)
+{
+}
+
+void MeshLayout::reset(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    _vertices.reset(vertexCapacity);
+    _indices.reset(indexCapacity);
+    _meshes.clear();
+    _freeHandles.clear();
+    _liveMeshes = 0;
+}
+
+MeshHandle MeshLayout::add(uint32_t vertexCount, uint32_t indexCount)
+{
+    uint32_t vertexOffset = _vertices.allocate(vertexCount);
+    if (vertexOffset == RangeAllocator::InvalidOffset) {
+        return InvalidMesh;
+    }
+    uint32_t firstIndex = _indices.allocate(indexCount);
+    if (firstIndex == RangeAllocator::InvalidOffset) {
+        _vertices.free(vertexOffset, vertexCount);
+        return InvalidMesh;
+    }
+
+    MeshHandle handle;
+    if (_freeHandles.empty()) {
+        handle = static_cast<MeshHandle>(_meshes.size());
+        _meshes.push_back(Mesh());
+    } else {
+        handle = _freeHandles.back();
+        _freeHandles.pop_back();
+    }
+    Mesh& mesh = _meshes[handle];
+    mesh.range.firstIndex = firstIndex;
+    mesh.range.indexCount = indexCount;
+    mesh.range.vertexOffset = static_cast<int32_t>(vertexOffset);
+    mesh.range.vertexCount = vertexCount;
+    mesh.live = true;
+    _liveMeshes++;
+    return handle;
+}
+
+void MeshLayout::remove(MeshHandle handle)
+{
+    if (!isLive(handle)) {
+        return;
+    }
+    Mesh& mesh = _meshes[handle];
+    _vertices.free(static_cast<uint32_t>(mesh.range.vertexOffset), mesh.range.vertexCount);
+    _indices.free(mesh.range.firstIndex, mesh.range.indexCount);
+    mesh.live = false;
+    _liveMeshes--;
+    _freeHandles.push_back(handle);
+}
+
+bool MeshLayout::isLive(MeshHandle handle) const
+{
+    return handle < _meshes.size() && _meshes[handle].live;
+}
+
+const MeshRange& MeshLayout::mesh(MeshHandle handle) const
+{
+    return _meshes[handle].range;
+}
+
+size_t MeshLayout::meshCount() const
+{
+    return _liveMeshes;
+}
+
+double MeshLayout::fragmentation() const
+{
+    return std::max(_vertices.fragmentation(), _indices.fragmentation());
+}
+
+double MeshLayout::slack() const
+{
+    double slack = 0.0;
+    for (const RangeAllocator* allocator : { &_vertices, &_indices }) {
+        if (allocator->end() > 0) {
+            slack = std::max(slack, 1.0 - static_cast<double>(allocator->used()) / static_cast<double>(allocator->end()));
+        }
+    }
+    return slack;
+}
+
+std::vector<MeshMove> MeshLayout::compact()
+{
+    std::vector<MeshMove> moves;
+    moves.reserve(_liveMeshes);
+    _vertices.reset(_vertices.capacity());
+    _indices.reset(_indices.capacity());
+    for (Mesh& mesh : _meshes) {
+        if (!mesh.live) {
+            continue;
+        }
+        MeshMove move;
+        move.from = mesh.range;
+        mesh.range.vertexOffset = static_cast<int32_t>(_vertices.allocate(mesh.range.vertexCount));
+        mesh.range.firstIndex = _indices.allocate(mesh.range.indexCount);
+        move.to = mesh.range;
+        moves.push_back(move);
+    }
+    return moves;
+}
+
+const RangeAllocator& MeshLayout::vertices() const
+{
+    return _vertices;
+}
+
+const RangeAllocator& MeshLayout::indices() const
+{
+    return _indices;
+}
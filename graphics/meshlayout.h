@@ -0,0 +1,68 @@
+#ifndef MESHLAYOUT_H
+#define MESHLAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rangeallocator.h"
+
+typedef uint32_t MeshHandle;
+const MeshHandle InvalidMesh = 0xffffffffu;
+
+// Where a mesh lives in the pool: indices are 16 bit and relative to the
+// mesh's first vertex, which vertexOffset supplies at draw time.
+struct MeshRange {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+};
+
+struct MeshMove {
+    MeshRange from;
+    MeshRange to;
+};
+
+// The bookkeeping half of the geometry pool: which vertex and index ranges
+// each mesh handle owns. Handles stay valid across compaction; only their
+// ranges move.
+class MeshLayout {
+public:
+    MeshLayout();
+
+    void reset(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+    // Returns InvalidMesh when no free range is large enough.
+    MeshHandle add(uint32_t vertexCount, uint32_t indexCount);
+    void remove(MeshHandle mesh);
+    bool isLive(MeshHandle mesh) const;
+    const MeshRange& mesh(MeshHandle mesh) const;
+    size_t meshCount() const;
+
+    double fragmentation() const;
+    // Share of the vertex or index range below its last mesh that is free, 0
+    // when the meshes are packed. Unlike fragmentation() it ignores the free
+    // space after the last mesh.
+    double slack() const;
+    // Packs the live meshes to the front of the ranges in handle order and
+    // returns where each one moved.
+    std::vector<MeshMove> compact();
+
+    const RangeAllocator& vertices() const;
+    const RangeAllocator& indices() const;
+
+private:
+    struct Mesh {
+        MeshRange range;
+        bool live = false;
+    };
+
+    RangeAllocator _vertices;
+    RangeAllocator _indices;
+    std::vector<Mesh> _meshes;
+    std::vector<MeshHandle> _freeHandles;
+    size_t _liveMeshes;
+};
+
+#endif // MESHLAYOUT_H
@@ -0,0 +1,607 @@
+#include "occlusionculler.h"
+#include "helperfunctions.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+// Bounding sphere of the scene mesh: both quads fit in a unit square, from z = -0.5 to 0.
+const glm::vec4 MeshBounds(0.0f, 0.0f, -0.25f, 0.75f);
+const float FieldSize = 4.0f;
+
+uint32_t hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float unitRandom(uint32_t& state)
+{
+    state = hash(state);
+    return static_cast<float>(state) / 4294967295.0f;
+}
+
+// Gribb-Hartmann planes for a [0, 1] depth range, normalized so that the
+// plane distance can be compared with a sphere radius.
+void extractFrustum(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[2];
+    planes[5] = rows[3] - rows[2];
+    for (int i = 0; i < 6; i++) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+}
+
+OcclusionCuller::OcclusionCuller()
+    : _memoryTracker(nullptr)
+    , _queueFamily(0)
+    , _objectCount(0)
+    , _slotCount(0)
+    , _parameters(nullptr)
+    , _parameterStride(0)
+    , _statistics(nullptr)
+    , _statisticsStride(0)
+    , _frames(0)
+    , _earlyDrawn(0)
+    , _lateDrawn(0)
+    , _visible(0)
+    , _occluded(0)
+    , _frustumCulled(0)
+{
+}
+
+bool OcclusionCuller::loadShaders(const std::string& shaderDirectory)
+{
+    return findShader(shaderDirectory, "hiz_cull_comp", _cullStorage, _cullCode) && findShader(shaderDirectory, "hiz_reduce_comp", _reduceStorage, _reduceCode)
+        && findShader(shaderDirectory, "objects_vert", _vertStorage, _vertCode);
+}
+
+void OcclusionCuller::init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, UploadBatch& uploads, uint32_t queueFamily, uint32_t objectCount, const MeshRange& mesh, uint32_t slotCount)
+{
+    _device = device;
+    _physicalDevice = physicalDevice;
+    _memoryTracker = &tracker;
+    _queueFamily = queueFamily;
+    _objectCount = objectCount;
+    _slotCount = slotCount;
+
+    // A grid of small copies of the mesh below the scene, most of them hidden
+    // behind it from the default camera.
+    std::vector<ObjectData> objects(objectCount);
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+    float spacing = FieldSize / static_cast<float>(side);
+    for (uint32_t i = 0; i < objectCount; i++) {
+        uint32_t state = i;
+        ObjectData& object = objects[i];
+        object.position[0] = (static_cast<float>(i % side) + 0.5f) * spacing - FieldSize * 0.5f;
+        object.position[1] = (static_cast<float>(i / side) + 0.5f) * spacing - FieldSize * 0.5f;
+        object.position[2] = -0.75f - 0.5f * unitRandom(state);
+        object.position[3] = spacing * (0.3f + 0.3f * unitRandom(state));
+        object.color[0] = 0.5f + 0.5f * unitRandom(state);
+        object.color[1] = 0.5f + 0.5f * unitRandom(state);
+        object.color[2] = 0.5f + 0.5f * unitRandom(state);
+        object.color[3] = 1.0f;
+    }
+
+    vk::DeviceSize objectBytes = sizeof(ObjectData) * objectCount;
+    createBuffer(_device, _physicalDevice, tracker, MemoryCategory::Storage, objectBytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, _objectBuffer, _objectMemory);
+    uploads.uploadBuffer(objects.data(), objectBytes, _objectBuffer);
+
+    vk::DeviceSize visibilityBytes = sizeof(uint32_t) * objectCount;
+    createBuffer(_device, _physicalDevice, tracker, MemoryCategory::Storage, visibilityBytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, _visibilityBuffer, _visibilityMemory);
+    uploads.fillBuffer(_visibilityBuffer, visibilityBytes, 0);
+
+    // Early and late draw lists followed by an identity list for views that draw everything.
+    std::vector<uint32_t> drawList(3 * static_cast<size_t>(objectCount));
+    for (uint32_t i = 0; i < objectCount; i++) {
+        drawList[2 * objectCount + i] = i;
+    }
+    vk::DeviceSize drawListBytes = sizeof(uint32_t) * drawList.size();
+    createBuffer(_device, _physicalDevice, tracker, MemoryCategory::Storage, drawListBytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, _drawListBuffer, _drawListMemory);
+    uploads.uploadBuffer(drawList.data(), drawListBytes, _drawListBuffer);
+
+    vk::DeviceSize commandBytes = sizeof(vk::DrawIndexedIndirectCommand) * 2;
+    createBuffer(_device, _physicalDevice, tracker, MemoryCategory::Storage, commandBytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, _commandBuffer, _commandMemory);
+    createBuffer(_device, _physicalDevice, tracker, MemoryCategory::Storage, commandBytes, vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, _commandTemplateBuffer, _commandTemplateMemory);
+    setMesh(uploads, mesh);
+
+    vk::PhysicalDeviceProperties properties;
+    _physicalDevice.getProperties(&properties);
+    vk::DeviceSize uniformAlignment = std::max<vk::DeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+    _parameterStride = (sizeof(Parameters) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+    vk::DeviceSize parameterBytes = _parameterStride * _slotCount * 2;
+    createBuffer(_device, _physicalDevice, tracker, MemoryCategory::Uniform, parameterBytes, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, _parameterBuffer, _parameterMemory);
+    void* mapped = nullptr;
+    vk::Result res = _device.mapMemory(_parameterMemory, 0, parameterBytes, vk::MemoryMapFlags(), &mapped);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to map culling parameters! error:" << res << std::endl;
+        std::abort();
+    }
+    _parameters = static_cast<uint8_t*>(mapped);
+    std::memset(_parameters, 0, static_cast<size_t>(parameterBytes));
+
+    vk::DeviceSize storageAlignment = std::max<vk::DeviceSize>(properties.limits.minStorageBufferOffsetAlignment, 1);
+    _statisticsStride = (sizeof(Statistics) + storageAlignment - 1) / storageAlignment * storageAlignment;
+    vk::DeviceSize statisticsBytes = _statisticsStride * _slotCount;
+    createBuffer(_device, _physicalDevice, tracker, MemoryCategory::Storage, statisticsBytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, _statisticsBuffer, _statisticsMemory);
+    res = _device.mapMemory(_statisticsMemory, 0, statisticsBytes, vk::MemoryMapFlags(), &mapped);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to map culling statistics! error:" << res << std::endl;
+        std::abort();
+    }
+    _statistics = static_cast<uint8_t*>(mapped);
+    _submitted.assign(_slotCount, false);
+
+    vk::SamplerCreateInfo samplerInfo;
+    samplerInfo.magFilter = vk::Filter::eNearest;
+    samplerInfo.minFilter = vk::Filter::eNearest;
+    samplerInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+    samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    if (_device.createSampler(&samplerInfo, nullptr, &_sampler) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create depth pyramid sampler!" << std::endl;
+        std::abort();
+    }
+
+    _cull.init(_device, vk::PipelineCache(), _cullCode,
+        { vk::DescriptorType::eStorageBuffer, vk::DescriptorType::eStorageBuffer, vk::DescriptorType::eStorageBuffer, vk::DescriptorType::eStorageBuffer, vk::DescriptorType::eStorageBufferDynamic,
+            vk::DescriptorType::eUniformBufferDynamic, vk::DescriptorType::eCombinedImageSampler });
+    _cullSet = _cull.allocateDescriptorSet();
+    _cull.bindBuffer(_cullSet, 0, _objectBuffer);
+    _cull.bindBuffer(_cullSet, 1, _visibilityBuffer);
+    _cull.bindBuffer(_cullSet, 2, _drawListBuffer);
+    _cull.bindBuffer(_cullSet, 3, _commandBuffer);
+    _cull.bindBuffer(_cullSet, 4, _statisticsBuffer, 0, sizeof(Statistics));
+    _cull.bindBuffer(_cullSet, 5, _parameterBuffer, 0, sizeof(Parameters));
+
+    std::array<vk::DescriptorSetLayoutBinding, 2> objectBindings;
+    for (uint32_t i = 0; i < objectBindings.size(); i++) {
+        objectBindings[i] = vk::DescriptorSetLayoutBinding(i, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eVertex, nullptr);
+    }
+    vk::DescriptorSetLayoutCreateInfo layoutInfo;
+    layoutInfo.bindingCount = objectBindings.size();
+    layoutInfo.pBindings = objectBindings.data();
+    if (_device.createDescriptorSetLayout(&layoutInfo, nullptr, &_objectSetLayout) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create object descriptor set layout!" << std::endl;
+        std::abort();
+    }
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, objectBindings.size());
+    vk::DescriptorPoolCreateInfo poolInfo(vk::DescriptorPoolCreateFlags(), 1, 1, &poolSize);
+    if (_device.createDescriptorPool(&poolInfo, nullptr, &_objectPool) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create object descriptor pool!" << std::endl;
+        std::abort();
+    }
+    vk::DescriptorSetAllocateInfo allocInfo(_objectPool, 1, &_objectSetLayout);
+    if (_device.allocateDescriptorSets(&allocInfo, &_objectSet) != vk::Result::eSuccess) {
+        std::cerr << "Failed to allocate object descriptor set!" << std::endl;
+        std::abort();
+    }
+    std::array<vk::DescriptorBufferInfo, 2> bufferInfos = { { vk::DescriptorBufferInfo(_objectBuffer, 0, VK_WHOLE_SIZE), vk::DescriptorBufferInfo(_drawListBuffer, 0, VK_WHOLE_SIZE) } };
+    std::array<vk::WriteDescriptorSet, 2> writes;
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i].dstSet = _objectSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = vk::DescriptorType::eStorageBuffer;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    _device.updateDescriptorSets(writes.size(), writes.data(), 0, nullptr);
+}
+
+void OcclusionCuller::setMesh(UploadBatch& uploads, const MeshRange& mesh)
+{
+    _mesh = mesh;
+    std::array<vk::DrawIndexedIndirectCommand, 2> commands;
+    for (uint32_t phase = 0; phase < commands.size(); phase++) {
+        commands[phase] = vk::DrawIndexedIndirectCommand(mesh.indexCount, 0, mesh.firstIndex, mesh.vertexOffset, 0);
+    }
+    uploads.uploadBuffer(commands.data(), sizeof(commands), _commandTemplateBuffer);
+}
+
+void OcclusionCuller::destroy()
+{
+    if (!isInitialized()) {
+        return;
+    }
+    destroyRenderPipeline();
+    destroyPyramid();
+    _cull.destroy();
+    _device.destroySampler(_sampler);
+    _device.destroyDescriptorPool(_objectPool);
+    _device.destroyDescriptorSetLayout(_objectSetLayout);
+
+    _device.unmapMemory(_parameterMemory);
+    _device.unmapMemory(_statisticsMemory);
+    vk::Buffer buffers[] = { _objectBuffer, _visibilityBuffer, _drawListBuffer, _commandBuffer, _commandTemplateBuffer, _parameterBuffer, _statisticsBuffer };
+    vk::DeviceMemory memories[] = { _objectMemory, _visibilityMemory, _drawListMemory, _commandMemory, _commandTemplateMemory, _parameterMemory, _statisticsMemory };
+    for (size_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); i++) {
+        _device.destroyBuffer(buffers[i]);
+        _memoryTracker->free(memories[i]);
+    }
+    _objectCount = 0;
+}
+
+bool OcclusionCuller::isInitialized() const
+{
+    return _objectCount != 0;
+}
+
+uint32_t OcclusionCuller::objectCount() const
+{
+    return _objectCount;
+}
+
+uint32_t OcclusionCuller::slotCount() const
+{
+    return _slotCount;
+}
+
+bool OcclusionCuller::supportsDepthFormat(vk::PhysicalDevice physicalDevice, vk::Format format)
+{
+    vk::FormatProperties formatProperties;
+    physicalDevice.getFormatProperties(format, &formatProperties);
+    vk::FormatProperties pyramidProperties;
+    physicalDevice.getFormatProperties(vk::Format::eR32Sfloat, &pyramidProperties);
+    return (formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage) && (pyramidProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eStorageImage);
+}
+
+void OcclusionCuller::createPyramid(vk::ImageView depthView, vk::Extent2D extent, uint32_t slotCount)
+{
+    // The first level is half the depth resolution; odd sizes round up so
+    // every depth texel is covered.
+    vk::Extent2D levelExtent((extent.width + 1) / 2, (extent.height + 1) / 2);
+    _levelExtents.clear();
+    for (;;) {
+        _levelExtents.push_back(levelExtent);
+        if (levelExtent.width == 1 && levelExtent.height == 1) {
+            break;
+        }
+        levelExtent = vk::Extent2D(std::max((levelExtent.width + 1) / 2, 1u), std::max((levelExtent.height + 1) / 2, 1u));
+    }
+    uint32_t levelCount = static_cast<uint32_t>(_levelExtents.size());
+
+    vk::ImageCreateInfo imageInfo;
+    imageInfo.imageType = vk::ImageType::e2D;
+    imageInfo.format = vk::Format::eR32Sfloat;
+    imageInfo.extent = vk::Extent3D(_levelExtents[0].width, _levelExtents[0].height, 1);
+    imageInfo.mipLevels = levelCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = vk::SampleCountFlagBits::e1;
+    imageInfo.tiling = vk::ImageTiling::eOptimal;
+    imageInfo.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled;
+    imageInfo.sharingMode = vk::SharingMode::eExclusive;
+    imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+    if (_device.createImage(&imageInfo, nullptr, &_pyramid) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create depth pyramid!" << std::endl;
+        std::abort();
+    }
+    vk::MemoryRequirements requirements;
+    _device.getImageMemoryRequirements(_pyramid, &requirements);
+    vk::MemoryAllocateInfo allocInfo(requirements.size, findMemoryType(_physicalDevice, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
+    if (_memoryTracker->allocate(allocInfo, MemoryCategory::Attachment, _pyramidMemory) != vk::Result::eSuccess) {
+        std::cerr << "Failed to allocate depth pyramid memory!" << std::endl;
+        std::abort();
+    }
+    _device.bindImageMemory(_pyramid, _pyramidMemory, 0);
+
+    vk::ImageViewCreateInfo viewInfo;
+    viewInfo.image = _pyramid;
+    viewInfo.viewType = vk::ImageViewType::e2D;
+    viewInfo.format = vk::Format::eR32Sfloat;
+    viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, levelCount, 0, 1);
+    if (_device.createImageView(&viewInfo, nullptr, &_pyramidView) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create depth pyramid view!" << std::endl;
+        std::abort();
+    }
+    _levelViews.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; level++) {
+        viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level, 1, 0, 1);
+        if (_device.createImageView(&viewInfo, nullptr, &_levelViews[level]) != vk::Result::eSuccess) {
+            std::cerr << "Failed to create depth pyramid level view!" << std::endl;
+            std::abort();
+        }
+    }
+
+    _reduce.init(_device, vk::PipelineCache(), _reduceCode, { vk::DescriptorType::eCombinedImageSampler, vk::DescriptorType::eStorageImage }, levelCount);
+    _reduceSets.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; level++) {
+        _reduceSets[level] = _reduce.allocateDescriptorSet();
+        if (level == 0) {
+            _reduce.bindImage(_reduceSets[level], 0, depthView, vk::ImageLayout::eDepthStencilReadOnlyOptimal, _sampler);
+        } else {
+            _reduce.bindImage(_reduceSets[level], 0, _levelViews[level - 1], vk::ImageLayout::eGeneral, _sampler);
+        }
+        _reduce.bindImage(_reduceSets[level], 1, _levelViews[level], vk::ImageLayout::eGeneral);
+    }
+    _cull.bindImage(_cullSet, 6, _pyramidView, vk::ImageLayout::eGeneral, _sampler);
+
+    if (!_pyramidTimer.init(_device, _physicalDevice, _queueFamily, slotCount)) {
+        std::cerr << "Depth pyramid build time will not be measured" << std::endl;
+    }
+}
+
+void OcclusionCuller::destroyPyramid()
+{
+    if (!hasPyramid()) {
+        return;
+    }
+    _pyramidTimer.destroy();
+    _reduce.destroy();
+    _reduceSets.clear();
+    for (const vk::ImageView& view : _levelViews) {
+        _device.destroyImageView(view);
+    }
+    _levelViews.clear();
+    _device.destroyImageView(_pyramidView);
+    _device.destroyImage(_pyramid);
+    _memoryTracker->free(_pyramidMemory);
+    _pyramid = vk::Image();
+}
+
+bool OcclusionCuller::hasPyramid() const
+{
+    return static_cast<bool>(_pyramid);
+}
+
+void OcclusionCuller::createRenderPipeline(vk::RenderPass renderPass, vk::DescriptorSetLayout sceneLayout, const ShaderCode& fragCode)
+{
+    createShaderModule(_device, _vertCode, _vertModule);
+    createShaderModule(_device, fragCode, _fragModule);
+
+    vk::PipelineShaderStageCreateInfo shaderStages[2];
+    shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
+    shaderStages[0].module = _vertModule;
+    shaderStages[0].pName = "main";
+    shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
+    shaderStages[1].module = _fragModule;
+    shaderStages[1].pName = "main";
+
+    auto bindingDescription = Vertex::getBindingDescription();
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly(vk::PipelineInputAssemblyStateCreateFlags(), vk::PrimitiveTopology::eTriangleList, VK_FALSE);
+
+    vk::PipelineViewportStateCreateInfo viewportState;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    vk::PipelineRasterizationStateCreateInfo rasterizer;
+    rasterizer.polygonMode = vk::PolygonMode::eFill;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = vk::CullModeFlagBits::eBack;
+    rasterizer.frontFace = vk::FrontFace::eCounterClockwise;
+
+    vk::PipelineMultisampleStateCreateInfo multisampling;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+    vk::PipelineDepthStencilStateCreateInfo depthStencil(vk::PipelineDepthStencilStateCreateFlags(), VK_TRUE, VK_TRUE, vk::CompareOp::eLess, VK_FALSE, VK_FALSE);
+
+    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
+    colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+    vk::PipelineColorBlendStateCreateInfo colorBlending(vk::PipelineColorBlendStateCreateFlags(), VK_FALSE, vk::LogicOp::eCopy, 1, &colorBlendAttachment, { { 0.0f, 0.0f, 0.0f, 0.0f } });
+
+    vk::DynamicState dynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+    vk::PipelineDynamicStateCreateInfo dynamicState(vk::PipelineDynamicStateCreateFlags(), 2, dynamicStates);
+
+    vk::DescriptorSetLayout setLayouts[] = { sceneLayout, _objectSetLayout };
+    vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t));
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+    pipelineLayoutInfo.setLayoutCount = 2;
+    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    vk::Result res = _device.createPipelineLayout(&pipelineLayoutInfo, nullptr, &_pipelineLayout);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create object pipeline layout! error:" << res << std::endl;
+        std::abort();
+    }
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo(vk::PipelineCreateFlags(), 2, shaderStages, &vertexInputInfo, &inputAssembly, nullptr, &viewportState, &rasterizer, &multisampling, &depthStencil, &colorBlending, &dynamicState, _pipelineLayout, renderPass, 0, vk::Pipeline(), 0);
+    res = _device.createGraphicsPipelines(vk::PipelineCache(), 1, &pipelineInfo, nullptr, &_pipeline);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create object pipeline! error:" << res << std::endl;
+        std::abort();
+    }
+}
+
+void OcclusionCuller::destroyRenderPipeline()
+{
+    if (!_pipeline) {
+        return;
+    }
+    _device.destroyPipeline(_pipeline);
+    _device.destroyPipelineLayout(_pipelineLayout);
+    _device.destroyShaderModule(_vertModule);
+    _device.destroyShaderModule(_fragModule);
+    _pipeline = vk::Pipeline();
+    _pipelineLayout = vk::PipelineLayout();
+    _vertModule = vk::ShaderModule();
+    _fragModule = vk::ShaderModule();
+}
+
+void OcclusionCuller::update(uint32_t slot, const glm::mat4& view, const glm::mat4& projection)
+{
+    Parameters parameters;
+    parameters.viewProjection = projection * view;
+    extractFrustum(parameters.viewProjection, parameters.frustum);
+    parameters.bounds = MeshBounds;
+    parameters.pyramidSize = _levelExtents.empty() ? glm::vec2(1.0f) : glm::vec2(static_cast<float>(_levelExtents[0].width), static_cast<float>(_levelExtents[0].height));
+    parameters.pyramidLevels = static_cast<uint32_t>(_levelExtents.size());
+    parameters.objectCount = _objectCount;
+    for (uint32_t phase = 0; phase < 2; phase++) {
+        parameters.phase = phase;
+        std::memcpy(_parameters + (slot * 2 + phase) * _parameterStride, &parameters, sizeof(Parameters));
+    }
+}
+
+void OcclusionCuller::recordEarlyCull(vk::CommandBuffer commandBuffer, uint32_t slot) const
+{
+    // The previous frame's draws and culling still read the buffers reset here.
+    vk::MemoryBarrier previousFrame(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eIndirectCommandRead,
+        vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader,
+        vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), 1, &previousFrame, 0, nullptr, 0, nullptr);
+
+    vk::BufferCopy copyRegion(0, 0, sizeof(vk::DrawIndexedIndirectCommand) * 2);
+    commandBuffer.copyBuffer(_commandTemplateBuffer, _commandBuffer, 1, &copyRegion);
+    commandBuffer.fillBuffer(_statisticsBuffer, slot * _statisticsStride, sizeof(Statistics), 0);
+    vk::MemoryBarrier resetDone(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), 1, &resetDone, 0, nullptr, 0, nullptr);
+
+    dispatchCull(commandBuffer, slot, 0);
+    recordCullToDrawBarrier(commandBuffer);
+}
+
+void OcclusionCuller::recordPyramid(vk::CommandBuffer commandBuffer, uint32_t slot, vk::Image depthImage) const
+{
+    if (_pyramidTimer.isInitialized()) {
+        _pyramidTimer.writeBegin(commandBuffer, slot);
+    }
+
+    // Depth written by the early pass is read by the first reduction; the
+    // pyramid's previous contents are discarded.
+    vk::ImageMemoryBarrier depthBarrier;
+    depthBarrier.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+    depthBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+    depthBarrier.oldLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+    depthBarrier.newLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+    depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depthBarrier.image = depthImage;
+    depthBarrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1);
+    vk::ImageMemoryBarrier pyramidBarrier = depthBarrier;
+    pyramidBarrier.srcAccessMask = vk::AccessFlags();
+    pyramidBarrier.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+    pyramidBarrier.oldLayout = vk::ImageLayout::eUndefined;
+    pyramidBarrier.newLayout = vk::ImageLayout::eGeneral;
+    pyramidBarrier.image = _pyramid;
+    pyramidBarrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, static_cast<uint32_t>(_levelExtents.size()), 0, 1);
+    vk::ImageMemoryBarrier barriers[] = { depthBarrier, pyramidBarrier };
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 2, barriers);
+
+    for (size_t level = 0; level < _levelExtents.size(); level++) {
+        _reduce.dispatch(commandBuffer, _reduceSets[level], ComputePipeline::groupCount(_levelExtents[level].width, ReduceLocalSize), ComputePipeline::groupCount(_levelExtents[level].height, ReduceLocalSize));
+        vk::ImageMemoryBarrier levelBarrier = pyramidBarrier;
+        levelBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+        levelBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        levelBarrier.oldLayout = vk::ImageLayout::eGeneral;
+        levelBarrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, static_cast<uint32_t>(level), 1, 0, 1);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &levelBarrier);
+    }
+
+    if (_pyramidTimer.isInitialized()) {
+        _pyramidTimer.writeEnd(commandBuffer, slot);
+    }
+}
+
+void OcclusionCuller::recordLateCull(vk::CommandBuffer commandBuffer, uint32_t slot) const
+{
+    dispatchCull(commandBuffer, slot, 1);
+    recordCullToDrawBarrier(commandBuffer);
+}
+
+void OcclusionCuller::recordDraw(vk::CommandBuffer commandBuffer, vk::DescriptorSet sceneSet, uint32_t phase) const
+{
+    vk::DescriptorSet sets[] = { sceneSet, _objectSet };
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, _pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _pipelineLayout, 0, 2, sets, 0, nullptr);
+    uint32_t drawListOffset = phase * _objectCount;
+    commandBuffer.pushConstants(_pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t), &drawListOffset);
+    commandBuffer.drawIndexedIndirect(_commandBuffer, phase * sizeof(vk::DrawIndexedIndirectCommand), 1, sizeof(vk::DrawIndexedIndirectCommand));
+}
+
+void OcclusionCuller::recordDrawAll(vk::CommandBuffer commandBuffer, vk::DescriptorSet sceneSet) const
+{
+    vk::DescriptorSet sets[] = { sceneSet, _objectSet };
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, _pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _pipelineLayout, 0, 2, sets, 0, nullptr);
+    uint32_t drawListOffset = 2 * _objectCount;
+    commandBuffer.pushConstants(_pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t), &drawListOffset);
+    commandBuffer.drawIndexed(_mesh.indexCount, _objectCount, _mesh.firstIndex, _mesh.vertexOffset, 0);
+}
+
+void OcclusionCuller::markSubmitted(uint32_t slot)
+{
+    _submitted[slot] = true;
+    if (_pyramidTimer.isInitialized()) {
+        _pyramidTimer.markSubmitted(slot);
+    }
+}
+
+void OcclusionCuller::collect(uint32_t slot)
+{
+    double milliseconds = 0.0;
+    if (_pyramidTimer.isInitialized() && _pyramidTimer.collect(slot, milliseconds)) {
+        _pyramidTimes.add(milliseconds);
+    }
+    if (!_submitted[slot]) {
+        return;
+    }
+    _submitted[slot] = false;
+    Statistics statistics;
+    std::memcpy(&statistics, _statistics + slot * _statisticsStride, sizeof(Statistics));
+    _frames++;
+    _earlyDrawn += statistics.earlyDrawn;
+    _lateDrawn += statistics.lateDrawn;
+    _visible += statistics.visible;
+    _occluded += statistics.occluded;
+    _frustumCulled += statistics.frustumCulled;
+}
+
+void OcclusionCuller::report(std::ostream& stream) const
+{
+    if (_frames == 0) {
+        return;
+    }
+    double frames = static_cast<double>(_frames);
+    stream << std::fixed << std::setprecision(1);
+    stream << "  occlusion culling: " << _objectCount << " objects, per frame " << _visible / frames << " visible, " << _occluded / frames << " occluded, " << _frustumCulled / frames << " outside the frustum" << std::endl;
+    stream << "    drawn " << (_earlyDrawn + _lateDrawn) / frames << " (early " << _earlyDrawn / frames << ", late " << _lateDrawn / frames << ")";
+    stream << std::setprecision(3);
+    if (_pyramidTimes.count() > 0) {
+        stream << " | pyramid " << _levelExtents.size() << " levels from " << _levelExtents[0].width << "x" << _levelExtents[0].height << ", build mean " << _pyramidTimes.mean() << " ms, max " << _pyramidTimes.max() << " ms";
+    }
+    stream << std::endl;
+    stream.unsetf(std::ios::floatfield);
+}
+
+void OcclusionCuller::dispatchCull(vk::CommandBuffer commandBuffer, uint32_t slot, uint32_t phase) const
+{
+    std::vector<uint32_t> offsets = { static_cast<uint32_t>(slot * _statisticsStride), static_cast<uint32_t>((slot * 2 + phase) * _parameterStride) };
+    _cull.dispatch(commandBuffer, _cullSet, ComputePipeline::groupCount(_objectCount, CullLocalSize), 1, 1, offsets);
+}
+
+void OcclusionCuller::recordCullToDrawBarrier(vk::CommandBuffer commandBuffer) const
+{
+    vk::MemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eComputeShader,
+        vk::DependencyFlags(), 1, &barrier, 0, nullptr, 0, nullptr);
+}
@@ -0,0 +1,154 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "computepipeline.h"
+#include "framestats.h"
+#include "geometrypool.h"
+#include "gputimer.h"
+#include "memorytracker.h"
+#include "shadercode.h"
+#include "uploadbatch.h"
+#include "vertex.h"
+
+struct ObjectData {
+    float position[4];
+    float color[4];
+};
+
+// GPU-driven two-phase hierarchical-Z culling of a field of mesh instances.
+// The early phase draws the objects that were visible last frame, a compute
+// pass reduces the resulting depth into a max-depth pyramid, and the late
+// phase tests every object against it, draws the ones that just became
+// visible and records visibility for the next frame. Both phases feed indirect
+// draws, so the CPU never reads culling results back except for statistics.
+class OcclusionCuller {
+public:
+    static const uint32_t CullLocalSize = 64;
+    static const uint32_t ReduceLocalSize = 8;
+
+    OcclusionCuller();
+
+    bool loadShaders(const std::string& shaderDirectory);
+    void init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, UploadBatch& uploads, uint32_t queueFamily, uint32_t objectCount, const MeshRange& mesh, uint32_t slotCount);
+    // For when the geometry pool moves the mesh; command buffers drawing the
+    // objects have to be recorded again.
+    void setMesh(UploadBatch& uploads, const MeshRange& mesh);
+    void destroy();
+    bool isInitialized() const;
+    uint32_t objectCount() const;
+    uint32_t slotCount() const;
+
+    static bool supportsDepthFormat(vk::PhysicalDevice physicalDevice, vk::Format format);
+    void createPyramid(vk::ImageView depthView, vk::Extent2D extent, uint32_t slotCount);
+    void destroyPyramid();
+    bool hasPyramid() const;
+
+    void createRenderPipeline(vk::RenderPass renderPass, vk::DescriptorSetLayout sceneLayout, const ShaderCode& fragCode);
+    void destroyRenderPipeline();
+
+    // Slots pair with pre-recorded command buffers, as for ParticleSystem.
+    void update(uint32_t slot, const glm::mat4& view, const glm::mat4& projection);
+    void recordEarlyCull(vk::CommandBuffer commandBuffer, uint32_t slot) const;
+    void recordPyramid(vk::CommandBuffer commandBuffer, uint32_t slot, vk::Image depthImage) const;
+    void recordLateCull(vk::CommandBuffer commandBuffer, uint32_t slot) const;
+    void recordDraw(vk::CommandBuffer commandBuffer, vk::DescriptorSet sceneSet, uint32_t phase) const;
+    void recordDrawAll(vk::CommandBuffer commandBuffer, vk::DescriptorSet sceneSet) const;
+    void markSubmitted(uint32_t slot);
+    void collect(uint32_t slot);
+
+    void report(std::ostream& stream) const;
+
+private:
+    struct Parameters {
+        glm::mat4 viewProjection;
+        glm::vec4 frustum[6];
+        glm::vec4 bounds;
+        glm::vec2 pyramidSize;
+        uint32_t pyramidLevels;
+        uint32_t objectCount;
+        uint32_t phase;
+    };
+
+    struct Statistics {
+        uint32_t earlyDrawn;
+        uint32_t lateDrawn;
+        uint32_t visible;
+        uint32_t occluded;
+        uint32_t frustumCulled;
+    };
+
+    void dispatchCull(vk::CommandBuffer commandBuffer, uint32_t slot, uint32_t phase) const;
+    void recordCullToDrawBarrier(vk::CommandBuffer commandBuffer) const;
+
+    vk::Device _device;
+    vk::PhysicalDevice _physicalDevice;
+    MemoryTracker* _memoryTracker;
+    uint32_t _queueFamily;
+    uint32_t _objectCount;
+    uint32_t _slotCount;
+    MeshRange _mesh;
+
+    std::vector<uint32_t> _cullStorage;
+    std::vector<uint32_t> _reduceStorage;
+    std::vector<uint32_t> _vertStorage;
+    ShaderCode _cullCode;
+    ShaderCode _reduceCode;
+    ShaderCode _vertCode;
+
+    vk::Buffer _objectBuffer;
+    vk::DeviceMemory _objectMemory;
+    vk::Buffer _visibilityBuffer;
+    vk::DeviceMemory _visibilityMemory;
+    vk::Buffer _drawListBuffer;
+    vk::DeviceMemory _drawListMemory;
+    vk::Buffer _commandBuffer;
+    vk::DeviceMemory _commandMemory;
+    vk::Buffer _commandTemplateBuffer;
+    vk::DeviceMemory _commandTemplateMemory;
+    vk::Buffer _parameterBuffer;
+    vk::DeviceMemory _parameterMemory;
+    uint8_t* _parameters;
+    vk::DeviceSize _parameterStride;
+    vk::Buffer _statisticsBuffer;
+    vk::DeviceMemory _statisticsMemory;
+    uint8_t* _statistics;
+    vk::DeviceSize _statisticsStride;
+
+    ComputePipeline _cull;
+    vk::DescriptorSet _cullSet;
+    vk::Sampler _sampler;
+
+    ComputePipeline _reduce;
+    std::vector<vk::DescriptorSet> _reduceSets;
+    vk::Image _pyramid;
+    vk::DeviceMemory _pyramidMemory;
+    vk::ImageView _pyramidView;
+    std::vector<vk::ImageView> _levelViews;
+    std::vector<vk::Extent2D> _levelExtents;
+    GpuTimer _pyramidTimer;
+
+    vk::DescriptorSetLayout _objectSetLayout;
+    vk::DescriptorPool _objectPool;
+    vk::DescriptorSet _objectSet;
+    vk::ShaderModule _vertModule;
+    vk::ShaderModule _fragModule;
+    vk::PipelineLayout _pipelineLayout;
+    vk::Pipeline _pipeline;
+
+    std::vector<bool> _submitted;
+    uint64_t _frames;
+    uint64_t _earlyDrawn;
+    uint64_t _lateDrawn;
+    uint64_t _visible;
+    uint64_t _occluded;
+    uint64_t _frustumCulled;
+    RunningStatistics _pyramidTimes;
+};
+
+#endif // OCCLUSIONCULLER_H
@@ -0,0 +1,216 @@
+#include "particlesystem.h"
+#include "helperfunctions.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+
+namespace {
+// Large steps after a stall would throw every particle out of the fountain.
+const double MaxDeltaTime = 0.1;
+}
+
+ParticleSystem::ParticleSystem()
+    : _memoryTracker(nullptr)
+    , _count(0)
+    , _slotCount(0)
+    , _parameters(nullptr)
+    , _parameterStride(0)
+    , _lastTime(0.0)
+    , _hasLastTime(false)
+    , _steps(0)
+{
+}
+
+bool ParticleSystem::loadShaders(const std::string& shaderDirectory)
+{
+    return findShader(shaderDirectory, "particles_comp", _compStorage, _compCode) && findShader(shaderDirectory, "particles_vert", _vertStorage, _vertCode)
+        && findShader(shaderDirectory, "particles_frag", _fragStorage, _fragCode);
+}
+
+void ParticleSystem::init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, UploadBatch& uploads, uint32_t count, uint32_t slotCount)
+{
+    _device = device;
+    _memoryTracker = &tracker;
+    _count = count;
+    _slotCount = slotCount;
+
+    vk::DeviceSize particleBytes = static_cast<vk::DeviceSize>(count) * sizeof(Particle);
+    createBuffer(_device, physicalDevice, tracker, MemoryCategory::Storage, particleBytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, _particleBuffer, _particleMemory);
+    // Zero lifetime makes the first dispatch spawn every particle.
+    uploads.fillBuffer(_particleBuffer, particleBytes, 0);
+
+    vk::PhysicalDeviceProperties properties;
+    physicalDevice.getProperties(&properties);
+    vk::DeviceSize alignment = std::max<vk::DeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+    _parameterStride = (sizeof(Parameters) + alignment - 1) / alignment * alignment;
+    createBuffer(_device, physicalDevice, tracker, MemoryCategory::Uniform, _parameterStride * _slotCount, vk::BufferUsageFlagBits::eUniformBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, _parameterBuffer, _parameterMemory);
+    void* mapped = nullptr;
+    vk::Result res = _device.mapMemory(_parameterMemory, 0, _parameterStride * _slotCount, vk::MemoryMapFlags(), &mapped);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to map particle parameters! error:" << res << std::endl;
+        std::abort();
+    }
+    _parameters = static_cast<uint8_t*>(mapped);
+    std::memset(_parameters, 0, static_cast<size_t>(_parameterStride * _slotCount));
+
+    _simulation.init(_device, vk::PipelineCache(), _compCode, { vk::DescriptorType::eStorageBuffer, vk::DescriptorType::eUniformBufferDynamic });
+    _descriptorSet = _simulation.allocateDescriptorSet();
+    _simulation.bindBuffer(_descriptorSet, 0, _particleBuffer);
+    _simulation.bindBuffer(_descriptorSet, 1, _parameterBuffer, 0, sizeof(Parameters));
+}
+
+void ParticleSystem::destroy()
+{
+    if (!isInitialized()) {
+        return;
+    }
+    destroyRenderPipeline();
+    _simulation.destroy();
+    _device.unmapMemory(_parameterMemory);
+    _device.destroyBuffer(_parameterBuffer);
+    _memoryTracker->free(_parameterMemory);
+    _device.destroyBuffer(_particleBuffer);
+    _memoryTracker->free(_particleMemory);
+    _count = 0;
+}
+
+bool ParticleSystem::isInitialized() const
+{
+    return _count != 0;
+}
+
+uint32_t ParticleSystem::count() const
+{
+    return _count;
+}
+
+uint32_t ParticleSystem::slotCount() const
+{
+    return _slotCount;
+}
+
+void ParticleSystem::createRenderPipeline(vk::RenderPass renderPass, vk::DescriptorSetLayout sceneLayout)
+{
+    createShaderModule(_device, _vertCode, _vertModule);
+    createShaderModule(_device, _fragCode, _fragModule);
+
+    vk::PipelineShaderStageCreateInfo shaderStages[2];
+    shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
+    shaderStages[0].module = _vertModule;
+    shaderStages[0].pName = "main";
+    shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
+    shaderStages[1].module = _fragModule;
+    shaderStages[1].pName = "main";
+
+    vk::VertexInputBindingDescription bindingDescription(0, sizeof(Particle), vk::VertexInputRate::eVertex);
+    std::array<vk::VertexInputAttributeDescription, 2> attributeDescriptions = { {
+        vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32B32A32Sfloat, offsetof(Particle, position)),
+        vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32A32Sfloat, offsetof(Particle, velocity)),
+    } };
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly(vk::PipelineInputAssemblyStateCreateFlags(), vk::PrimitiveTopology::ePointList, VK_FALSE);
+
+    vk::PipelineViewportStateCreateInfo viewportState;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    vk::PipelineRasterizationStateCreateInfo rasterizer;
+    rasterizer.polygonMode = vk::PolygonMode::eFill;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = vk::CullModeFlagBits::eNone;
+
+    vk::PipelineMultisampleStateCreateInfo multisampling;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+    vk::PipelineDepthStencilStateCreateInfo depthStencil(vk::PipelineDepthStencilStateCreateFlags(), VK_TRUE, VK_FALSE, vk::CompareOp::eLess, VK_FALSE, VK_FALSE);
+
+    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
+    colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+    vk::PipelineColorBlendStateCreateInfo colorBlending(vk::PipelineColorBlendStateCreateFlags(), VK_FALSE, vk::LogicOp::eCopy, 1, &colorBlendAttachment, { { 0.0f, 0.0f, 0.0f, 0.0f } });
+
+    vk::DynamicState dynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+    vk::PipelineDynamicStateCreateInfo dynamicState(vk::PipelineDynamicStateCreateFlags(), 2, dynamicStates);
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &sceneLayout;
+    vk::Result res = _device.createPipelineLayout(&pipelineLayoutInfo, nullptr, &_pipelineLayout);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create particle pipeline layout! error:" << res << std::endl;
+        std::abort();
+    }
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo(vk::PipelineCreateFlags(), 2, shaderStages, &vertexInputInfo, &inputAssembly, nullptr, &viewportState, &rasterizer, &multisampling, &depthStencil, &colorBlending, &dynamicState, _pipelineLayout, renderPass, 0, vk::Pipeline(), 0);
+    res = _device.createGraphicsPipelines(vk::PipelineCache(), 1, &pipelineInfo, nullptr, &_pipeline);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create particle pipeline! error:" << res << std::endl;
+        std::abort();
+    }
+}
+
+void ParticleSystem::destroyRenderPipeline()
+{
+    _device.destroyPipeline(_pipeline);
+    _device.destroyPipelineLayout(_pipelineLayout);
+    _device.destroyShaderModule(_vertModule);
+    _device.destroyShaderModule(_fragModule);
+    _pipeline = vk::Pipeline();
+    _pipelineLayout = vk::PipelineLayout();
+    _vertModule = vk::ShaderModule();
+    _fragModule = vk::ShaderModule();
+}
+
+void ParticleSystem::update(uint32_t slot, double time)
+{
+    double deltaTime = _hasLastTime ? std::min(std::max(time - _lastTime, 0.0), MaxDeltaTime) : 0.0;
+    _lastTime = time;
+    _hasLastTime = true;
+
+    Parameters parameters;
+    parameters.deltaTime = static_cast<float>(deltaTime);
+    parameters.time = static_cast<float>(time);
+    parameters.count = _count;
+    parameters.seed = static_cast<uint32_t>(_steps * 2654435761u);
+    std::memcpy(_parameters + slot * _parameterStride, &parameters, sizeof(Parameters));
+    _steps++;
+}
+
+void ParticleSystem::recordSimulation(vk::CommandBuffer commandBuffer, uint32_t slot) const
+{
+    recordVertexToComputeBarrier(commandBuffer, _particleBuffer);
+    std::vector<uint32_t> offsets = { static_cast<uint32_t>(slot * _parameterStride) };
+    _simulation.dispatch(commandBuffer, _descriptorSet, ComputePipeline::groupCount(_count, LocalSize), 1, 1, offsets);
+    recordComputeToVertexBarrier(commandBuffer, _particleBuffer);
+}
+
+void ParticleSystem::recordDraw(vk::CommandBuffer commandBuffer, vk::DescriptorSet sceneSet) const
+{
+    vk::DeviceSize offset = 0;
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, _pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _pipelineLayout, 0, 1, &sceneSet, 0, nullptr);
+    commandBuffer.bindVertexBuffers(0, 1, &_particleBuffer, &offset);
+    commandBuffer.draw(_count, 1, 0, 0);
+}
+
+void ParticleSystem::report(std::ostream& stream, double seconds) const
+{
+    if (!isInitialized() || seconds <= 0.0) {
+        return;
+    }
+    double particlesPerSecond = static_cast<double>(_count) * static_cast<double>(_steps) / seconds;
+    stream << std::fixed << std::setprecision(1);
+    stream << "  particles: " << _count << " x " << _steps << " steps, " << particlesPerSecond / 1e6 << " M particles/s" << std::endl;
+    stream.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,86 @@
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "computepipeline.h"
+#include "memorytracker.h"
+#include "shadercode.h"
+#include "uploadbatch.h"
+
+struct Particle {
+    float position[4];
+    float velocity[4];
+};
+
+// Particles live in one storage buffer that a compute pass integrates and the
+// draw reads back as point vertices; the CPU only writes the time step.
+class ParticleSystem {
+public:
+    static const uint32_t LocalSize = 256;
+
+    ParticleSystem();
+
+    bool loadShaders(const std::string& shaderDirectory);
+    void init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker, UploadBatch& uploads, uint32_t count, uint32_t slotCount);
+    void destroy();
+    bool isInitialized() const;
+    uint32_t count() const;
+    uint32_t slotCount() const;
+
+    void createRenderPipeline(vk::RenderPass renderPass, vk::DescriptorSetLayout sceneLayout);
+    void destroyRenderPipeline();
+
+    // Slots pair with pre-recorded command buffers, one per swap chain image;
+    // update a slot only after the fence of the command buffer using it has
+    // signalled.
+    void update(uint32_t slot, double time);
+    void recordSimulation(vk::CommandBuffer commandBuffer, uint32_t slot) const;
+    void recordDraw(vk::CommandBuffer commandBuffer, vk::DescriptorSet sceneSet) const;
+
+    void report(std::ostream& stream, double seconds) const;
+
+private:
+    struct Parameters {
+        float deltaTime;
+        float time;
+        uint32_t count;
+        uint32_t seed;
+    };
+
+    vk::Device _device;
+    MemoryTracker* _memoryTracker;
+    uint32_t _count;
+    uint32_t _slotCount;
+
+    std::vector<uint32_t> _compStorage;
+    std::vector<uint32_t> _vertStorage;
+    std::vector<uint32_t> _fragStorage;
+    ShaderCode _compCode;
+    ShaderCode _vertCode;
+    ShaderCode _fragCode;
+
+    ComputePipeline _simulation;
+    vk::DescriptorSet _descriptorSet;
+    vk::Buffer _particleBuffer;
+    vk::DeviceMemory _particleMemory;
+    vk::Buffer _parameterBuffer;
+    vk::DeviceMemory _parameterMemory;
+    uint8_t* _parameters;
+    vk::DeviceSize _parameterStride;
+
+    vk::ShaderModule _vertModule;
+    vk::ShaderModule _fragModule;
+    vk::PipelineLayout _pipelineLayout;
+    vk::Pipeline _pipeline;
+
+    double _lastTime;
+    bool _hasLastTime;
+    uint64_t _steps;
+};
+
+#endif // PARTICLESYSTEM_H
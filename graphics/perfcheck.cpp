@@ -0,0 +1,119 @@
+#include "perfcheck.h"
+#include "imagewriter.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+bool PerfCheck::loadBaseline(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open baseline: [" << path << "]" << std::endl;
+        return false;
+    }
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name)) {
+            continue;
+        }
+        bool valid;
+        if (name == "hash") {
+            uint64_t frame;
+            std::string hash;
+            valid = static_cast<bool>(fields >> frame >> hash);
+            if (valid) {
+                _baselineHashes[frame] = std::strtoull(hash.c_str(), nullptr, 16);
+            }
+        } else {
+            BaselineMetric metric;
+            valid = static_cast<bool>(fields >> metric.value >> metric.tolerance);
+            if (valid) {
+                _baseline[name] = metric;
+            }
+        }
+        if (!valid) {
+            std::cerr << "Invalid baseline line " << lineNumber << " in [" << path << "]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PerfCheck::writeBaseline(const std::string& path, double tolerance) const
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to create baseline: [" << path << "]" << std::endl;
+        return false;
+    }
+    file << "# metric value tolerance" << std::endl;
+    for (const Metric& metric : _metrics) {
+        file << metric.name << " " << metric.value << " " << tolerance << std::endl;
+    }
+    for (const std::pair<const uint64_t, uint64_t>& hash : _hashes) {
+        file << "hash " << hash.first << " " << hashToString(hash.second) << std::endl;
+    }
+    return static_cast<bool>(file);
+}
+
+void PerfCheck::record(const std::string& name, double value, bool higherIsBetter)
+{
+    Metric metric;
+    metric.name = name;
+    metric.value = value;
+    metric.higherIsBetter = higherIsBetter;
+    _metrics.push_back(metric);
+}
+
+void PerfCheck::recordHash(uint64_t frame, uint64_t hash)
+{
+    _hashes[frame] = hash;
+}
+
+bool PerfCheck::compare(std::ostream& stream) const
+{
+    bool passed = true;
+    stream << std::fixed << std::setprecision(3);
+    stream << "  perf check:" << std::endl;
+    for (const Metric& metric : _metrics) {
+        stream << "    " << std::left << std::setw(16) << metric.name << std::right << std::setw(12) << metric.value;
+        std::map<std::string, BaselineMetric>::const_iterator baseline = _baseline.find(metric.name);
+        if (baseline == _baseline.end()) {
+            stream << "  no baseline" << std::endl;
+            continue;
+        }
+        double limit = metric.higherIsBetter ? baseline->second.value * (1.0 - baseline->second.tolerance) : baseline->second.value * (1.0 + baseline->second.tolerance);
+        bool regressed = metric.higherIsBetter ? metric.value < limit : metric.value > limit;
+        stream << "  baseline " << std::setw(12) << baseline->second.value << (metric.higherIsBetter ? "  min " : "  max ") << std::setw(12) << limit << (regressed ? "  REGRESSED" : "  ok") << std::endl;
+        passed = passed && !regressed;
+    }
+    for (const std::pair<const std::string, BaselineMetric>& baseline : _baseline) {
+        bool measured = false;
+        for (const Metric& metric : _metrics) {
+            measured = measured || metric.name == baseline.first;
+        }
+        if (!measured) {
+            stream << "    " << std::left << std::setw(16) << baseline.first << std::right << "  not measured" << std::endl;
+            passed = false;
+        }
+    }
+    for (const std::pair<const uint64_t, uint64_t>& expected : _baselineHashes) {
+        std::map<uint64_t, uint64_t>::const_iterator hash = _hashes.find(expected.first);
+        if (hash == _hashes.end()) {
+            stream << "    frame " << expected.first << " was not captured" << std::endl;
+            passed = false;
+        } else if (hash->second != expected.second) {
+            stream << "    frame " << expected.first << " hash " << hashToString(hash->second) << " differs from " << hashToString(expected.second) << std::endl;
+            passed = false;
+        }
+    }
+    stream << "    " << (passed ? "passed" : "FAILED") << ", " << _baselineHashes.size() << " frame hashes compared" << std::endl;
+    stream.unsetf(std::ios::floatfield);
+    return passed;
+}
@@ -0,0 +1,46 @@
+#ifndef PERFCHECK_H
+#define PERFCHECK_H
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Measurements of one run, compared against a baseline file. Baseline lines
+// are "<metric> <value> <tolerance>" or "hash <frame> <hash>"; '#' starts a
+// comment. Tolerance is relative, 0.25 lets a metric get 25% worse before the
+// check fails. Frame hashes have to match exactly.
+class PerfCheck {
+public:
+    bool loadBaseline(const std::string& path);
+    bool writeBaseline(const std::string& path, double tolerance) const;
+
+    void record(const std::string& name, double value, bool higherIsBetter);
+    void recordHash(uint64_t frame, uint64_t hash);
+
+    // Prints every metric next to its baseline; false when a metric regressed
+    // beyond its tolerance, a baseline metric or frame was not measured, or a
+    // frame hash differs.
+    bool compare(std::ostream& stream) const;
+
+private:
+    struct Metric {
+        std::string name;
+        double value;
+        bool higherIsBetter;
+    };
+
+    struct BaselineMetric {
+        double value;
+        double tolerance;
+    };
+
+    std::vector<Metric> _metrics;
+    std::map<uint64_t, uint64_t> _hashes;
+    std::map<std::string, BaselineMetric> _baseline;
+    std::map<uint64_t, uint64_t> _baselineHashes;
+};
+
+#endif // PERFCHECK_H
@@ -0,0 +1,141 @@
+#include "pipelinestatistics.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+// In the order of their flag bits, which is the order of the query results.
+const vk::QueryPipelineStatisticFlagBits Counters[] = { vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices, vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives,
+    vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations, vk::QueryPipelineStatisticFlagBits::eClippingInvocations, vk::QueryPipelineStatisticFlagBits::eClippingPrimitives,
+    vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations, vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations };
+const char* const CounterNames[] = { "vertices", "primitives", "vertex shader", "clipping in", "clipping out", "fragment shader", "compute shader" };
+const uint32_t CounterCount = sizeof(Counters) / sizeof(Counters[0]);
+}
+
+PipelineStatistics::PipelineStatistics()
+    : _passCount(0)
+{
+}
+
+void PipelineStatistics::init(vk::Device device, uint32_t slotCount, const std::vector<std::string>& passes)
+{
+    vk::QueryPoolCreateInfo poolInfo;
+    poolInfo.queryType = vk::QueryType::ePipelineStatistics;
+    poolInfo.queryCount = slotCount * static_cast<uint32_t>(passes.size());
+    for (vk::QueryPipelineStatisticFlagBits counter : Counters) {
+        poolInfo.pipelineStatistics |= counter;
+    }
+    vk::Result res = device.createQueryPool(&poolInfo, nullptr, &_queryPool);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create pipeline statistics query pool! error:" << res << std::endl;
+        std::abort();
+    }
+
+    _device = device;
+    _passCount = static_cast<uint32_t>(passes.size());
+    _recorded.assign(poolInfo.queryCount, false);
+    _submitted.assign(slotCount, false);
+    // Totals survive swap chain recreation, which destroys the pool.
+    if (_totals.empty()) {
+        _totals.resize(passes.size());
+        for (size_t i = 0; i < passes.size(); i++) {
+            _totals[i].name = passes[i];
+            _totals[i].counters.assign(CounterCount, 0);
+        }
+    }
+}
+
+void PipelineStatistics::destroy()
+{
+    if (!isInitialized()) {
+        return;
+    }
+    _device.destroyQueryPool(_queryPool);
+    _queryPool = vk::QueryPool();
+    _device = vk::Device();
+    _recorded.clear();
+    _submitted.clear();
+}
+
+bool PipelineStatistics::isInitialized() const
+{
+    return !_submitted.empty();
+}
+
+uint32_t PipelineStatistics::query(uint32_t slot, uint32_t pass) const
+{
+    return slot * _passCount + pass;
+}
+
+void PipelineStatistics::reset(vk::CommandBuffer commandBuffer, uint32_t slot)
+{
+    commandBuffer.resetQueryPool(_queryPool, query(slot, 0), _passCount);
+    for (uint32_t pass = 0; pass < _passCount; pass++) {
+        _recorded[query(slot, pass)] = false;
+    }
+}
+
+void PipelineStatistics::begin(vk::CommandBuffer commandBuffer, uint32_t slot, uint32_t pass)
+{
+    commandBuffer.beginQuery(_queryPool, query(slot, pass), vk::QueryControlFlags());
+    _recorded[query(slot, pass)] = true;
+}
+
+void PipelineStatistics::end(vk::CommandBuffer commandBuffer, uint32_t slot, uint32_t pass) const
+{
+    commandBuffer.endQuery(_queryPool, query(slot, pass));
+}
+
+void PipelineStatistics::markSubmitted(uint32_t slot)
+{
+    _submitted[slot] = true;
+}
+
+void PipelineStatistics::collect(uint32_t slot)
+{
+    if (!_submitted[slot]) {
+        return;
+    }
+    _submitted[slot] = false;
+    uint64_t results[CounterCount];
+    for (uint32_t pass = 0; pass < _passCount; pass++) {
+        if (!_recorded[query(slot, pass)]) {
+            continue;
+        }
+        // Without eWait this returns eNotReady instead of blocking.
+        vk::Result res = _device.getQueryPoolResults(_queryPool, query(slot, pass), 1, sizeof(results), results, sizeof(results), vk::QueryResultFlagBits::e64);
+        if (res != vk::Result::eSuccess) {
+            continue;
+        }
+        PassTotals& totals = _totals[pass];
+        totals.frames++;
+        for (uint32_t i = 0; i < CounterCount; i++) {
+            totals.counters[i] += results[i];
+        }
+    }
+}
+
+void PipelineStatistics::report(std::ostream& stream) const
+{
+    bool any = false;
+    for (const PassTotals& totals : _totals) {
+        any = any || totals.frames > 0;
+    }
+    if (!any) {
+        return;
+    }
+    stream << std::fixed << std::setprecision(0);
+    stream << "  pipeline statistics per frame:" << std::endl;
+    for (const PassTotals& totals : _totals) {
+        if (totals.frames == 0) {
+            continue;
+        }
+        stream << "    " << std::left << std::setw(8) << totals.name << std::right;
+        for (uint32_t i = 0; i < CounterCount; i++) {
+            stream << (i == 0 ? " " : ", ") << CounterNames[i] << " " << static_cast<double>(totals.counters[i]) / static_cast<double>(totals.frames);
+        }
+        stream << std::endl;
+    }
+    stream.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,51 @@
+#ifndef PIPELINESTATISTICS_H
+#define PIPELINESTATISTICS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// Counts vertices, primitives and shader invocations of named passes with a
+// pipeline statistics query per pass and slot. As with GpuTimer, slots match
+// pre-recorded command buffers and are read after the fence guarding them was
+// waited on, and results that are not available are skipped rather than
+// waited for.
+class PipelineStatistics {
+public:
+    PipelineStatistics();
+
+    void init(vk::Device device, uint32_t slotCount, const std::vector<std::string>& passes);
+    void destroy();
+    bool isInitialized() const;
+
+    // Resets the slot's queries; has to be recorded outside a render pass
+    // before the first begin().
+    void reset(vk::CommandBuffer commandBuffer, uint32_t slot);
+    void begin(vk::CommandBuffer commandBuffer, uint32_t slot, uint32_t pass);
+    void end(vk::CommandBuffer commandBuffer, uint32_t slot, uint32_t pass) const;
+    void markSubmitted(uint32_t slot);
+    void collect(uint32_t slot);
+
+    void report(std::ostream& stream) const;
+
+private:
+    struct PassTotals {
+        std::string name;
+        uint64_t frames = 0;
+        std::vector<uint64_t> counters;
+    };
+
+    uint32_t query(uint32_t slot, uint32_t pass) const;
+
+    vk::Device _device;
+    vk::QueryPool _queryPool;
+    uint32_t _passCount;
+    // Per slot and pass: the recorded command buffer contains the query.
+    std::vector<bool> _recorded;
+    std::vector<bool> _submitted;
+    std::vector<PassTotals> _totals;
+};
+
+#endif // PIPELINESTATISTICS_H
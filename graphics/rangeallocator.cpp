@@ -0,0 +1,103 @@
+#include "rangeallocator.h"
+
+#include <algorithm>
+#include <iterator>
+
+const uint32_t RangeAllocator::InvalidOffset;
+
+RangeAllocator::RangeAllocator(uint32_t capacity)
+{
+    reset(capacity);
+}
+
+void RangeAllocator::reset(uint32_t capacity)
+{
+    _free.clear();
+    _capacity = capacity;
+    _used = 0;
+    if (capacity > 0) {
+        _free[0] = capacity;
+    }
+}
+
+uint32_t RangeAllocator::allocate(uint32_t count)
+{
+    if (count == 0) {
+        return InvalidOffset;
+    }
+    for (auto range = _free.begin(); range != _free.end(); ++range) {
+        if (range->second < count) {
+            continue;
+        }
+        uint32_t offset = range->first;
+        uint32_t remaining = range->second - count;
+        _free.erase(range);
+        if (remaining > 0) {
+            _free[offset + count] = remaining;
+        }
+        _used += count;
+        return offset;
+    }
+    return InvalidOffset;
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    _used -= count;
+    auto next = _free.lower_bound(offset);
+    if (next != _free.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            count += previous->second;
+            _free.erase(previous);
+        }
+    }
+    if (next != _free.end() && offset + count == next->first) {
+        count += next->second;
+        _free.erase(next);
+    }
+    _free[offset] = count;
+}
+
+uint32_t RangeAllocator::capacity() const
+{
+    return _capacity;
+}
+
+uint32_t RangeAllocator::used() const
+{
+    return _used;
+}
+
+uint32_t RangeAllocator::largestFree() const
+{
+    uint32_t largest = 0;
+    for (const auto& range : _free) {
+        largest = std::max(largest, range.second);
+    }
+    return largest;
+}
+
+uint32_t RangeAllocator::end() const
+{
+    if (!_free.empty()) {
+        auto last = std::prev(_free.end());
+        if (last->first + last->second == _capacity) {
+            return last->first;
+        }
+    }
+    return _capacity;
+}
+
+double RangeAllocator::fragmentation() const
+{
+    uint32_t free = _capacity - _used;
+    if (free == 0) {
+        return 0.0;
+    }
+    return 1.0 - static_cast<double>(largestFree()) / static_cast<double>(free);
+}
@@ -0,0 +1,34 @@
+#ifndef RANGEALLOCATOR_H
+#define RANGEALLOCATOR_H
+
+#include <cstdint>
+#include <map>
+
+// First-fit allocator for ranges of elements in a fixed-size buffer. Freed
+// ranges are merged with their free neighbours.
+class RangeAllocator {
+public:
+    static const uint32_t InvalidOffset = 0xffffffffu;
+
+    explicit RangeAllocator(uint32_t capacity = 0);
+
+    void reset(uint32_t capacity);
+    uint32_t allocate(uint32_t count);
+    void free(uint32_t offset, uint32_t count);
+
+    uint32_t capacity() const;
+    uint32_t used() const;
+    uint32_t largestFree() const;
+    // One past the last allocated element.
+    uint32_t end() const;
+    // Share of the free space outside the largest free range, 0 when all
+    // free space is contiguous.
+    double fragmentation() const;
+
+private:
+    std::map<uint32_t, uint32_t> _free;
+    uint32_t _capacity;
+    uint32_t _used;
+};
+
+#endif // RANGEALLOCATOR_H
@@ -0,0 +1,95 @@
+#include "redrawscheduler.h"
+
+#include <iomanip>
+
+namespace {
+const double IdleTimeout = 0.25;
+}
+
+RedrawScheduler::RedrawScheduler(bool onDemand)
+    : _onDemand(onDemand)
+    , _dirty(true)
+    , _animating(false)
+    , _frames(0)
+    , _waits(0)
+    , _idleSeconds(0.0)
+    , _idleCpuSeconds(0.0)
+    , _gpuSeconds(0.0)
+    , _idleCpuStart(0)
+{
+}
+
+void RedrawScheduler::configure(bool onDemand)
+{
+    _onDemand = onDemand;
+    _dirty = true;
+}
+
+bool RedrawScheduler::isOnDemand() const
+{
+    return _onDemand;
+}
+
+void RedrawScheduler::invalidate()
+{
+    _dirty = true;
+}
+
+void RedrawScheduler::setAnimating(bool animating)
+{
+    _animating = animating;
+}
+
+bool RedrawScheduler::shouldDraw() const
+{
+    return !_onDemand || _dirty || _animating;
+}
+
+double RedrawScheduler::idleTimeout() const
+{
+    return IdleTimeout;
+}
+
+void RedrawScheduler::frameStarted()
+{
+    // Cleared before drawing, so a swap chain recreated during the frame
+    // invalidates again and gets a frame of its own.
+    _dirty = false;
+    _frames++;
+}
+
+void RedrawScheduler::beginIdle()
+{
+    _idleStart = Clock::now();
+    _idleCpuStart = std::clock();
+}
+
+void RedrawScheduler::endIdle()
+{
+    _idleSeconds += std::chrono::duration<double>(Clock::now() - _idleStart).count();
+    // std::clock counts the CPU time of every thread in the process.
+    _idleCpuSeconds += static_cast<double>(std::clock() - _idleCpuStart) / CLOCKS_PER_SEC;
+    _waits++;
+}
+
+void RedrawScheduler::addGpuTime(double milliseconds)
+{
+    _gpuSeconds += milliseconds / 1000.0;
+}
+
+void RedrawScheduler::report(std::ostream& stream, double loopSeconds) const
+{
+    if (!_onDemand || loopSeconds <= 0.0) {
+        return;
+    }
+    stream << std::fixed << std::setprecision(1);
+    stream << "  on-demand redraw: " << _frames << " frames in " << loopSeconds << " s, idle " << 100.0 * _idleSeconds / loopSeconds << "% of the time over " << _waits << " waits";
+    if (_idleSeconds > 0.0) {
+        stream << ", CPU while idle " << 100.0 * _idleCpuSeconds / _idleSeconds << "% of a core";
+    }
+    if (_gpuSeconds > 0.0) {
+        stream << ", GPU busy " << 100.0 * _gpuSeconds / loopSeconds << "%";
+    }
+    stream << std::endl;
+    stream.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,50 @@
+#ifndef REDRAWSCHEDULER_H
+#define REDRAWSCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+
+// Decides whether the main loop draws a frame or blocks for window events.
+// Continuous mode draws every iteration. On demand, a frame is drawn while an
+// animation runs or after something invalidated the picture, otherwise the
+// loop waits; the time spent waiting and the CPU used meanwhile are measured.
+class RedrawScheduler {
+public:
+    explicit RedrawScheduler(bool onDemand = false);
+
+    void configure(bool onDemand);
+    bool isOnDemand() const;
+
+    // The scene, a camera or a window changed; the next iteration draws.
+    void invalidate();
+    void setAnimating(bool animating);
+    bool shouldDraw() const;
+    // Upper bound for one wait, so periodic work in the loop still runs.
+    double idleTimeout() const;
+
+    void frameStarted();
+    void beginIdle();
+    void endIdle();
+    void addGpuTime(double milliseconds);
+
+    void report(std::ostream& stream, double loopSeconds) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    bool _onDemand;
+    bool _dirty;
+    bool _animating;
+
+    uint64_t _frames;
+    uint64_t _waits;
+    double _idleSeconds;
+    double _idleCpuSeconds;
+    double _gpuSeconds;
+    Clock::time_point _idleStart;
+    std::clock_t _idleCpuStart;
+};
+
+#endif // REDRAWSCHEDULER_H
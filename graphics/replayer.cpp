@@ -0,0 +1,717 @@
+#include "replayer.h"
+#include "helperfunctions.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+namespace {
+const uint32_t MissingHandle = 0xffffffffu;
+// Larger handles than this come from a corrupt stream, not from the engine.
+const uint32_t MaxStreamHandle = 1u << 20;
+const char* const ShaderNames[] = { "vert", "frag", "material_frag" };
+}
+
+Replayer::Replayer()
+    : _queueFamily(0)
+    , _colorFormat(vk::Format::eB8G8R8A8Unorm)
+    , _depthFormat(vk::Format::eUndefined)
+    , _uniformAlignment(1)
+    , _uniformSize(0)
+    , _setupFinished(false)
+    , _meshCount(0)
+    , _materialCount(0)
+    , _paced(false)
+    , _frames(0)
+    , _skippedFrames(0)
+    , _skippedRecords(0)
+    , _commandBuffersRecorded(0)
+    , _missingShaders(0)
+{
+}
+
+Replayer::~Replayer()
+{
+    destroy();
+}
+
+bool Replayer::run(DrawStreamReader& stream, bool paced, const std::string& shaderDirectory)
+{
+    _paced = paced;
+    // Sizes the geometry pool for every mesh of the stream.
+    uint64_t vertexCount = 0;
+    uint64_t indexCount = 0;
+    DrawStreamRecord record;
+    stream.rewind();
+    while (stream.next(record)) {
+        if (record.type == DrawStreamRecordType::Mesh) {
+            DrawStreamMesh mesh = DrawStreamReader::fixedPart<DrawStreamMesh>(record);
+            vertexCount += mesh.vertexCount;
+            indexCount += mesh.indexCount;
+        }
+    }
+    if (vertexCount == 0 || indexCount == 0 || vertexCount > MissingHandle || indexCount > MissingHandle) {
+        std::cerr << "Draw stream has no meshes to replay" << std::endl;
+        return false;
+    }
+    init(stream, shaderDirectory, static_cast<uint32_t>(vertexCount), static_cast<uint32_t>(indexCount));
+
+    std::chrono::steady_clock::time_point start;
+    uint64_t firstFrameTime = 0;
+    uint64_t lastFrameTime = 0;
+    stream.rewind();
+    while (stream.next(record)) {
+        switch (record.type) {
+        case DrawStreamRecordType::View:
+            setView(DrawStreamReader::fixedPart<DrawStreamView>(record));
+            break;
+        case DrawStreamRecordType::Material:
+            // Material parameters are uploaded once, so as in the engine all
+            // materials have to exist before the first frame.
+            if (_setupFinished) {
+                _skippedRecords++;
+            } else {
+                addMaterial(DrawStreamReader::fixedPart<DrawStreamMaterial>(record));
+            }
+            break;
+        case DrawStreamRecordType::Mesh:
+            if (_setupFinished) {
+                _skippedRecords++;
+            } else {
+                addMesh(record);
+            }
+            break;
+        case DrawStreamRecordType::Commands:
+            setCommands(record);
+            break;
+        case DrawStreamRecordType::Frame: {
+            if (!_setupFinished) {
+                finishSetup();
+            }
+            DrawStreamFrame frame = DrawStreamReader::fixedPart<DrawStreamFrame>(record);
+            if (_frames + _skippedFrames == 0) {
+                start = std::chrono::steady_clock::now();
+                firstFrameTime = frame.nanoseconds;
+            } else {
+                _recordedFrameTimes.add(static_cast<double>(frame.nanoseconds - lastFrameTime) * 1e-6);
+            }
+            lastFrameTime = frame.nanoseconds;
+            if (_paced) {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(frame.nanoseconds - firstFrameTime));
+            }
+            drawFrame(record);
+            break;
+        }
+        }
+    }
+    destroy();
+    if (_frames == 0) {
+        std::cerr << "Draw stream has no frames to replay" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Replayer::init(const DrawStreamReader& stream, const std::string& shaderDirectory, uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    _uniformSize = stream.uniformSize();
+    createDevice();
+    _uploads.init(_device, _physicalDevice, _memoryTracker);
+    _attachments.init(_device, _physicalDevice, _memoryTracker);
+
+    vk::CommandPoolCreateInfo poolInfo;
+    poolInfo.queueFamilyIndex = _queueFamily;
+    // Command buffers are re-recorded in place when the stream changes their draws.
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+    vk::Result res = _device.createCommandPool(&poolInfo, nullptr, &_commandPool);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create command pool! error:" << res << std::endl;
+        std::abort();
+    }
+
+    createRenderPass();
+    createDescriptors();
+    vk::PipelineCacheCreateInfo cacheCreateInfo;
+    res = _device.createPipelineCache(&cacheCreateInfo, nullptr, &_cache);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create pipeline cache! error:" << res << std::endl;
+        std::abort();
+    }
+    _materials.init(_device, _physicalDevice, _memoryTracker, _descriptorSetLayout);
+    loadShaders(shaderDirectory);
+    _geometry.init(_device, _physicalDevice, _memoryTracker, vertexCapacity, indexCapacity);
+}
+
+void Replayer::createDevice()
+{
+    vk::ApplicationInfo appInfo;
+    appInfo.pApplicationName = "engine_replay";
+    appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.pEngineName = "No Engine";
+    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_0;
+
+    // Headless: no surface, so no window system extensions.
+    std::vector<const char*> extensions = _memoryTracker.requestInstanceExtensions();
+    vk::InstanceCreateInfo createInfo;
+    createInfo.pApplicationInfo = &appInfo;
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
+    vk::Result res = vk::createInstance(&createInfo, nullptr, &_instance);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Cannot create instance! error:" << res << std::endl;
+        std::abort();
+    }
+
+    uint32_t deviceCount = 0;
+    _instance.enumeratePhysicalDevices(&deviceCount, nullptr);
+    std::vector<vk::PhysicalDevice> devices(deviceCount);
+    _instance.enumeratePhysicalDevices(&deviceCount, devices.data());
+    bool found = false;
+    for (vk::PhysicalDevice& device : devices) {
+        uint32_t familyCount = 0;
+        device.getQueueFamilyProperties(&familyCount, nullptr);
+        std::vector<vk::QueueFamilyProperties> families(familyCount);
+        device.getQueueFamilyProperties(&familyCount, families.data());
+        for (uint32_t i = 0; i < familyCount && !found; i++) {
+            if (families[i].queueCount > 0 && (families[i].queueFlags & vk::QueueFlagBits::eGraphics)) {
+                _physicalDevice = device;
+                _queueFamily = i;
+                found = true;
+            }
+        }
+        if (found) {
+            break;
+        }
+    }
+    if (!found) {
+        std::cerr << "Failed to find a GPU with a graphics queue!" << std::endl;
+        std::abort();
+    }
+
+    float queuePriority = 1.0f;
+    vk::DeviceQueueCreateInfo queueCreateInfo;
+    queueCreateInfo.queueFamilyIndex = _queueFamily;
+    queueCreateInfo.queueCount = 1;
+    queueCreateInfo.pQueuePriorities = &queuePriority;
+
+    vk::PhysicalDeviceFeatures deviceFeatures;
+    std::vector<const char*> deviceExtensions = _memoryTracker.requestDeviceExtensions(_physicalDevice);
+    vk::DeviceCreateInfo deviceInfo;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueCreateInfo;
+    deviceInfo.pEnabledFeatures = &deviceFeatures;
+    deviceInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    res = _physicalDevice.createDevice(&deviceInfo, nullptr, &_device);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create logical device! error:" << res << std::endl;
+        std::abort();
+    }
+    _device.getQueue(_queueFamily, 0, &_queue);
+    _memoryTracker.init(_instance, _physicalDevice, _device);
+
+    vk::PhysicalDeviceProperties properties;
+    _physicalDevice.getProperties(&properties);
+    _uniformAlignment = std::max<vk::DeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+    LOG_INFO(LogCategory::Startup, "Replaying on %s", properties.deviceName);
+}
+
+void Replayer::createRenderPass()
+{
+    _depthFormat = findDepthFormat(_physicalDevice);
+
+    vk::AttachmentDescription colorAttachment;
+    colorAttachment.format = _colorFormat;
+    colorAttachment.samples = vk::SampleCountFlagBits::e1;
+    colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+    colorAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+    colorAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+    colorAttachment.initialLayout = vk::ImageLayout::eUndefined;
+    colorAttachment.finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+
+    vk::AttachmentDescription depthAttachment;
+    depthAttachment.format = _depthFormat;
+    depthAttachment.samples = vk::SampleCountFlagBits::e1;
+    depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+    depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+    depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+    depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
+    depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
+    vk::AttachmentReference colorAttachmentRef(0, vk::ImageLayout::eColorAttachmentOptimal);
+    vk::AttachmentReference depthAttachmentRef(1, vk::ImageLayout::eDepthStencilAttachmentOptimal);
+
+    vk::SubpassDescription subpass;
+    subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+    // Each view's target is shared by all of its frames; wait for the
+    // previous frame's writes.
+    vk::SubpassDependency dependency;
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests;
+    dependency.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+    dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+    dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+    std::array<vk::AttachmentDescription, 2> attachments = { { colorAttachment, depthAttachment } };
+    vk::RenderPassCreateInfo renderPassInfo;
+    renderPassInfo.attachmentCount = attachments.size();
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
+
+    vk::Result res = _device.createRenderPass(&renderPassInfo, nullptr, &_renderPass);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to create render pass! error:" << res << std::endl;
+        std::abort();
+    }
+}
+
+void Replayer::createDescriptors()
+{
+    vk::DescriptorSetLayoutBinding uboLayoutBinding;
+    uboLayoutBinding.binding = 0;
+    uboLayoutBinding.descriptorCount = 1;
+    uboLayoutBinding.descriptorType = vk::DescriptorType::eUniformBuffer;
+    uboLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eVertex;
+
+    vk::DescriptorSetLayoutCreateInfo layoutInfo;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &uboLayoutBinding;
+    if (_device.createDescriptorSetLayout(&layoutInfo, nullptr, &_descriptorSetLayout) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create descriptor set layout!" << std::endl;
+        std::abort();
+    }
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eUniformBuffer, ReplayMaxDescriptorSets);
+    // Sets are freed and reallocated when the stream recreates a view.
+    vk::DescriptorPoolCreateInfo poolInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, ReplayMaxDescriptorSets, 1, &poolSize);
+    if (_device.createDescriptorPool(&poolInfo, nullptr, &_descriptorPool) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create descriptor pool!" << std::endl;
+        std::abort();
+    }
+}
+
+void Replayer::loadShaders(const std::string& shaderDirectory)
+{
+    _shaderStorage.resize(sizeof(ShaderNames) / sizeof(ShaderNames[0]));
+    for (size_t i = 0; i < _shaderStorage.size(); i++) {
+        ShaderCode code;
+        if (findShader(shaderDirectory, ShaderNames[i], _shaderStorage[i], code)) {
+            _materials.addShader(ShaderNames[i], code);
+        }
+    }
+    if (!_materials.hasShader("vert") || !_materials.hasShader("frag")) {
+        std::cerr << "Scene shaders are not available" << std::endl;
+        std::abort();
+    }
+}
+
+void Replayer::setView(const DrawStreamView& record)
+{
+    if (record.view >= DrawStreamMaxViews || record.slotCount == 0 || record.width == 0 || record.height == 0) {
+        _skippedRecords++;
+        return;
+    }
+    _device.waitIdle();
+    while (_views.size() <= record.view) {
+        _views.push_back(std::unique_ptr<ReplayView>(new ReplayView()));
+    }
+    ReplayView& view = *_views[record.view];
+    destroyViewResources(view);
+    view.extent = vk::Extent2D(record.width, record.height);
+    view.slotCount = record.slotCount;
+
+    view.uniformStride = (_uniformSize + _uniformAlignment - 1) / _uniformAlignment * _uniformAlignment;
+    vk::DeviceSize bufferSize = view.uniformStride * view.slotCount;
+    createBuffer(_device, _physicalDevice, _memoryTracker, MemoryCategory::Uniform, bufferSize, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, view.uniformBuffer, view.uniformMemory);
+    void* dataPtr = nullptr;
+    vk::Result res = _device.mapMemory(view.uniformMemory, vk::DeviceSize(0), bufferSize, vk::MemoryMapFlags(), &dataPtr);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to map memory for uniform buffer! error:" << res << std::endl;
+        std::abort();
+    }
+    view.uniformData = static_cast<uint8_t*>(dataPtr);
+
+    view.descriptorSets.resize(view.slotCount);
+    std::vector<vk::DescriptorSetLayout> layouts(view.slotCount, _descriptorSetLayout);
+    vk::DescriptorSetAllocateInfo allocInfo(_descriptorPool, view.slotCount, layouts.data());
+    if (_device.allocateDescriptorSets(&allocInfo, view.descriptorSets.data()) != vk::Result::eSuccess) {
+        std::cerr << "Failed to allocate descriptor sets, at most " << ReplayMaxDescriptorSets << " slots across all views!" << std::endl;
+        std::abort();
+    }
+    for (uint32_t i = 0; i < view.slotCount; i++) {
+        vk::DescriptorBufferInfo bufferInfo(view.uniformBuffer, view.uniformStride * i, _uniformSize);
+        vk::WriteDescriptorSet write;
+        write.dstSet = view.descriptorSets[i];
+        write.dstBinding = 0;
+        write.descriptorType = vk::DescriptorType::eUniformBuffer;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &bufferInfo;
+        _device.updateDescriptorSets(1, &write, 0, nullptr);
+    }
+
+    view.commandBuffers.resize(view.slotCount);
+    vk::CommandBufferAllocateInfo commandInfo;
+    commandInfo.commandPool = _commandPool;
+    commandInfo.level = vk::CommandBufferLevel::ePrimary;
+    commandInfo.commandBufferCount = view.slotCount;
+    if (_device.allocateCommandBuffers(&commandInfo, view.commandBuffers.data()) != vk::Result::eSuccess) {
+        std::cerr << "Failed to allocate command buffers!" << std::endl;
+        std::abort();
+    }
+    view.draws.assign(view.slotCount, std::vector<DrawStreamDraw>());
+    view.renderExtents.assign(view.slotCount, view.extent);
+
+    // Fences and GPU timestamps follow the first view's slots, as they follow
+    // the primary swap chain in the engine.
+    if (record.view == 0) {
+        for (vk::Fence fence : _frameFences) {
+            _device.destroyFence(fence);
+        }
+        _frameFences.assign(view.slotCount, vk::Fence());
+        vk::FenceCreateInfo fenceInfo(vk::FenceCreateFlagBits::eSignaled);
+        for (vk::Fence& fence : _frameFences) {
+            if (_device.createFence(&fenceInfo, nullptr, &fence) != vk::Result::eSuccess) {
+                std::cerr << "Failed to create fence!" << std::endl;
+                std::abort();
+            }
+        }
+        for (const std::unique_ptr<ReplayView>& other : _views) {
+            other->slotFences.assign(other->slotCount, vk::Fence());
+        }
+        _gpuTimer.destroy();
+        _gpuTimer.init(_device, _physicalDevice, _queueFamily, view.slotCount);
+    }
+    view.slotFences.assign(view.slotCount, vk::Fence());
+    createFramebuffers();
+}
+
+void Replayer::destroyViewResources(ReplayView& view)
+{
+    if (!view.commandBuffers.empty()) {
+        _device.freeCommandBuffers(_commandPool, static_cast<uint32_t>(view.commandBuffers.size()), view.commandBuffers.data());
+        view.commandBuffers.clear();
+    }
+    if (!view.descriptorSets.empty()) {
+        _device.freeDescriptorSets(_descriptorPool, static_cast<uint32_t>(view.descriptorSets.size()), view.descriptorSets.data());
+        view.descriptorSets.clear();
+    }
+    if (view.uniformData != nullptr) {
+        _device.unmapMemory(view.uniformMemory);
+        _device.destroyBuffer(view.uniformBuffer);
+        _memoryTracker.free(view.uniformMemory);
+        view.uniformData = nullptr;
+        view.uniformBuffer = vk::Buffer();
+        view.uniformMemory = vk::DeviceMemory();
+    }
+}
+
+void Replayer::createFramebuffers()
+{
+    // As in the engine, the views render concurrently and share one pass index.
+    _attachments.reset();
+    for (const std::unique_ptr<ReplayView>& view : _views) {
+        if (view->slotCount == 0) {
+            continue;
+        }
+        view->color = _attachments.request(AttachmentKey(_colorFormat, view->extent, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc), 0, 0);
+        view->depth = _attachments.request(AttachmentKey(_depthFormat, view->extent, vk::ImageUsageFlagBits::eDepthStencilAttachment), 0, 0);
+    }
+    _attachments.build();
+
+    for (const std::unique_ptr<ReplayView>& view : _views) {
+        if (view->framebuffer) {
+            _device.destroyFramebuffer(view->framebuffer);
+            view->framebuffer = vk::Framebuffer();
+        }
+        if (view->slotCount == 0) {
+            continue;
+        }
+        std::array<vk::ImageView, 2> attachments = { { _attachments.view(view->color), _attachments.view(view->depth) } };
+        vk::FramebufferCreateInfo framebufferInfo;
+        framebufferInfo.renderPass = _renderPass;
+        framebufferInfo.attachmentCount = attachments.size();
+        framebufferInfo.pAttachments = attachments.data();
+        framebufferInfo.width = view->extent.width;
+        framebufferInfo.height = view->extent.height;
+        framebufferInfo.layers = 1;
+        vk::Result res = _device.createFramebuffer(&framebufferInfo, nullptr, &view->framebuffer);
+        if (res != vk::Result::eSuccess) {
+            std::cerr << "Failed to create framebuffer! error:" << res << std::endl;
+            std::abort();
+        }
+        view->recorded.assign(view->slotCount, false);
+    }
+}
+
+void Replayer::addMaterial(const DrawStreamMaterial& record)
+{
+    if (record.handle >= MaxStreamHandle) {
+        _skippedRecords++;
+        return;
+    }
+    // Streams from builds with more shaders fall back to the scene shaders.
+    MaterialDesc desc = makeMaterialDesc(record);
+    if (!_materials.hasShader(desc.state.vertexShader)) {
+        desc.state.vertexShader = "vert";
+        _missingShaders++;
+    }
+    if (!_materials.hasShader(desc.state.fragmentShader)) {
+        desc.state.fragmentShader = "frag";
+        _missingShaders++;
+    }
+    if (_materialHandles.size() <= record.handle) {
+        _materialHandles.resize(record.handle + 1, MissingHandle);
+    }
+    _materialHandles[record.handle] = _materials.create(desc);
+}
+
+void Replayer::addMesh(const DrawStreamRecord& record)
+{
+    DrawStreamMesh mesh = DrawStreamReader::fixedPart<DrawStreamMesh>(record);
+    if (mesh.handle >= MaxStreamHandle || mesh.vertexCount == 0 || mesh.indexCount == 0) {
+        _skippedRecords++;
+        return;
+    }
+    // The payload is not aligned for Vertex, so it is copied out first.
+    std::vector<Vertex> vertices(mesh.vertexCount);
+    std::vector<uint16_t> indices(mesh.indexCount);
+    const char* payload = record.data + sizeof(DrawStreamMesh);
+    std::memcpy(vertices.data(), payload, vertices.size() * sizeof(Vertex));
+    std::memcpy(indices.data(), payload + vertices.size() * sizeof(Vertex), indices.size() * sizeof(uint16_t));
+    if (_meshHandles.size() <= mesh.handle) {
+        _meshHandles.resize(mesh.handle + 1, InvalidMesh);
+    }
+    _meshHandles[mesh.handle] = _geometry.add(_uploads, vertices.data(), mesh.vertexCount, indices.data(), mesh.indexCount);
+}
+
+void Replayer::setCommands(const DrawStreamRecord& record)
+{
+    DrawStreamCommands commands = DrawStreamReader::fixedPart<DrawStreamCommands>(record);
+    if (commands.view >= _views.size() || commands.slot >= _views[commands.view]->slotCount) {
+        _skippedRecords++;
+        return;
+    }
+    ReplayView& view = *_views[commands.view];
+    std::vector<DrawStreamDraw>& draws = view.draws[commands.slot];
+    draws.resize(commands.drawCount);
+    std::memcpy(draws.data(), record.data + sizeof(DrawStreamCommands), draws.size() * sizeof(DrawStreamDraw));
+    view.renderExtents[commands.slot] = vk::Extent2D(std::min(commands.width, view.extent.width), std::min(commands.height, view.extent.height));
+    view.recorded[commands.slot] = false;
+}
+
+void Replayer::finishSetup()
+{
+    if (_materials.materialCount() == 0) {
+        MaterialDesc scene;
+        scene.name = "scene";
+        _materialHandles.assign(1, _materials.create(scene));
+    }
+    _materials.uploadParameters(_uploads);
+    LOG_INFO(LogCategory::Startup, "Submitting %zu uploads...", _uploads.pendingCount());
+    _uploads.submit(_commandPool, _queue);
+    _materials.createPipelines(_renderPass, _cache);
+    _meshCount = _geometry.meshCount();
+    _materialCount = _materials.materialCount();
+    _setupFinished = true;
+}
+
+void Replayer::recordCommandBuffer(uint32_t viewIndex, uint32_t slot)
+{
+    ReplayView& view = *_views[viewIndex];
+    bool primary = viewIndex == 0;
+    vk::CommandBuffer commandBuffer = view.commandBuffers[slot];
+    vk::Extent2D extent = view.renderExtents[slot];
+
+    vk::RenderPassBeginInfo renderPassInfo;
+    renderPassInfo.renderPass = _renderPass;
+    renderPassInfo.framebuffer = view.framebuffer;
+    renderPassInfo.renderArea.offset = vk::Offset2D(0, 0);
+    renderPassInfo.renderArea.extent = extent;
+    std::array<vk::ClearValue, 2> clearValues = {};
+    clearValues[0].color = vk::ClearColorValue(std::array<float, 4>{ { 0.1f, 0.2f, 0.1f, 1.0f } });
+    clearValues[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+    renderPassInfo.clearValueCount = clearValues.size();
+    renderPassInfo.pClearValues = clearValues.data();
+
+    vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f);
+    vk::Rect2D scissor(vk::Offset2D(0, 0), extent);
+
+    _drawList.clear();
+    for (const DrawStreamDraw& draw : view.draws[slot]) {
+        if (draw.material >= _materialHandles.size() || _materialHandles[draw.material] == MissingHandle || draw.mesh >= _meshHandles.size() || _meshHandles[draw.mesh] == InvalidMesh) {
+            continue;
+        }
+        MaterialHandle material = _materialHandles[draw.material];
+        MeshHandle mesh = _meshHandles[draw.mesh];
+        const MeshRange& range = _geometry.mesh(mesh);
+        DrawItem item;
+        item.pipeline = _materials.pipeline(material);
+        item.pipelineLayout = _materials.pipelineLayout();
+        item.descriptorSet = view.descriptorSets[slot];
+        item.materialSet = _materials.descriptorSet();
+        item.materialIndex = material;
+        item.indexCount = range.indexCount;
+        item.firstIndex = range.firstIndex;
+        item.vertexOffset = range.vertexOffset;
+        item.instanceCount = draw.instanceCount;
+        item.firstInstance = draw.firstInstance;
+        _drawList.add(makeSortKey(0, 0, _materials.pipelineIndex(material), material, mesh, 0.0f), item);
+    }
+    _drawList.sort();
+
+    vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
+    if (commandBuffer.begin(&beginInfo) != vk::Result::eSuccess) {
+        std::cerr << "Command buffers bind fail!" << std::endl;
+        std::abort();
+    }
+    if (primary && _gpuTimer.isInitialized()) {
+        _gpuTimer.writeBegin(commandBuffer, slot);
+    }
+    commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+    commandBuffer.setViewport(0, 1, &viewport);
+    commandBuffer.setScissor(0, 1, &scissor);
+    _geometry.bind(commandBuffer);
+    _drawStats += _drawList.record(commandBuffer);
+    commandBuffer.endRenderPass();
+    if (primary && _gpuTimer.isInitialized()) {
+        _gpuTimer.writeEnd(commandBuffer, slot);
+    }
+    commandBuffer.end();
+    view.recorded[slot] = true;
+    _commandBuffersRecorded++;
+}
+
+void Replayer::drawFrame(const DrawStreamRecord& record)
+{
+    DrawStreamFrame frame = DrawStreamReader::fixedPart<DrawStreamFrame>(record);
+    const char* entries = record.data + sizeof(DrawStreamFrame);
+    size_t entrySize = sizeof(DrawStreamFrameView) + _uniformSize;
+    DrawStreamFrameView first;
+    if (frame.viewCount != 0) {
+        std::memcpy(&first, entries, sizeof(first));
+    }
+    if (frame.viewCount == 0 || _views.empty() || first.view != 0 || first.slot >= _views[0]->slotCount) {
+        _skippedFrames++;
+        return;
+    }
+
+    // The slot of the first view guards the whole frame, the other views wait
+    // for whichever frame last used their slot.
+    _frameStats.beginFrame();
+    vk::Fence frameFence = _frameFences[first.slot];
+    _device.waitForFences(1, &frameFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    _device.resetFences(1, &frameFence);
+    double gpuMilliseconds = 0.0;
+    if (_gpuTimer.isInitialized() && _gpuTimer.collect(first.slot, gpuMilliseconds)) {
+        _gpuFrameTimes.add(gpuMilliseconds);
+    }
+
+    _submitBuffers.clear();
+    for (uint32_t i = 0; i < frame.viewCount; i++) {
+        DrawStreamFrameView entry;
+        std::memcpy(&entry, entries + i * entrySize, sizeof(entry));
+        if (entry.view >= _views.size() || entry.slot >= _views[entry.view]->slotCount) {
+            continue;
+        }
+        ReplayView& view = *_views[entry.view];
+        vk::Fence& slotFence = view.slotFences[entry.slot];
+        if (slotFence && slotFence != frameFence) {
+            _device.waitForFences(1, &slotFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+        slotFence = frameFence;
+        if (!view.recorded[entry.slot]) {
+            recordCommandBuffer(entry.view, entry.slot);
+        }
+        std::memcpy(view.uniformData + view.uniformStride * entry.slot, entries + i * entrySize + sizeof(DrawStreamFrameView), _uniformSize);
+        _submitBuffers.push_back(view.commandBuffers[entry.slot]);
+    }
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.commandBufferCount = static_cast<uint32_t>(_submitBuffers.size());
+    submitInfo.pCommandBuffers = _submitBuffers.data();
+    vk::Result submitResult = _queue.submit(1, &submitInfo, frameFence);
+    if (submitResult != vk::Result::eSuccess) {
+        std::cerr << "failed to submit draw command buffer! error:" << submitResult << std::endl;
+        std::abort();
+    }
+    if (_gpuTimer.isInitialized()) {
+        _gpuTimer.markSubmitted(first.slot);
+    }
+    _frameStats.endFrame();
+    _frames++;
+}
+
+void Replayer::destroy()
+{
+    if (!_device) {
+        return;
+    }
+    _device.waitIdle();
+    for (const std::unique_ptr<ReplayView>& view : _views) {
+        destroyViewResources(*view);
+        if (view->framebuffer) {
+            _device.destroyFramebuffer(view->framebuffer);
+        }
+    }
+    _views.clear();
+    for (vk::Fence fence : _frameFences) {
+        _device.destroyFence(fence);
+    }
+    _frameFences.clear();
+    _gpuTimer.destroy();
+    _attachments.destroy();
+    _geometry.destroy();
+    _materials.destroy();
+    _device.destroyPipelineCache(_cache);
+    _device.destroyDescriptorPool(_descriptorPool);
+    _device.destroyDescriptorSetLayout(_descriptorSetLayout);
+    _device.destroyRenderPass(_renderPass);
+    _device.destroyCommandPool(_commandPool);
+    _device.destroy();
+    _device = vk::Device();
+    _instance.destroy();
+    _instance = vk::Instance();
+}
+
+void Replayer::report(std::ostream& stream) const
+{
+    std::ostringstream label;
+    label << "replay, " << (_paced ? "recorded pacing" : "as fast as possible") << ", " << _meshCount << " meshes, " << _materialCount << " materials";
+    _frameStats.report(stream, label.str());
+    stream << std::fixed << std::setprecision(3);
+    if (_recordedFrameTimes.count() > 0) {
+        stream << "  recorded frame time ms: mean " << _recordedFrameTimes.mean() << " stddev " << _recordedFrameTimes.stddev() << " min " << _recordedFrameTimes.min() << " max " << _recordedFrameTimes.max() << std::endl;
+    }
+    if (_gpuFrameTimes.count() > 0) {
+        stream << "  gpu frame time ms: mean " << _gpuFrameTimes.mean() << " stddev " << _gpuFrameTimes.stddev() << " min " << _gpuFrameTimes.min() << " max " << _gpuFrameTimes.max() << std::endl;
+    }
+    if (_commandBuffersRecorded > 0) {
+        double buffers = static_cast<double>(_commandBuffersRecorded);
+        stream << std::setprecision(1);
+        stream << "  command buffers: " << _commandBuffersRecorded << " recorded, per buffer " << _drawStats.draws / buffers << " draws, " << _drawStats.binds() / buffers << " binds" << std::endl;
+    }
+    if (_skippedFrames > 0 || _skippedRecords > 0) {
+        stream << "  skipped " << _skippedFrames << " frames and " << _skippedRecords << " records that did not match the stream's views and resources" << std::endl;
+    }
+    if (_missingShaders > 0) {
+        stream << "  " << _missingShaders << " material shaders were not available and replaced by the scene shaders" << std::endl;
+    }
+    stream.unsetf(std::ios::floatfield);
+}
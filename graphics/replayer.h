@@ -0,0 +1,119 @@
+#ifndef REPLAYER_H
+#define REPLAYER_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "attachmentpool.h"
+#include "drawlist.h"
+#include "drawstream.h"
+#include "framestats.h"
+#include "geometrypool.h"
+#include "gputimer.h"
+#include "materialsystem.h"
+#include "memorytracker.h"
+#include "shadercode.h"
+#include "uploadbatch.h"
+
+const uint32_t ReplayMaxDescriptorSets = 64;
+
+// Plays a draw stream back without a window: every view renders into its own
+// offscreen target, with the materials, meshes and per-frame uniforms of the
+// recording. Frames are submitted as fast as the GPU takes them, or at the
+// recorded pacing, and timed like the engine's frames.
+class Replayer {
+public:
+    Replayer();
+    ~Replayer();
+
+    bool run(DrawStreamReader& stream, bool paced, const std::string& shaderDirectory);
+    void report(std::ostream& stream) const;
+
+private:
+    struct ReplayView {
+        vk::Extent2D extent;
+        uint32_t slotCount = 0;
+        AttachmentHandle color = 0;
+        AttachmentHandle depth = 0;
+        vk::Framebuffer framebuffer;
+        vk::Buffer uniformBuffer;
+        vk::DeviceMemory uniformMemory;
+        uint8_t* uniformData = nullptr;
+        vk::DeviceSize uniformStride = 0;
+        std::vector<vk::DescriptorSet> descriptorSets;
+        std::vector<vk::CommandBuffer> commandBuffers;
+        std::vector<vk::Fence> slotFences;
+        std::vector<std::vector<DrawStreamDraw>> draws;
+        std::vector<vk::Extent2D> renderExtents;
+        std::vector<bool> recorded;
+    };
+
+    void init(const DrawStreamReader& stream, const std::string& shaderDirectory, uint32_t vertexCapacity, uint32_t indexCapacity);
+    void destroy();
+    void createDevice();
+    void createRenderPass();
+    void createDescriptors();
+    void loadShaders(const std::string& shaderDirectory);
+
+    void setView(const DrawStreamView& record);
+    void destroyViewResources(ReplayView& view);
+    void createFramebuffers();
+    void addMaterial(const DrawStreamMaterial& record);
+    void addMesh(const DrawStreamRecord& record);
+    void setCommands(const DrawStreamRecord& record);
+    void finishSetup();
+    void recordCommandBuffer(uint32_t viewIndex, uint32_t slot);
+    void drawFrame(const DrawStreamRecord& record);
+
+    vk::Instance _instance;
+    vk::PhysicalDevice _physicalDevice;
+    vk::Device _device;
+    uint32_t _queueFamily;
+    vk::Queue _queue;
+    vk::CommandPool _commandPool;
+    vk::RenderPass _renderPass;
+    vk::Format _colorFormat;
+    vk::Format _depthFormat;
+    vk::DescriptorSetLayout _descriptorSetLayout;
+    vk::DescriptorPool _descriptorPool;
+    vk::PipelineCache _cache;
+    vk::DeviceSize _uniformAlignment;
+    uint32_t _uniformSize;
+
+    MemoryTracker _memoryTracker;
+    UploadBatch _uploads;
+    AttachmentPool _attachments;
+    GeometryPool _geometry;
+    MaterialSystem _materials;
+    GpuTimer _gpuTimer;
+    DrawList _drawList;
+    DrawListStats _drawStats;
+    std::vector<std::vector<uint32_t>> _shaderStorage;
+
+    std::vector<std::unique_ptr<ReplayView>> _views;
+    // Stream handles to replay handles; streams are recorded from one run, so
+    // these normally match, but the replay does not rely on it.
+    std::vector<MaterialHandle> _materialHandles;
+    std::vector<MeshHandle> _meshHandles;
+    std::vector<vk::Fence> _frameFences;
+    std::vector<vk::CommandBuffer> _submitBuffers;
+    bool _setupFinished;
+    size_t _meshCount;
+    size_t _materialCount;
+
+    FrameStats _frameStats;
+    RunningStatistics _recordedFrameTimes;
+    RunningStatistics _gpuFrameTimes;
+    bool _paced;
+    uint64_t _frames;
+    uint64_t _skippedFrames;
+    uint64_t _skippedRecords;
+    uint64_t _commandBuffersRecorded;
+    uint32_t _missingShaders;
+};
+
+#endif // REPLAYER_H
@@ -0,0 +1,145 @@
+#include "resolutionscaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+ResolutionScaler::ResolutionScaler()
+    : _budget(0.0)
+    , _minScale(1.0)
+    , _maxScale(1.0)
+    , _scale(1.0)
+    , _filtered(0.0)
+    , _hasFiltered(false)
+    , _settle(0)
+    , _version(0)
+    , _changes(0)
+    , _overBudget(0)
+{
+}
+
+void ResolutionScaler::configure(double budgetMilliseconds, double minScale, double maxScale, const ResolutionScalerTuning& tuning)
+{
+    _tuning = tuning;
+    _budget = std::max(budgetMilliseconds, 0.0);
+    _maxScale = std::min(std::max(maxScale, 0.1), 1.0);
+    _minScale = std::min(std::max(minScale, 0.1), _maxScale);
+    _scale = _maxScale;
+    _hasFiltered = false;
+    _settle = 0;
+    _version++;
+    _changes = 0;
+    _overBudget = 0;
+    _gpuTimes.reset();
+    _scales.reset();
+}
+
+bool ResolutionScaler::isEnabled() const
+{
+    return _budget > 0.0;
+}
+
+bool ResolutionScaler::update(double gpuMilliseconds)
+{
+    _gpuTimes.add(gpuMilliseconds);
+    _scales.add(_scale);
+    if (!isEnabled()) {
+        return false;
+    }
+    if (gpuMilliseconds > _budget) {
+        _overBudget++;
+    }
+    if (_settle > 0) {
+        _settle--;
+        return false;
+    }
+
+    if (_hasFiltered) {
+        _filtered += _tuning.smoothing * (gpuMilliseconds - _filtered);
+    } else {
+        _filtered = gpuMilliseconds;
+        _hasFiltered = true;
+    }
+
+    double load = _filtered / _budget;
+    if (load >= _tuning.lowWatermark && load <= _tuning.highWatermark) {
+        return false;
+    }
+
+    // Aim for the middle of the dead band rather than its edge, so the next
+    // measurement does not immediately cross back over.
+    double target = 0.5 * (_tuning.lowWatermark + _tuning.highWatermark);
+    double desired = _scale * std::sqrt(target / std::max(load, 1e-6));
+    desired = std::min(std::max(desired, _scale - _tuning.maxStep), _scale + _tuning.maxStep);
+    desired = quantize(std::min(std::max(desired, _minScale), _maxScale));
+    if (desired == _scale) {
+        return false;
+    }
+
+    // Predict the cost at the new scale instead of waiting for the average
+    // to catch up from stale samples.
+    _filtered *= (desired * desired) / (_scale * _scale);
+    _scale = desired;
+    _settle = _tuning.settleFrames;
+    _version++;
+    _changes++;
+    return true;
+}
+
+double ResolutionScaler::quantize(double scale) const
+{
+    if (_tuning.quantum <= 0.0 || scale >= _maxScale || scale <= _minScale) {
+        return scale;
+    }
+    return std::min(std::max(std::round(scale / _tuning.quantum) * _tuning.quantum, _minScale), _maxScale);
+}
+
+double ResolutionScaler::scale() const
+{
+    return _scale;
+}
+
+uint32_t ResolutionScaler::version() const
+{
+    return _version;
+}
+
+void ResolutionScaler::scaledExtent(uint32_t width, uint32_t height, uint32_t& scaledWidth, uint32_t& scaledHeight) const
+{
+    scaledWidth = std::min(width, std::max(1u, static_cast<uint32_t>(std::lround(width * _scale))));
+    scaledHeight = std::min(height, std::max(1u, static_cast<uint32_t>(std::lround(height * _scale))));
+}
+
+const RunningStatistics& ResolutionScaler::gpuTimes() const
+{
+    return _gpuTimes;
+}
+
+const RunningStatistics& ResolutionScaler::scales() const
+{
+    return _scales;
+}
+
+uint64_t ResolutionScaler::changes() const
+{
+    return _changes;
+}
+
+uint64_t ResolutionScaler::framesOverBudget() const
+{
+    return _overBudget;
+}
+
+void ResolutionScaler::report(std::ostream& stream) const
+{
+    if (_gpuTimes.count() == 0) {
+        return;
+    }
+    stream << std::fixed << std::setprecision(3);
+    stream << "  gpu time ms: mean " << _gpuTimes.mean() << " stddev " << _gpuTimes.stddev() << " min " << _gpuTimes.min() << " max " << _gpuTimes.max() << std::endl;
+    if (isEnabled()) {
+        stream << "  dynamic resolution: budget " << _budget << " ms, scale mean " << _scales.mean() << " min " << _scales.min() << " max " << _scales.max()
+               << ", " << _changes << " changes, " << _overBudget << " frames over budget" << std::endl;
+    }
+    stream.unsetf(std::ios::floatfield);
+}
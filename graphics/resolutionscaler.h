@@ -0,0 +1,62 @@
+#ifndef RESOLUTIONSCALER_H
+#define RESOLUTIONSCALER_H
+
+#include <cstdint>
+#include <ostream>
+
+#include "framestats.h"
+
+struct ResolutionScalerTuning {
+    // Weight of the newest GPU time in the exponential moving average.
+    double smoothing = 0.15;
+    // No change while the filtered time stays within [low, high] of the budget.
+    double lowWatermark = 0.80;
+    double highWatermark = 0.95;
+    // Largest scale change per adjustment, and the step scales are rounded to.
+    double maxStep = 0.10;
+    double quantum = 0.05;
+    // Frames ignored after a change, until timings from the new scale arrive.
+    uint32_t settleFrames = 8;
+};
+
+// Picks a render scale so that the measured GPU frame time stays below a budget.
+// Cost is assumed to grow with pixel count, i.e. with the square of the scale.
+class ResolutionScaler {
+public:
+    ResolutionScaler();
+
+    void configure(double budgetMilliseconds, double minScale, double maxScale = 1.0, const ResolutionScalerTuning& tuning = ResolutionScalerTuning());
+    bool isEnabled() const;
+
+    // Feeds one GPU frame time, returns true when the scale changed.
+    bool update(double gpuMilliseconds);
+
+    double scale() const;
+    uint32_t version() const;
+    void scaledExtent(uint32_t width, uint32_t height, uint32_t& scaledWidth, uint32_t& scaledHeight) const;
+
+    const RunningStatistics& gpuTimes() const;
+    const RunningStatistics& scales() const;
+    uint64_t changes() const;
+    uint64_t framesOverBudget() const;
+    void report(std::ostream& stream) const;
+
+private:
+    double quantize(double scale) const;
+
+    ResolutionScalerTuning _tuning;
+    double _budget;
+    double _minScale;
+    double _maxScale;
+    double _scale;
+    double _filtered;
+    bool _hasFiltered;
+    uint32_t _settle;
+    uint32_t _version;
+    uint64_t _changes;
+    uint64_t _overBudget;
+    RunningStatistics _gpuTimes;
+    RunningStatistics _scales;
+};
+
+#endif // RESOLUTIONSCALER_H
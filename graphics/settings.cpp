@@ -0,0 +1,193 @@
+#include "settings.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace {
+bool parsePresentMode(const std::string& value, vk::PresentModeKHR& mode)
+{
+    if (value == "fifo") {
+        mode = vk::PresentModeKHR::eFifo;
+    } else if (value == "fifo-relaxed") {
+        mode = vk::PresentModeKHR::eFifoRelaxed;
+    } else if (value == "mailbox") {
+        mode = vk::PresentModeKHR::eMailbox;
+    } else if (value == "immediate") {
+        mode = vk::PresentModeKHR::eImmediate;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// The whole value has to be a number in range; strtoul alone reads "abc" as 0
+// and "-1" as the largest value.
+template <typename T>
+bool parseInteger(const std::string& value, T& result, uint64_t minimum = 0, uint64_t maximum = std::numeric_limits<T>::max())
+{
+    if (value.empty() || value[0] < '0' || value[0] > '9') {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = std::strtoull(value.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || parsed < minimum || parsed > maximum) {
+        return false;
+    }
+    result = static_cast<T>(parsed);
+    return true;
+}
+
+bool parseNumber(const std::string& value, double& result, double minimum, double maximum = std::numeric_limits<double>::max())
+{
+    if (value.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    double parsed = std::strtod(value.c_str(), &end);
+    if (*end != '\0' || !std::isfinite(parsed) || parsed < minimum || parsed > maximum) {
+        return false;
+    }
+    result = parsed;
+    return true;
+}
+
+bool splitOption(const char* argument, std::string& name, std::string& value)
+{
+    if (std::strncmp(argument, "--", 2) != 0) {
+        return false;
+    }
+    std::string option(argument + 2);
+    size_t separator = option.find('=');
+    name = option.substr(0, separator);
+    value = separator == std::string::npos ? std::string() : option.substr(separator + 1);
+    return true;
+}
+}
+
+void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]" << std::endl
+              << "  --present=fifo|fifo-relaxed|mailbox|immediate  preferred present mode (default mailbox)" << std::endl
+              << "  --images=N                                     swapchain image count, at most 16 (default minImageCount + 1)" << std::endl
+              << "  --fps=N                                        frame rate limit, 0 for unlimited" << std::endl
+              << "  --frames=N                                     exit after N presented frames" << std::endl
+              << "  --redraw=continuous|on-demand                  draw every frame or only when something changed (default continuous)" << std::endl
+              << "  --capture=DIR                                  write captured frames into DIR" << std::endl
+              << "  --capture-format=png|ppm                       image format for --capture (default png)" << std::endl
+              << "  --capture-every=N                              capture every Nth frame (default 1)" << std::endl
+              << "  --hash-file=PATH                               write a hash of every captured frame to PATH" << std::endl
+              << "  --stream=PATH|'|command'                       stream raw RGB frames to a file or pipe" << std::endl
+              << "  --gpu-budget=MS                                scale the render resolution to keep GPU frame time under MS" << std::endl
+              << "  --min-scale=F                                  lowest render scale for --gpu-budget (default 0.5)" << std::endl
+              << "  --memory-report=N                              print GPU memory usage every N frames" << std::endl
+              << "  --memory-budget=F                              warn when a heap uses more than F of its budget (default 0.9)" << std::endl
+              << "  --particles=N                                  simulate and draw N particles on the GPU" << std::endl
+              << "  --objects=N                                    draw N small objects below the scene" << std::endl
+              << "  --meshes=N                                     add N static meshes to the geometry pool, drawn with indirect draws" << std::endl
+              << "  --mesh-churn=N                                 replace one static mesh every N frames, compacting the pool when fragmented" << std::endl
+              << "  --culling=hiz|off                              occlusion culling for --objects (default hiz)" << std::endl
+              << "  --lights=N                                     light the scene with N moving point lights (clustered forward shading)" << std::endl
+              << "  --materials=N                                  register N extra materials to exercise pipeline state deduplication" << std::endl
+              << "  --views=N                                      open N windows onto the scene, each with its own camera (at most 16)" << std::endl
+              << "  --pipeline-stats=on|off                        count vertices, primitives and shader invocations per pass (default off)" << std::endl
+              << "  --perf-check=FILE                              compare init, frame, upload and resize times and frame hashes with a baseline" << std::endl
+              << "  --perf-record=FILE                             write this run's measurements as a new baseline" << std::endl
+              << "  --trace=FILE                                   trace startup and the first frames to FILE; T traces more frames at runtime" << std::endl
+              << "  --trace-frames=N                               frames per trace capture (default 120)" << std::endl
+              << "  --record-stream=FILE                           record resources, uniforms and draws for engine_replay" << std::endl
+              << "  --log=LEVEL|CATEGORY:LEVEL,...                 log levels (debug, info, warning, error, off) overall or per category" << std::endl
+              << "  --shader-dir=DIR|FILE.pak                      load vert.spv/frag.spv from DIR or an archive instead of the embedded shaders" << std::endl;
+}
+
+bool parseSettings(int argc, char** argv, ApplicationSettings& settings)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string name;
+        std::string value;
+        if (!splitOption(argv[i], name, value)) {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+
+        if (name == "present" && parsePresentMode(value, settings.presentMode)) {
+            continue;
+        } else if (name == "images" && parseInteger(value, settings.swapchainImages, 0, MaxSwapchainImages)) {
+            continue;
+        } else if (name == "fps" && parseNumber(value, settings.frameRateLimit, 0.0)) {
+            continue;
+        } else if (name == "frames" && parseInteger(value, settings.frameCount)) {
+            continue;
+        } else if (name == "capture" && !value.empty()) {
+            settings.capture.directory = value;
+        } else if (name == "capture-format" && (value == "png" || value == "ppm")) {
+            settings.capture.format = value;
+        } else if (name == "capture-every" && parseInteger(value, settings.capture.interval, 1)) {
+            continue;
+        } else if (name == "hash-file" && !value.empty()) {
+            settings.capture.hashFile = value;
+        } else if (name == "stream" && !value.empty()) {
+            settings.capture.stream = value;
+        } else if (name == "gpu-budget" && parseNumber(value, settings.gpuBudget, 0.0)) {
+            continue;
+        } else if (name == "min-scale" && parseNumber(value, settings.minResolutionScale, 0.1, 1.0)) {
+            continue;
+        } else if (name == "memory-report" && parseInteger(value, settings.memoryReportInterval)) {
+            continue;
+        } else if (name == "memory-budget" && parseNumber(value, settings.memoryBudgetThreshold, 0.0, 1.0)) {
+            continue;
+        } else if (name == "particles" && parseInteger(value, settings.particleCount)) {
+            continue;
+        } else if (name == "objects" && parseInteger(value, settings.objectCount)) {
+            continue;
+        } else if (name == "meshes" && parseInteger(value, settings.staticMeshCount)) {
+            continue;
+        } else if (name == "mesh-churn" && parseInteger(value, settings.meshChurnInterval)) {
+            continue;
+        } else if (name == "redraw" && (value == "continuous" || value == "on-demand")) {
+            settings.onDemandRedraw = value == "on-demand";
+        } else if (name == "culling" && (value == "hiz" || value == "off")) {
+            settings.occlusionCulling = value == "hiz";
+        } else if (name == "lights" && parseInteger(value, settings.lightCount)) {
+            continue;
+        } else if (name == "materials" && parseInteger(value, settings.materialCount)) {
+            continue;
+        } else if (name == "views" && parseInteger(value, settings.viewCount, 1, MaxViewCount)) {
+            continue;
+        } else if (name == "log" && Logger::instance().configure(value)) {
+            settings.logLevels = value;
+        } else if (name == "shader-dir" && !value.empty()) {
+            settings.shaderDirectory = value;
+        } else if (name == "pipeline-stats" && (value == "on" || value == "off")) {
+            settings.pipelineStatistics = value == "on";
+        } else if (name == "perf-check" && !value.empty()) {
+            settings.perfBaseline = value;
+        } else if (name == "perf-record" && !value.empty()) {
+            settings.perfRecord = value;
+        } else if (name == "trace" && !value.empty()) {
+            settings.tracePath = value;
+            settings.traceStartup = true;
+        } else if (name == "record-stream" && !value.empty()) {
+            settings.drawStreamPath = value;
+        } else if (name == "trace-frames" && parseInteger(value, settings.traceFrames, 1)) {
+            continue;
+        } else {
+            std::cerr << "Invalid option: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if ((!settings.perfBaseline.empty() || !settings.perfRecord.empty()) && settings.frameCount == 0) {
+        std::cerr << "--perf-check and --perf-record need --frames" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <cstdint>
+#include <string>
+#include <vulkan/vulkan.hpp>
+
+// Views share the 4 bit view field of draw sort keys.
+const uint32_t MaxViewCount = 16;
+const uint32_t MaxSwapchainImages = 16;
+
+struct CaptureSettings {
+    std::string directory;
+    std::string format = "png";
+    uint32_t interval = 1;
+    std::string hashFile;
+    std::string stream;
+    bool keepHashes = false;
+};
+
+struct ApplicationSettings {
+    vk::PresentModeKHR presentMode = vk::PresentModeKHR::eMailbox;
+    uint32_t swapchainImages = 0;
+    double frameRateLimit = 0.0;
+    uint64_t frameCount = 0;
+    std::string shaderDirectory;
+    double gpuBudget = 0.0;
+    double minResolutionScale = 0.5;
+    uint64_t memoryReportInterval = 0;
+    double memoryBudgetThreshold = 0.9;
+    uint32_t particleCount = 0;
+    uint32_t viewCount = 1;
+    uint32_t objectCount = 0;
+    uint32_t staticMeshCount = 0;
+    uint32_t meshChurnInterval = 0;
+    uint32_t lightCount = 0;
+    uint32_t materialCount = 0;
+    bool occlusionCulling = true;
+    bool onDemandRedraw = false;
+    bool pipelineStatistics = false;
+    std::string logLevels;
+    std::string perfBaseline;
+    std::string perfRecord;
+    std::string tracePath = "trace.json";
+    bool traceStartup = false;
+    std::string drawStreamPath;
+    uint64_t traceFrames = 120;
+    CaptureSettings capture;
+};
+
+bool parseSettings(int argc, char** argv, ApplicationSettings& settings);
+void printUsage(const char* program);
+
+#endif // SETTINGS_H
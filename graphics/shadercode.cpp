@@ -0,0 +1,164 @@
+#include "shadercode.h"
+#include "assetarchive.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "clustered_frag.spv.h"
+#include "clustered_vert.spv.h"
+#include "frag.spv.h"
+#include "hiz_cull_comp.spv.h"
+#include "hiz_reduce_comp.spv.h"
+#include "light_cluster_comp.spv.h"
+#include "material_frag.spv.h"
+#include "objects_vert.spv.h"
+#include "particles_comp.spv.h"
+#include "particles_frag.spv.h"
+#include "particles_vert.spv.h"
+#include "vert.spv.h"
+
+namespace {
+struct EmbeddedShader {
+    const char* name;
+    const uint32_t* words;
+    size_t size;
+};
+
+const EmbeddedShader EmbeddedShaders[] = {
+    { "vert", vert_spv, vert_spv_size },
+    { "frag", frag_spv, frag_spv_size },
+    { "particles_comp", particles_comp_spv, particles_comp_spv_size },
+    { "particles_vert", particles_vert_spv, particles_vert_spv_size },
+    { "particles_frag", particles_frag_spv, particles_frag_spv_size },
+    { "hiz_cull_comp", hiz_cull_comp_spv, hiz_cull_comp_spv_size },
+    { "hiz_reduce_comp", hiz_reduce_comp_spv, hiz_reduce_comp_spv_size },
+    { "objects_vert", objects_vert_spv, objects_vert_spv_size },
+    { "light_cluster_comp", light_cluster_comp_spv, light_cluster_comp_spv_size },
+    { "clustered_vert", clustered_vert_spv, clustered_vert_spv_size },
+    { "clustered_frag", clustered_frag_spv, clustered_frag_spv_size },
+    { "material_frag", material_frag_spv, material_frag_spv_size },
+};
+
+const uint32_t SpirvMagic = 0x07230203;
+const std::string ArchiveExtension = ".pak";
+
+bool isArchivePath(const std::string& path)
+{
+    return path.size() > ArchiveExtension.size() && path.compare(path.size() - ArchiveExtension.size(), ArchiveExtension.size(), ArchiveExtension) == 0;
+}
+
+// Archives stay mapped until exit, so uncompressed shaders are used in place.
+AssetArchive* openArchive(const std::string& path)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::unique_ptr<AssetArchive>> archives;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<AssetArchive>& archive = archives[path];
+    if (!archive) {
+        archive.reset(new AssetArchive());
+        if (!archive->open(path)) {
+            archives.erase(path);
+            return nullptr;
+        }
+    }
+    return archive.get();
+}
+
+bool findArchivedShader(const std::string& path, const std::string& name, std::vector<uint32_t>& storage, ShaderCode& code)
+{
+    AssetArchive* archive = openArchive(path);
+    const ArchiveEntry* entry = archive ? archive->find(name + ".spv") : nullptr;
+    if (!entry) {
+        return false;
+    }
+    if (entry->size == 0 || entry->size % sizeof(uint32_t) != 0) {
+        std::cerr << "Invalid SPIR-V size for [" << name << "] in [" << path << "]: " << entry->size << std::endl;
+        return false;
+    }
+
+    const char* data;
+    size_t size;
+    std::vector<char> contents;
+    if (!archive->view(*entry, data, size)) {
+        if (!archive->read(*entry, contents)) {
+            std::cerr << "Failed to decompress [" << name << "] from [" << path << "]" << std::endl;
+            return false;
+        }
+        storage.resize(contents.size() / sizeof(uint32_t));
+        std::memcpy(storage.data(), contents.data(), contents.size());
+        data = reinterpret_cast<const char*>(storage.data());
+        size = contents.size();
+    }
+    code.words = reinterpret_cast<const uint32_t*>(data);
+    code.size = size;
+    if (code.words[0] != SpirvMagic) {
+        std::cerr << "Invalid SPIR-V magic for [" << name << "] in [" << path << "]" << std::endl;
+        return false;
+    }
+    return true;
+}
+}
+
+bool findEmbeddedShader(const std::string& name, ShaderCode& code)
+{
+    for (const EmbeddedShader& shader : EmbeddedShaders) {
+        if (name == shader.name && shader.size != 0) {
+            code.words = shader.words;
+            code.size = shader.size;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool findShader(const std::string& overrideDirectory, const std::string& name, std::vector<uint32_t>& storage, ShaderCode& code)
+{
+    if (overrideDirectory.empty()) {
+        return findEmbeddedShader(name, code);
+    }
+    if (isArchivePath(overrideDirectory)) {
+        return findArchivedShader(overrideDirectory, name, storage, code);
+    }
+
+    std::string path = overrideDirectory + "/" + name + ".spv";
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::streamoff fileSize = file.tellg();
+    if (fileSize <= 0 || fileSize % sizeof(uint32_t) != 0) {
+        std::cerr << "Invalid SPIR-V size in [" << path << "]: " << fileSize << std::endl;
+        return false;
+    }
+    storage.resize(static_cast<size_t>(fileSize) / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(storage.data()), fileSize);
+    if (!file || file.gcount() != fileSize) {
+        std::cerr << "Failed to read SPIR-V: [" << path << "]" << std::endl;
+        return false;
+    }
+    if (storage[0] != SpirvMagic) {
+        std::cerr << "Invalid SPIR-V magic in [" << path << "]" << std::endl;
+        return false;
+    }
+
+    code.words = storage.data();
+    code.size = static_cast<size_t>(fileSize);
+    return true;
+}
+
+ShaderCode loadShader(const std::string& overrideDirectory, const std::string& name, std::vector<uint32_t>& storage)
+{
+    ShaderCode code;
+    if (!findShader(overrideDirectory, name, storage, code)) {
+        std::cerr << "Failed to load shader [" << name << "]" << (overrideDirectory.empty() ? std::string() : " from " + overrideDirectory) << std::endl;
+        std::abort();
+    }
+    return code;
+}
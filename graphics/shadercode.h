@@ -0,0 +1,23 @@
+#ifndef SHADERCODE_H
+#define SHADERCODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// SPIR-V words for a shader module. Points either into the binary (embedded
+// at build time) or into caller-owned storage loaded from an override directory.
+struct ShaderCode {
+    const uint32_t* words = nullptr;
+    size_t size = 0;
+};
+
+bool findEmbeddedShader(const std::string& name, ShaderCode& code);
+// Looks in overrideDirectory when it is set, otherwise in the embedded shaders.
+// An overrideDirectory ending in .pak is read as an archive of <name>.spv
+// entries; uncompressed entries are used in place without touching storage.
+bool findShader(const std::string& overrideDirectory, const std::string& name, std::vector<uint32_t>& storage, ShaderCode& code);
+ShaderCode loadShader(const std::string& overrideDirectory, const std::string& name, std::vector<uint32_t>& storage);
+
+#endif // SHADERCODE_H
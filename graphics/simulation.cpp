@@ -0,0 +1,139 @@
+#include "simulation.h"
+#include "tracer.h"
+
+#include <algorithm>
+
+namespace {
+const double RotationSpeed = 3.14159265358979323846 / 2.0;
+const int MaxTickLag = 8;
+}
+
+Simulation::Simulation(double tickRate)
+    : _tickInterval(1.0 / tickRate)
+    , _running(false)
+    , _paused(false)
+    , _hasSnapshot(false)
+{
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::start()
+{
+    if (_running.exchange(true)) {
+        return;
+    }
+    _thread = std::thread(&Simulation::threadMain, this);
+}
+
+void Simulation::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_pauseMutex);
+        _running = false;
+    }
+    _pauseCondition.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+bool Simulation::isRunning() const
+{
+    return _running;
+}
+
+void Simulation::setPaused(bool paused)
+{
+    {
+        std::lock_guard<std::mutex> lock(_pauseMutex);
+        _paused = paused;
+    }
+    _pauseCondition.notify_all();
+}
+
+bool Simulation::isPaused() const
+{
+    return _paused;
+}
+
+double Simulation::tickInterval() const
+{
+    return _tickInterval;
+}
+
+SimulationState Simulation::interpolatedState()
+{
+    if (_snapshots.update()) {
+        _hasSnapshot = true;
+    }
+    if (!_hasSnapshot) {
+        return SimulationState();
+    }
+
+    const SimulationSnapshot& snapshot = _snapshots.readBuffer();
+    std::chrono::duration<double> sinceTick = std::chrono::steady_clock::now() - snapshot.tickTime;
+    double alpha = std::min(std::max(sinceTick.count() / _tickInterval, 0.0), 1.0);
+
+    SimulationState state = snapshot.current;
+    state.time = snapshot.previous.time + (snapshot.current.time - snapshot.previous.time) * alpha;
+    state.rotation = snapshot.previous.rotation + (snapshot.current.rotation - snapshot.previous.rotation) * alpha;
+    return state;
+}
+
+void Simulation::threadMain()
+{
+    Tracer::instance().setThreadName("simulation");
+    typedef std::chrono::steady_clock Clock;
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_tickInterval));
+
+    SimulationState previous;
+    SimulationState current;
+    auto nextTick = Clock::now();
+
+    while (_running) {
+        if (_paused) {
+            // Publish a settled snapshot so interpolation stops where it is.
+            SimulationSnapshot& snapshot = _snapshots.writeBuffer();
+            snapshot.previous = current;
+            snapshot.current = current;
+            snapshot.tickTime = Clock::now();
+            _snapshots.publish();
+
+            std::unique_lock<std::mutex> lock(_pauseMutex);
+            _pauseCondition.wait(lock, [this]() { return !_paused || !_running; });
+            previous = current;
+            nextTick = Clock::now();
+            continue;
+        }
+        previous = current;
+        {
+            TRACE_SCOPE("simulation tick");
+            step(current, _tickInterval);
+        }
+
+        SimulationSnapshot& snapshot = _snapshots.writeBuffer();
+        snapshot.previous = previous;
+        snapshot.current = current;
+        snapshot.tickTime = Clock::now();
+        _snapshots.publish();
+
+        nextTick += interval;
+        auto now = Clock::now();
+        if (now > nextTick + interval * MaxTickLag) {
+            // Too far behind to catch up; drop the backlog instead of spiralling.
+            nextTick = now;
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+void Simulation::step(SimulationState& state, double dt) const
+{
+    state.tick++;
+    state.time += dt;
+    state.rotation += RotationSpeed * dt;
+}
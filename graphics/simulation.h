@@ -0,0 +1,53 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "triplebuffer.h"
+
+struct SimulationState {
+    uint64_t tick = 0;
+    double time = 0.0;
+    double rotation = 0.0;
+};
+
+struct SimulationSnapshot {
+    SimulationState previous;
+    SimulationState current;
+    std::chrono::steady_clock::time_point tickTime;
+};
+
+class Simulation {
+public:
+    explicit Simulation(double tickRate = 60.0);
+    ~Simulation();
+
+    void start();
+    void stop();
+    bool isRunning() const;
+    // A paused simulation holds its state and its thread sleeps until resumed.
+    void setPaused(bool paused);
+    bool isPaused() const;
+    double tickInterval() const;
+    SimulationState interpolatedState();
+
+private:
+    void threadMain();
+    void step(SimulationState& state, double dt) const;
+
+    double _tickInterval;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<bool> _paused;
+    std::mutex _pauseMutex;
+    std::condition_variable _pauseCondition;
+    TripleBuffer<SimulationSnapshot> _snapshots;
+    bool _hasSnapshot;
+};
+
+#endif // SIMULATION_H
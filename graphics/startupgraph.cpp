@@ -0,0 +1,121 @@
+#include "startupgraph.h"
+#include "jobsystem.h"
+#include "tracer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+namespace {
+double milliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+}
+
+StartupStep StartupGraph::addStep(const std::string& name, std::initializer_list<StartupStep> dependencies, std::function<void()> function)
+{
+    StartupStep index = _steps.size();
+    std::unique_ptr<Step> step(new Step());
+    step->name = name;
+    step->traceName = Tracer::instance().intern(name);
+    step->dependencies.assign(dependencies.begin(), dependencies.end());
+    step->function = std::move(function);
+    step->remaining = dependencies.size();
+    for (StartupStep dependency : dependencies) {
+        _steps[dependency]->dependents.push_back(index);
+    }
+    _steps.push_back(std::move(step));
+    return index;
+}
+
+void StartupGraph::run(JobSystem& jobs)
+{
+    _start = Clock::now();
+    JobCounter counter;
+    for (StartupStep i = 0; i < _steps.size(); i++) {
+        if (_steps[i]->dependencies.empty()) {
+            schedule(jobs, counter, i);
+        }
+    }
+    jobs.wait(counter);
+    _end = Clock::now();
+}
+
+void StartupGraph::schedule(JobSystem& jobs, JobCounter& counter, StartupStep step)
+{
+    JobSystem* system = &jobs;
+    JobCounter* done = &counter;
+    jobs.run([this, system, done, step]() { execute(*system, *done, step); }, &counter);
+}
+
+void StartupGraph::execute(JobSystem& jobs, JobCounter& counter, StartupStep index)
+{
+    Step& step = *_steps[index];
+    step.thread = std::this_thread::get_id();
+    step.start = Clock::now();
+    {
+        TRACE_SCOPE(step.traceName);
+        step.function();
+    }
+    step.end = Clock::now();
+
+    // Dependents are queued before this job retires, so the counter cannot drain early.
+    for (StartupStep dependent : step.dependents) {
+        if (_steps[dependent]->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            schedule(jobs, counter, dependent);
+        }
+    }
+}
+
+double StartupGraph::wallTime() const
+{
+    return milliseconds(_end - _start);
+}
+
+double StartupGraph::serialTime() const
+{
+    double total = 0.0;
+    for (const std::unique_ptr<Step>& step : _steps) {
+        total += milliseconds(step->end - step->start);
+    }
+    return total;
+}
+
+double StartupGraph::criticalPathTime() const
+{
+    // Steps are added after their dependencies, so one forward pass suffices.
+    std::vector<double> finish(_steps.size(), 0.0);
+    double longest = 0.0;
+    for (StartupStep i = 0; i < _steps.size(); i++) {
+        double ready = 0.0;
+        for (StartupStep dependency : _steps[i]->dependencies) {
+            ready = std::max(ready, finish[dependency]);
+        }
+        finish[i] = ready + milliseconds(_steps[i]->end - _steps[i]->start);
+        longest = std::max(longest, finish[i]);
+    }
+    return longest;
+}
+
+void StartupGraph::report(std::ostream& stream) const
+{
+    std::vector<const Step*> ordered;
+    for (const std::unique_ptr<Step>& step : _steps) {
+        ordered.push_back(step.get());
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const Step* a, const Step* b) { return a->start < b->start; });
+
+    std::map<std::thread::id, size_t> threads;
+    for (const Step* step : ordered) {
+        threads.insert(std::make_pair(step->thread, threads.size()));
+    }
+
+    stream << std::fixed << std::setprecision(3);
+    stream << "[startup] " << std::setw(26) << std::left << "step" << std::right << std::setw(10) << "start ms" << std::setw(10) << "time ms" << std::setw(8) << "thread" << std::endl;
+    for (const Step* step : ordered) {
+        stream << "[startup] " << std::setw(26) << std::left << step->name << std::right << std::setw(10) << milliseconds(step->start - _start) << std::setw(10) << milliseconds(step->end - step->start) << std::setw(8) << threads[step->thread] << std::endl;
+    }
+    stream << "[startup] wall " << wallTime() << " ms, serial " << serialTime() << " ms, critical path " << criticalPathTime() << " ms" << std::endl;
+    stream.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,55 @@
+#ifndef STARTUPGRAPH_H
+#define STARTUPGRAPH_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+class JobSystem;
+
+typedef size_t StartupStep;
+
+// Dependency-ordered initialization. Steps become runnable as soon as all of
+// their dependencies have finished, and independent steps run concurrently
+// on the job system. Every step is timed for the startup report.
+class StartupGraph {
+public:
+    StartupStep addStep(const std::string& name, std::initializer_list<StartupStep> dependencies, std::function<void()> function);
+    void run(JobSystem& jobs);
+
+    double wallTime() const;
+    double serialTime() const;
+    double criticalPathTime() const;
+    void report(std::ostream& stream) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Step {
+        std::string name;
+        const char* traceName;
+        std::vector<StartupStep> dependencies;
+        std::vector<StartupStep> dependents;
+        std::function<void()> function;
+        std::atomic<size_t> remaining;
+        Clock::time_point start;
+        Clock::time_point end;
+        std::thread::id thread;
+    };
+
+    void schedule(JobSystem& jobs, JobCounter& counter, StartupStep step);
+    void execute(JobSystem& jobs, JobCounter& counter, StartupStep step);
+
+    std::vector<std::unique_ptr<Step>> _steps;
+    Clock::time_point _start;
+    Clock::time_point _end;
+};
+
+#endif // STARTUPGRAPH_H
@@ -0,0 +1,203 @@
+#include "tracer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace {
+thread_local TraceBuffer* t_traceBuffer = nullptr;
+
+double steadyNanoseconds()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void writeEvent(std::ostream& stream, const char* name, uint32_t threadId, double begin, double end)
+{
+    stream << ",\n{\"name\":\"";
+    for (const char* c = name; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            stream << '\\';
+        }
+        stream << *c;
+    }
+    stream << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId << ",\"ts\":" << begin / 1000.0 << ",\"dur\":" << std::max(end - begin, 0.0) / 1000.0 << "}";
+}
+}
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+    : _capturing(false)
+    , _capture(0)
+    , _startTimestamp(0)
+    , _stopTimestamp(0)
+    , _startNanoseconds(0.0)
+    , _stopNanoseconds(0.0)
+{
+}
+
+void Tracer::start()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _gpuEvents.clear();
+    _capture.fetch_add(1, std::memory_order_relaxed);
+    _startNanoseconds = steadyNanoseconds();
+    _startTimestamp = traceTimestamp();
+    _capturing.store(true, std::memory_order_release);
+}
+
+void Tracer::stop()
+{
+    _capturing.store(false, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopTimestamp = traceTimestamp();
+    _stopNanoseconds = steadyNanoseconds();
+}
+
+TraceBuffer& Tracer::threadBuffer()
+{
+    if (!t_traceBuffer) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer()));
+        t_traceBuffer = _buffers.back().get();
+        // Thread 0 is the GPU.
+        t_traceBuffer->threadId = static_cast<uint32_t>(_buffers.size());
+    }
+    return *t_traceBuffer;
+}
+
+void Tracer::record(const char* name, uint64_t begin, uint64_t end)
+{
+    TraceBuffer& buffer = threadBuffer();
+    uint32_t capture = _capture.load(std::memory_order_relaxed);
+    if (buffer.capture.load(std::memory_order_relaxed) != capture) {
+        if (!buffer.events) {
+            buffer.events.reset(new TraceEvent[TraceBufferSize]);
+        }
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.dropped.store(0, std::memory_order_relaxed);
+        buffer.capture.store(capture, std::memory_order_release);
+    }
+    size_t count = buffer.count.load(std::memory_order_relaxed);
+    if (count == TraceBufferSize) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent& event = buffer.events[count];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    buffer.count.store(count + 1, std::memory_order_release);
+}
+
+void Tracer::recordGpu(const char* name, uint64_t gpuBegin, uint64_t gpuEnd, uint64_t submitted)
+{
+    GpuEvent event;
+    event.name = name;
+    event.begin = gpuBegin;
+    event.end = gpuEnd;
+    event.submitted = submitted;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _gpuEvents.push_back(event);
+}
+
+void Tracer::setThreadName(const std::string& name)
+{
+    TraceBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(_mutex);
+    buffer.threadName = name;
+}
+
+const char* Tracer::intern(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _names.insert(name).first->c_str();
+}
+
+double Tracer::nanoseconds(uint64_t timestamp) const
+{
+    double ticks = static_cast<double>(_stopTimestamp - _startTimestamp);
+    double scale = ticks > 0.0 ? (_stopNanoseconds - _startNanoseconds) / ticks : 1.0;
+    return _startNanoseconds + static_cast<double>(static_cast<int64_t>(timestamp - _startTimestamp)) * scale;
+}
+
+bool Tracer::write(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open trace file: [" << path << "]" << std::endl;
+        return false;
+    }
+    write(file);
+    return static_cast<bool>(file);
+}
+
+void Tracer::write(std::ostream& stream) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint32_t capture = _capture.load(std::memory_order_relaxed);
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+    for (const std::unique_ptr<TraceBuffer>& buffer : _buffers) {
+        std::string name = buffer->threadName.empty() ? "thread " + std::to_string(buffer->threadId) : buffer->threadName;
+        stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":\"" << name << "\"}}";
+        if (buffer->capture.load(std::memory_order_acquire) != capture) {
+            continue;
+        }
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent& event = buffer->events[i];
+            // Spans that began before this capture started belong to no capture.
+            if (static_cast<int64_t>(event.begin - _startTimestamp) < 0) {
+                continue;
+            }
+            writeEvent(stream, event.name, buffer->threadId, nanoseconds(event.begin) - _startNanoseconds, nanoseconds(event.end) - _startNanoseconds);
+        }
+    }
+
+    if (!_gpuEvents.empty()) {
+        double offset = -std::numeric_limits<double>::max();
+        for (const GpuEvent& event : _gpuEvents) {
+            offset = std::max(offset, nanoseconds(event.submitted) - static_cast<double>(event.begin));
+        }
+        for (const GpuEvent& event : _gpuEvents) {
+            writeEvent(stream, event.name, 0, static_cast<double>(event.begin) + offset - _startNanoseconds, static_cast<double>(event.end) + offset - _startNanoseconds);
+        }
+    }
+    stream << "\n]}\n";
+    stream.unsetf(std::ios::floatfield);
+}
+
+size_t Tracer::eventCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint32_t capture = _capture.load(std::memory_order_relaxed);
+    size_t count = _gpuEvents.size();
+    for (const std::unique_ptr<TraceBuffer>& buffer : _buffers) {
+        if (buffer->capture.load(std::memory_order_acquire) == capture) {
+            count += buffer->count.load(std::memory_order_acquire);
+        }
+    }
+    return count;
+}
+
+uint64_t Tracer::droppedCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint32_t capture = _capture.load(std::memory_order_relaxed);
+    uint64_t dropped = 0;
+    for (const std::unique_ptr<TraceBuffer>& buffer : _buffers) {
+        if (buffer->capture.load(std::memory_order_acquire) == capture) {
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    return dropped;
+}
@@ -0,0 +1,144 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+const size_t TraceBufferSize = 1 << 16;
+
+// Raw timestamp for trace spans: the TSC where there is one, otherwise steady
+// clock nanoseconds. Converted to nanoseconds when a capture is written.
+inline uint64_t traceTimestamp()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+struct TraceEvent {
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// Spans of one thread. Only the owning thread writes and it resets the buffer
+// itself when a new capture starts, so recording takes no lock; the writer
+// reads the first count events of buffers that belong to the last capture.
+struct TraceBuffer {
+    std::string threadName;
+    uint32_t threadId = 0;
+    std::atomic<uint32_t> capture;
+    std::atomic<size_t> count;
+    std::atomic<uint64_t> dropped;
+    std::unique_ptr<TraceEvent[]> events;
+
+    TraceBuffer()
+        : capture(0)
+        , count(0)
+        , dropped(0)
+    {
+    }
+};
+
+// Collects CPU spans between start() and stop() and writes them as Chrome
+// trace event JSON, which chrome://tracing and Perfetto open. GPU spans are
+// placed on the same timeline: GPU clocks have their own epoch, so they are
+// shifted by the smallest offset that starts none of them before its command
+// buffer was submitted.
+class Tracer {
+public:
+    static Tracer& instance();
+
+    void start();
+    void stop();
+    bool isCapturing() const
+    {
+        return _capturing.load(std::memory_order_relaxed);
+    }
+
+    void record(const char* name, uint64_t begin, uint64_t end);
+    // gpuBegin and gpuEnd are GPU timestamps in nanoseconds, submitted is the
+    // traceTimestamp() taken when the work was submitted.
+    void recordGpu(const char* name, uint64_t gpuBegin, uint64_t gpuEnd, uint64_t submitted);
+    void setThreadName(const std::string& name);
+    // Span names must outlive the capture; this keeps a copy that does.
+    const char* intern(const std::string& name);
+
+    bool write(const std::string& path) const;
+    void write(std::ostream& stream) const;
+    size_t eventCount() const;
+    uint64_t droppedCount() const;
+
+private:
+    struct GpuEvent {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+        uint64_t submitted;
+    };
+
+    Tracer();
+    TraceBuffer& threadBuffer();
+    double nanoseconds(uint64_t timestamp) const;
+
+    std::atomic<bool> _capturing;
+    std::atomic<uint32_t> _capture;
+    mutable std::mutex _mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> _buffers;
+    std::vector<GpuEvent> _gpuEvents;
+    std::set<std::string> _names;
+    // Timestamps and steady clock nanoseconds at start and stop, to convert
+    // TSC ticks.
+    uint64_t _startTimestamp;
+    uint64_t _stopTimestamp;
+    double _startNanoseconds;
+    double _stopNanoseconds;
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name)
+        : _name(name)
+        , _begin(Tracer::instance().isCapturing() ? traceTimestamp() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (_begin != 0) {
+            Tracer::instance().record(_name, _begin, traceTimestamp());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* _name;
+    uint64_t _begin;
+};
+
+// Spans compile to nothing unless the engine is configured with ENGINE_TRACING.
+#ifdef ENGINE_TRACING
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif // TRACER_H
@@ -0,0 +1,244 @@
+#include "transformhierarchy.h"
+#include "jobsystem.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define TRANSFORM_USE_SSE
+#endif
+
+namespace {
+void composeTRS(const glm::vec3& t, const glm::quat& q, const glm::vec3& s, glm::mat4& out)
+{
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    out[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x, 2.0f * (xz - wy) * s.x, 0.0f);
+    out[1] = glm::vec4(2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz + wx) * s.y, 0.0f);
+    out[2] = glm::vec4(2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z, (1.0f - 2.0f * (xx + yy)) * s.z, 0.0f);
+    out[3] = glm::vec4(t, 1.0f);
+}
+
+void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#ifdef TRANSFORM_USE_SSE
+    const float* pa = &a[0][0];
+    const float* pb = &b[0][0];
+    float* po = &out[0][0];
+    __m128 a0 = _mm_loadu_ps(pa);
+    __m128 a1 = _mm_loadu_ps(pa + 4);
+    __m128 a2 = _mm_loadu_ps(pa + 8);
+    __m128 a3 = _mm_loadu_ps(pa + 12);
+    for (int column = 0; column < 4; column++) {
+        const float* bc = pb + column * 4;
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+        _mm_storeu_ps(po + column * 4, r);
+    }
+#else
+    out = a * b;
+#endif
+}
+}
+
+TransformHierarchy::TransformHierarchy()
+    : _levelOrdered(false)
+    , _lastUpdatedCount(0)
+{
+}
+
+TransformHandle TransformHierarchy::create(TransformHandle parent)
+{
+    uint32_t index = static_cast<uint32_t>(_parents.size());
+    TransformHandle handle = static_cast<TransformHandle>(_indices.size());
+
+    int32_t parentIndex = -1;
+    uint32_t depth = 0;
+    if (parent != InvalidTransform) {
+        parentIndex = static_cast<int32_t>(_indices[parent]);
+        depth = _depths[static_cast<size_t>(parentIndex)] + 1;
+    }
+    _levelOrdered = false;
+
+    _positions.push_back(glm::vec3(0.0f));
+    _rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    _scales.push_back(glm::vec3(1.0f));
+    _parents.push_back(parentIndex);
+    _depths.push_back(depth);
+    _world.push_back(glm::mat4(1.0f));
+    _flags.push_back(LocalDirty);
+    _handles.push_back(handle);
+    _indices.push_back(index);
+    return handle;
+}
+
+void TransformHierarchy::reserve(size_t count)
+{
+    _positions.reserve(count);
+    _rotations.reserve(count);
+    _scales.reserve(count);
+    _parents.reserve(count);
+    _depths.reserve(count);
+    _world.reserve(count);
+    _flags.reserve(count);
+    _handles.reserve(count);
+    _indices.reserve(count);
+}
+
+size_t TransformHierarchy::size() const
+{
+    return _parents.size();
+}
+
+void TransformHierarchy::markDirty(TransformHandle handle)
+{
+    _flags[_indices[handle]] |= LocalDirty;
+}
+
+void TransformHierarchy::setPosition(TransformHandle handle, const glm::vec3& position)
+{
+    _positions[_indices[handle]] = position;
+    markDirty(handle);
+}
+
+void TransformHierarchy::setRotation(TransformHandle handle, const glm::quat& rotation)
+{
+    _rotations[_indices[handle]] = rotation;
+    markDirty(handle);
+}
+
+void TransformHierarchy::setScale(TransformHandle handle, const glm::vec3& scale)
+{
+    _scales[_indices[handle]] = scale;
+    markDirty(handle);
+}
+
+void TransformHierarchy::setLocal(TransformHandle handle, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    uint32_t index = _indices[handle];
+    _positions[index] = position;
+    _rotations[index] = rotation;
+    _scales[index] = scale;
+    _flags[index] |= LocalDirty;
+}
+
+const glm::mat4& TransformHierarchy::world(TransformHandle handle) const
+{
+    return _world[_indices[handle]];
+}
+
+size_t TransformHierarchy::lastUpdatedCount() const
+{
+    return _lastUpdatedCount;
+}
+
+size_t TransformHierarchy::updateRange(size_t begin, size_t end)
+{
+    size_t updated = 0;
+    glm::mat4 local;
+    for (size_t i = begin; i < end; i++) {
+        int32_t parent = _parents[i];
+        bool changed = (_flags[i] & LocalDirty) || (parent >= 0 && (_flags[static_cast<size_t>(parent)] & WorldChanged));
+        if (!changed) {
+            _flags[i] = 0;
+            continue;
+        }
+
+        composeTRS(_positions[i], _rotations[i], _scales[i], local);
+        if (parent >= 0) {
+            multiply(_world[static_cast<size_t>(parent)], local, _world[i]);
+        } else {
+            _world[i] = local;
+        }
+        _flags[i] = WorldChanged;
+        updated++;
+    }
+    return updated;
+}
+
+void TransformHierarchy::update()
+{
+    _lastUpdatedCount = updateRange(0, _parents.size());
+}
+
+void TransformHierarchy::update(JobSystem& jobs, size_t grain)
+{
+    if (!_levelOrdered) {
+        sortByDepth();
+    }
+
+    std::atomic<size_t> updated(0);
+    for (size_t level = 0; level + 1 < _levelOffsets.size(); level++) {
+        size_t begin = _levelOffsets[level];
+        size_t end = _levelOffsets[level + 1];
+        if (end - begin <= grain) {
+            updated += updateRange(begin, end);
+            continue;
+        }
+        jobs.parallelFor(end - begin, grain, [this, begin, &updated](size_t first, size_t last) {
+            updated.fetch_add(updateRange(begin + first, begin + last), std::memory_order_relaxed);
+        });
+    }
+    _lastUpdatedCount = updated;
+}
+
+void TransformHierarchy::sortByDepth()
+{
+    size_t count = _parents.size();
+    uint32_t maxDepth = 0;
+    for (uint32_t depth : _depths) {
+        maxDepth = std::max(maxDepth, depth);
+    }
+
+    // Counting sort by depth; stable, so the result is still topologically ordered.
+    _levelOffsets.assign(maxDepth + 2, 0);
+    for (uint32_t depth : _depths) {
+        _levelOffsets[depth + 1]++;
+    }
+    for (size_t level = 1; level < _levelOffsets.size(); level++) {
+        _levelOffsets[level] += _levelOffsets[level - 1];
+    }
+
+    std::vector<uint32_t> remap(count);
+    std::vector<size_t> cursor(_levelOffsets.begin(), _levelOffsets.end() - 1);
+    for (size_t i = 0; i < count; i++) {
+        remap[i] = static_cast<uint32_t>(cursor[_depths[i]]++);
+    }
+
+    std::vector<glm::vec3> positions(count);
+    std::vector<glm::quat> rotations(count);
+    std::vector<glm::vec3> scales(count);
+    std::vector<int32_t> parents(count);
+    std::vector<uint32_t> depths(count);
+    std::vector<glm::mat4> world(count);
+    std::vector<uint8_t> flags(count);
+    std::vector<TransformHandle> handles(count);
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t target = remap[i];
+        positions[target] = _positions[i];
+        rotations[target] = _rotations[i];
+        scales[target] = _scales[i];
+        parents[target] = _parents[i] >= 0 ? static_cast<int32_t>(remap[static_cast<size_t>(_parents[i])]) : -1;
+        depths[target] = _depths[i];
+        world[target] = _world[i];
+        flags[target] = _flags[i];
+        handles[target] = _handles[i];
+        _indices[_handles[i]] = target;
+    }
+
+    _positions.swap(positions);
+    _rotations.swap(rotations);
+    _scales.swap(scales);
+    _parents.swap(parents);
+    _depths.swap(depths);
+    _world.swap(world);
+    _flags.swap(flags);
+    _handles.swap(handles);
+    _levelOrdered = true;
+}
@@ -0,0 +1,63 @@
+#ifndef TRANSFORMHIERARCHY_H
+#define TRANSFORMHIERARCHY_H
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+class JobSystem;
+
+typedef uint32_t TransformHandle;
+const TransformHandle InvalidTransform = 0xffffffffu;
+
+// Local TRS and parent links stored as structure-of-arrays. Parents always
+// precede their children, so world matrices are resolved in one linear pass
+// and only subtrees below a changed node are recomputed.
+class TransformHierarchy {
+public:
+    TransformHierarchy();
+
+    TransformHandle create(TransformHandle parent = InvalidTransform);
+    void reserve(size_t count);
+    size_t size() const;
+
+    void setPosition(TransformHandle handle, const glm::vec3& position);
+    void setRotation(TransformHandle handle, const glm::quat& rotation);
+    void setScale(TransformHandle handle, const glm::vec3& scale);
+    void setLocal(TransformHandle handle, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+    const glm::mat4& world(TransformHandle handle) const;
+
+    void update();
+    // Level-ordered parallel update; nodes of one depth are split across workers.
+    void update(JobSystem& jobs, size_t grain = 4096);
+    size_t lastUpdatedCount() const;
+
+private:
+    enum Flags : uint8_t {
+        LocalDirty = 0x1,
+        WorldChanged = 0x2
+    };
+
+    void markDirty(TransformHandle handle);
+    void sortByDepth();
+    size_t updateRange(size_t begin, size_t end);
+
+    std::vector<glm::vec3> _positions;
+    std::vector<glm::quat> _rotations;
+    std::vector<glm::vec3> _scales;
+    std::vector<int32_t> _parents;
+    std::vector<uint32_t> _depths;
+    std::vector<glm::mat4> _world;
+    std::vector<uint8_t> _flags;
+
+    std::vector<TransformHandle> _handles;
+    std::vector<uint32_t> _indices;
+    std::vector<size_t> _levelOffsets;
+    bool _levelOrdered;
+    size_t _lastUpdatedCount;
+};
+
+#endif // TRANSFORMHIERARCHY_H
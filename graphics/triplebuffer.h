@@ -0,0 +1,56 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Single producer / single consumer triple buffer. The writer always owns one
+// slot, the reader another, and the third is swapped through an atomic index
+// so neither side ever waits for the other.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+        : _middle(1)
+        , _writeIndex(0)
+        , _readIndex(2)
+    {
+    }
+
+    T& writeBuffer()
+    {
+        return _buffers[_writeIndex];
+    }
+
+    void publish()
+    {
+        uint8_t previous = _middle.exchange(static_cast<uint8_t>(_writeIndex | DirtyBit), std::memory_order_acq_rel);
+        _writeIndex = previous & IndexMask;
+    }
+
+    bool update()
+    {
+        if ((_middle.load(std::memory_order_relaxed) & DirtyBit) == 0) {
+            return false;
+        }
+        uint8_t previous = _middle.exchange(_readIndex, std::memory_order_acq_rel);
+        _readIndex = previous & IndexMask;
+        return true;
+    }
+
+    const T& readBuffer() const
+    {
+        return _buffers[_readIndex];
+    }
+
+private:
+    static const uint8_t IndexMask = 0x3;
+    static const uint8_t DirtyBit = 0x4;
+
+    T _buffers[3];
+    alignas(64) std::atomic<uint8_t> _middle;
+    alignas(64) uint8_t _writeIndex;
+    alignas(64) uint8_t _readIndex;
+};
+
+#endif // TRIPLEBUFFER_H
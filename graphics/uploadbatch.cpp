@@ -0,0 +1,151 @@
+#include "uploadbatch.h"
+#include "helperfunctions.h"
+
+#include <cstring>
+#include <limits>
+
+void UploadBatch::init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker)
+{
+    _device = device;
+    _physicalDevice = physicalDevice;
+    _memoryTracker = &tracker;
+}
+
+void UploadBatch::uploadBuffer(const void* data, vk::DeviceSize size, vk::Buffer destination, vk::DeviceSize destinationOffset)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    BufferUpload upload;
+    upload.destination = destination;
+    upload.destinationOffset = destinationOffset;
+    upload.size = size;
+    createBuffer(_device, _physicalDevice, *_memoryTracker, MemoryCategory::Staging, size, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, upload.stagingBuffer, upload.stagingMemory);
+
+    void* dataPtr = nullptr;
+    vk::Result res = _device.mapMemory(upload.stagingMemory, vk::DeviceSize(0), size, vk::MemoryMapFlags(), &dataPtr);
+    if (res != vk::Result::eSuccess) {
+        std::cerr << "Failed to map memory for staging buffer! error:" << res << std::endl;
+        std::abort();
+    }
+    memcpy(dataPtr, data, static_cast<size_t>(size));
+    _device.unmapMemory(upload.stagingMemory);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _uploads.push_back(upload);
+    _uploadedBytes += size;
+    _uploadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void UploadBatch::copyBuffer(vk::Buffer source, vk::DeviceSize sourceOffset, vk::Buffer destination, vk::DeviceSize destinationOffset, vk::DeviceSize size)
+{
+    BufferCopy copy;
+    copy.source = source;
+    copy.destination = destination;
+    copy.region = vk::BufferCopy(sourceOffset, destinationOffset, size);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _copies.push_back(copy);
+}
+
+void UploadBatch::fillBuffer(vk::Buffer destination, vk::DeviceSize size, uint32_t value)
+{
+    BufferFill fill;
+    fill.destination = destination;
+    fill.size = size;
+    fill.value = value;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _fills.push_back(fill);
+}
+
+void UploadBatch::transitionImage(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
+{
+    ImageTransition transition;
+    transition.image = image;
+    transition.format = format;
+    transition.oldLayout = oldLayout;
+    transition.newLayout = newLayout;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _transitions.push_back(transition);
+}
+
+size_t UploadBatch::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _uploads.size() + _copies.size() + _fills.size() + _transitions.size();
+}
+
+uint64_t UploadBatch::uploadedBytes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _uploadedBytes;
+}
+
+double UploadBatch::uploadSeconds() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _uploadSeconds;
+}
+
+void UploadBatch::submit(vk::CommandPool commandPool, vk::Queue queue)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_uploads.empty() && _copies.empty() && _fills.empty() && _transitions.empty()) {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    vk::CommandBuffer commandBuffer = beginSingleTimeCommands(_device, commandPool);
+    for (const BufferCopy& copy : _copies) {
+        commandBuffer.copyBuffer(copy.source, copy.destination, 1, &copy.region);
+    }
+    if (!_copies.empty()) {
+        // Uploads may target ranges the copies just vacated.
+        vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferWrite);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+    for (const BufferUpload& upload : _uploads) {
+        vk::BufferCopy copyRegion(0, upload.destinationOffset, upload.size);
+        commandBuffer.copyBuffer(upload.stagingBuffer, upload.destination, 1, &copyRegion);
+    }
+    for (const BufferFill& fill : _fills) {
+        commandBuffer.fillBuffer(fill.destination, 0, fill.size, fill.value);
+    }
+    if (!_uploads.empty() || !_copies.empty() || !_fills.empty()) {
+        vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+    for (const ImageTransition& transition : _transitions) {
+        recordImageLayoutTransition(commandBuffer, transition.image, transition.format, transition.oldLayout, transition.newLayout);
+    }
+    commandBuffer.end();
+
+    vk::FenceCreateInfo fenceCreateInfo;
+    vk::Fence fence;
+    if (_device.createFence(&fenceCreateInfo, nullptr, &fence) != vk::Result::eSuccess) {
+        std::cerr << "Failed to create upload fence!" << std::endl;
+        std::abort();
+    }
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    vk::Result submitRes = queue.submit(1, &submitInfo, fence);
+    if (submitRes != vk::Result::eSuccess) {
+        std::cerr << "Upload submit failed! error:" << submitRes << std::endl;
+        std::abort();
+    }
+    _device.waitForFences(1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    _uploadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    _device.destroyFence(fence);
+    _device.freeCommandBuffers(commandPool, 1, &commandBuffer);
+
+    for (const BufferUpload& upload : _uploads) {
+        _device.destroyBuffer(upload.stagingBuffer);
+        _memoryTracker->free(upload.stagingMemory);
+    }
+    _uploads.clear();
+    _copies.clear();
+    _fills.clear();
+    _transitions.clear();
+}
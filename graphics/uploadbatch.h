@@ -0,0 +1,71 @@
+#ifndef UPLOADBATCH_H
+#define UPLOADBATCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "memorytracker.h"
+
+// Collects buffer uploads and image layout transitions from any thread and
+// flushes them in a single command buffer and queue submission.
+class UploadBatch {
+public:
+    void init(vk::Device device, vk::PhysicalDevice physicalDevice, MemoryTracker& tracker);
+
+    void uploadBuffer(const void* data, vk::DeviceSize size, vk::Buffer destination, vk::DeviceSize destinationOffset = 0);
+    // Device-side copies run before the uploads and fills of the same batch.
+    void copyBuffer(vk::Buffer source, vk::DeviceSize sourceOffset, vk::Buffer destination, vk::DeviceSize destinationOffset, vk::DeviceSize size);
+    void fillBuffer(vk::Buffer destination, vk::DeviceSize size, uint32_t value);
+    void transitionImage(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
+    void submit(vk::CommandPool commandPool, vk::Queue queue);
+
+    size_t pendingCount() const;
+    // Bytes uploaded from the host so far, and the time spent staging and
+    // submitting them.
+    uint64_t uploadedBytes() const;
+    double uploadSeconds() const;
+
+private:
+    struct BufferUpload {
+        vk::Buffer stagingBuffer;
+        vk::DeviceMemory stagingMemory;
+        vk::Buffer destination;
+        vk::DeviceSize destinationOffset;
+        vk::DeviceSize size;
+    };
+
+    struct BufferCopy {
+        vk::Buffer source;
+        vk::Buffer destination;
+        vk::BufferCopy region;
+    };
+
+    struct BufferFill {
+        vk::Buffer destination;
+        vk::DeviceSize size;
+        uint32_t value;
+    };
+
+    struct ImageTransition {
+        vk::Image image;
+        vk::Format format;
+        vk::ImageLayout oldLayout;
+        vk::ImageLayout newLayout;
+    };
+
+    vk::Device _device;
+    vk::PhysicalDevice _physicalDevice;
+    MemoryTracker* _memoryTracker = nullptr;
+    mutable std::mutex _mutex;
+    std::vector<BufferUpload> _uploads;
+    std::vector<BufferCopy> _copies;
+    std::vector<BufferFill> _fills;
+    std::vector<ImageTransition> _transitions;
+    uint64_t _uploadedBytes = 0;
+    double _uploadSeconds = 0.0;
+};
+
+#endif // UPLOADBATCH_H
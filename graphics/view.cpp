@@ -0,0 +1,27 @@
+#include "view.h"
+
+#include <cmath>
+
+glm::mat4 Camera::viewMatrix() const
+{
+    return glm::lookAt(eye, target, up);
+}
+
+glm::mat4 Camera::projectionMatrix(vk::Extent2D extent) const
+{
+    float ratio = static_cast<float>(extent.width) / static_cast<float>(extent.height);
+    glm::mat4 projection = glm::perspective(glm::radians(fieldOfView), ratio, nearPlane, farPlane);
+    projection[1][1] *= -1.0f;
+    return projection;
+}
+
+Camera orbitCamera(uint32_t index, uint32_t count)
+{
+    // Views are spread evenly around the scene; the first keeps the default camera.
+    Camera camera;
+    float angle = 2.0f * glm::pi<float>() * static_cast<float>(index) / static_cast<float>(count);
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    camera.eye = glm::vec3(c * camera.eye.x - s * camera.eye.y, s * camera.eye.x + c * camera.eye.y, camera.eye.z);
+    return camera;
+}
@@ -0,0 +1,59 @@
+#ifndef VIEW_H
+#define VIEW_H
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "attachmentpool.h"
+#include "vertex.h"
+#include "window/window.h"
+
+struct Camera {
+    glm::vec3 eye = glm::vec3(1.0f, 1.0f, 1.0f);
+    glm::vec3 target = glm::vec3(0.0f, 0.0f, 0.0f);
+    glm::vec3 up = glm::vec3(0.0f, 0.0f, 1.0f);
+    float fieldOfView = 46.0f;
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+
+    glm::mat4 viewMatrix() const;
+    glm::mat4 projectionMatrix(vk::Extent2D extent) const;
+};
+
+// A window with its own surface, swap chain, framebuffers and camera. The
+// device, render pass, pipelines and geometry belong to the Application and
+// are shared by every view.
+struct View {
+    Window window;
+    Camera camera;
+    vk::SurfaceKHR surface;
+    vk::SwapchainKHR swapChain;
+    std::vector<vk::Image> images;
+    std::vector<vk::ImageView> imageViews;
+    std::vector<vk::Framebuffer> framebuffers;
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent2D extent;
+    vk::PresentModeKHR presentMode = vk::PresentModeKHR::eFifo;
+    AttachmentHandle depthAttachment = 0;
+
+    // One uniform slot and descriptor set per swap chain image, so a slot is
+    // only rewritten once the frame that read it has retired.
+    vk::Buffer uniformBuffer;
+    vk::DeviceMemory uniformBufferMemory;
+    vk::DeviceSize uniformStride = 0;
+    uint8_t* uniformData = nullptr;
+    std::vector<vk::DescriptorSet> descriptorSets;
+
+    std::vector<vk::CommandBuffer> commandBuffers;
+    std::vector<uint32_t> commandBufferVersions;
+    vk::Semaphore imageAvailableSemaphore;
+    vk::Semaphore renderFinishedSemaphore;
+    // Fence of the frame that last rendered into each swap chain image.
+    std::vector<vk::Fence> imageFences;
+    uint32_t imageIndex = 0;
+};
+
+Camera orbitCamera(uint32_t index, uint32_t count);
+
+#endif // VIEW_H
@@ -3,6 +3,43 @@
 #include "GLFW/glfw3.h"
 #include <iostream>
 
+namespace {
+// GLFW is process wide; it is initialized by the first window and
+// terminated after the last one is destroyed.
+unsigned int glfwWindowCount = 0;
+
+Window* windowOf(GLFWwindow* window)
+{
+    return static_cast<Window*>(glfwGetWindowUserPointer(window));
+}
+
+void onDamage(GLFWwindow* window)
+{
+    windowOf(window)->markDamaged();
+}
+
+void onResize(GLFWwindow* window, int, int)
+{
+    windowOf(window)->markDamaged();
+}
+
+void onIconify(GLFWwindow* window, int)
+{
+    windowOf(window)->markDamaged();
+}
+
+void onKey(GLFWwindow* window, int key, int, int action, int)
+{
+    if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
+        windowOf(window)->requestPause();
+    }
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        windowOf(window)->requestTrace();
+    }
+    windowOf(window)->markDamaged();
+}
+}
+
 uint32_t Window::width() const
 {
     return _width;
@@ -33,6 +70,47 @@ void Window::pollEvents()
     glfwPollEvents();
 }
 
+void Window::waitEvents(double timeoutSeconds)
+{
+    glfwWaitEventsTimeout(timeoutSeconds);
+}
+
+bool Window::takeDamage()
+{
+    bool damaged = _damaged;
+    _damaged = false;
+    return damaged;
+}
+
+bool Window::takePauseRequest()
+{
+    bool requested = _pauseRequested;
+    _pauseRequested = false;
+    return requested;
+}
+
+bool Window::takeTraceRequest()
+{
+    bool requested = _traceRequested;
+    _traceRequested = false;
+    return requested;
+}
+
+void Window::markDamaged()
+{
+    _damaged = true;
+}
+
+void Window::requestPause()
+{
+    _pauseRequested = true;
+}
+
+void Window::requestTrace()
+{
+    _traceRequested = true;
+}
+
 std::vector<const char*> Window::getRequiredExtensions(bool validation)
 {
     std::vector<const char*> extensions;
@@ -49,10 +127,11 @@ std::vector<const char*> Window::getRequiredExtensions(bool validation)
 
 void Window::init()
 {
-    if (!glfwInit()) {
+    if (glfwWindowCount == 0 && !glfwInit()) {
         std::cerr << "Failed to init glfw!" << std::endl;
         std::abort();
     }
+    glfwWindowCount++;
 
     if (!glfwVulkanSupported()) {
         std::cerr << "glfw vulkan not supported!" << std::endl;
@@ -64,13 +143,21 @@ void Window::init()
 
     window = glfwCreateWindow(_width, _height, "Vulkan", nullptr, nullptr);
     assert(window);
+    glfwSetWindowUserPointer(window, this);
+    glfwSetWindowRefreshCallback(window, onDamage);
+    glfwSetFramebufferSizeCallback(window, onResize);
+    glfwSetWindowIconifyCallback(window, onIconify);
+    glfwSetKeyCallback(window, onKey);
 }
 
 void Window::destroy()
 {
     assert(window);
     glfwDestroyWindow(window);
-    glfwTerminate();
+    window = nullptr;
+    if (--glfwWindowCount == 0) {
+        glfwTerminate();
+    }
 }
 
 bool Window::shouldBeClosed()
@@ -98,5 +185,8 @@ Window::Window()
     : _width(1024)
     , _height(768)
     , window(nullptr)
+    , _damaged(false)
+    , _pauseRequested(false)
+    , _traceRequested(false)
 {
 }
@@ -11,6 +11,9 @@ class Window
     uint32_t _width;
     uint32_t _height;
     GLFWwindow* window;
+    bool _damaged;
+    bool _pauseRequested;
+    bool _traceRequested;
 
 public:
     void init();
@@ -25,6 +28,17 @@ public:
     void setWidth(const uint32_t& width);
     GLFWwindow* getWindow() const;
     void pollEvents();
+    // Blocks until an event arrives or the timeout expires.
+    void waitEvents(double timeoutSeconds);
+    // Resize, expose or input since the last call; the contents are stale.
+    bool takeDamage();
+    // Space was pressed since the last call.
+    bool takePauseRequest();
+    // T was pressed since the last call.
+    bool takeTraceRequest();
+    void markDamaged();
+    void requestPause();
+    void requestTrace();
     std::vector<const char*> getRequiredExtensions(bool validation);
 };
 
@@ -1,14 +1,21 @@
 #include "graphics/application.h"
 
-int main() {
-    Application app;
+int main(int argc, char** argv) {
+    ApplicationSettings settings;
+    if (!parseSettings(argc, argv, settings)) {
+        return EXIT_FAILURE;
+    }
+    Logger::instance().start(std::cerr);
+    Application app(settings);
 
+    bool passed;
     try {
-        app.run();
+        passed = app.run();
     } catch (const std::runtime_error& e) {
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
     }
+    Logger::instance().stop();
 
-    return EXIT_SUCCESS;
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,63 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+const uint ClusterCountX = 16;
+const uint ClusterCountY = 9;
+const uint ClusterCountZ = 24;
+const uint MaxLightsPerCluster = 128;
+const float Ambient = 0.15;
+
+struct PointLight {
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Lights {
+    PointLight lights[];
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer ClusterCounts {
+    uint clusterCounts[];
+};
+
+layout(std430, set = 1, binding = 2) readonly buffer ClusterLights {
+    uint clusterLights[];
+};
+
+layout(set = 1, binding = 3) uniform Parameters {
+    mat4 view;
+    mat4 inverseProjection;
+    vec2 screenSize;
+    float nearPlane;
+    float farPlane;
+    uint lightCount;
+} params;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragViewPosition;
+
+layout(location = 0) out vec4 outFragColor;
+
+void main() {
+    // The mesh has no normals; faces are flat, so derive them from the position.
+    vec3 normal = normalize(cross(dFdx(fragViewPosition), dFdy(fragViewPosition)));
+    if (dot(normal, fragViewPosition) > 0.0) {
+        normal = -normal;
+    }
+
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / params.screenSize * vec2(ClusterCountX, ClusterCountY)), uvec2(ClusterCountX - 1, ClusterCountY - 1));
+    float slice = log(max(-fragViewPosition.z, params.nearPlane) / params.nearPlane) / log(params.farPlane / params.nearPlane) * float(ClusterCountZ);
+    uint cluster = tile.x + tile.y * ClusterCountX + min(uint(slice), ClusterCountZ - 1) * ClusterCountX * ClusterCountY;
+
+    vec3 lighting = vec3(Ambient);
+    uint count = clusterCounts[cluster];
+    for (uint i = 0; i < count; i++) {
+        PointLight light = lights[clusterLights[cluster * MaxLightsPerCluster + i]];
+        vec3 toLight = (params.view * vec4(light.positionRadius.xyz, 1.0)).xyz - fragViewPosition;
+        float distance = length(toLight);
+        float falloff = clamp(1.0 - (distance * distance) / (light.positionRadius.w * light.positionRadius.w), 0.0, 1.0);
+        lighting += light.color.rgb * light.color.a * falloff * falloff * max(dot(normal, toLight / max(distance, 1e-4)), 0.0);
+    }
+    outFragColor = vec4(fragColor * lighting, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+struct Material {
+    vec4 baseColor;
+    vec4 emissive;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Materials {
+    Material materials[];
+};
+
+layout(push_constant) uniform Constants {
+    uint materialIndex;
+} constants;
+
+layout(location = 0) out vec4 outFragColor;
+
+void main() {
+    Material material = materials[constants.materialIndex];
+    outFragColor = vec4(fragColor * material.baseColor.rgb + material.emissive.rgb, material.baseColor.a);
+}
@@ -0,0 +1,45 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+struct ObjectData {
+    vec4 position;
+    vec4 color;
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout(std430, set = 1, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer DrawList {
+    uint drawList[];
+};
+
+// Start of the draw list for this draw; indirect draws cannot rely on
+// firstInstance without the drawIndirectFirstInstance feature.
+layout(push_constant) uniform Constants {
+    uint drawListOffset;
+} constants;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+void main() {
+    ObjectData object = objects[drawList[constants.drawListOffset + gl_InstanceIndex]];
+    gl_Position = ubo.proj * ubo.view * vec4(object.position.xyz + inPosition * object.position.w, 1.0);
+    fragColor = inColor * object.color.rgb;
+    fragTexCoord = inTexCoord;
+}
@@ -0,0 +1,24 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inVelocity;
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout(location = 0) out vec3 fragColor;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+    float gl_PointSize;
+};
+
+void main() {
+    gl_Position = ubo.proj * ubo.view * vec4(inPosition.xyz, 1.0);
+    gl_PointSize = 1.0;
+    fragColor = mix(vec3(1.0, 0.3, 0.1), vec3(0.3, 0.7, 1.0), clamp(inPosition.w * 0.5, 0.0, 1.0));
+}
@@ -0,0 +1,95 @@
+#include "assetarchive.h"
+#include "jobsystem.h"
+#include "test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+const char* ArchivePath = "assetarchivetest.pak";
+
+std::vector<char> repetitive(size_t size)
+{
+    std::string text = "layout(location = 0) in vec3 position; ";
+    std::vector<char> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = text[i % text.size()];
+    }
+    return data;
+}
+
+std::vector<char> readFile(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const char* path, const std::vector<char>& data)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+void readsEntries()
+{
+    AssetArchiveWriter writer;
+    std::vector<std::vector<char>> contents;
+    for (size_t i = 0; i < 100; i++) {
+        contents.push_back(repetitive(100 + i * 37));
+        writer.add("asset" + std::to_string(i), contents.back().data(), contents.back().size(), i % 2 == 0);
+    }
+    CHECK(writer.write(ArchivePath));
+
+    AssetArchive archive;
+    CHECK(archive.open(ArchivePath));
+    CHECK(archive.entryCount() == contents.size());
+    CHECK(archive.find("missing") == nullptr);
+    std::vector<const ArchiveEntry*> entries;
+    for (size_t i = 0; i < contents.size(); i++) {
+        const ArchiveEntry* entry = archive.find("asset" + std::to_string(i));
+        CHECK(entry != nullptr);
+        if (entry) {
+            entries.push_back(entry);
+        }
+    }
+    JobSystem jobs(4);
+    std::vector<std::vector<char>> data;
+    CHECK(archive.readAll(jobs, entries, data));
+    CHECK(data == contents);
+}
+
+// A compressed entry cannot claim more than LZ4 could expand it to, so a
+// damaged size never turns into a huge allocation in read().
+void rejectsOversizedEntry()
+{
+    AssetArchiveWriter writer;
+    std::vector<char> content = repetitive(4096);
+    writer.add("shader", content.data(), content.size(), true);
+    CHECK(writer.write(ArchivePath));
+
+    std::vector<char> file = readFile(ArchivePath);
+    ArchiveHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    ArchiveEntry entry;
+    std::memcpy(&entry, file.data() + header.tocOffset, sizeof(entry));
+    CHECK(entry.flags == ArchiveEntryCompressed);
+    entry.size = entry.storedSize * 256;
+    std::memcpy(file.data() + header.tocOffset, &entry, sizeof(entry));
+    writeFile(ArchivePath, file);
+
+    AssetArchive archive;
+    CHECK(!archive.open(ArchivePath));
+}
+}
+
+int main()
+{
+    readsEntries();
+    rejectsOversizedEntry();
+    std::remove(ArchivePath);
+    return testResult();
+}
@@ -0,0 +1,91 @@
+#include "drawlist.h"
+#include "test.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+// Only compared and counted, never passed to a driver.
+template <typename Handle, typename Raw>
+Handle fakeHandle(uint64_t value)
+{
+    Raw raw;
+    std::memcpy(&raw, &value, sizeof(raw));
+    return Handle(raw);
+}
+
+void keyFieldOrder()
+{
+    CHECK(makeSortKey(1, 0, 0, 0, 0, 0.0f) > makeSortKey(0, 15, 4095, 65535, 4095, 1.0f));
+    CHECK(makeSortKey(0, 1, 0, 0, 0, 0.0f) > makeSortKey(0, 0, 4095, 65535, 4095, 1.0f));
+    CHECK(makeSortKey(0, 0, 1, 0, 0, 0.0f) > makeSortKey(0, 0, 0, 65535, 4095, 1.0f));
+    CHECK(makeSortKey(0, 0, 0, 1, 0, 0.0f) > makeSortKey(0, 0, 0, 0, 4095, 1.0f));
+    CHECK(makeSortKey(0, 0, 0, 0, 1, 0.0f) > makeSortKey(0, 0, 0, 0, 0, 1.0f));
+    CHECK(makeSortKey(0, 0, 0, 0, 0, 0.5f) > makeSortKey(0, 0, 0, 0, 0, 0.25f));
+    // Out of range fields saturate instead of spilling into the next field.
+    CHECK(makeSortKey(0, 0, 0, 70000, 0, 0.0f) < makeSortKey(0, 0, 1, 0, 0, 0.0f));
+    CHECK(makeSortKey(0, 0, 0, 0, 0, 2.0f) == makeSortKey(0, 0, 0, 0, 0, 1.0f));
+    CHECK(makeSortKey(0, 0, 0, 0, 0, -1.0f) == makeSortKey(0, 0, 0, 0, 0, 0.0f));
+}
+
+// The radix sort orders by key and keeps equal keys in insertion order.
+void sortsStably()
+{
+    std::mt19937 random(3);
+    DrawList list;
+    std::vector<uint64_t> keys;
+    for (uint32_t i = 0; i < 5000; i++) {
+        uint64_t key = makeSortKey(random() % 2, 0, random() % 4, random() % 8, 0, 0.0f);
+        DrawItem item;
+        item.firstInstance = i;
+        list.add(key, item);
+        keys.push_back(key);
+    }
+    list.sort();
+    bool ordered = true;
+    for (size_t i = 1; i < list.size(); i++) {
+        uint64_t previous = keys[list.sorted(i - 1).firstInstance];
+        uint64_t current = keys[list.sorted(i).firstInstance];
+        ordered = ordered && (previous < current || (previous == current && list.sorted(i - 1).firstInstance < list.sorted(i).firstInstance));
+    }
+    CHECK(ordered);
+}
+
+void skipsRedundantBinds()
+{
+    DrawList list;
+    for (uint32_t i = 0; i < 8; i++) {
+        uint32_t pipeline = i % 2;
+        DrawItem item;
+        item.pipeline = fakeHandle<vk::Pipeline, VkPipeline>(pipeline + 1);
+        item.pipelineLayout = fakeHandle<vk::PipelineLayout, VkPipelineLayout>(1);
+        item.descriptorSet = fakeHandle<vk::DescriptorSet, VkDescriptorSet>(1);
+        item.vertexBuffer = fakeHandle<vk::Buffer, VkBuffer>(1);
+        item.indexBuffer = fakeHandle<vk::Buffer, VkBuffer>(2);
+        item.indexCount = 36;
+        list.add(makeSortKey(0, 0, pipeline, 0, 0, 0.0f), item);
+    }
+    DrawListStats unsorted = list.countBinds();
+    CHECK(unsorted.pipelineBinds == 8);
+    list.sort();
+    DrawListStats stats = list.countBinds();
+    CHECK(stats.draws == 8);
+    CHECK(stats.pipelineBinds == 2);
+    CHECK(stats.descriptorSetBinds == 1);
+    CHECK(stats.vertexBufferBinds == 1);
+    CHECK(stats.indexBufferBinds == 1);
+
+    list.clear();
+    CHECK(list.size() == 0);
+    CHECK(list.countBinds().draws == 0);
+}
+}
+
+int main()
+{
+    keyFieldOrder();
+    sortsStably();
+    skipsRedundantBinds();
+    return testResult();
+}
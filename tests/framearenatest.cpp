@@ -0,0 +1,72 @@
+#include "framearena.h"
+#include "test.h"
+
+#include <cstdint>
+
+namespace {
+void alignsAndBumps()
+{
+    FrameArena arena(1024);
+    char* a = static_cast<char*>(arena.allocate(3, 1));
+    char* b = static_cast<char*>(arena.allocate(8, 8));
+    char* c = static_cast<char*>(arena.allocate(16, 16));
+    CHECK(b > a && c > b);
+    CHECK(reinterpret_cast<uintptr_t>(b) % 8 == 0);
+    CHECK(reinterpret_cast<uintptr_t>(c) % 16 == 0);
+    CHECK(arena.used() == 27);
+    CHECK(arena.capacity() == 1024);
+    CHECK(arena.overflows() == 0);
+}
+
+// An overflowing frame chains a block; reset() folds the blocks into one
+// that fits the peak, so the next frame of the same size does not overflow.
+void growsToPeak()
+{
+    FrameArena arena(256);
+    for (int i = 0; i < 10; i++) {
+        arena.allocate(100, 8);
+    }
+    CHECK(arena.overflows() > 0);
+    CHECK(arena.peak() == 1000);
+    arena.reset();
+    CHECK(arena.used() == 0);
+    CHECK(arena.capacity() >= 1000);
+    uint64_t overflows = arena.overflows();
+    for (int i = 0; i < 10; i++) {
+        arena.allocate(100, 8);
+    }
+    CHECK(arena.overflows() == overflows);
+}
+
+void largerThanBlock()
+{
+    FrameArena arena(64);
+    void* memory = arena.allocate(1000, 16);
+    CHECK(memory != nullptr);
+    CHECK(arena.capacity() >= 1064);
+}
+
+void frameVector()
+{
+    FrameArena arena(64);
+    FrameVector<int> values{ ArenaAllocator<int>(arena) };
+    for (int i = 0; i < 100; i++) {
+        values.push_back(i);
+    }
+    bool ordered = true;
+    for (int i = 0; i < 100; i++) {
+        ordered = ordered && values[i] == i;
+    }
+    CHECK(ordered);
+    CHECK(arena.used() >= 100 * sizeof(int));
+}
+}
+
+int main()
+{
+    alignsAndBumps();
+    growsToPeak();
+    largerThanBlock();
+    frameVector();
+    return testResult();
+}
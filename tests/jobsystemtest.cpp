@@ -0,0 +1,68 @@
+#include "jobsystem.h"
+#include "test.h"
+
+#include <atomic>
+#include <vector>
+
+namespace {
+const unsigned ThreadCounts[] = { 1, 2, 4 };
+
+// Many more jobs in flight than a worker's pool holds, so slots must not be
+// reused before their jobs have run.
+void parallelForBeyondPool(JobSystem& jobs)
+{
+    const size_t count = JobPoolSize * 5;
+    std::atomic<uint64_t> sum(0);
+    std::vector<int> visits(count, 0);
+    jobs.parallelFor(count, 1, [&sum, &visits](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            visits[i]++;
+            sum.fetch_add(i, std::memory_order_relaxed);
+        }
+    });
+    CHECK(sum.load() == static_cast<uint64_t>(count) * (count - 1) / 2);
+    bool once = true;
+    for (int visit : visits) {
+        once = once && visit == 1;
+    }
+    CHECK(once);
+}
+
+void nestedJobs(JobSystem& jobs)
+{
+    std::atomic<int> total(0);
+    jobs.parallelFor(64, 1, [&jobs, &total](size_t, size_t) {
+        JobCounter counter;
+        for (int i = 0; i < 128; i++) {
+            jobs.run([&total]() { total.fetch_add(1, std::memory_order_relaxed); }, &counter);
+        }
+        jobs.wait(counter);
+    });
+    CHECK(total.load() == 64 * 128);
+}
+
+void continuationsRunInOrder(JobSystem& jobs)
+{
+    std::vector<int> order;
+    JobCounter first;
+    JobCounter second;
+    JobCounter third;
+    jobs.run([&order]() { order.push_back(1); }, &first);
+    jobs.runAfter(first, [&order]() { order.push_back(2); }, &second);
+    jobs.runAfter(second, [&order]() { order.push_back(3); }, &third);
+    jobs.wait(third);
+    CHECK(order == std::vector<int>({ 1, 2, 3 }));
+    CHECK(first.isDone() && second.isDone() && third.isDone());
+}
+}
+
+int main()
+{
+    for (unsigned threads : ThreadCounts) {
+        JobSystem jobs(threads);
+        parallelForBeyondPool(jobs);
+        nestedJobs(jobs);
+        continuationsRunInOrder(jobs);
+    }
+    return testResult();
+}
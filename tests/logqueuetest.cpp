@@ -0,0 +1,93 @@
+#include "logger.h"
+#include "test.h"
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+bool push(LogQueue& queue, const std::string& message)
+{
+    size_t position = 0;
+    LogRecord* record = queue.beginPush(position);
+    if (record == nullptr) {
+        return false;
+    }
+    record->category = LogCategory::General;
+    record->level = LogLevel::Info;
+    record->length = static_cast<uint16_t>(message.size());
+    std::memcpy(record->message, message.data(), message.size());
+    queue.endPush(position);
+    return true;
+}
+
+void fifoAndFull()
+{
+    LogQueue queue(4);
+    LogRecord record;
+    CHECK(!queue.pop(record));
+    for (int i = 0; i < 4; i++) {
+        CHECK(push(queue, "message " + std::to_string(i)));
+    }
+    CHECK(!push(queue, "dropped"));
+    for (int i = 0; i < 4; i++) {
+        CHECK(queue.pop(record));
+        CHECK(std::string(record.message, record.length) == "message " + std::to_string(i));
+    }
+    CHECK(!queue.pop(record));
+    CHECK(push(queue, "again"));
+    CHECK(queue.pop(record) && std::string(record.message, record.length) == "again");
+}
+
+// Every record of every producer arrives once and each producer's records
+// stay in order.
+void concurrentProducers()
+{
+    const int Producers = 4;
+    const int PerProducer = 20000;
+    LogQueue queue(256);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < Producers; p++) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < PerProducer; i++) {
+                std::string message = std::to_string(p) + " " + std::to_string(i);
+                while (!push(queue, message)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::vector<int> next(Producers, 0);
+    bool ordered = true;
+    int received = 0;
+    LogRecord record;
+    while (received < Producers * PerProducer) {
+        if (!queue.pop(record)) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::string message(record.message, record.length);
+        size_t space = message.find(' ');
+        int producer = std::stoi(message.substr(0, space));
+        int index = std::stoi(message.substr(space + 1));
+        ordered = ordered && producer >= 0 && producer < Producers && index == next[producer];
+        if (producer >= 0 && producer < Producers) {
+            next[producer] = index + 1;
+        }
+        received++;
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    CHECK(ordered);
+    CHECK(!queue.pop(record));
+}
+}
+
+int main()
+{
+    fifoAndFull();
+    concurrentProducers();
+    return testResult();
+}
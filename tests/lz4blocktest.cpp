@@ -0,0 +1,86 @@
+#include "lz4block.h"
+#include "test.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+bool roundTrip(const std::vector<char>& data)
+{
+    std::vector<char> compressed(lz4CompressBound(data.size()));
+    size_t size = lz4Compress(data.data(), data.size(), compressed.data(), compressed.size());
+    if (size == 0 && !data.empty()) {
+        return false;
+    }
+    std::vector<char> decompressed(data.size());
+    return lz4Decompress(compressed.data(), size, decompressed.data(), decompressed.size()) && decompressed == data;
+}
+
+std::vector<char> randomBytes(size_t size, std::mt19937& random)
+{
+    std::vector<char> data(size);
+    for (char& c : data) {
+        c = static_cast<char>(random());
+    }
+    return data;
+}
+
+std::vector<char> repetitive(size_t size)
+{
+    std::string text = "vertex 0.25 0.5 1.0 normal 0 1 0 ";
+    std::vector<char> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = text[i % text.size()];
+    }
+    return data;
+}
+
+void roundTrips()
+{
+    std::mt19937 random(11);
+    const size_t Sizes[] = { 0, 1, 5, 12, 13, 64, 1000, 65536, 1 << 20 };
+    for (size_t size : Sizes) {
+        CHECK(roundTrip(randomBytes(size, random)));
+        CHECK(roundTrip(repetitive(size)));
+        CHECK(roundTrip(std::vector<char>(size, 'x')));
+    }
+}
+
+void compresses()
+{
+    std::vector<char> data = repetitive(1 << 16);
+    std::vector<char> compressed(lz4CompressBound(data.size()));
+    size_t size = lz4Compress(data.data(), data.size(), compressed.data(), compressed.size());
+    CHECK(size > 0 && size < data.size() / 10);
+    CHECK(lz4Compress(data.data(), data.size(), compressed.data(), 16) == 0);
+}
+
+// Truncated or damaged blocks and wrong sizes are rejected without reading
+// or writing out of bounds.
+void rejectsBadInput()
+{
+    std::mt19937 random(13);
+    std::vector<char> data = repetitive(4096);
+    std::vector<char> compressed(lz4CompressBound(data.size()));
+    size_t size = lz4Compress(data.data(), data.size(), compressed.data(), compressed.size());
+    std::vector<char> output(data.size());
+    CHECK(!lz4Decompress(compressed.data(), size - 1, output.data(), output.size()));
+    CHECK(!lz4Decompress(compressed.data(), size, output.data(), output.size() - 1));
+    CHECK(!lz4Decompress(compressed.data(), size, output.data(), output.size() + 1));
+    for (int i = 0; i < 1000; i++) {
+        std::vector<char> damaged(compressed.begin(), compressed.begin() + size);
+        damaged[random() % size] = static_cast<char>(random());
+        std::vector<char> decoded(data.size());
+        lz4Decompress(damaged.data(), damaged.size(), decoded.data(), decoded.size());
+    }
+}
+}
+
+int main()
+{
+    roundTrips();
+    compresses();
+    rejectsBadInput();
+    return testResult();
+}
@@ -0,0 +1,126 @@
+#include "meshlayout.h"
+#include "test.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+bool overlaps(uint32_t offsetA, uint32_t countA, uint32_t offsetB, uint32_t countB)
+{
+    return offsetA < offsetB + countB && offsetB < offsetA + countA;
+}
+
+void addAndRemove()
+{
+    MeshLayout layout;
+    layout.reset(100, 300);
+    MeshHandle a = layout.add(40, 120);
+    MeshHandle b = layout.add(40, 120);
+    CHECK(a != InvalidMesh && b != InvalidMesh && a != b);
+    CHECK(layout.mesh(b).vertexOffset == 40);
+    CHECK(layout.mesh(b).firstIndex == 120);
+    CHECK(layout.add(40, 10) == InvalidMesh);
+    // A mesh whose indices do not fit gives its vertices back.
+    CHECK(layout.add(10, 100) == InvalidMesh);
+    CHECK(layout.vertices().used() == 80);
+
+    layout.remove(a);
+    CHECK(!layout.isLive(a));
+    CHECK(layout.meshCount() == 1);
+    layout.remove(a);
+    CHECK(layout.meshCount() == 1);
+    MeshHandle c = layout.add(20, 60);
+    CHECK(c == a);
+    CHECK(layout.mesh(c).vertexOffset == 0);
+}
+
+// Compaction keeps handles and sizes, packs the live meshes to the front and
+// reports each move, which is what the pool copies.
+void compactPacksLiveMeshes()
+{
+    MeshLayout layout;
+    layout.reset(100, 100);
+    MeshHandle a = layout.add(30, 30);
+    MeshHandle b = layout.add(30, 30);
+    MeshHandle c = layout.add(30, 30);
+    CHECK(layout.slack() == 0.0);
+    layout.remove(a);
+    CHECK(layout.fragmentation() > 0.0);
+    CHECK(layout.slack() > 0.3);
+    CHECK(layout.add(40, 40) == InvalidMesh);
+
+    std::vector<MeshMove> moves = layout.compact();
+    CHECK(moves.size() == 2);
+    CHECK(moves[0].from.vertexOffset == 30);
+    CHECK(moves[0].to.vertexOffset == 0);
+    CHECK(moves[1].from.firstIndex == 60);
+    CHECK(moves[1].to.firstIndex == 30);
+    CHECK(layout.mesh(b).vertexOffset == 0);
+    CHECK(layout.mesh(c).vertexOffset == 30);
+    CHECK(layout.mesh(c).vertexCount == 30);
+    CHECK(layout.fragmentation() == 0.0);
+    CHECK(layout.slack() == 0.0);
+    CHECK(layout.add(40, 40) != InvalidMesh);
+}
+
+// Meshes of varying size churned through the layout never overlap, and after
+// a compaction the live meshes cover the front of both ranges exactly.
+void churn()
+{
+    MeshLayout layout;
+    layout.reset(2048, 4096);
+    std::vector<MeshHandle> live;
+    std::mt19937 random(11);
+    bool disjoint = true;
+    bool packed = true;
+    int compactions = 0;
+    for (int i = 0; i < 5000; i++) {
+        if (live.size() > 4 && random() % 2 == 0) {
+            size_t index = random() % live.size();
+            layout.remove(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+            continue;
+        }
+        uint32_t vertexCount = 8 + random() % 64;
+        MeshHandle mesh = layout.add(vertexCount, vertexCount * 2);
+        if (mesh == InvalidMesh && layout.fragmentation() > 0.0) {
+            layout.compact();
+            compactions++;
+            uint32_t vertices = 0;
+            uint32_t indices = 0;
+            for (MeshHandle handle : live) {
+                const MeshRange& range = layout.mesh(handle);
+                vertices += range.vertexCount;
+                indices += range.indexCount;
+                packed = packed && static_cast<uint32_t>(range.vertexOffset) + range.vertexCount <= layout.vertices().used();
+                packed = packed && range.firstIndex + range.indexCount <= layout.indices().used();
+            }
+            packed = packed && vertices == layout.vertices().used() && indices == layout.indices().used() && layout.slack() == 0.0;
+            mesh = layout.add(vertexCount, vertexCount * 2);
+        }
+        if (mesh == InvalidMesh) {
+            continue;
+        }
+        const MeshRange& added = layout.mesh(mesh);
+        for (MeshHandle handle : live) {
+            const MeshRange& range = layout.mesh(handle);
+            disjoint = disjoint && !overlaps(static_cast<uint32_t>(added.vertexOffset), added.vertexCount, static_cast<uint32_t>(range.vertexOffset), range.vertexCount);
+            disjoint = disjoint && !overlaps(added.firstIndex, added.indexCount, range.firstIndex, range.indexCount);
+        }
+        live.push_back(mesh);
+    }
+    CHECK(disjoint);
+    CHECK(packed);
+    CHECK(compactions > 0);
+    CHECK(layout.meshCount() == live.size());
+}
+}
+
+int main()
+{
+    addAndRemove();
+    compactPacksLiveMeshes();
+    churn();
+    return testResult();
+}
@@ -0,0 +1,95 @@
+#include "rangeallocator.h"
+#include "test.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+void firstFit()
+{
+    RangeAllocator allocator(100);
+    CHECK(allocator.allocate(30) == 0);
+    CHECK(allocator.allocate(30) == 30);
+    CHECK(allocator.allocate(30) == 60);
+    CHECK(allocator.allocate(20) == RangeAllocator::InvalidOffset);
+    CHECK(allocator.used() == 90);
+    CHECK(allocator.largestFree() == 10);
+    CHECK(allocator.end() == 90);
+
+    allocator.free(0, 30);
+    CHECK(allocator.allocate(10) == 0);
+    CHECK(allocator.allocate(0) == RangeAllocator::InvalidOffset);
+}
+
+void mergesNeighbours()
+{
+    RangeAllocator allocator(90);
+    uint32_t a = allocator.allocate(30);
+    uint32_t b = allocator.allocate(30);
+    uint32_t c = allocator.allocate(30);
+    allocator.free(a, 30);
+    allocator.free(c, 30);
+    CHECK(allocator.end() == 60);
+    CHECK(allocator.largestFree() == 30);
+    CHECK(allocator.fragmentation() == 0.5);
+    allocator.free(b, 30);
+    CHECK(allocator.used() == 0);
+    CHECK(allocator.end() == 0);
+    CHECK(allocator.largestFree() == 90);
+    CHECK(allocator.fragmentation() == 0.0);
+    CHECK(allocator.allocate(90) == 0);
+}
+
+// Random allocations and frees never overlap, and freeing everything leaves
+// one free range again.
+void randomOperations()
+{
+    const uint32_t capacity = 4096;
+    RangeAllocator allocator(capacity);
+    std::vector<int> owner(capacity, -1);
+    struct Range {
+        uint32_t offset;
+        uint32_t count;
+    };
+    std::vector<Range> live;
+    std::mt19937 random(7);
+    bool disjoint = true;
+    for (int i = 0; i < 20000; i++) {
+        if (live.empty() || random() % 3 != 0) {
+            uint32_t count = 1 + random() % 64;
+            uint32_t offset = allocator.allocate(count);
+            if (offset == RangeAllocator::InvalidOffset) {
+                continue;
+            }
+            for (uint32_t j = offset; j < offset + count; j++) {
+                disjoint = disjoint && owner[j] < 0;
+                owner[j] = i;
+            }
+            live.push_back({ offset, count });
+        } else {
+            size_t index = random() % live.size();
+            Range range = live[index];
+            for (uint32_t j = range.offset; j < range.offset + range.count; j++) {
+                owner[j] = -1;
+            }
+            allocator.free(range.offset, range.count);
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    CHECK(disjoint);
+    for (const Range& range : live) {
+        allocator.free(range.offset, range.count);
+    }
+    CHECK(allocator.used() == 0);
+    CHECK(allocator.largestFree() == capacity);
+}
+}
+
+int main()
+{
+    firstFit();
+    mergesNeighbours();
+    randomOperations();
+    return testResult();
+}
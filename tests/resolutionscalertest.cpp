@@ -0,0 +1,89 @@
+#include "resolutionscaler.h"
+#include "test.h"
+
+namespace {
+// GPU time of a frame whose cost grows with the pixel count.
+double gpuTime(double fullResolution, double scale)
+{
+    return fullResolution * scale * scale;
+}
+
+void disabledWithoutBudget()
+{
+    ResolutionScaler scaler;
+    CHECK(!scaler.isEnabled());
+    CHECK(!scaler.update(100.0));
+    CHECK(scaler.scale() == 1.0);
+}
+
+void convergesIntoBudget()
+{
+    ResolutionScaler scaler;
+    scaler.configure(10.0, 0.5);
+    uint32_t version = scaler.version();
+    for (int i = 0; i < 300; i++) {
+        scaler.update(gpuTime(16.0, scaler.scale()));
+    }
+    CHECK(scaler.scale() < 1.0);
+    CHECK(scaler.scale() >= 0.5);
+    CHECK(scaler.version() != version);
+    double load = gpuTime(16.0, scaler.scale()) / 10.0;
+    CHECK(load <= 0.95);
+
+    // Settled: no more changes while the load stays in the dead band.
+    uint64_t changes = scaler.changes();
+    for (int i = 0; i < 100; i++) {
+        scaler.update(gpuTime(16.0, scaler.scale()));
+    }
+    CHECK(scaler.changes() == changes);
+}
+
+void clampsToMinimum()
+{
+    ResolutionScaler scaler;
+    scaler.configure(1.0, 0.5);
+    for (int i = 0; i < 300; i++) {
+        scaler.update(gpuTime(100.0, scaler.scale()));
+    }
+    CHECK(scaler.scale() == 0.5);
+}
+
+void recoversWhenCheap()
+{
+    ResolutionScaler scaler;
+    scaler.configure(10.0, 0.5);
+    for (int i = 0; i < 300; i++) {
+        scaler.update(gpuTime(30.0, scaler.scale()));
+    }
+    CHECK(scaler.scale() < 0.7);
+    for (int i = 0; i < 300; i++) {
+        scaler.update(gpuTime(2.0, scaler.scale()));
+    }
+    CHECK(scaler.scale() == 1.0);
+}
+
+void scaledExtent()
+{
+    ResolutionScaler scaler;
+    scaler.configure(1.0, 0.5);
+    for (int i = 0; i < 300; i++) {
+        scaler.update(100.0);
+    }
+    uint32_t width = 0;
+    uint32_t height = 0;
+    scaler.scaledExtent(1920, 1080, width, height);
+    CHECK(width == 960 && height == 540);
+    scaler.scaledExtent(1, 1, width, height);
+    CHECK(width == 1 && height == 1);
+}
+}
+
+int main()
+{
+    disabledWithoutBudget();
+    convergesIntoBudget();
+    clampsToMinimum();
+    recoversWhenCheap();
+    scaledExtent();
+    return testResult();
+}
@@ -0,0 +1,34 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the unit tests: a failed CHECK prints where it failed
+// and the test keeps going; main() returns testResult().
+inline int& testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void checkCondition(bool passed, const char* expression, const char* file, int line)
+{
+    if (!passed) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        testFailures()++;
+    }
+}
+
+inline int testResult()
+{
+    if (testFailures() > 0) {
+        std::fprintf(stderr, "%d checks failed\n", testFailures());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+#define CHECK(condition) checkCondition((condition), #condition, __FILE__, __LINE__)
+
+#endif // TEST_H
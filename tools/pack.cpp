@@ -0,0 +1,84 @@
+#include "assetarchive.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+void printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [--store] ARCHIVE FILE...   pack FILEs, named by their file names" << std::endl
+              << "       " << program << " --list ARCHIVE              list the entries of ARCHIVE" << std::endl
+              << "  --store    write entries uncompressed, so all of them can be read in place" << std::endl;
+}
+
+std::string fileName(const std::string& path)
+{
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool readContents(const std::string& path, std::vector<char>& contents)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    contents.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+    return static_cast<bool>(file);
+}
+
+int list(const std::string& path)
+{
+    AssetArchive archive;
+    if (!archive.open(path)) {
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < archive.entryCount(); i++) {
+        const ArchiveEntry& entry = archive.entry(i);
+        std::cout << archive.name(entry) << " " << entry.size << " bytes";
+        if (entry.flags & ArchiveEntryCompressed) {
+            std::cout << ", " << entry.storedSize << " compressed";
+        }
+        std::cout << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && std::strcmp(argv[1], "--list") == 0) {
+        return list(argv[2]);
+    }
+    int first = 1;
+    bool compress = true;
+    if (argc > 1 && std::strcmp(argv[1], "--store") == 0) {
+        compress = false;
+        first++;
+    }
+    if (argc - first < 2) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    AssetArchiveWriter writer;
+    std::vector<char> contents;
+    for (int i = first + 1; i < argc; i++) {
+        if (!readContents(argv[i], contents)) {
+            std::cerr << "Failed to read: [" << argv[i] << "]" << std::endl;
+            return EXIT_FAILURE;
+        }
+        writer.add(fileName(argv[i]), contents.data(), contents.size(), compress);
+    }
+    if (!writer.write(argv[first])) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Packed " << writer.entryCount() << " files, " << writer.size() << " bytes stored in " << writer.storedSize() << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,52 @@
+#include "drawstream.h"
+#include "replayer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+void printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [--paced] [--shader-dir=DIR|FILE.pak] STREAM   replay a stream recorded with --record-stream" << std::endl
+              << "  --paced                    submit frames at the recorded times instead of as fast as possible" << std::endl
+              << "  --shader-dir=DIR|FILE.pak  load shaders from DIR or an archive instead of the embedded shaders" << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    bool paced = false;
+    std::string shaderDirectory;
+    std::string path;
+    const char* shaderOption = "--shader-dir=";
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--paced") == 0) {
+            paced = true;
+        } else if (std::strncmp(argv[i], shaderOption, std::strlen(shaderOption)) == 0) {
+            shaderDirectory = argv[i] + std::strlen(shaderOption);
+        } else if (path.empty() && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (path.empty()) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    DrawStreamReader stream;
+    if (!stream.open(path)) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Replaying " << stream.frameCount() << " frames, " << stream.recordCount() << " records" << std::endl;
+    Replayer replayer;
+    if (!replayer.run(stream, paced, shaderDirectory)) {
+        return EXIT_FAILURE;
+    }
+    replayer.report(std::cout);
+    return EXIT_SUCCESS;
+}